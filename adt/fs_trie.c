@@ -160,6 +160,67 @@ int trie_delete(trie_t * t, const char * full_key) {
 	}
 }
 
+/** Moves the node representing @a old_key (including all its children) under the name @a new_key. If
+ * there is already a node representing @a new_key, it is deleted first (together with its children).
+ * All missing nodes on the path to @a new_key are inserted.
+ *
+ * @arg t Trie in which to move the node
+ * @arg old_key t->delim separated list of keys representing path to the node to move
+ * @arg new_key t->delim separated list of keys representing new path of the node
+ *
+ * @return TRIE_OK if the node was moved, TRIE_ERR if no node representing @a old_key exists in @a t or
+ *         @a new_key lies under @a old_key.
+ */
+
+int trie_move(trie_t * t, const char * old_key, const char * new_key) {
+	trie_node_t * node;
+	trie_node_t * target;
+	trie_node_t * parent;
+	char * strtmp;
+	char * base;
+	int len;
+
+	assert(t);
+	node = trie_find(t, old_key);
+
+	if ( ! node || node == t->root ) {
+		return TRIE_ERR;
+	}
+
+	len = strlen(old_key);
+	if ( strncmp(old_key, new_key, len) == 0 && new_key[len] == t->delim ) { //can't move node under itself
+		return TRIE_ERR;
+	}
+
+	target = trie_find(t, new_key);
+	if ( target == node ) {
+		return TRIE_OK;
+	} else if ( target == t->root ) {
+		return TRIE_ERR;
+	} else if ( target ) {
+		trie_delete2(t, target);
+	}
+
+	strtmp = strdup(new_key);
+	base = rindex(strtmp, t->delim);
+	if ( base == NULL ) { // no delimiter at all
+		base = strtmp;
+		parent = t->root;
+	} else {
+		*base = 0;
+		base++;
+		parent = ( *strtmp ) ? trie_insert(t, strtmp) : t->root;
+	}
+
+	list_remove2(&node->item);
+	free(node->key);
+	node->key = strdup(base);
+	list_append(&parent->children, &node->item);
+
+	free(strtmp);
+	return TRIE_OK;
+}
+
 /** Looks for its direct child with given @a part_key
  * @arg n node in which to look for the child
  * @arg part_key key that the child should have
@@ -98,6 +98,7 @@ trie_node_t * trie_insert(trie_t *t, const char * full_key);
 trie_node_t * trie_insert2(trie_t * t, const char * full_key, trie_node_t * (*crate)(void));
 int trie_delete(trie_t *t, const char * full_key);
 int trie_delete2(trie_t *t, trie_node_t * node);
+int trie_move(trie_t * t, const char * old_key, const char * new_key);
 trie_node_t * trie_find_child(trie_node_t * n, const char * part_key);
 trie_node_t * trie_longest_prefix(trie_t * t, const char * full_key, char * buff);
 void trie_destroy(trie_t * t);
@@ -0,0 +1,217 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <inttypes.h>
+
+#include "common.h"
+#include "anon.h"
+
+int anon_on = 0;
+uint64_t anon_k0, anon_k1; ///< SipHash key
+
+static const char * anon_keep[] = ANON_KEEP;
+static const char anon_alphabet[] = "abcdefghijklmnopqrstuvwxyz234567";
+
+#define ANON_ROTL(x, b) (uint64_t) (((x) << (b)) | ((x) >> (64 - (b))))
+
+#define ANON_SIPROUND \
+	do { \
+		v0 += v1; v1 = ANON_ROTL(v1, 13); v1 ^= v0; v0 = ANON_ROTL(v0, 32); \
+		v2 += v3; v3 = ANON_ROTL(v3, 16); v3 ^= v2; \
+		v0 += v3; v3 = ANON_ROTL(v3, 21); v3 ^= v0; \
+		v2 += v1; v1 = ANON_ROTL(v1, 17); v1 ^= v2; v2 = ANON_ROTL(v2, 32); \
+	} while (0)
+
+/** SipHash-2-4 of @a len bytes at @a data with key @a k0, @a k1. */
+
+static uint64_t anon_siphash(const unsigned char * data, size_t len, uint64_t k0, uint64_t k1) {
+	uint64_t v0 = 0x736f6d6570736575ULL ^ k0;
+	uint64_t v1 = 0x646f72616e646f6dULL ^ k1;
+	uint64_t v2 = 0x6c7967656e657261ULL ^ k0;
+	uint64_t v3 = 0x7465646279746573ULL ^ k1;
+	uint64_t b = (uint64_t) len << 56;
+	uint64_t m;
+	size_t i, j, left = len & 7;
+
+	for (i = 0; i + 8 <= len; i += 8) {
+		for (m = 0, j = 0; j < 8; j++) { //little endian, so names do not depend on the machine
+			m |= (uint64_t) data[i + j] << (8 * j);
+		}
+		v3 ^= m;
+		ANON_SIPROUND;
+		ANON_SIPROUND;
+		v0 ^= m;
+	}
+	for (m = 0; left > 0; left--) {
+		m |= (uint64_t) data[i + left - 1] << (8 * (left - 1));
+	}
+	b |= m;
+	v3 ^= b;
+	ANON_SIPROUND;
+	ANON_SIPROUND;
+	v0 ^= b;
+	v2 ^= 0xff;
+	ANON_SIPROUND;
+	ANON_SIPROUND;
+	ANON_SIPROUND;
+	ANON_SIPROUND;
+	return v0 ^ v1 ^ v2 ^ v3;
+}
+
+/** Enables anonymization with key @a key. The SipHash key is derived from @a key, so any string can be used.
+ *
+ * @arg key the key, or @<file> to read it from the first line of <file> (so it does not show in the process list)
+ * @return 0 on success, -1 on error
+ */
+
+int anon_init(const char * key) {
+	char buf[MAX_STRING];
+	FILE * f;
+
+	if (key[0] == '@') {
+		if ( (f = fopen(key + 1, "r")) == NULL) {
+			ERRORPRINTF("Error opening key file %s: %s\n", key + 1, strerror(errno));
+			return -1;
+		}
+		if (fgets(buf, MAX_STRING, f) == NULL) {
+			buf[0] = 0;
+		}
+		fclose(f);
+		buf[strcspn(buf, "\r\n")] = 0;
+		key = buf;
+	}
+	if ( ! key[0]) {
+		ERRORPRINTF("Empty anonymization key%s", "\n");
+		return -1;
+	}
+	anon_k0 = anon_siphash((const unsigned char *) key, strlen(key), 0x0706050403020100ULL, 0x0f0e0d0c0b0a0908ULL);
+	anon_k1 = anon_siphash((const unsigned char *) key, strlen(key), anon_k0, 0x0f0e0d0c0b0a0908ULL);
+	memset(buf, 0, sizeof(buf));
+	anon_on = 1;
+	return 0;
+}
+
+int anon_enabled() {
+	return anon_on;
+}
+
+/** @return length of the extension (with the dot) of component @a comp of length @a len, 0 if it is not kept */
+
+static inline size_t anon_ext(const char * comp, size_t len) {
+	size_t i;
+
+	for (i = len; i > 1 && len - i < ANON_MAX_EXT + 1; i--) {
+		if (comp[i - 1] == '.') {
+			return i - 1 < len - 1 ? len - i + 1 : 0; //"name." has no extension
+		}
+		if ( ! isalnum((unsigned char) comp[i - 1])) {
+			return 0;
+		}
+	}
+	return 0;
+}
+
+/** Writes anonymized path @a name to @a out (MAX_STRING long). @a name and @a out can be the same buffer.
+ *
+ * @return 0 on success, -1 if the anonymized path does not fit
+ */
+
+int anon_path(const char * name, char * out) {
+	char buf[MAX_STRING];
+	const char * comp, * end;
+	size_t len, ext, pos = 0;
+	uint64_t h;
+	int i;
+
+	for (i = 0; anon_keep[i]; i++) {
+		if ( ! strncmp(name, anon_keep[i], strlen(anon_keep[i]))) {
+			if (out != name) {
+				strncpy(out, name, MAX_STRING);
+			}
+			return 0;
+		}
+	}
+	for (comp = name; ; comp = end + 1) {
+		if ( (end = strchr(comp, '/')) == NULL) {
+			end = comp + strlen(comp);
+		}
+		len = end - comp;
+		if (len == 0 || (len == 1 && comp[0] == '.') || (len == 2 && comp[0] == '.' && comp[1] == '.')) {
+			if (pos + len + 1 >= MAX_STRING) {
+				return -1;
+			}
+			memcpy(buf + pos, comp, len);
+			pos += len;
+		} else {
+			ext = anon_ext(comp, len);
+			if (pos + ANON_LEN + ext + 1 >= MAX_STRING) {
+				return -1;
+			}
+			h = anon_siphash((const unsigned char *) comp, len, anon_k0, anon_k1);
+			for (i = 0; i < ANON_LEN; i++, h >>= 5) {
+				buf[pos++] = anon_alphabet[h & 31];
+			}
+			memcpy(buf + pos, end - ext, ext);
+			pos += ext;
+		}
+		if (*end == 0) {
+			break;
+		}
+		buf[pos++] = '/';
+	}
+	buf[pos] = 0;
+	memcpy(out, buf, pos + 1);
+	return 0;
+}
+
+/** Anonymizes all paths in @a list.
+ *
+ * @return number of paths rewritten, -1 if some of them did not fit
+ */
+
+int64_t anon_apply(list_t * list) {
+	common_op_item_t * com_it;
+	item_t * item;
+	char * names[2];
+	int64_t count = 0;
+	int i, n;
+
+	for (item = list->head; item; item = item->next) {
+		com_it = list_entry(item, common_op_item_t, item);
+		n = get_item_names(com_it, names);
+		for (i = 0; i < n; i++) {
+			if (anon_path(names[i], names[i]) != 0) {
+				ERRORPRINTF("Anonymized name of %s is too long\n", names[i]);
+				return -1;
+			}
+			count++;
+		}
+	}
+	return count;
+}
+
+void anon_finish() {
+	anon_on = 0;
+	anon_k0 = anon_k1 = 0;
+}
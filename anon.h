@@ -0,0 +1,51 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _ANON_H_
+#define _ANON_H_
+
+/** @file anon.h
+ *
+ * Path anonymization for conversion to the binary format. Every component of every path in the trace (open,
+ * stat, access, mkdir, rmdir, unlink, rename, link, symlink, readlink and execve) is replaced by a keyed hash
+ * (SipHash-2-4) of it, written as ANON_LEN characters of base32. The same component gives the same hash
+ * everywhere, so the directory structure, depth, shared prefixes and relations between names (renames, links,
+ * relative symlink targets) are kept. Extensions of up to ANON_MAX_EXT characters, ".", "..", empty components
+ * (leading or double slashes) and paths under ANON_KEEP prefixes (devices and kernel interfaces, which are
+ * replayed as they are) are kept too.
+ *
+ * Without the key, names cannot be recovered or checked against guesses. The same key gives the same names
+ * in different traces, so traces of one system converted separately still share their files.
+ */
+
+#include <stdint.h>
+#include "common.h"
+#include "in_common.h"
+
+#define ANON_LEN 13 ///< 64 bits in base32
+#define ANON_MAX_EXT 8
+#define ANON_KEEP { "/dev/", "/proc/", "/sys/", NULL }
+
+int anon_init(const char * key);
+int anon_enabled();
+int anon_path(const char * name, char * out);
+int64_t anon_apply(list_t * list);
+void anon_finish();
+
+#endif
@@ -0,0 +1,144 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <sys/mman.h>
+
+#include "common.h"
+#include "bufpool.h"
+
+#ifndef MAP_HUGETLB
+#define MAP_HUGETLB 0x40000 ///< not defined by older headers
+#endif
+
+#define HUGEPAGE_SIZE (2*1024*1024)
+
+typedef struct buffer {
+	char * data;
+	int64_t size; ///< size of the mapping
+	int huge; ///< whether the buffer is backed by huge pages
+} buffer_t;
+
+buffer_t bufpool[BUFPOOL_CLASSES];
+int bufpool_hugepages = 0; ///< try to use huge pages for buffers large enough
+int64_t bufpool_bytes = 0; ///< memory allocated by the pool
+int bufpool_count = 0; ///< number of buffers allocated
+int bufpool_huge_count = 0; ///< number of buffers backed by huge pages
+
+/** Initializes the pool. No memory is allocated until a buffer is needed.
+ *
+ * @arg hugepages non-zero to back buffers of at least 2MB with huge pages. If huge pages are not
+ *      available, normal pages are used instead.
+ */
+
+void bufpool_init(int hugepages) {
+	memset(bufpool, 0, sizeof(bufpool));
+	bufpool_hugepages = hugepages;
+	bufpool_bytes = 0;
+	bufpool_count = 0;
+	bufpool_huge_count = 0;
+}
+
+/** Allocates buffer of @a size bytes for size class @a buffer.
+ *
+ * @return 0 on success, -1 otherwise
+ */
+
+static int bufpool_alloc(buffer_t * buffer, int64_t size) {
+	char * data = MAP_FAILED;
+
+	if (bufpool_hugepages && size >= HUGEPAGE_SIZE) {
+		data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (data == MAP_FAILED) {
+			DEBUGPRINTF("Huge pages not available for buffer of %"PRIi64" bytes: %s\n", size, strerror(errno));
+		} else {
+			buffer->huge = 1;
+			bufpool_huge_count++;
+		}
+	}
+
+	if (data == MAP_FAILED) {
+		data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (data == MAP_FAILED) {
+			ERRORPRINTF("Can not allocate buffer of %"PRIi64" bytes: %s\n", size, strerror(errno));
+			return -1;
+		}
+#ifdef MADV_HUGEPAGE
+		if (bufpool_hugepages) {
+			madvise(data, size, MADV_HUGEPAGE); //transparent huge pages are better than nothing
+		}
+#endif
+	}
+
+	buffer->data = data;
+	buffer->size = size;
+	bufpool_bytes += size;
+	bufpool_count++;
+	return 0;
+}
+
+/** Returns aligned buffer of at least @a size bytes. The buffer is valid until the next call of bufpool_get() 
+ * with the same size class. Content of the buffer is undefined (zeros for fresh ones).
+ *
+ * @arg size requested size
+ * @return pointer to the buffer or NULL if it can not be allocated
+ */
+
+char * bufpool_get(int64_t size) {
+	int i = 0;
+	int64_t class_size = 1 << BUFPOOL_MIN_SHIFT;
+
+	while (class_size < size && i < BUFPOOL_CLASSES - 1) {
+		class_size <<= 1;
+		i++;
+	}
+
+	if (bufpool[i].data == NULL) {
+		if (bufpool_alloc(&bufpool[i], class_size) != 0) {
+			return NULL;
+		}
+	}
+	return bufpool[i].data;
+}
+
+/** Prints statistics of the pool to stdout.
+ */
+
+void bufpool_report() {
+	fprintf(stdout, "Buffer pool: %d buffers (%d backed by huge pages), %"PRIi64" bytes\n", bufpool_count,
+			bufpool_huge_count, bufpool_bytes);
+}
+
+/** Frees all buffers of the pool.
+ */
+
+void bufpool_finish() {
+	int i;
+
+	for (i = 0; i < BUFPOOL_CLASSES; i++) {
+		if (bufpool[i].data != NULL) {
+			munmap(bufpool[i].data, bufpool[i].size);
+			bufpool[i].data = NULL;
+		}
+	}
+}
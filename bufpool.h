@@ -0,0 +1,48 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _BUFPOOL_H_
+#define _BUFPOOL_H_
+
+/** @file bufpool.h
+ *
+ * Pool of aligned buffers used as a source/destination of replayed read and write calls.
+ *
+ * Buffers are aligned to BUFPOOL_ALIGN, so they can be used for IO on files opened with O_DIRECT. There is
+ * one buffer for every power of two size class, it is allocated on the first use and reused afterwards. As the
+ * replay is done by a single thread, one buffer per class is enough. Buffers may be backed by huge pages.
+ */
+
+#include <stdint.h>
+
+#define BUFPOOL_ALIGN 4096 ///< alignment of buffers, offsets and sizes for O_DIRECT IO
+#define BUFPOOL_MIN_SHIFT 12 ///< the smallest size class is 2^BUFPOOL_MIN_SHIFT bytes
+#define BUFPOOL_CLASSES 40 ///< number of size classes
+
+/** Rounds @a x up to the multiple of BUFPOOL_ALIGN */
+#define BUFPOOL_ROUND_UP(x) (((x) + BUFPOOL_ALIGN - 1) & ~((int64_t)BUFPOOL_ALIGN - 1))
+/** Rounds @a x down to the multiple of BUFPOOL_ALIGN */
+#define BUFPOOL_ROUND_DOWN(x) ((x) & ~((int64_t)BUFPOOL_ALIGN - 1))
+
+void bufpool_init(int hugepages);
+char * bufpool_get(int64_t size);
+void bufpool_report();
+void bufpool_finish();
+
+#endif
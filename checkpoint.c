@@ -0,0 +1,453 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <sys/time.h>
+
+#include "common.h"
+#include "checkpoint.h"
+#include "fdmap.h"
+#include "adt/hash_table.h"
+
+extern hash_table_t * fd_mappings;
+extern hash_table_t * usage_map;
+extern int32_t global_parent_pid;
+extern int32_t next_pipe_fd;
+extern int32_t next_socket_fd;
+
+char checkpoint_file[MAX_STRING] = "";
+char checkpoint_resume[MAX_STRING] = ""; ///< checkpoint to resume from by the next replay
+double checkpoint_interval = CHECKPOINT_DEFAULT_INTERVAL;
+struct timeval checkpoint_last; ///< when the last checkpoint was saved
+int64_t checkpoint_count = 0; ///< number of checkpoints saved
+
+/** Key of the hash table of collected objects. key_t is too small for an address, so the hash is derived
+ * from it and the compare function gets the whole key. */
+typedef struct ckpt_key {
+	key_t hash; ///< MUST be first, used by ht_hash_int
+	void * ptr; ///< address of the object
+} ckpt_key_t;
+
+/** Objects (fd tables, fd maps) collected when saving, each gets an index by the order it was found */
+typedef struct ckpt_ptr {
+	item_t item;
+	ckpt_key_t key;
+	int32_t idx;
+} ckpt_ptr_t;
+
+hash_table_t ckpt_ptrs;
+checkpoint_process_t * ckpt_processes;
+checkpoint_entry_t * ckpt_entries;
+fd_map_t ** ckpt_maps;
+hash_table_t ** ckpt_tables;
+checkpoint_header_t ckpt_hdr;
+int64_t ckpt_size; ///< allocated size of all the arrays above
+int32_t ckpt_cur_table; ///< index of the table whose entries are being collected
+
+static int ht_compare_ckpt(key_t *key, item_t *item) {
+	ckpt_ptr_t * cp;
+
+	cp = hash_table_entry(item, ckpt_ptr_t, item);
+	return cp->key.ptr == ((ckpt_key_t *) key)->ptr;
+}
+
+static inline void ht_remove_callback_ckpt(item_t * item) {
+	ckpt_ptr_t * cp = hash_table_entry(item, ckpt_ptr_t, item);	
+	free(cp);
+	return;
+}
+
+/** hash table operations. */
+static hash_table_operations_t ht_ops_ckpt = {
+	.hash = ht_hash_int,
+	.compare = ht_compare_ckpt,
+	.remove_callback = ht_remove_callback_ckpt
+};
+
+/** Sets up checkpointing.
+ *
+ * @arg filename file to save checkpoints to
+ * @arg interval seconds between two checkpoints
+ */
+
+void checkpoint_init(const char * filename, double interval) {
+	strncpy(checkpoint_file, filename, MAX_STRING);
+	checkpoint_file[MAX_STRING-1] = 0;
+	checkpoint_interval = interval;
+	gettimeofday(&checkpoint_last, NULL);
+}
+
+int checkpoint_enabled() {
+	return checkpoint_file[0] != 0;
+}
+
+/** Sets checkpoint from which the next replay continues. It is used only once. */
+void checkpoint_set_resume(const char * filename) {
+	strncpy(checkpoint_resume, filename, MAX_STRING);
+	checkpoint_resume[MAX_STRING-1] = 0;
+}
+
+/** Returns the checkpoint to resume from and forgets it, or NULL if there is none. */
+const char * checkpoint_get_resume() {
+	static char filename[MAX_STRING];
+
+	if ( ! checkpoint_resume[0] ) {
+		return NULL;
+	}
+	strcpy(filename, checkpoint_resume);
+	checkpoint_resume[0] = 0;
+	return filename;
+}
+
+/** Returns whether it is time to save a checkpoint. Called after every operation, @a index is the number
+ * of operations done so far.
+ */
+
+int checkpoint_due(int64_t index) {
+	struct timeval now;
+
+	if ( ! checkpoint_file[0] || index % CHECKPOINT_CHECK_EVERY != 0) {
+		return 0;
+	}
+	gettimeofday(&now, NULL);
+	return (now.tv_sec - checkpoint_last.tv_sec) + (now.tv_usec - checkpoint_last.tv_usec) / 1000000.0 >= checkpoint_interval;
+}
+
+/** Returns index of object @a ptr, or -1 if it was not seen yet. */
+static inline void ckpt_make_key(ckpt_key_t * key, void * ptr) {
+	key->hash = (key_t) (((uintptr_t) ptr >> 4) & 0x7fffffff);
+	key->ptr = ptr;
+}
+
+static int32_t ckpt_find(void * ptr) {
+	ckpt_key_t key;
+	item_t * item;
+
+	ckpt_make_key(&key, ptr);
+	if ( (item = hash_table_find(&ckpt_ptrs, (key_t *) &key)) == NULL) {
+		return -1;
+	}
+	return hash_table_entry(item, ckpt_ptr_t, item)->idx;
+}
+
+static void ckpt_add(void * ptr, int32_t idx) {
+	ckpt_ptr_t * cp = malloc(sizeof(ckpt_ptr_t));
+
+	item_init(&cp->item);
+	ckpt_make_key(&cp->key, ptr);
+	cp->idx = idx;
+	hash_table_insert(&ckpt_ptrs, (key_t *) &cp->key, &cp->item);
+}
+
+/** Makes sure all the arrays can hold one more object. */
+static void ckpt_grow() {
+	int64_t used = ckpt_hdr.processes;
+
+	if (ckpt_hdr.tables > used) used = ckpt_hdr.tables;
+	if (ckpt_hdr.maps > used) used = ckpt_hdr.maps;
+	if (ckpt_hdr.entries > used) used = ckpt_hdr.entries;
+	if (used < ckpt_size) {
+		return;
+	}
+	ckpt_size = ckpt_size ? 2 * ckpt_size : 256;
+	ckpt_processes = realloc(ckpt_processes, ckpt_size * sizeof(checkpoint_process_t));
+	ckpt_entries = realloc(ckpt_entries, ckpt_size * sizeof(checkpoint_entry_t));
+	ckpt_maps = realloc(ckpt_maps, ckpt_size * sizeof(fd_map_t *));
+	ckpt_tables = realloc(ckpt_tables, ckpt_size * sizeof(hash_table_t *));
+}
+
+static void ckpt_collect_process(item_t * item) {
+	process_hash_item_t * p_item = hash_table_entry(item, process_hash_item_t, item);
+	int32_t idx;
+
+	ckpt_grow();
+	if ( (idx = ckpt_find(p_item->ht)) == -1) {
+		idx = ckpt_hdr.tables++;
+		ckpt_tables[idx] = p_item->ht;
+		ckpt_add(p_item->ht, idx);
+	}
+	ckpt_processes[ckpt_hdr.processes].pid = p_item->pid;
+	ckpt_processes[ckpt_hdr.processes].table = idx;
+	ckpt_hdr.processes++;
+}
+
+static void ckpt_collect_fd(item_t * item) {
+	fd_item_t * fd_item = hash_table_entry(item, fd_item_t, item);
+	checkpoint_entry_t * entry;
+	int32_t idx;
+
+	ckpt_grow();
+	if ( (idx = ckpt_find(fd_item->fd_map)) == -1) {
+		idx = ckpt_hdr.maps++;
+		ckpt_maps[idx] = fd_item->fd_map;
+		ckpt_add(fd_item->fd_map, idx);
+	}
+	entry = &ckpt_entries[ckpt_hdr.entries++];
+	entry->table = ckpt_cur_table;
+	entry->old_fd = fd_item->old_fd;
+	entry->cloexec = fd_item->cloexec;
+	entry->map = idx;
+}
+
+/** Saves a checkpoint.
+ *
+ * @arg index number of operations of the trace done so far
+ * @arg last_orig original time of the last operation done
+ * @return 0 on success, non-zero otherwise
+ */
+
+int checkpoint_save(int64_t index, uint64_t last_orig) {
+	char tmpname[MAX_STRING + 4];
+	FILE * f;
+	int32_t i;
+	int retval = 0;
+
+	memset(&ckpt_hdr, 0, sizeof(ckpt_hdr));
+	strcpy(ckpt_hdr.magic, CHECKPOINT_MAGIC);
+	ckpt_hdr.index = index;
+	ckpt_hdr.last_orig = last_orig;
+	ckpt_hdr.parent_pid = global_parent_pid;
+	ckpt_hdr.next_pipe_fd = next_pipe_fd;
+	ckpt_hdr.next_socket_fd = next_socket_fd;
+
+	hash_table_init(&ckpt_ptrs, HASH_TABLE_SIZE, &ht_ops_ckpt);
+	hash_table_apply(fd_mappings, ckpt_collect_process);
+	for (ckpt_cur_table = 0; ckpt_cur_table < ckpt_hdr.tables; ckpt_cur_table++) {
+		hash_table_apply(ckpt_tables[ckpt_cur_table], ckpt_collect_fd);
+	}
+	hash_table_destroy(&ckpt_ptrs);
+
+	snprintf(tmpname, sizeof(tmpname), "%s.tmp", checkpoint_file);
+	if ( (f = fopen(tmpname, "w")) == NULL) {
+		ERRORPRINTF("Cannot open checkpoint file %s: %s\n", tmpname, strerror(errno));
+		return -1;
+	}
+	if (fwrite(&ckpt_hdr, sizeof(ckpt_hdr), 1, f) != 1 ||
+			fwrite(ckpt_processes, sizeof(checkpoint_process_t), ckpt_hdr.processes, f) != ckpt_hdr.processes ||
+			fwrite(ckpt_entries, sizeof(checkpoint_entry_t), ckpt_hdr.entries, f) != ckpt_hdr.entries) {
+		retval = -1;
+	}
+	for (i = 0; i < ckpt_hdr.maps && retval == 0; i++) {
+		fd_map_t fd_map = *ckpt_maps[i];
+		int32_t flags = -1;
+		off_t pos;
+
+		//the real fd may be shared by fd maps of several processes (after clone), so save its real position
+		if (fd_map.type == S_IFREG && (pos = lseek(fd_map.my_fd, 0, SEEK_CUR)) != -1) {
+			fd_map.cur_pos = pos;
+		}
+		if (fd_map.type == S_IFREG || fd_map.type == S_IFDIR) {
+			flags = fcntl(fd_map.my_fd, F_GETFL);
+		}
+		if (fwrite(&fd_map, sizeof(fd_map_t), 1, f) != 1 || fwrite(&flags, sizeof(flags), 1, f) != 1) {
+			retval = -1;
+		}
+	}
+	if (fclose(f) != 0 || retval != 0) {
+		ERRORPRINTF("Error writing checkpoint file %s: %s\n", tmpname, strerror(errno));
+		unlink(tmpname);
+		return -1;
+	}
+	if (rename(tmpname, checkpoint_file) == -1) {
+		ERRORPRINTF("Cannot rename checkpoint file %s: %s\n", tmpname, strerror(errno));
+		return -1;
+	}
+	gettimeofday(&checkpoint_last, NULL);
+	checkpoint_count++;
+	DEBUGPRINTF("Checkpoint %"PRIi64" saved after %"PRIi64" operations: %d processes, %d fd maps\n", checkpoint_count,
+			index, ckpt_hdr.processes, ckpt_hdr.maps);
+	return 0;
+}
+
+/** Finds fd of an already reopened file. @a fds holds pairs of the old and the new fd. */
+static int32_t ckpt_reopened(int32_t * fds, int32_t count, int32_t old_fd) {
+	int32_t i;
+
+	for (i = 0; i < count; i++) {
+		if (fds[2*i] == old_fd) {
+			return fds[2*i+1];
+		}
+	}
+	return -1;
+}
+
+/** Reopens file of @a fd_map and seeks to its recorded position.
+ *
+ * @arg saved file status flags of the fd when the checkpoint was saved (O_APPEND...), -1 if unknown
+ * @return the new fd, or -1 on error
+ */
+
+static int32_t ckpt_reopen(fd_map_t * fd_map, int32_t saved) {
+	int flags = fd_map->type == S_IFDIR ? O_RDONLY | O_DIRECTORY : O_RDWR;
+	int fd;
+
+	if (saved != -1) {
+		flags = (saved & ~(O_CREAT | O_EXCL | O_TRUNC)) | (fd_map->type == S_IFDIR ? O_DIRECTORY : 0);
+	}
+	if (fd_map->direct) {
+		flags |= O_DIRECT;
+	}
+	fd = open(fd_map->name, flags);
+	if (fd == -1 && fd_map->type != S_IFDIR && (errno == EACCES || errno == EROFS || errno == EPERM)) {
+		flags = (flags & ~O_RDWR) | O_RDONLY;
+		if ( (fd = open(fd_map->name, flags)) == -1 ) {
+			flags = (flags & ~O_RDONLY) | O_WRONLY;
+			fd = open(fd_map->name, flags);
+		}
+	}
+	if (fd == -1) {
+		ERRORPRINTF("Cannot reopen file %s: %s\n", fd_map->name, strerror(errno));
+		return -1;
+	}
+	if (fd_map->type == S_IFREG && lseek(fd, fd_map->cur_pos, SEEK_SET) == -1) {
+		ERRORPRINTF("Cannot seek in file %s to %"PRIu64": %s\n", fd_map->name, fd_map->cur_pos, strerror(errno));
+	}
+	return fd;
+}
+
+/** Replaces fd mapping state created by replicate_init() by the state from the checkpoint.
+ *
+ * @arg filename the checkpoint file
+ * @arg index number of operations done before the checkpoint was saved
+ * @arg last_orig original time of the last operation done
+ * @return 0 on success, non-zero otherwise
+ */
+
+int checkpoint_restore(const char * filename, int64_t * index, uint64_t * last_orig) {
+	FILE * f;
+	checkpoint_header_t hdr;
+	checkpoint_process_t * processes = NULL;
+	checkpoint_entry_t * entries = NULL;
+	fd_map_t ** maps = NULL;
+	hash_table_t ** tables = NULL;
+	int32_t * fds = NULL; ///< pairs of old and new fds of reopened files
+	int32_t * flags = NULL; ///< file status flags of the fd of each map
+	int32_t nfds = 0, failed = 0;
+	int32_t i;
+	int64_t e;
+	hash_table_t * ht;
+	process_hash_item_t * p_item;
+	fd_item_t * fd_item;
+	int retval = -1;
+
+	if ( (f = fopen(filename, "r")) == NULL) {
+		ERRORPRINTF("Cannot open checkpoint file %s: %s\n", filename, strerror(errno));
+		return -1;
+	}
+	if (fread(&hdr, sizeof(hdr), 1, f) != 1 || strncmp(hdr.magic, CHECKPOINT_MAGIC, sizeof(hdr.magic))) {
+		ERRORPRINTF("File %s is not a checkpoint file.\n", filename);
+		fclose(f);
+		return -1;
+	}
+	processes = malloc(hdr.processes * sizeof(checkpoint_process_t) + 1);
+	entries = malloc(hdr.entries * sizeof(checkpoint_entry_t) + 1);
+	maps = calloc(hdr.maps + 1, sizeof(fd_map_t *));
+	tables = calloc(hdr.tables + 1, sizeof(hash_table_t *));
+	fds = malloc((hdr.maps + 1) * 2 * sizeof(int32_t));
+	flags = malloc((hdr.maps + 1) * sizeof(int32_t));
+	if (fread(processes, sizeof(checkpoint_process_t), hdr.processes, f) != hdr.processes ||
+			fread(entries, sizeof(checkpoint_entry_t), hdr.entries, f) != hdr.entries) {
+		ERRORPRINTF("Checkpoint file %s is truncated.\n", filename);
+		goto out;
+	}
+	for (i = 0; i < hdr.maps; i++) {
+		maps[i] = malloc(sizeof(fd_map_t));
+		fdmap_mem_add(sizeof(fd_map_t));
+		if (fread(maps[i], sizeof(fd_map_t), 1, f) != 1 || fread(&flags[i], sizeof(int32_t), 1, f) != 1) {
+			ERRORPRINTF("Checkpoint file %s is truncated.\n", filename);
+			goto out;
+		}
+	}
+
+	//throw away the state made by replicate_init()
+	if ( (ht = get_process_ht(fd_mappings, global_parent_pid)) != NULL) {
+		hash_table_apply(ht, fd_item_remove_fd_map);
+		delete_process_table(ht);
+		delete_process_ht(fd_mappings, global_parent_pid);
+	}
+	hash_table_destroy(usage_map);
+	hash_table_init(usage_map, HASH_TABLE_SIZE, usage_map->op);
+	global_parent_pid = hdr.parent_pid;
+	next_pipe_fd = hdr.next_pipe_fd;
+	next_socket_fd = hdr.next_socket_fd;
+
+	for (i = 0; i < hdr.maps; i++) {
+		if (maps[i]->channel) { //data in the channel is lost, go on with a placeholder
+			maps[i]->channel = 0;
+			maps[i]->my_fd = maps[i]->type == S_IFSOCK ? --next_socket_fd : --next_pipe_fd;
+		}
+		if (maps[i]->type != S_IFREG && maps[i]->type != S_IFDIR) {
+			continue; //std streams and placeholders
+		}
+		int32_t fd = ckpt_reopened(fds, nfds, maps[i]->my_fd);
+		if (fd == -1) {
+			if ( (fd = ckpt_reopen(maps[i], flags[i])) == -1) {
+				failed++;
+			}
+			fds[2*nfds] = maps[i]->my_fd;
+			fds[2*nfds+1] = fd;
+			nfds++;
+		}
+		maps[i]->my_fd = fd;
+	}
+
+	for (i = 0; i < hdr.processes; i++) {
+		item_t * item = new_process_ht(processes[i].pid);
+		p_item = hash_table_entry(item, process_hash_item_t, item);
+		if (tables[processes[i].table] == NULL) {
+			tables[processes[i].table] = p_item->ht;
+		} else { //the table is shared (CLONE_FILES)
+			delete_process_table(p_item->ht);
+			p_item->ht = tables[processes[i].table];
+		}
+		hash_table_insert(fd_mappings, &p_item->pid, &p_item->item);
+	}
+
+	for (e = 0; e < hdr.entries; e++) {
+		fd_item = new_fd_item();
+		delete_fd_map(fd_item->fd_map);
+		fd_item->fd_map = maps[entries[e].map];
+		fd_item->old_fd = entries[e].old_fd;
+		fd_item->cloexec = entries[e].cloexec;
+		hash_table_insert(tables[entries[e].table], &fd_item->old_fd, &fd_item->item);
+		increase_fd_usage(usage_map, fd_item->fd_map->my_fd);
+	}
+
+	*index = hdr.index;
+	*last_orig = hdr.last_orig;
+	fprintf(stderr, "Resuming from checkpoint %s after %"PRIi64" operations: %d processes, %d fd maps, %d files reopened, %d failed\n",
+			filename, hdr.index, hdr.processes, hdr.maps, nfds - failed, failed);
+	retval = 0;
+
+out:
+	fclose(f);
+	free(processes);
+	free(entries);
+	free(maps);
+	free(tables);
+	free(fds);
+	free(flags);
+	return retval;
+}
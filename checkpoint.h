@@ -0,0 +1,80 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _CHECKPOINT_H_
+#define _CHECKPOINT_H_
+
+/** @file checkpoint.h
+ *
+ * Periodically saves position of the replay and all fd mapping state (fd_mappings, usage_map), so a long replay
+ * which was interrupted can continue from the last checkpoint instead of the start of the trace.
+ *
+ * The checkpoint file holds a header, list of processes with indexes of their fd tables (tables shared 
+ * by CLONE_FILES have the same index), entries of every table (old fd, cloexec and index of fd map) and the fd maps 
+ * themselves, each followed by the file status flags of its fd. It is written to a temporary file which is then 
+ * renamed, so a crash never leaves a broken checkpoint.
+ *
+ * When resuming, regular files and directories are reopened under their mapped names with the saved status flags 
+ * (O_APPEND, O_DIRECT...) and regular files are seeked to their recorded cur_pos, which is the real position of 
+ * the fd when the checkpoint was saved. Fds shared by several fd maps (after clone) stay shared. Placeholder fds 
+ * of pipes, sockets and ignored files are restored as they were, real pipe channels (PIPE_CHANNELS) become 
+ * placeholders. Memory mappings are not restored.
+ */
+
+#include <stdint.h>
+#include "common.h"
+
+#define CHECKPOINT_MAGIC "IOCKPT2" ///< 8 bytes including the terminating zero
+#define CHECKPOINT_DEFAULT_INTERVAL 60 ///< seconds between checkpoints
+#define CHECKPOINT_CHECK_EVERY 1024 ///< time is checked every n-th operation
+
+typedef struct checkpoint_header {
+	char magic[8];
+	int64_t index; ///< number of operations of the trace done
+	uint64_t last_orig; ///< original time of the last operation done, in usec
+	int32_t parent_pid;
+	int32_t next_pipe_fd; ///< next placeholder fd for pipes
+	int32_t next_socket_fd; ///< next placeholder fd for sockets
+	int32_t processes;
+	int32_t tables;
+	int32_t maps;
+	int64_t entries;
+} checkpoint_header_t;
+
+typedef struct checkpoint_process {
+	int32_t pid;
+	int32_t table; ///< index of the fd table
+} checkpoint_process_t;
+
+typedef struct checkpoint_entry {
+	int32_t table; ///< index of the fd table
+	int32_t old_fd;
+	int32_t cloexec;
+	int32_t map; ///< index of the fd map
+} checkpoint_entry_t;
+
+void checkpoint_init(const char * filename, double interval);
+int checkpoint_enabled();
+int checkpoint_due(int64_t index);
+int checkpoint_save(int64_t index, uint64_t last_orig);
+int checkpoint_restore(const char * filename, int64_t * index, uint64_t * last_orig);
+void checkpoint_set_resume(const char * filename);
+const char * checkpoint_get_resume();
+
+#endif
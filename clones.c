@@ -0,0 +1,169 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <sys/time.h>
+
+#include "common.h"
+#include "clones.h"
+#include "namemap.h"
+#include "replicate.h"
+
+#define TIMEVAL_DIFF(t1, t2) (((uint64_t)(t1.tv_sec) * 1000000 + (uint64_t)(t1.tv_usec)) - ((uint64_t)(t2.tv_sec) * 1000000 + (uint64_t)(t2.tv_usec)))
+
+int clones_index = 0; ///< index of the clone this process replays, 0 if clones are not used
+int clones_num = 1;
+char clones_prefix[MAX_STRING] = CLONES_DEFAULT_PREFIX;
+double clones_offset = 0; ///< start of clone k is delayed by k * clones_offset seconds
+double clones_jitter = 0; ///< and by random time up to clones_jitter seconds
+
+/** Sets up clones.
+ *
+ * @arg count number of clones, 1 to disable them
+ * @arg prefix file names of clone k are prefixed by "<prefix><k>", NULL for the default
+ * @arg offset delay between starts of two consecutive clones in seconds
+ * @arg jitter maximum random delay of a start of every clone in seconds
+ */
+
+void clones_init(int count, const char * prefix, double offset, double jitter) {
+	clones_num = count > 1 ? count : 1;
+	if (prefix) {
+		strncpy(clones_prefix, prefix, MAX_STRING);
+		clones_prefix[MAX_STRING-1] = 0;
+	}
+	clones_offset = offset;
+	clones_jitter = jitter;
+}
+
+int clones_count() {
+	return clones_num;
+}
+
+static void clones_report(replay_stats_t * stats, int * failed, double wall) {
+	replay_stats_t total;
+	int i, nfailed = 0;
+
+	memset(&total, 0, sizeof(total));
+	for (i = 0; i < clones_num; i++) {
+		printf("Clone %d: %s, %lfs, %"PRIi64" calls, %"PRIi64" bytes\n", i, failed[i] ? "failed" : "ok",
+				stats[i].duration, stats[i].io_calls, stats[i].io_bytes);
+		nfailed += failed[i];
+		replay_stats_merge(&total, &stats[i]);
+	}
+
+	printf("Clones: %d, %d failed, all finished in %lfs\n", clones_num, nfailed, wall);
+	printf("Combined throughput: %.1lf IOPS, %.3lf MB/s\n", wall > 0 ? total.io_calls / wall : 0.0, 
+			wall > 0 ? total.io_bytes / wall / (1024 * 1024) : 0.0);
+	printf("Combined latency: mean %.1lfus, p50 < %.1lfus, p99 < %.1lfus, max %.1lfus\n",
+			total.io_calls ? total.io_time / 1000.0 / total.io_calls : 0.0,
+			replay_stats_percentile(&total, 0.5) / 1000.0, replay_stats_percentile(&total, 0.99) / 1000.0, total.io_max / 1000.0);
+}
+
+/** Runs @a fn in every clone. Without clones, @a fn is just called.
+ *
+ * @arg fn function doing the work in a clone, returns zero on success
+ * @arg arg argument passed to @a fn
+ * @arg concurrent whether to run clones at once (replay) with the start delays and the final report, or one 
+ *      after another (e.g. to prepare files of all clones)
+ * @return 0 if @a fn succeeded in all clones, non-zero otherwise
+ */
+
+int clones_run(int (* fn)(void * arg), void * arg, int concurrent) {
+	replay_stats_t * stats;
+	int * failed;
+	pid_t * pids;
+	struct timeval start, end;
+	char prefix[MAX_STRING];
+	int i, status, retval = 0;
+	double delay;
+
+	if (clones_num == 1) {
+		clones_index = 0;
+		return fn(arg);
+	}
+
+	stats = mmap(NULL, clones_num * sizeof(replay_stats_t), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (stats == MAP_FAILED) {
+		ERRORPRINTF("Cannot allocate shared memory for clone statistics: %s\n", strerror(errno));
+		return -1;
+	}
+	memset(stats, 0, clones_num * sizeof(replay_stats_t));
+	failed = calloc(clones_num, sizeof(int));
+	pids = calloc(clones_num, sizeof(pid_t));
+
+	fflush(stdout);
+	fflush(stderr);
+	gettimeofday(&start, NULL);
+	for (i = 0; i < clones_num; i++) {
+		delay = clones_offset * i + clones_jitter * (random() / (RAND_MAX + 1.0));
+		pids[i] = fork();
+		if (pids[i] == -1) {
+			ERRORPRINTF("Cannot fork clone %d: %s\n", i, strerror(errno));
+			failed[i] = 1;
+			continue;
+		} else if (pids[i] == 0) {
+			clones_index = i;
+			if (snprintf(prefix, MAX_STRING, "%s%d", clones_prefix, i) >= MAX_STRING) {
+				ERRORPRINTF("Prefix %s of clone %d is too long.\n", clones_prefix, i);
+				_exit(1);
+			}
+			namemap_set_prefix(prefix);
+			srandom(getpid());
+			if (concurrent) {
+				global_quiet = 1;
+				if (delay > 0) {
+					usleep(delay * 1000000);
+				}
+			}
+			retval = fn(arg);
+			stats[i] = replay_stats;
+			fflush(stdout);
+			_exit(retval ? 1 : 0);
+		}
+		if ( ! concurrent ) {
+			waitpid(pids[i], &status, 0);
+			failed[i] = ! WIFEXITED(status) || WEXITSTATUS(status) != 0;
+			pids[i] = -1;
+		}
+	}
+	for (i = 0; i < clones_num; i++) {
+		if (pids[i] > 0) {
+			waitpid(pids[i], &status, 0);
+			failed[i] = ! WIFEXITED(status) || WEXITSTATUS(status) != 0;
+		}
+		retval |= failed[i];
+	}
+	gettimeofday(&end, NULL);
+
+	if (concurrent) {
+		clones_report(stats, failed, TIMEVAL_DIFF(end, start) / 1000000.0);
+	}
+
+	munmap(stats, clones_num * sizeof(replay_stats_t));
+	free(failed);
+	free(pids);
+	return retval;
+}
@@ -0,0 +1,42 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _CLONES_H_
+#define _CLONES_H_
+
+/** @file clones.h
+ *
+ * Runs several isolated copies (clones) of one loaded trace at once, to see what many instances of the same 
+ * application do to a shared storage.
+ *
+ * Every clone is a child process forked after the trace is loaded, so the trace memory is shared (copy on write).
+ * Clone number k uses prefix "<prefix><k>" for all its file names (see namemap_set_prefix()), and its start may
+ * be delayed by k times the offset plus a random jitter. When all clones finish, statistics of their reads and
+ * writes (replay_stats_t) are merged into one report.
+ */
+
+#define CLONES_DEFAULT_PREFIX "clone"
+
+extern int clones_index;
+
+void clones_init(int count, const char * prefix, double offset, double jitter);
+int clones_count();
+int clones_run(int (* fn)(void * arg), void * arg, int concurrent);
+
+#endif
@@ -0,0 +1,340 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "common.h"
+#include "coalesce.h"
+
+int64_t coalesce_target = 0; ///< size of merged calls, 0 = no coalescing
+int64_t coalesce_window = COALESCE_WINDOW;
+int64_t coalesce_split = 0; ///< size of split calls, 0 = no splitting
+hash_table_t coalesce_pids;
+
+static int ht_compare_coalesce(key_t *key, item_t *item) {
+	return hash_table_entry(item, coalesce_pid_t, item)->pid == *key;
+}
+
+static void ht_remove_callback_coalesce(item_t * item) {
+	coalesce_pid_t * cp = hash_table_entry(item, coalesce_pid_t, item);
+
+	free(cp->runs);
+	free(cp);
+}
+
+static hash_table_operations_t ht_ops_coalesce = {
+	.hash = ht_hash_int,
+	.compare = ht_compare_coalesce,
+	.remove_callback = ht_remove_callback_coalesce
+};
+
+/** Parses size with an optional K, M or G suffix (powers of 1024).
+ *
+ * @return the size, -1 on error
+ */
+
+static int64_t coalesce_parse_size(const char * str, char ** end) {
+	double size = strtod(str, end);
+
+	if (*end == str) {
+		return -1;
+	}
+	switch (**end) {
+		case 'G': case 'g':
+			size *= 1024;
+		case 'M': case 'm':
+			size *= 1024;
+		case 'K': case 'k':
+			size *= 1024;
+			(*end)++;
+			break;
+	}
+	return size >= 1 ? (int64_t) size : -1;
+}
+
+/** Enables coalescing.
+ *
+ * @arg spec <size>[:<window>], where <size> is the target size of merged calls (K, M and G suffixes are
+ *           accepted) and <window> is the longest time (us, ms or s, usec by default) between the first and
+ *           the last call of a run
+ * @return 0 on success, -1 on error
+ */
+
+int coalesce_init(const char * spec) {
+	char * end;
+	double window;
+
+	if ( (coalesce_target = coalesce_parse_size(spec, &end)) < 0) {
+		return -1;
+	}
+	if (*end == ':') {
+		spec = end + 1;
+		window = strtod(spec, &end);
+		if (end == spec || window < 0) {
+			return -1;
+		}
+		if ( ! strcmp(end, "ms")) {
+			window *= 1000;
+		} else if ( ! strcmp(end, "s")) {
+			window *= 1000000;
+		} else if (*end && strcmp(end, "us")) {
+			return -1;
+		}
+		coalesce_window = window;
+	} else if (*end) {
+		return -1;
+	}
+	return 0;
+}
+
+/** Enables splitting of calls bigger than @a spec (K, M and G suffixes are accepted).
+ *
+ * @return 0 on success, -1 on error
+ */
+
+int coalesce_split_init(const char * spec) {
+	char * end;
+
+	if ( (coalesce_split = coalesce_parse_size(spec, &end)) < 0 || *end) {
+		return -1;
+	}
+	return 0;
+}
+
+int coalesce_enabled() {
+	return coalesce_target > 0 || coalesce_split > 0;
+}
+
+/** Fills @a rw with fields of @a com_it.
+ *
+ * @return 0 if @a com_it is a read or write, -1 otherwise
+ */
+
+static int coalesce_get_rw(common_op_item_t * com_it, coalesce_rw_t * rw) {
+	switch (com_it->type) {
+		case OP_READ:
+		case OP_WRITE: //read_op_t and write_op_t are the same
+			rw->fd = ((read_item_t *) com_it)->o.fd;
+			rw->size = &((read_item_t *) com_it)->o.size;
+			rw->offset = NULL;
+			rw->retval = &((read_item_t *) com_it)->o.retval;
+			rw->info = &((read_item_t *) com_it)->o.info;
+			return 0;
+		case OP_PREAD:
+		case OP_PWRITE: //pread_op_t and pwrite_op_t are the same
+			rw->fd = ((pread_item_t *) com_it)->o.fd;
+			rw->size = &((pread_item_t *) com_it)->o.size;
+			rw->offset = &((pread_item_t *) com_it)->o.offset;
+			rw->retval = &((pread_item_t *) com_it)->o.retval;
+			rw->info = &((pread_item_t *) com_it)->o.info;
+			return 0;
+		default:
+			return -1;
+	}
+}
+
+static coalesce_pid_t * coalesce_get_pid(int32_t pid) {
+	coalesce_pid_t * cp;
+	item_t * item;
+	key_t key = pid;
+
+	if ( (item = hash_table_find(&coalesce_pids, &key)) != NULL) {
+		return hash_table_entry(item, coalesce_pid_t, item);
+	}
+	cp = calloc(1, sizeof(coalesce_pid_t));
+	item_init(&cp->item);
+	cp->pid = pid;
+	hash_table_insert(&coalesce_pids, &cp->pid, &cp->item);
+	return cp;
+}
+
+static inline int64_t coalesce_usec(struct int32timeval t) {
+	return (int64_t) t.tv_sec * 1000000 + t.tv_usec;
+}
+
+/** Merges sequential calls of @a list.
+ *
+ * @return number of calls removed
+ */
+
+static int64_t coalesce_merge(list_t * list) {
+	common_op_item_t * com_it;
+	coalesce_rw_t rw, head;
+	coalesce_pid_t * cp;
+	coalesce_run_t * run;
+	item_t * item, * next, * pid_item;
+	op_info_t * info;
+	int64_t removed = 0, start;
+	int32_t fd;
+	key_t key;
+
+	hash_table_init(&coalesce_pids, COALESCE_HT_SIZE, &ht_ops_coalesce);
+	for (item = list->head; item; item = next) {
+		next = item->next;
+		com_it = list_entry(item, common_op_item_t, item);
+		if (coalesce_get_rw(com_it, &rw) != 0) {
+			//any other call of the process ends all its runs
+			if ( (info = get_item_info(com_it)) == NULL) {
+				continue;
+			}
+			key = info->pid;
+			if ( (pid_item = hash_table_find(&coalesce_pids, &key)) != NULL) {
+				cp = hash_table_entry(pid_item, coalesce_pid_t, item);
+				memset(cp->runs, 0, cp->size * sizeof(coalesce_run_t));
+			}
+			continue;
+		}
+		if (rw.fd < 0 || *rw.retval <= 0) {
+			continue;
+		}
+		cp = coalesce_get_pid(rw.info->pid);
+		if (rw.fd >= cp->size) {
+			fd = cp->size;
+			cp->size = rw.fd + 16;
+			cp->runs = realloc(cp->runs, cp->size * sizeof(coalesce_run_t));
+			memset(cp->runs + fd, 0, (cp->size - fd) * sizeof(coalesce_run_t));
+		}
+		run = &cp->runs[rw.fd];
+		start = coalesce_usec(rw.info->start);
+		if (run->head && run->head->type == com_it->type && start - run->start <= coalesce_window
+				&& run->bytes + *rw.retval <= coalesce_target && ( ! rw.offset || *rw.offset == run->next)
+				&& coalesce_get_rw(run->head, &head) == 0) {
+			*head.size += *rw.size;
+			*head.retval += *rw.retval;
+			head.info->dur += rw.info->dur;
+			run->bytes += *rw.retval;
+			run->next += *rw.retval;
+			if (*rw.retval < *rw.size) { //EOF or full disk
+				run->head = NULL;
+			}
+			list_remove(list, item);
+			free(com_it);
+			removed++;
+			continue;
+		}
+		run->head = NULL;
+		if (*rw.retval == *rw.size && *rw.retval < coalesce_target) {
+			run->head = com_it;
+			run->start = start;
+			run->bytes = *rw.retval;
+			run->next = rw.offset ? *rw.offset + *rw.retval : 0;
+		}
+	}
+	hash_table_destroy(&coalesce_pids);
+	return removed;
+}
+
+/** @return copy of @a com_it */
+
+static common_op_item_t * coalesce_copy(common_op_item_t * com_it) {
+	common_op_item_t * copy;
+	size_t size;
+
+	switch (com_it->type) {
+		case OP_READ:
+			size = sizeof(read_item_t);
+			break;
+		case OP_WRITE:
+			size = sizeof(write_item_t);
+			break;
+		case OP_PREAD:
+			size = sizeof(pread_item_t);
+			break;
+		default:
+			size = sizeof(pwrite_item_t);
+			break;
+	}
+	copy = malloc(size);
+	memcpy(copy, com_it, size);
+	item_init(&copy->item);
+	return copy;
+}
+
+/** Splits calls of @a list bigger than the split size.
+ *
+ * @return number of calls added
+ */
+
+static int64_t coalesce_split_calls(list_t * list) {
+	common_op_item_t * com_it, * piece;
+	coalesce_rw_t rw, prw;
+	item_t * item, * next;
+	int64_t added = 0, size, retval, start, dur, done, n, i;
+
+	for (item = list->head; item; item = next) {
+		next = item->next;
+		com_it = list_entry(item, common_op_item_t, item);
+		if (coalesce_get_rw(com_it, &rw) != 0 || *rw.retval <= coalesce_split) {
+			continue;
+		}
+		size = *rw.size;
+		retval = *rw.retval;
+		start = coalesce_usec(rw.info->start);
+		dur = rw.info->dur;
+		n = (retval + coalesce_split - 1) / coalesce_split;
+		//the original call becomes the first piece, the others follow it
+		*rw.size = *rw.retval = coalesce_split;
+		rw.info->dur = dur / n;
+		for (i = 1, done = coalesce_split; i < n; i++, done += coalesce_split) {
+			piece = coalesce_copy(com_it);
+			if (coalesce_get_rw(piece, &prw) != 0) {
+				free(piece);
+				break;
+			}
+			*prw.retval = retval - done < coalesce_split ? retval - done : coalesce_split;
+			*prw.size = i == n - 1 ? size - done : *prw.retval;
+			if (prw.offset) {
+				*prw.offset += done;
+			}
+			prw.info->start.tv_sec = (start + dur * i / n) / 1000000;
+			prw.info->start.tv_usec = (start + dur * i / n) % 1000000;
+			prw.info->dur = dur * (i + 1) / n - dur * i / n;
+			list_insert_after(item, &piece->item);
+			item = &piece->item;
+			added++;
+		}
+	}
+	return added;
+}
+
+/** Coalesces and splits calls of @a list, as enabled by coalesce_init() and coalesce_split_init().
+ *
+ * @return change of the number of calls
+ */
+
+int64_t coalesce_apply(list_t * list) {
+	int64_t removed = 0, added = 0;
+
+	if (coalesce_target > 0) {
+		removed = coalesce_merge(list);
+	}
+	if (coalesce_split > 0) {
+		added = coalesce_split_calls(list);
+	}
+	DEBUGPRINTF("%"PRIi64" calls merged into others, %"PRIi64" calls added by splitting\n", removed, added);
+	return added - removed;
+}
+
+void coalesce_finish() {
+	coalesce_target = coalesce_split = 0;
+	coalesce_window = COALESCE_WINDOW;
+}
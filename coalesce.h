@@ -0,0 +1,78 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _COALESCE_H_
+#define _COALESCE_H_
+
+/** @file coalesce.h
+ *
+ * Changes sizes of reads and writes of the trace when converting, to see what bigger or smaller application
+ * buffers would give by replaying both versions.
+ *
+ * Coalescing merges runs of sequential calls of one process on one descriptor into one call of up to the target
+ * size: read and write calls following each other on the descriptor, pread and pwrite calls whose offset is the
+ * end of the previous one. The merged call is issued at the start of the first one, lasts for the sum of their
+ * durations and transfers the sum of their bytes. Runs end when the target size would be exceeded, when a call
+ * starts more than the window after the first one of the run, after a short read or write, and on any other call
+ * of the process (lseek, close, open, clone, ...), so no call is moved over anything it may depend on. Calls of
+ * the process on other descriptors do not end the run.
+ *
+ * Splitting does the reverse: every read or write of more than the split size is replaced by calls of the split
+ * size issued one after another within the duration of the original call.
+ */
+
+#include <stdint.h>
+#include "common.h"
+#include "in_common.h"
+#include "adt/hash_table.h"
+
+#define COALESCE_WINDOW 10000 ///< default window in usec
+#define COALESCE_HT_SIZE 1024
+
+/** Run of calls being merged into @a head. */
+typedef struct coalesce_run {
+	common_op_item_t * head; ///< NULL if there is no run
+	int64_t start; ///< start of the head in usec
+	int64_t bytes;
+	int64_t next; ///< offset the next pread or pwrite has to start at
+} coalesce_run_t;
+
+typedef struct coalesce_pid {
+	item_t item;
+	key_t pid;
+	coalesce_run_t * runs; ///< indexed by descriptor
+	int32_t size;
+} coalesce_pid_t;
+
+/** Pointers to fields of any read or write call. */
+typedef struct coalesce_rw {
+	int32_t fd;
+	int64_t * size;
+	int64_t * offset; ///< NULL for read and write
+	int64_t * retval;
+	op_info_t * info;
+} coalesce_rw_t;
+
+int coalesce_init(const char * spec);
+int coalesce_split_init(const char * spec);
+int coalesce_enabled();
+int64_t coalesce_apply(list_t * list);
+void coalesce_finish();
+
+#endif
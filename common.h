@@ -86,6 +86,22 @@
 #define OP_STAT 's'
 #define OP_SENDFILE 't'
 #define OP_FCNTL 'f'
+#define OP_RENAME 'n'
+#define OP_LINK 'k'
+#define OP_SYMLINK 'y'
+#define OP_READLINK 'K'
+#define OP_GETDENTS 'g'
+#define OP_MUNMAP 'U'
+#define OP_MSYNC 'Y'
+#define OP_MADVISE 'v'
+#define OP_EXIT 'x'
+#define OP_EXIT_GROUP 'X'
+#define OP_EXECVE 'E'
+#define OP_WAIT 'z'
+#define OP_SOCKETPAIR 'b'
+#define OP_EVENTFD 'h'
+#define OP_EPOLL 'q'
+#define OP_TIMERFD 'j'
 
 // Timing modes
 #define TIME_DIFF  0x80000000 ///< Try to hold the same difference between calls
@@ -106,6 +122,30 @@
 #define ACT_PRINT 0x40
 #define FIX_MISSING 0x80
 
+// Page touching modes for replayed mmap calls
+#define MMAP_TOUCH_SEQ 0x100 ///< touch all pages of a new mapping sequentially
+#define MMAP_TOUCH_SEQ_STR "seq"
+#define MMAP_TOUCH_RANDOM 0x200 ///< touch all pages of a new mapping in random order
+#define MMAP_TOUCH_RANDOM_STR "random"
+#define MMAP_TOUCH_DERIVED 0x400 ///< touch only ranges passed to msync/madvise calls
+#define MMAP_TOUCH_DERIVED_STR "derived"
+#define MMAP_TOUCH_MASK 0x700
+
+#define DIRECT_FORCE 0x800 ///< open all regular files with O_DIRECT
+#define BUF_HUGEPAGES 0x1000 ///< back IO buffers by huge pages
+
+// Page cache control modes applied before replay
+#define CACHE_EVICT 0x2000 ///< evict all files from the page cache
+#define CACHE_EVICT_STR "evict"
+#define CACHE_WARM 0x4000 ///< cache given fraction of every file
+#define CACHE_WARM_STR "warm"
+#define CACHE_LEAVE 0x8000 ///< don't touch the page cache, just measure it
+#define CACHE_LEAVE_STR "leave"
+#define CACHE_MASK 0xE000
+
+#define FILTER_MARK 0x10000 ///< remember operations out of the slice, so they can be removed from the trace
+#define PIPE_CHANNELS 0x20000 ///< replay pipes and socketpairs as real channels carrying the recorded data
+
 /** Our own version of struct timeval structure - the reason for it is to make sure
 	it will be of equal size on both 32 and 64bit platforms. It will overflow in some
    100 years, so we don't have to worry about it. 
@@ -160,7 +200,7 @@ typedef struct pwrite_op {
 typedef struct pipe_op {
 	int32_t fd1;
 	int32_t fd2;	
-	mode_t mode;
+	mode_t mode; ///< flags of pipe2 (O_CLOEXEC, O_NONBLOCK...), O_CLOEXEC for socketpair with SOCK_CLOEXEC
 	int32_t retval;
 	op_info_t info;
 } pipe_op_t;
@@ -256,6 +296,75 @@ typedef struct sendfile_op {
 	op_info_t info;
 } sendfile_op_t;
 
+typedef struct rename_op {
+	char old_name[MAX_STRING];
+	char new_name[MAX_STRING];
+	int32_t retval;
+	op_info_t info;
+} rename_op_t;
+
+/** Used for both link(2) and symlink(2) calls, the type of the item distinguishes them. */
+typedef struct link_op {
+	char old_name[MAX_STRING]; ///< existing file for link(2), target of the symlink for symlink(2)
+	char new_name[MAX_STRING];
+	int32_t retval;
+	op_info_t info;
+} link_op_t;
+
+typedef struct readlink_op {
+	char name[MAX_STRING];
+	int64_t size;
+	int64_t retval;
+	op_info_t info;
+} readlink_op_t;
+
+typedef struct getdents_op {
+	int32_t fd;
+	int64_t size; ///< size of the buffer passed to the call
+	int32_t entries; ///< number of directory entries returned, -1 if not known
+	int64_t retval; ///< number of bytes returned
+	op_info_t info;
+} getdents_op_t;
+
+typedef struct mmap_op {
+	int64_t addr;
+	int64_t length;
+	int32_t prot;
+	int32_t flags;
+	int32_t fd;
+	int64_t offset; ///< offset in bytes (even for mmap2)
+	int64_t retval; ///< address of the mapping or -1
+	op_info_t info;
+} mmap_op_t;
+
+/** Used for munmap(2), msync(2) and madvise(2) calls, the type of the item distinguishes them. */
+typedef struct mem_op {
+	int64_t addr;
+	int64_t length;
+	int32_t flags; ///< MS_* flags for msync, advice for madvise, unused for munmap
+	int32_t retval;
+	op_info_t info;
+} mem_op_t;
+
+/** Used for exit(2) and exit_group(2) calls, the type of the item distinguishes them. Process killed by a signal
+ * is recorded as exit_group. */
+typedef struct exit_op {
+	int32_t status; ///< exit status, -1 if killed by a signal
+	op_info_t info;
+} exit_op_t;
+
+typedef struct execve_op {
+	char name[MAX_STRING];
+	int32_t retval;
+	op_info_t info;
+} execve_op_t;
+
+typedef struct wait_op {
+	int32_t pid; ///< pid argument of the call
+	int32_t retval; ///< pid of the child that was waited for
+	op_info_t info;
+} wait_op_t;
+
 void * attach_sh_mem();
 
 #endif
@@ -0,0 +1,465 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netdb.h>
+
+#include "common.h"
+#include "coord.h"
+
+int coord_fd = -1; ///< connection of the worker to the coordinator, -1 if not connected
+struct timeval coord_last; ///< time of the last tick
+
+static inline double coord_since(struct timeval * t) {
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return (now.tv_sec - t->tv_sec) + (now.tv_usec - t->tv_usec) / 1000000.0;
+}
+
+/** Fills @a sa with @a address: a Unix domain socket if it contains '/', TCP [<host>:]<port> otherwise. The host
+ * is a name or a numeric address, the first address it resolves to is used.
+ *
+ * @return 0 on success, -1 on error
+ */
+
+static int coord_address(const char * address, struct sockaddr_storage * sa, socklen_t * len) {
+	struct sockaddr_un * sun = (struct sockaddr_un *) sa;
+	struct addrinfo hints, * res;
+	char host[MAX_STRING] = "127.0.0.1";
+	const char * port;
+	char * end;
+	long n;
+	int rv;
+
+	memset(sa, 0, sizeof(*sa));
+	if (strchr(address, '/')) {
+		if (strlen(address) >= sizeof(sun->sun_path)) {
+			ERRORPRINTF("Socket path %s is too long\n", address);
+			return -1;
+		}
+		sun->sun_family = AF_UNIX;
+		strcpy(sun->sun_path, address);
+		*len = sizeof(struct sockaddr_un);
+		return 0;
+	}
+	if ( (port = strrchr(address, ':')) != NULL) {
+		if (port - address >= MAX_STRING) {
+			return -1;
+		}
+		if (port > address) {
+			memcpy(host, address, port - address);
+			host[port - address] = 0;
+		}
+		port++;
+	} else {
+		port = address;
+	}
+	n = strtol(port, &end, 10);
+	if (end == port || *end || n < 1 || n > 65535) {
+		ERRORPRINTF("Wrong port of address %s\n", address);
+		return -1;
+	}
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_NUMERICSERV;
+	if ( (rv = getaddrinfo(host, port, &hints, &res)) != 0) {
+		ERRORPRINTF("Cannot resolve host of address %s: %s\n", address, gai_strerror(rv));
+		return -1;
+	}
+	memcpy(sa, res->ai_addr, res->ai_addrlen);
+	*len = res->ai_addrlen;
+	freeaddrinfo(res);
+	return 0;
+}
+
+/** Sends @a line (ending with a newline) to @a fd.
+ *
+ * @return 0 on success, -1 on error
+ */
+
+static int coord_send(int fd, const char * line) {
+	size_t done = 0, len = strlen(line);
+	ssize_t n;
+
+	while (done < len) {
+		if ( (n = send(fd, line + done, len - done, MSG_NOSIGNAL)) < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return -1;
+		}
+		done += n;
+	}
+	return 0;
+}
+
+/** Parses replay_stats_t of done line @a str into @a stats.
+ *
+ * @return 0 on success, -1 on error
+ */
+
+static int coord_parse_stats(char * str, int * status, replay_stats_t * stats) {
+	char * end;
+	int b;
+
+	*status = strtol(str, &end, 10);
+	if (end == str) {
+		return -1;
+	}
+	stats->duration = strtod(str = end, &end);
+	stats->io_calls = strtoll(str = end, &end, 10);
+	stats->io_bytes = strtoll(str = end, &end, 10);
+	stats->io_time = strtoull(str = end, &end, 10);
+	stats->io_max = strtoull(str = end, &end, 10);
+	for (b = 0; b < REPLAY_HIST_BUCKETS && end != str; b++) {
+		stats->hist[b] = strtoll(str = end, &end, 10);
+	}
+	return end == str ? -1 : 0;
+}
+
+/** Handles @a line received from worker @a w. */
+
+static void coord_line(coord_worker_t * w, char * line) {
+	int status, pos = 0;
+
+	if (sscanf(line, "hello %d %d %n", &w->pid, &w->clone, &pos) == 2 && pos > 0) {
+		strncpy(w->name, line + pos, MAX_STRING);
+		w->name[MAX_STRING-1] = 0;
+		w->state = COORD_READY;
+	} else if (sscanf(line, "tick %"SCNi64" %"SCNi64, &w->calls, &w->bytes) == 2) {
+		return;
+	} else if ( ! strncmp(line, "done ", 5) && coord_parse_stats(line + 5, &status, &w->stats) == 0) {
+		w->state = status ? COORD_FAILED : COORD_DONE;
+		w->calls = w->stats.io_calls;
+		w->bytes = w->stats.io_bytes;
+	} else {
+		ERRORPRINTF("Unknown message from worker %d: %s\n", w->pid, line);
+	}
+}
+
+/** Reads what worker @a w sent and handles complete lines.
+ *
+ * @return 0 on success, -1 if the connection was closed or broken
+ */
+
+static int coord_read(coord_worker_t * w) {
+	char * nl;
+	ssize_t n;
+
+	if ( (n = read(w->fd, w->buf + w->len, COORD_LINE - 1 - w->len)) <= 0) {
+		return n < 0 && errno == EINTR ? 0 : -1;
+	}
+	w->len += n;
+	w->buf[w->len] = 0;
+	while ( (nl = strchr(w->buf, '\n')) != NULL) {
+		*nl = 0;
+		coord_line(w, w->buf);
+		w->len -= nl + 1 - w->buf;
+		memmove(w->buf, nl + 1, w->len + 1);
+	}
+	return w->len == COORD_LINE - 1 ? -1 : 0;
+}
+
+static void coord_progress(coord_worker_t * w, int workers, double elapsed, double dt, int64_t * calls, int64_t * bytes) {
+	int64_t c = 0, b = 0;
+	int i, running = 0;
+
+	for (i = 0; i < workers; i++) {
+		c += w[i].calls;
+		b += w[i].bytes;
+		running += w[i].state == COORD_READY;
+	}
+	printf("%9.1lfs %4d running %12.1lf IOPS %10.3lf MB/s\n", elapsed, running, dt > 0 ? (c - *calls) / dt : 0.0,
+			dt > 0 ? (b - *bytes) / dt / (1024 * 1024) : 0.0);
+	fflush(stdout);
+	*calls = c;
+	*bytes = b;
+}
+
+static int coord_report(coord_worker_t * w, int workers, double wall) {
+	replay_stats_t total;
+	int i, nfailed = 0;
+
+	memset(&total, 0, sizeof(total));
+	for (i = 0; i < workers; i++) {
+		printf("Worker %d (pid %d, clone %d, %s): %s, %lfs, %"PRIi64" calls, %"PRIi64" bytes, p99 < %.1lfus\n", i,
+				w[i].pid, w[i].clone, w[i].name, w[i].state == COORD_DONE ? "ok" : "failed", w[i].stats.duration,
+				w[i].stats.io_calls, w[i].stats.io_bytes, replay_stats_percentile(&w[i].stats, 0.99) / 1000.0);
+		nfailed += w[i].state != COORD_DONE;
+		replay_stats_merge(&total, &w[i].stats);
+	}
+	printf("Workers: %d, %d failed, all finished in %lfs\n", workers, nfailed, wall);
+	printf("Combined throughput: %.1lf IOPS, %.3lf MB/s\n", wall > 0 ? total.io_calls / wall : 0.0,
+			wall > 0 ? total.io_bytes / wall / (1024 * 1024) : 0.0);
+	printf("Combined latency: mean %.1lfus, p50 < %.1lfus, p99 < %.1lfus, max %.1lfus\n",
+			total.io_calls ? total.io_time / 1000.0 / total.io_calls : 0.0,
+			replay_stats_percentile(&total, 0.5) / 1000.0, replay_stats_percentile(&total, 0.99) / 1000.0, total.io_max / 1000.0);
+	return nfailed ? -1 : 0;
+}
+
+/** Runs the coordinator: waits for @a workers workers connecting to @a address, starts them at once, prints their
+ * throughput while they replay and the combined report when they finish.
+ *
+ * @return 0 if all workers succeeded, -1 otherwise
+ */
+
+int coord_serve(const char * address, int workers) {
+	struct sockaddr_storage sa;
+	socklen_t len;
+	coord_worker_t * w;
+	struct timeval start, last, timeout;
+	fd_set fds;
+	int64_t calls = 0, bytes = 0;
+	int i, lfd, maxfd, connected = 0, ready = 0, left, one = 1, retval = 0;
+	double wait;
+
+	if (workers < 1) {
+		ERRORPRINTF("Number of workers has to be positive: %d\n", workers);
+		return -1;
+	}
+	if (coord_address(address, &sa, &len) != 0) {
+		return -1;
+	}
+	if ( (lfd = socket(sa.ss_family, SOCK_STREAM, 0)) < 0) {
+		ERRORPRINTF("Cannot create socket: %s\n", strerror(errno));
+		return -1;
+	}
+	if (sa.ss_family == AF_UNIX) {
+		unlink(address);
+	} else {
+		setsockopt(lfd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	}
+	if (bind(lfd, (struct sockaddr *) &sa, len) != 0 || listen(lfd, COORD_BACKLOG) != 0) {
+		ERRORPRINTF("Cannot listen on %s: %s\n", address, strerror(errno));
+		close(lfd);
+		return -1;
+	}
+	w = calloc(workers, sizeof(coord_worker_t));
+	printf("Waiting for %d workers on %s...\n", workers, address);
+	fflush(stdout);
+
+	//the start barrier: wait until all workers connect and load their traces
+	while (ready < workers) {
+		FD_ZERO(&fds);
+		maxfd = lfd;
+		if (connected < workers) {
+			FD_SET(lfd, &fds);
+		}
+		for (i = 0; i < connected; i++) {
+			FD_SET(w[i].fd, &fds);
+			maxfd = w[i].fd > maxfd ? w[i].fd : maxfd;
+		}
+		if (select(maxfd + 1, &fds, NULL, NULL, NULL) < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			ERRORPRINTF("Error waiting for workers: %s\n", strerror(errno));
+			retval = -1;
+			goto out;
+		}
+		for (i = 0; i < connected; i++) {
+			if (FD_ISSET(w[i].fd, &fds) && coord_read(&w[i]) != 0) { //left before the start, its place is free
+				ERRORPRINTF("Worker %d disconnected before the start\n", w[i].pid);
+				close(w[i].fd);
+				w[i--] = w[--connected];
+			}
+		}
+		if (FD_ISSET(lfd, &fds) && connected < workers) {
+			memset(&w[connected], 0, sizeof(coord_worker_t));
+			if ( (w[connected].fd = accept(lfd, NULL, NULL)) >= 0) {
+				connected++;
+			}
+		}
+		for (ready = 0, i = 0; i < connected; i++) {
+			ready += w[i].state == COORD_READY;
+		}
+	}
+	gettimeofday(&start, NULL);
+	for (i = 0; i < workers; i++) {
+		if (coord_send(w[i].fd, "go\n") != 0) {
+			w[i].state = COORD_FAILED;
+		}
+	}
+	printf("All %d workers ready, started\n", workers);
+	fflush(stdout);
+
+	last = start;
+	do {
+		FD_ZERO(&fds);
+		maxfd = -1;
+		for (left = 0, i = 0; i < workers; i++) {
+			if (w[i].state == COORD_READY) {
+				FD_SET(w[i].fd, &fds);
+				maxfd = w[i].fd > maxfd ? w[i].fd : maxfd;
+				left++;
+			}
+		}
+		if ( (wait = COORD_INTERVAL - coord_since(&last)) <= 0 || ! left) {
+			wait = coord_since(&last);
+			coord_progress(w, workers, coord_since(&start), wait, &calls, &bytes);
+			gettimeofday(&last, NULL);
+			continue;
+		}
+		timeout.tv_sec = wait;
+		timeout.tv_usec = (wait - timeout.tv_sec) * 1000000;
+		if (select(maxfd + 1, &fds, NULL, NULL, &timeout) < 0 && errno != EINTR) {
+			ERRORPRINTF("Error waiting for workers: %s\n", strerror(errno));
+			retval = -1;
+			goto out;
+		}
+		for (i = 0; i < workers; i++) {
+			if (w[i].state == COORD_READY && FD_ISSET(w[i].fd, &fds) && coord_read(&w[i]) != 0) {
+				w[i].state = COORD_FAILED;
+			}
+		}
+	} while (left);
+	retval = coord_report(w, workers, coord_since(&start));
+
+out:
+	for (i = 0; i < connected; i++) {
+		close(w[i].fd);
+	}
+	close(lfd);
+	if (sa.ss_family == AF_UNIX) {
+		unlink(address);
+	}
+	free(w);
+	return retval;
+}
+
+/** Connects to the coordinator at @a address and waits until it starts all workers. Called after the trace is
+ * loaded, right before the replay.
+ *
+ * @arg name name of the trace, shown in the report of the coordinator
+ * @arg clone number of the clone (see clones.h) doing the replay
+ * @return 0 on success, -1 on error
+ */
+
+int coord_join(const char * address, const char * name, int clone) {
+	struct sockaddr_storage sa;
+	struct timeval start;
+	socklen_t len;
+	char line[COORD_LINE];
+	int n = 0;
+	char c;
+
+	if (coord_address(address, &sa, &len) != 0) {
+		return -1;
+	}
+	gettimeofday(&start, NULL);
+	while (1) { //the coordinator may not be running yet
+		if ( (coord_fd = socket(sa.ss_family, SOCK_STREAM, 0)) < 0) {
+			ERRORPRINTF("Cannot create socket: %s\n", strerror(errno));
+			return -1;
+		}
+		if (connect(coord_fd, (struct sockaddr *) &sa, len) == 0) {
+			break;
+		}
+		close(coord_fd);
+		coord_fd = -1;
+		if (coord_since(&start) > COORD_CONNECT_TIMEOUT) {
+			ERRORPRINTF("Cannot connect to coordinator %s: %s\n", address, strerror(errno));
+			return -1;
+		}
+		usleep(100000);
+	}
+	snprintf(line, COORD_LINE, "hello %d %d %s\n", getpid(), clone, name);
+	if (coord_send(coord_fd, line) != 0) {
+		ERRORPRINTF("Error sending to coordinator %s: %s\n", address, strerror(errno));
+		close(coord_fd);
+		coord_fd = -1;
+		return -1;
+	}
+	DEBUGPRINTF("Connected to coordinator %s, waiting for the start\n", address);
+	while (n < COORD_LINE - 1 && read(coord_fd, &c, 1) == 1) {
+		if (c != '\n') {
+			line[n++] = c;
+			continue;
+		}
+		line[n] = 0;
+		if ( ! strcmp(line, "go")) {
+			gettimeofday(&coord_last, NULL);
+			return 0;
+		}
+		n = 0;
+	}
+	ERRORPRINTF("Coordinator %s did not start the replay\n", address);
+	close(coord_fd);
+	coord_fd = -1;
+	return -1;
+}
+
+int coord_due(int64_t index) {
+	return coord_fd >= 0 && index % COORD_CHECK_EVERY == 0 && coord_since(&coord_last) >= COORD_INTERVAL;
+}
+
+/** Sends reads and writes done so far to the coordinator. If it is gone, the replay continues without it. */
+
+void coord_tick() {
+	char line[COORD_LINE];
+
+	snprintf(line, COORD_LINE, "tick %"PRIi64" %"PRIi64"\n", replay_stats.io_calls, replay_stats.io_bytes);
+	if (coord_send(coord_fd, line) != 0) {
+		ERRORPRINTF("Lost connection to the coordinator: %s\n", strerror(errno));
+		close(coord_fd);
+		coord_fd = -1;
+		return;
+	}
+	gettimeofday(&coord_last, NULL);
+}
+
+/** Sends statistics of the finished replay to the coordinator and disconnects.
+ *
+ * @arg status 0 if the replay succeeded
+ * @return 0 on success, -1 on error
+ */
+
+int coord_done(int status) {
+	char line[COORD_LINE];
+	int b, pos, retval;
+
+	if (coord_fd < 0) {
+		return -1;
+	}
+	pos = snprintf(line, COORD_LINE, "done %d %lf %"PRIi64" %"PRIi64" %"PRIu64" %"PRIu64, status, replay_stats.duration,
+			replay_stats.io_calls, replay_stats.io_bytes, replay_stats.io_time, replay_stats.io_max);
+	for (b = 0; b < REPLAY_HIST_BUCKETS; b++) {
+		pos += snprintf(line + pos, COORD_LINE - pos, " %"PRIi64, replay_stats.hist[b]);
+	}
+	snprintf(line + pos, COORD_LINE - pos, "\n");
+	if ( (retval = coord_send(coord_fd, line)) != 0) {
+		ERRORPRINTF("Error sending results to the coordinator: %s\n", strerror(errno));
+	}
+	close(coord_fd);
+	coord_fd = -1;
+	return retval;
+}
@@ -0,0 +1,77 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _COORD_H_
+#define _COORD_H_
+
+/** @file coord.h
+ *
+ * Coordinated replay by more ioreplay processes (e.g. replaying shards made by -Q, or different traces). The
+ * coordinator waits until all workers connect, starts them at once and merges their results into one report.
+ *
+ * Workers connect to the address of the coordinator (a Unix domain socket if it contains '/', TCP
+ * [<host>:]<port> otherwise, localhost by default) after their trace is loaded and sends a line per message:
+ *
+ *   hello <pid> <clone> <trace>           worker is ready, sent on connect
+ *   go                                    from the coordinator to all workers once all of them are ready
+ *   tick <calls> <bytes>                  reads and writes done so far, about every COORD_INTERVAL seconds
+ *   done <status> <duration> <calls> <bytes> <time> <max> <hist>...
+ *                                         replay_stats_t of the finished replay, status is 0 on success
+ *
+ * The coordinator prints throughput of all workers every COORD_INTERVAL seconds and the combined report with
+ * latency percentiles of the merged histograms when all workers finish. A worker which disconnects without
+ * done is counted as failed.
+ */
+
+#include <stdint.h>
+#include "common.h"
+#include "replicate.h"
+
+#define COORD_INTERVAL 1.0 ///< seconds between ticks and progress lines
+#define COORD_CHECK_EVERY 64 ///< time is checked every n-th operation of the replay
+#define COORD_CONNECT_TIMEOUT 30 ///< seconds a worker tries to connect to the coordinator
+#define COORD_LINE 4096
+#define COORD_BACKLOG 64
+
+// States of workers
+#define COORD_CONNECTED 0
+#define COORD_READY 1
+#define COORD_DONE 2
+#define COORD_FAILED 3
+
+typedef struct coord_worker {
+	int fd;
+	char buf[COORD_LINE]; ///< incomplete line read so far
+	int len;
+	int state;
+	int32_t pid;
+	int32_t clone;
+	char name[MAX_STRING];
+	int64_t calls; ///< from the last tick
+	int64_t bytes;
+	replay_stats_t stats; ///< from done
+} coord_worker_t;
+
+int coord_serve(const char * address, int workers);
+int coord_join(const char * address, const char * name, int clone);
+int coord_due(int64_t index);
+void coord_tick();
+int coord_done(int status);
+
+#endif
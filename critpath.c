@@ -0,0 +1,495 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "common.h"
+#include "critpath.h"
+
+int critpath_top = 0; ///< number of files, chains and processes to print, 0 = analysis not enabled
+hash_table_t critpath_files;
+hash_table_t critpath_pids;
+critpath_file_t ** critpath_file_list = NULL; ///< files by their number
+int32_t critpath_nfiles = 0;
+int32_t critpath_files_size = 0;
+critpath_pid_t ** critpath_pid_list = NULL;
+int64_t critpath_npids = 0;
+int64_t critpath_pids_size = 0;
+critpath_chain_t * critpath_chains = NULL; ///< the longest chains, the longest first
+int critpath_nchains = 0;
+
+/** Time of the critical path spent in IO, waiting for processes not in the trace and elsewhere. */
+int64_t critpath_io = 0;
+int64_t critpath_wait = 0;
+int64_t critpath_think = 0;
+
+static int ht_compare_critpath_file(key_t *key, item_t *item) {
+	return ! strncmp(hash_table_entry(item, critpath_file_t, item)->name, (char *) key, MAX_STRING);
+}
+
+static int ht_compare_critpath_pid(key_t *key, item_t *item) {
+	return hash_table_entry(item, critpath_pid_t, item)->pid == *key;
+}
+
+static void ht_remove_callback_critpath_file(item_t * item) {
+	free(hash_table_entry(item, critpath_file_t, item));
+}
+
+static void ht_remove_callback_critpath_pid(item_t * item) {
+	critpath_pid_t * p = hash_table_entry(item, critpath_pid_t, item);
+
+	free(p->events);
+	free(p);
+}
+
+static hash_table_operations_t ht_ops_critpath_file = {
+	.hash = ht_hash_str,
+	.compare = ht_compare_critpath_file,
+	.remove_callback = ht_remove_callback_critpath_file
+};
+
+static hash_table_operations_t ht_ops_critpath_pid = {
+	.hash = ht_hash_int,
+	.compare = ht_compare_critpath_pid,
+	.remove_callback = ht_remove_callback_critpath_pid
+};
+
+/** Starts the analysis.
+ *
+ * @arg top number of files, chains and processes to print
+ * @return 0 on success, -1 on error
+ */
+
+int critpath_init(int top) {
+	if (top <= 0) {
+		ERRORPRINTF("Number of files to print has to be positive: %d\n", top);
+		return -1;
+	}
+	critpath_top = top;
+	hash_table_init(&critpath_files, CRITPATH_HT_SIZE, &ht_ops_critpath_file);
+	hash_table_init(&critpath_pids, CRITPATH_HT_SIZE, &ht_ops_critpath_pid);
+	critpath_chains = malloc(top * sizeof(critpath_chain_t));
+	critpath_io = critpath_wait = critpath_think = 0;
+	return 0;
+}
+
+int critpath_enabled() {
+	return critpath_top > 0;
+}
+
+static critpath_pid_t * critpath_find_pid(int32_t pid) {
+	item_t * item;
+	key_t key = pid;
+
+	if ( (item = hash_table_find(&critpath_pids, &key)) == NULL) {
+		return NULL;
+	}
+	return hash_table_entry(item, critpath_pid_t, item);
+}
+
+static critpath_pid_t * critpath_get_pid(int32_t pid) {
+	critpath_pid_t * p;
+
+	if ( (p = critpath_find_pid(pid)) != NULL) {
+		return p;
+	}
+	p = calloc(1, sizeof(critpath_pid_t));
+	item_init(&p->item);
+	p->pid = pid;
+	p->parent = -1;
+	p->first = INT64_MAX;
+	p->last = INT64_MIN;
+	hash_table_insert(&critpath_pids, &p->pid, &p->item);
+	if (critpath_npids == critpath_pids_size) {
+		critpath_pids_size = critpath_pids_size ? 2 * critpath_pids_size : 1024;
+		critpath_pid_list = realloc(critpath_pid_list, critpath_pids_size * sizeof(critpath_pid_t *));
+	}
+	critpath_pid_list[critpath_npids++] = p;
+	return p;
+}
+
+static int32_t critpath_get_file(const char * name) {
+	critpath_file_t * file;
+	item_t * item;
+
+	if ( (item = hash_table_find(&critpath_files, (key_t *) name)) != NULL) {
+		return hash_table_entry(item, critpath_file_t, item)->id;
+	}
+	file = calloc(1, sizeof(critpath_file_t));
+	item_init(&file->item);
+	strncpy(file->name, name, MAX_STRING);
+	file->name[MAX_STRING-1] = 0;
+	file->id = critpath_nfiles;
+	hash_table_insert(&critpath_files, (key_t *) file->name, &file->item);
+	if (critpath_nfiles == critpath_files_size) {
+		critpath_files_size = critpath_files_size ? 2 * critpath_files_size : 1024;
+		critpath_file_list = realloc(critpath_file_list, critpath_files_size * sizeof(critpath_file_t *));
+	}
+	critpath_file_list[critpath_nfiles++] = file;
+	return file->id;
+}
+
+static inline int64_t critpath_usec(struct int32timeval t) {
+	return (int64_t) t.tv_sec * 1000000 + t.tv_usec;
+}
+
+/** Notes one call of process @a p: its time span and, if it is an IO call or wait(), an event.
+ *
+ * @arg file number of the file of an IO call, -1 for wait(), -2 for other calls
+ * @arg child child returned by wait()
+ */
+
+static void critpath_note(critpath_pid_t * p, int64_t start, int64_t dur, int32_t file, int32_t child) {
+	critpath_event_t * ev;
+
+	if (dur < 0) {
+		dur = 0;
+	}
+	if (start < p->first) {
+		p->first = start;
+	}
+	if (start + dur > p->last) {
+		p->last = start + dur;
+	}
+	if (file < -1) {
+		return;
+	}
+	if (p->nevents && p->events[p->nevents-1].start == start && p->events[p->nevents-1].dur == dur) {
+		return; //second half of sendfile
+	}
+	if (p->nevents == p->size) {
+		p->size = p->size ? 2 * p->size : 64;
+		if ( (p->events = realloc(p->events, p->size * sizeof(critpath_event_t))) == NULL) {
+			ERRORPRINTF("Not enough memory for %"PRIi64" calls of process %d\n", p->size, p->pid);
+			exit(1);
+		}
+	}
+	ev = &p->events[p->nevents++];
+	ev->start = start;
+	ev->dur = dur;
+	ev->file = file;
+	ev->child = child;
+	if (file >= 0) {
+		p->io += dur;
+		critpath_file_list[file]->io += dur;
+		critpath_file_list[file]->calls++;
+	} else {
+		p->wait += dur;
+	}
+}
+
+/** Notes one IO call on a descriptor. Called by simulate_* functions, which know the file behind it.
+ *
+ * @arg pid process which did the call
+ * @arg name name of the file
+ * @arg start start of the call
+ * @arg dur duration of the call in usec
+ */
+
+void critpath_add_io(int32_t pid, const char * name, struct int32timeval start, int32_t dur) {
+	critpath_note(critpath_get_pid(pid), critpath_usec(start), dur, critpath_get_file(name), 0);
+}
+
+/** Takes time spans of processes, clones, waits and IO calls working with names from the trace. Has to be called
+ * after the simulation.
+ */
+
+void critpath_scan(list_t * list) {
+	common_op_item_t * com_it;
+	item_t * item;
+	op_info_t * info;
+	critpath_pid_t * p, * c;
+	const char * name;
+	int32_t retval;
+
+	for (item = list->head; item; item = item->next) {
+		com_it = list_entry(item, common_op_item_t, item);
+		if ( (info = get_item_info(com_it)) == NULL) {
+			continue;
+		}
+		p = critpath_get_pid(info->pid);
+		name = NULL;
+		switch (com_it->type) {
+			case OP_CLONE:
+				if ( (retval = ((clone_item_t *) com_it)->o.retval) > 0) {
+					c = critpath_get_pid(retval);
+					c->parent = info->pid;
+					c->clone = critpath_usec(info->start);
+				}
+				break;
+			case OP_WAIT:
+				if ( (retval = ((wait_item_t *) com_it)->o.retval) > 0) {
+					critpath_note(p, critpath_usec(info->start), info->dur, -1, retval);
+					continue;
+				}
+				break;
+			case OP_OPEN:
+				name = ((open_item_t *) com_it)->o.name;
+				break;
+			case OP_STAT:
+				name = ((stat_item_t *) com_it)->o.name;
+				break;
+			case OP_ACCESS:
+				name = ((access_item_t *) com_it)->o.name;
+				break;
+			case OP_UNLINK:
+				name = ((unlink_item_t *) com_it)->o.name;
+				break;
+			case OP_MKDIR:
+				name = ((mkdir_item_t *) com_it)->o.name;
+				break;
+			case OP_RMDIR:
+				name = ((rmdir_item_t *) com_it)->o.name;
+				break;
+			case OP_RENAME:
+				name = ((rename_item_t *) com_it)->o.old_name;
+				break;
+			case OP_LINK:
+			case OP_SYMLINK:
+				name = ((link_item_t *) com_it)->o.new_name;
+				break;
+			case OP_READLINK:
+				name = ((readlink_item_t *) com_it)->o.name;
+				break;
+		}
+		critpath_note(p, critpath_usec(info->start), info->dur, name ? critpath_get_file(name) : -2, 0);
+	}
+}
+
+static int critpath_compare_event(const void * a, const void * b) {
+	int64_t sa = ((const critpath_event_t *) a)->start, sb = ((const critpath_event_t *) b)->start;
+
+	return sa < sb ? -1 : sa > sb;
+}
+
+/** @return when process @a p started: its clone, or the first call if it was not cloned in the trace */
+
+static inline int64_t critpath_begin(critpath_pid_t * p) {
+	return p->parent >= 0 && p->clone < p->first ? p->clone : p->first;
+}
+
+/** Walks the critical path backwards through process @a p from time @a end to its beginning.
+ */
+
+static void critpath_walk(critpath_pid_t * p, int64_t end) {
+	int64_t begin = critpath_begin(p), cursor = end, ev_end, child_end, i;
+	critpath_event_t * ev;
+	critpath_pid_t * c;
+
+	p->walked = 1;
+	for (i = p->nevents - 1; i >= 0 && cursor > begin; i--) {
+		ev = &p->events[i];
+		if (ev->start >= cursor) { //done in parallel with a child on the path
+			continue;
+		}
+		ev_end = ev->start + ev->dur < cursor ? ev->start + ev->dur : cursor;
+		critpath_think += cursor - ev_end;
+		p->cp += cursor - ev_end;
+		if (ev->file >= 0) {
+			critpath_io += ev_end - ev->start;
+			critpath_file_list[ev->file]->cp += ev_end - ev->start;
+			p->cp += ev_end - ev->start;
+			p->cp_io += ev_end - ev->start;
+			cursor = ev->start;
+		} else if ( (c = critpath_find_pid(ev->child)) != NULL && c->parent == p->pid && ! c->walked
+				&& critpath_begin(c) >= begin && critpath_begin(c) < ev_end) {
+			child_end = c->last < ev_end ? c->last : ev_end;
+			critpath_think += ev_end - child_end; //delivery of the exit to the parent
+			p->cp += ev_end - child_end;
+			critpath_walk(c, child_end);
+			cursor = critpath_begin(c);
+		} else { //waiting for something not in the trace
+			critpath_wait += ev_end - ev->start;
+			p->cp += ev_end - ev->start;
+			cursor = ev->start;
+		}
+	}
+	if (cursor > begin) {
+		critpath_think += cursor - begin;
+		p->cp += cursor - begin;
+	}
+}
+
+/** Offers chain @a ch to the list of the longest chains. */
+
+static void critpath_add_chain(critpath_chain_t * ch) {
+	int i;
+
+	if (critpath_nchains == critpath_top && ch->end - ch->start <= critpath_chains[critpath_nchains-1].end - critpath_chains[critpath_nchains-1].start) {
+		return;
+	}
+	if (critpath_nchains < critpath_top) {
+		critpath_nchains++;
+	}
+	for (i = critpath_nchains - 1; i > 0 && critpath_chains[i-1].end - critpath_chains[i-1].start < ch->end - ch->start; i--) {
+		critpath_chains[i] = critpath_chains[i-1];
+	}
+	critpath_chains[i] = *ch;
+}
+
+/** Finds IO chains of process @a p. */
+
+static void critpath_find_chains(critpath_pid_t * p) {
+	critpath_chain_t ch;
+	critpath_event_t * ev;
+	int64_t i, longest = -1;
+
+	ch.calls = 0;
+	for (i = 0; i < p->nevents; i++) {
+		ev = &p->events[i];
+		if (ev->file < 0) {
+			continue;
+		}
+		if (ch.calls && ev->start - ch.end > CRITPATH_GAP) {
+			critpath_add_chain(&ch);
+			ch.calls = 0;
+		}
+		if (ch.calls == 0) {
+			ch.pid = p->pid;
+			ch.start = ev->start;
+			ch.end = ev->start;
+			ch.io = 0;
+			longest = -1;
+		}
+		ch.calls++;
+		ch.io += ev->dur;
+		if (ev->start + ev->dur > ch.end) {
+			ch.end = ev->start + ev->dur;
+		}
+		if (ev->dur > longest) {
+			longest = ev->dur;
+			ch.file = ev->file;
+		}
+	}
+	if (ch.calls) {
+		critpath_add_chain(&ch);
+	}
+}
+
+static int critpath_compare_file(const void * a, const void * b) {
+	const critpath_file_t * fa = *(critpath_file_t * const *) a, * fb = *(critpath_file_t * const *) b;
+
+	if (fa->cp != fb->cp) {
+		return fa->cp > fb->cp ? -1 : 1;
+	}
+	return fa->io > fb->io ? -1 : fa->io < fb->io;
+}
+
+static int critpath_compare_pid(const void * a, const void * b) {
+	const critpath_pid_t * pa = *(critpath_pid_t * const *) a, * pb = *(critpath_pid_t * const *) b;
+
+	if (pa->cp != pb->cp) {
+		return pa->cp > pb->cp ? -1 : 1;
+	}
+	return pa->io > pb->io ? -1 : pa->io < pb->io;
+}
+
+static inline double critpath_ms(int64_t usec) {
+	return usec / 1000.0;
+}
+
+/** Walks the critical path and prints it with per process IO time, the longest IO chains and files with the most
+ * IO time on the critical path.
+ */
+
+void critpath_report() {
+	critpath_pid_t * root = NULL, * p;
+	critpath_file_t ** files;
+	int64_t i, n, span, think;
+
+	for (i = 0; i < critpath_npids; i++) {
+		p = critpath_pid_list[i];
+		qsort(p->events, p->nevents, sizeof(critpath_event_t), critpath_compare_event);
+		critpath_find_chains(p);
+		if (p->last >= p->first && p->parent < 0 && (root == NULL || p->last > root->last)) {
+			root = p;
+		}
+	}
+	if (root == NULL) {
+		printf("No calls to analyze.\n");
+		return;
+	}
+	critpath_walk(root, root->last);
+	span = root->last - critpath_begin(root);
+
+	printf("Critical path of process %d: %.3lf ms\n", root->pid, critpath_ms(span));
+	printf("  IO: %.3lf ms (%.1lf%%), waiting for processes not in the trace: %.3lf ms (%.1lf%%), CPU and other calls: %.3lf ms (%.1lf%%)\n",
+			critpath_ms(critpath_io), span ? 100.0 * critpath_io / span : 0.0,
+			critpath_ms(critpath_wait), span ? 100.0 * critpath_wait / span : 0.0,
+			critpath_ms(critpath_think), span ? 100.0 * critpath_think / span : 0.0);
+
+	qsort(critpath_pid_list, critpath_npids, sizeof(critpath_pid_t *), critpath_compare_pid);
+	n = critpath_top < critpath_npids ? critpath_top : critpath_npids;
+	printf("Processes (wall time split to IO, waiting for children and the rest; time on the critical path):\n");
+	printf("%8s %8s %12s %12s %7s %12s %12s %12s %12s\n", "pid", "parent", "wall ms", "io ms", "io", "wait ms",
+			"think ms", "critical ms", "crit io ms");
+	for (i = 0; i < n; i++) {
+		p = critpath_pid_list[i];
+		span = p->last > critpath_begin(p) ? p->last - critpath_begin(p) : 0;
+		think = span - p->io - p->wait > 0 ? span - p->io - p->wait : 0;
+		printf("%8d %8d %12.3lf %12.3lf %6.1lf%% %12.3lf %12.3lf %12.3lf %12.3lf  %s\n", p->pid, p->parent,
+				critpath_ms(span), critpath_ms(p->io), span ? 100.0 * p->io / span : 0.0, critpath_ms(p->wait),
+				critpath_ms(think), critpath_ms(p->cp), critpath_ms(p->cp_io), p->walked ? "on path" : "");
+	}
+
+	printf("Longest IO chains (IO calls with gaps up to %d usec):\n", CRITPATH_GAP);
+	printf("%8s %14s %12s %10s %12s %7s  %s\n", "pid", "start s", "length ms", "calls", "io ms", "io", "file of the longest call");
+	for (i = 0; i < critpath_nchains; i++) {
+		critpath_chain_t * ch = &critpath_chains[i];
+
+		printf("%8d %14.6lf %12.3lf %10"PRIi64" %12.3lf %6.1lf%%  %s\n", ch->pid,
+				(ch->start - critpath_begin(root)) / 1000000.0, critpath_ms(ch->end - ch->start), ch->calls,
+				critpath_ms(ch->io), ch->end > ch->start ? 100.0 * ch->io / (ch->end - ch->start) : 100.0,
+				critpath_file_list[ch->file]->name);
+	}
+
+	files = malloc((critpath_nfiles + 1) * sizeof(critpath_file_t *));
+	memcpy(files, critpath_file_list, critpath_nfiles * sizeof(critpath_file_t *));
+	qsort(files, critpath_nfiles, sizeof(critpath_file_t *), critpath_compare_file);
+	n = critpath_top < critpath_nfiles ? critpath_top : critpath_nfiles;
+	printf("Files by IO time on the critical path:\n");
+	printf("%12s %7s %12s %10s  %s\n", "critical ms", "path", "io ms", "calls", "file");
+	for (i = 0; i < n; i++) {
+		printf("%12.3lf %6.1lf%% %12.3lf %10"PRIi64"  %s\n", critpath_ms(files[i]->cp),
+				root->last > critpath_begin(root) ? 100.0 * files[i]->cp / (root->last - critpath_begin(root)) : 0.0,
+				critpath_ms(files[i]->io), files[i]->calls, files[i]->name);
+	}
+	free(files);
+}
+
+void critpath_finish() {
+	if ( ! critpath_enabled()) {
+		return;
+	}
+	hash_table_destroy(&critpath_files);
+	hash_table_destroy(&critpath_pids);
+	free(critpath_file_list);
+	free(critpath_pid_list);
+	free(critpath_chains);
+	critpath_file_list = NULL;
+	critpath_pid_list = NULL;
+	critpath_chains = NULL;
+	critpath_nfiles = critpath_files_size = 0;
+	critpath_npids = critpath_pids_size = 0;
+	critpath_nchains = 0;
+	critpath_top = 0;
+}
@@ -0,0 +1,99 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _CRITPATH_H_
+#define _CRITPATH_H_
+
+/** @file critpath.h
+ *
+ * Critical path and IO wait attribution. Wall time of every process (from its clone or first call to the end of
+ * its last call) is split into time spent in IO calls, time waiting for children and the rest (CPU and other
+ * syscalls, "think time").
+ *
+ * The critical path of the job is walked backwards from the end of the root process, i.e. the process not cloned
+ * in the trace which ended last. IO calls on the way are on the path. When the process was blocked in wait() for
+ * a child, the path continues in the child from its end back to its clone and then in the parent before the
+ * clone; calls the parent did in parallel with the child are not on the path. Time of IO on the critical path is
+ * attributed to files, which shows where faster storage would shorten the job.
+ *
+ * IO calls are reads, writes, sendfile and getdents (noted during simulation, see simulate_note_rw(), to know the
+ * file behind the descriptor) and calls working with names: open, stat, access, unlink, mkdir, rmdir, rename,
+ * link and readlink (taken from the trace by critpath_scan()).
+ *
+ * IO chains are runs of IO calls of one process with gaps of at most CRITPATH_GAP usec, i.e. IO bound stretches.
+ */
+
+#include <stdint.h>
+#include "common.h"
+#include "in_common.h"
+#include "adt/hash_table.h"
+
+#define CRITPATH_GAP 1000 ///< maximal gap (usec) between IO calls of one chain
+#define CRITPATH_HT_SIZE 1024
+
+typedef struct critpath_event {
+	int64_t start; ///< in usec
+	int64_t dur;
+	int32_t file; ///< number of the file, -1 for wait()
+	int32_t child; ///< child the wait() returned
+} critpath_event_t;
+
+typedef struct critpath_file {
+	item_t item;
+	char name[MAX_STRING];
+	int32_t id;
+	int64_t calls;
+	int64_t io; ///< time of all IO calls on the file
+	int64_t cp; ///< time of IO calls on the critical path
+} critpath_file_t;
+
+typedef struct critpath_pid {
+	item_t item;
+	key_t pid;
+	int32_t parent; ///< -1 if the process was not cloned in the trace
+	int64_t clone; ///< when the parent cloned the process
+	int64_t first; ///< start of the first call
+	int64_t last; ///< end of the last call
+	int64_t io; ///< time spent in IO calls
+	int64_t wait; ///< time spent waiting for children
+	int64_t cp; ///< time of the critical path spent in the process
+	int64_t cp_io; ///< time of IO calls on the critical path
+	int walked; ///< the critical path went through the process
+	critpath_event_t * events;
+	int64_t nevents;
+	int64_t size;
+} critpath_pid_t;
+
+typedef struct critpath_chain {
+	int32_t pid;
+	int32_t file; ///< file of the longest call of the chain
+	int64_t start;
+	int64_t end;
+	int64_t calls;
+	int64_t io;
+} critpath_chain_t;
+
+int critpath_init(int top);
+int critpath_enabled();
+void critpath_add_io(int32_t pid, const char * name, struct int32timeval start, int32_t dur);
+void critpath_scan(list_t * list);
+void critpath_report();
+void critpath_finish();
+
+#endif
@@ -0,0 +1,715 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <math.h>
+#include <time.h>
+
+#include "common.h"
+#include "devmodel.h"
+#include "replicate.h"
+
+/** Parameters of the modeled device. Latencies are in ns, bandwidths in bytes per ns. */
+typedef struct devmodel_params {
+	const char * name;
+	int qd; ///< number of calls served at once
+	double lat[2][2]; ///< mean latency, indexed by [write][seq]
+	double bw[2]; ///< bandwidth of reads and writes
+	int dist; ///< latency distribution, DEVMODEL_DIST_*
+	double sigma; ///< sigma of the lognormal distribution
+	int64_t cache; ///< size of the page cache in bytes, 0 = no cache
+	int64_t writeback; ///< size of the write-back buffer in bytes, 0 = write through
+	double hit; ///< latency of a call served from memory (cache hit, buffered write)
+} devmodel_params_t;
+
+#define GB (1024.0 * 1024 * 1024 / 1e9) ///< 1GB/s in bytes per ns
+#define MB (1024.0 * 1024 / 1e9) ///< 1MB/s in bytes per ns
+
+static devmodel_params_t devmodel_presets[] = {
+	{ "nvme", 64, {{90000, 15000}, {25000, 20000}}, {3 * GB, 2 * GB}, DEVMODEL_DIST_EXP, 0.5, 0, 0, 1000 },
+	{ "ssd", 32, {{120000, 60000}, {70000, 50000}}, {520 * MB, 480 * MB}, DEVMODEL_DIST_EXP, 0.5, 0, 0, 1000 },
+	{ "hdd", 1, {{8000000, 100000}, {8000000, 100000}}, {180 * MB, 170 * MB}, DEVMODEL_DIST_EXP, 0.5, 0, 0, 1000 },
+	{ NULL }
+};
+
+devmodel_params_t devmodel;
+int devmodel_on = 0;
+char devmodel_spec[MAX_STRING];
+
+devmodel_op_t * devmodel_ops = NULL; ///< all reads and writes in the order of the trace
+int64_t devmodel_nops = 0;
+int64_t devmodel_maxops = 0;
+hash_table_t devmodel_files;
+hash_table_t devmodel_pids;
+int32_t devmodel_nfiles = 0;
+int32_t devmodel_npids = 0;
+uint64_t devmodel_rnd = 88172645463325252ULL; ///< state of the xorshift generator, fixed so runs are repeatable
+
+/** Page cache model: LRU list of pages in arrays, found by an open addressing hash table of indexes. */
+int64_t * cache_key = NULL; ///< file << 36 | page number
+int32_t * cache_prev = NULL;
+int32_t * cache_next = NULL;
+int32_t * cache_slot = NULL; ///< hash table, -1 = empty
+int32_t cache_pages = 0; ///< capacity in pages
+int32_t cache_used = 0;
+int32_t cache_head = -1; ///< most recently used page
+int32_t cache_tail = -1; ///< least recently used page
+uint32_t cache_mask = 0;
+
+/** Results */
+replay_stats_t devmodel_stats; ///< modeled latencies
+replay_stats_t devmodel_orig; ///< original latencies
+double devmodel_end = 0; ///< predicted end of the last call, ns
+double devmodel_orig_end = 0; ///< original end of the last call, ns
+double devmodel_busy = 0; ///< sum of times the calls spent in the device, ns
+double devmodel_runtime = 0; ///< how long the model itself ran, s
+int64_t devmodel_reads = 0, devmodel_seq = 0;
+int64_t devmodel_hits = 0, devmodel_absorbed = 0, devmodel_waited = 0;
+
+static int ht_compare_devmodel_file(key_t *key, item_t *item) {
+	return ! strncmp(hash_table_entry(item, devmodel_file_t, item)->name, (char *) key, MAX_STRING);
+}
+
+static int ht_compare_devmodel_pid(key_t *key, item_t *item) {
+	return hash_table_entry(item, devmodel_pid_t, item)->pid == *key;
+}
+
+static void ht_remove_callback_devmodel_file(item_t * item) {
+	free(hash_table_entry(item, devmodel_file_t, item));
+}
+
+static void ht_remove_callback_devmodel_pid(item_t * item) {
+	free(hash_table_entry(item, devmodel_pid_t, item));
+}
+
+static hash_table_operations_t ht_ops_devmodel_file = {
+	.hash = ht_hash_str,
+	.compare = ht_compare_devmodel_file,
+	.remove_callback = ht_remove_callback_devmodel_file
+};
+
+static hash_table_operations_t ht_ops_devmodel_pid = {
+	.hash = ht_hash_int,
+	.compare = ht_compare_devmodel_pid,
+	.remove_callback = ht_remove_callback_devmodel_pid
+};
+
+/** Parses time with an optional ns, us, ms or s suffix (default is us).
+ *
+ * @return the time in ns, -1 on error
+ */
+
+static double devmodel_parse_time(const char * str) {
+	char * end;
+	double t = strtod(str, &end);
+
+	if (end == str || t < 0) {
+		return -1;
+	}
+	if ( ! strcmp(end, "ns")) {
+		return t;
+	} else if ( ! strcmp(end, "us") || *end == 0) {
+		return t * 1e3;
+	} else if ( ! strcmp(end, "ms")) {
+		return t * 1e6;
+	} else if ( ! strcmp(end, "s")) {
+		return t * 1e9;
+	}
+	return -1;
+}
+
+/** Parses size with an optional K, M, G or T suffix (powers of 1024).
+ *
+ * @return the size, -1 on error
+ */
+
+static double devmodel_parse_size(const char * str) {
+	char * end;
+	double s = strtod(str, &end);
+
+	if (end == str || s < 0) {
+		return -1;
+	}
+	switch (*end) {
+		case 'T': case 't':
+			s *= 1024;
+		case 'G': case 'g':
+			s *= 1024;
+		case 'M': case 'm':
+			s *= 1024;
+		case 'K': case 'k':
+			s *= 1024;
+			end++;
+		default:
+			break;
+	}
+	return *end ? -1 : s;
+}
+
+/** Sets one parameter of the model given as key=value.
+ *
+ * @return 0 on success, -1 on error
+ */
+
+static int devmodel_set(char * key, char * value) {
+	double v;
+
+	if ( ! strcmp(key, "dist")) {
+		if ( ! strcmp(value, "fixed")) {
+			devmodel.dist = DEVMODEL_DIST_FIXED;
+		} else if ( ! strcmp(value, "exp")) {
+			devmodel.dist = DEVMODEL_DIST_EXP;
+		} else if ( ! strncmp(value, "lognormal", strlen("lognormal"))) {
+			devmodel.dist = DEVMODEL_DIST_LOGNORMAL;
+			if (value[strlen("lognormal")] == ':' && (devmodel.sigma = atof(value + strlen("lognormal") + 1)) <= 0) {
+				return -1;
+			}
+		} else {
+			return -1;
+		}
+		return 0;
+	}
+	if ( ! strcmp(key, "qd")) {
+		return (devmodel.qd = atoi(value)) > 0 ? 0 : -1;
+	}
+	if ( ! strcmp(key, "seq-read") || ! strcmp(key, "rand-read") || ! strcmp(key, "seq-write") || ! strcmp(key, "rand-write")
+			|| ! strcmp(key, "hit")) {
+		if ( (v = devmodel_parse_time(value)) < 0) {
+			return -1;
+		}
+		if ( ! strcmp(key, "hit")) {
+			devmodel.hit = v;
+		} else {
+			devmodel.lat[strstr(key, "write") != NULL][key[0] == 's'] = v;
+		}
+		return 0;
+	}
+	if ( (v = devmodel_parse_size(value)) < 0) {
+		return -1;
+	}
+	if ( ! strcmp(key, "read-bw") && v > 0) {
+		devmodel.bw[0] = v / 1e9;
+	} else if ( ! strcmp(key, "write-bw") && v > 0) {
+		devmodel.bw[1] = v / 1e9;
+	} else if ( ! strcmp(key, "cache")) {
+		devmodel.cache = v;
+	} else if ( ! strcmp(key, "writeback")) {
+		devmodel.writeback = v;
+	} else {
+		return -1;
+	}
+	return 0;
+}
+
+/** Sets the model from @a spec: comma separated preset name and key=value pairs (see devmodel.h).
+ *
+ * @return 0 on success, -1 on error
+ */
+
+int devmodel_init(const char * spec) {
+	char buf[MAX_STRING];
+	char * tok, * save, * eq;
+	int i;
+
+	strncpy(devmodel_spec, spec, MAX_STRING);
+	devmodel_spec[MAX_STRING-1] = 0;
+	strcpy(buf, devmodel_spec);
+	devmodel = devmodel_presets[0];
+	for (tok = strtok_r(buf, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+		if ( (eq = strchr(tok, '=')) == NULL) {
+			for (i = 0; devmodel_presets[i].name && strcmp(devmodel_presets[i].name, tok); i++)
+				;
+			if (devmodel_presets[i].name == NULL) {
+				ERRORPRINTF("Unknown device model: %s\n", tok);
+				return -1;
+			}
+			devmodel = devmodel_presets[i];
+			continue;
+		}
+		*eq = 0;
+		if (devmodel_set(tok, eq + 1) != 0) {
+			ERRORPRINTF("Wrong device model parameter: %s=%s\n", tok, eq + 1);
+			return -1;
+		}
+	}
+
+	if (devmodel.cache >= DEVMODEL_PAGE) {
+		if (devmodel.cache / DEVMODEL_PAGE > INT32_MAX / 4) {
+			ERRORPRINTF("Page cache of the device model is too big: %"PRIi64" bytes\n", devmodel.cache);
+			return -1;
+		}
+		cache_pages = devmodel.cache / DEVMODEL_PAGE;
+		for (cache_mask = 1; cache_mask < 2 * (uint32_t) cache_pages; cache_mask <<= 1)
+			;
+		cache_key = malloc(cache_pages * sizeof(int64_t));
+		cache_prev = malloc(cache_pages * sizeof(int32_t));
+		cache_next = malloc(cache_pages * sizeof(int32_t));
+		cache_slot = malloc(cache_mask * sizeof(int32_t));
+		if ( ! cache_key || ! cache_prev || ! cache_next || ! cache_slot) {
+			ERRORPRINTF("Not enough memory for page cache of the device model%s", "\n");
+			return -1;
+		}
+		memset(cache_slot, -1, cache_mask * sizeof(int32_t));
+		cache_mask--;
+	}
+
+	hash_table_init(&devmodel_files, DEVMODEL_HT_SIZE, &ht_ops_devmodel_file);
+	hash_table_init(&devmodel_pids, DEVMODEL_HT_SIZE, &ht_ops_devmodel_pid);
+	devmodel_on = 1;
+	return 0;
+}
+
+int devmodel_enabled() {
+	return devmodel_on;
+}
+
+/** Notes one read or write. Called by simulate_* functions.
+ *
+ * @arg pid process which did the call
+ * @arg name name of the file
+ * @arg offset offset of the call
+ * @arg size number of bytes the call transferred
+ * @arg write whether it was a write
+ * @arg start original start of the call
+ * @arg dur original duration of the call in usec
+ */
+
+void devmodel_add(int32_t pid, const char * name, int64_t offset, int64_t size, int write, struct int32timeval start, int32_t dur) {
+	devmodel_op_t * op;
+	devmodel_file_t * file;
+	devmodel_pid_t * p;
+	item_t * item;
+	key_t key = pid;
+
+	if (size <= 0) {
+		return;
+	}
+	if (devmodel_nops == devmodel_maxops) {
+		devmodel_maxops = devmodel_maxops ? 2 * devmodel_maxops : 65536;
+		if ( (devmodel_ops = realloc(devmodel_ops, devmodel_maxops * sizeof(devmodel_op_t))) == NULL) {
+			ERRORPRINTF("Not enough memory for %"PRIi64" operations of the device model\n", devmodel_maxops);
+			exit(1);
+		}
+	}
+
+	if ( (item = hash_table_find(&devmodel_files, (key_t *) name)) == NULL) {
+		file = malloc(sizeof(devmodel_file_t));
+		item_init(&file->item);
+		strncpy(file->name, name, MAX_STRING);
+		file->name[MAX_STRING-1] = 0;
+		file->id = devmodel_nfiles++;
+		file->end = -1;
+		hash_table_insert(&devmodel_files, (key_t *) file->name, &file->item);
+	} else {
+		file = hash_table_entry(item, devmodel_file_t, item);
+	}
+
+	if ( (item = hash_table_find(&devmodel_pids, &key)) == NULL) {
+		p = malloc(sizeof(devmodel_pid_t));
+		item_init(&p->item);
+		p->pid = pid;
+		p->first = devmodel_nops;
+		devmodel_npids++;
+		hash_table_insert(&devmodel_pids, &p->pid, &p->item);
+	} else {
+		p = hash_table_entry(item, devmodel_pid_t, item);
+		devmodel_ops[p->last].next = devmodel_nops;
+	}
+	p->last = devmodel_nops;
+
+	op = &devmodel_ops[devmodel_nops++];
+	op->start = (int64_t) start.tv_sec * 1000000 + start.tv_usec;
+	op->dur = dur;
+	op->offset = offset;
+	op->size = size;
+	op->next = -1;
+	op->file = file->id;
+	op->write = write;
+	op->seq = file->end == offset;
+	file->end = offset + size;
+}
+
+static inline uint64_t devmodel_random() {
+	devmodel_rnd ^= devmodel_rnd >> 12;
+	devmodel_rnd ^= devmodel_rnd << 25;
+	devmodel_rnd ^= devmodel_rnd >> 27;
+	return devmodel_rnd * 2685821657736338717ULL;
+}
+
+/** @return uniformly distributed number from (0, 1] */
+
+static inline double devmodel_uniform() {
+	return ((devmodel_random() >> 11) + 1) * (1.0 / 9007199254740992.0);
+}
+
+/** Samples latency with mean @a mean from the distribution of the model. */
+
+static double devmodel_latency(double mean) {
+	double n;
+
+	switch (devmodel.dist) {
+		case DEVMODEL_DIST_EXP:
+			return -mean * log(devmodel_uniform());
+		case DEVMODEL_DIST_LOGNORMAL:
+			n = sqrt(-2 * log(devmodel_uniform())) * cos(2 * M_PI * devmodel_uniform());
+			return exp(log(mean) - devmodel.sigma * devmodel.sigma / 2 + devmodel.sigma * n);
+		default:
+			return mean;
+	}
+}
+
+static inline uint32_t cache_hash(int64_t key) {
+	return (uint32_t) (((uint64_t) key * 11400714819323198485ULL) >> 32) & cache_mask;
+}
+
+/** @return index of the page @a key in the cache, -1 if not cached */
+
+static int32_t cache_find(int64_t key, uint32_t * slot) {
+	uint32_t s;
+
+	for (s = cache_hash(key); cache_slot[s] != -1; s = (s + 1) & cache_mask) {
+		if (cache_key[cache_slot[s]] == key) {
+			*slot = s;
+			return cache_slot[s];
+		}
+	}
+	*slot = s;
+	return -1;
+}
+
+static void cache_unlink(int32_t i) {
+	if (cache_prev[i] != -1) {
+		cache_next[cache_prev[i]] = cache_next[i];
+	} else {
+		cache_head = cache_next[i];
+	}
+	if (cache_next[i] != -1) {
+		cache_prev[cache_next[i]] = cache_prev[i];
+	} else {
+		cache_tail = cache_prev[i];
+	}
+}
+
+static void cache_push_head(int32_t i) {
+	cache_prev[i] = -1;
+	cache_next[i] = cache_head;
+	if (cache_head != -1) {
+		cache_prev[cache_head] = i;
+	}
+	cache_head = i;
+	if (cache_tail == -1) {
+		cache_tail = i;
+	}
+}
+
+/** Removes entry from slot @a s of the hash table, shifting back entries of the same probe sequence. */
+
+static void cache_slot_remove(uint32_t s) {
+	uint32_t j = s, k;
+
+	cache_slot[s] = -1;
+	for (j = (j + 1) & cache_mask; cache_slot[j] != -1; j = (j + 1) & cache_mask) {
+		k = cache_hash(cache_key[cache_slot[j]]);
+		if ( (j > s && (k <= s || k > j)) || (j < s && k <= s && k > j)) {
+			cache_slot[s] = cache_slot[j];
+			cache_slot[j] = -1;
+			s = j;
+		}
+	}
+}
+
+/** Accesses pages of the range in the cache, missing pages are added (evicting the least recently used ones).
+ *
+ * @return whether all the pages were cached
+ */
+
+static int cache_access(int32_t file, int64_t offset, int64_t size) {
+	int64_t page, last = (offset + size - 1) / DEVMODEL_PAGE;
+	int64_t key;
+	int32_t i;
+	uint32_t s, victim;
+	int hit = 1;
+
+	for (page = offset / DEVMODEL_PAGE; page <= last; page++) {
+		key = (int64_t) file << 36 | page;
+		if ( (i = cache_find(key, &s)) != -1) {
+			cache_unlink(i);
+			cache_push_head(i);
+			continue;
+		}
+		hit = 0;
+		if (cache_used < cache_pages) {
+			i = cache_used++;
+		} else {
+			i = cache_tail;
+			cache_find(cache_key[i], &victim);
+			cache_unlink(i);
+			cache_slot_remove(victim);
+			cache_find(key, &s); //the slot might have moved
+		}
+		cache_key[i] = key;
+		cache_slot[s] = i;
+		cache_push_head(i);
+	}
+	return hit;
+}
+
+/** Serves one call by the device: waits for a free queue slot, then for the latency and then for the shared
+ * bandwidth.
+ *
+ * @arg qd end times of calls in the queue slots, a min-heap
+ * @arg xfer time when the bandwidth is free
+ * @arg now time the call is issued
+ * @return time the call completes
+ */
+
+static double devmodel_device(double * qd, double * xfer, double now, devmodel_op_t * op) {
+	double start = qd[0] > now ? qd[0] : now;
+	double done, tmp;
+	int i = 0, c;
+
+	done = start + devmodel_latency(devmodel.lat[(int) op->write][(int) op->seq]);
+	if (*xfer > done) {
+		done = *xfer;
+	}
+	done += op->size / devmodel.bw[(int) op->write];
+	*xfer = done;
+	devmodel_busy += done - start;
+
+	qd[0] = done; //sift down the slot of this call
+	while ( (c = 2 * i + 1) < devmodel.qd) {
+		if (c + 1 < devmodel.qd && qd[c + 1] < qd[c]) {
+			c++;
+		}
+		if (qd[c] >= qd[i]) {
+			break;
+		}
+		tmp = qd[c];
+		qd[c] = qd[i];
+		qd[i] = tmp;
+		i = c;
+	}
+	return *xfer;
+}
+
+static void devmodel_heap_push(devmodel_pid_t ** heap, int * n, devmodel_pid_t * p) {
+	int i = (*n)++;
+
+	while (i > 0 && heap[(i - 1) / 2]->ready > p->ready) {
+		heap[i] = heap[(i - 1) / 2];
+		i = (i - 1) / 2;
+	}
+	heap[i] = p;
+}
+
+static devmodel_pid_t * devmodel_heap_pop(devmodel_pid_t ** heap, int * n) {
+	devmodel_pid_t * top = heap[0];
+	devmodel_pid_t * last = heap[--(*n)];
+	int i = 0, c;
+
+	while ( (c = 2 * i + 1) < *n) {
+		if (c + 1 < *n && heap[c + 1]->ready < heap[c]->ready) {
+			c++;
+		}
+		if (heap[c]->ready >= last->ready) {
+			break;
+		}
+		heap[i] = heap[c];
+		i = c;
+	}
+	heap[i] = last;
+	return top;
+}
+
+static devmodel_pid_t ** devmodel_heap;
+static int devmodel_heap_n;
+
+static void devmodel_collect_pid(item_t * item) {
+	devmodel_heap[devmodel_heap_n++] = hash_table_entry(item, devmodel_pid_t, item);
+}
+
+/** Runs the discrete-event simulation of all noted calls on the modeled device. */
+
+void devmodel_run() {
+	devmodel_pid_t * p;
+	devmodel_op_t * op, * next;
+	double * qd;
+	double xfer = 0, now, done, think;
+	double dirty = 0, dirty_time = 0;
+	int64_t t0, i;
+	struct timespec t1, t2;
+	int n;
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	memset(&devmodel_stats, 0, sizeof(devmodel_stats));
+	memset(&devmodel_orig, 0, sizeof(devmodel_orig));
+	if (devmodel_nops == 0) {
+		return;
+	}
+
+	t0 = devmodel_ops[0].start;
+	for (i = 0; i < devmodel_nops; i++) {
+		op = &devmodel_ops[i];
+		if (op->start < t0) {
+			t0 = op->start;
+		}
+	}
+	for (i = 0; i < devmodel_nops; i++) {
+		op = &devmodel_ops[i];
+		replay_stats_add(&devmodel_orig, op->size, (uint64_t) op->dur * 1000);
+		if ( (op->start - t0 + op->dur) * 1000.0 > devmodel_orig_end) {
+			devmodel_orig_end = (op->start - t0 + op->dur) * 1000.0;
+		}
+	}
+
+	qd = calloc(devmodel.qd, sizeof(double));
+	devmodel_heap = malloc(devmodel_npids * sizeof(devmodel_pid_t *));
+	devmodel_heap_n = 0;
+	hash_table_apply(&devmodel_pids, devmodel_collect_pid);
+	n = 0;
+	for (i = 0; i < devmodel_heap_n; i++) {
+		p = devmodel_heap[i];
+		p->cur = p->first;
+		p->ready = (devmodel_ops[p->first].start - t0) * 1000.0;
+		devmodel_heap_push(devmodel_heap, &n, p);
+	}
+
+	while (n > 0) {
+		p = devmodel_heap_pop(devmodel_heap, &n);
+		op = &devmodel_ops[p->cur];
+		now = p->ready;
+
+		if ( ! op->write) {
+			devmodel_reads++;
+		}
+		devmodel_seq += op->seq;
+		if ( ! op->write && cache_pages && cache_access(op->file, op->offset, op->size)) {
+			devmodel_hits++;
+			done = now + devmodel.hit;
+		} else if (op->write && devmodel.writeback > 0) {
+			if (cache_pages) {
+				cache_access(op->file, op->offset, op->size);
+			}
+			if (now > dirty_time) { //drain the buffer
+				dirty -= (now - dirty_time) * devmodel.bw[1];
+				dirty = dirty < 0 ? 0 : dirty;
+				dirty_time = now;
+			}
+			done = now + devmodel.hit;
+			if (dirty + op->size > devmodel.writeback) { //wait until there is room
+				done += (dirty + op->size - devmodel.writeback) / devmodel.bw[1];
+				dirty = devmodel.writeback;
+				dirty_time = done;
+				devmodel_waited++;
+			} else {
+				dirty += op->size;
+				devmodel_absorbed++;
+			}
+		} else {
+			if (cache_pages) {
+				cache_access(op->file, op->offset, op->size);
+			}
+			done = devmodel_device(qd, &xfer, now, op);
+		}
+
+		replay_stats_add(&devmodel_stats, op->size, (uint64_t) (done - now));
+		if (done > devmodel_end) {
+			devmodel_end = done;
+		}
+		if (op->next != -1) {
+			next = &devmodel_ops[op->next];
+			think = (next->start - op->start - op->dur) * 1000.0;
+			p->cur = op->next;
+			p->ready = done + (think > 0 ? think : 0);
+			devmodel_heap_push(devmodel_heap, &n, p);
+		}
+	}
+
+	free(qd);
+	free(devmodel_heap);
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	devmodel_runtime = (t2.tv_sec - t1.tv_sec) + (t2.tv_nsec - t1.tv_nsec) / 1e9;
+}
+
+static const char * devmodel_dist_name() {
+	switch (devmodel.dist) {
+		case DEVMODEL_DIST_EXP:
+			return "exp";
+		case DEVMODEL_DIST_LOGNORMAL:
+			return "lognormal";
+		default:
+			return "fixed";
+	}
+}
+
+/** Prints parameters of the model and the prediction. */
+
+void devmodel_report() {
+	int64_t writes = devmodel_nops - devmodel_reads;
+
+	printf("Device model %s: qd %d, read %.1lfus seq / %.1lfus random, write %.1lfus seq / %.1lfus random (%s)\n",
+			devmodel_spec, devmodel.qd, devmodel.lat[0][1] / 1e3, devmodel.lat[0][0] / 1e3, devmodel.lat[1][1] / 1e3,
+			devmodel.lat[1][0] / 1e3, devmodel_dist_name());
+	printf("  bandwidth %.1lf MB/s read, %.1lf MB/s write, page cache %"PRIi64" bytes, write-back %"PRIi64" bytes\n",
+			devmodel.bw[0] / MB, devmodel.bw[1] / MB, devmodel.cache, devmodel.writeback);
+	printf("Modeled calls: %"PRIi64" reads, %"PRIi64" writes, %"PRIi64" bytes, %.1lf%% sequential, %d processes\n",
+			devmodel_reads, writes, devmodel_stats.io_bytes, devmodel_nops ? 100.0 * devmodel_seq / devmodel_nops : 0.0,
+			devmodel_npids);
+	printf("Original IO time: %lfs, predicted: %lfs\n", devmodel_orig_end / 1e9, devmodel_end / 1e9);
+	printf("Original latency: mean %.1lfus, p50 < %.1lfus, p99 < %.1lfus, max %.1lfus\n",
+			devmodel_orig.io_calls ? devmodel_orig.io_time / 1000.0 / devmodel_orig.io_calls : 0.0,
+			replay_stats_percentile(&devmodel_orig, 0.5) / 1000.0, replay_stats_percentile(&devmodel_orig, 0.99) / 1000.0,
+			devmodel_orig.io_max / 1000.0);
+	printf("Predicted latency: mean %.1lfus, p50 < %.1lfus, p99 < %.1lfus, max %.1lfus\n",
+			devmodel_stats.io_calls ? devmodel_stats.io_time / 1000.0 / devmodel_stats.io_calls : 0.0,
+			replay_stats_percentile(&devmodel_stats, 0.5) / 1000.0, replay_stats_percentile(&devmodel_stats, 0.99) / 1000.0,
+			devmodel_stats.io_max / 1000.0);
+	printf("Predicted device load: mean queue depth %.2lf, %.1lf%% busy\n", devmodel_end > 0 ? devmodel_busy / devmodel_end : 0.0,
+			devmodel_end > 0 ? 100.0 * devmodel_busy / devmodel.qd / devmodel_end : 0.0);
+	if (cache_pages) {
+		printf("Page cache: %"PRIi64" of %"PRIi64" reads hit (%.1lf%%)\n", devmodel_hits, devmodel_reads,
+				devmodel_reads ? 100.0 * devmodel_hits / devmodel_reads : 0.0);
+	}
+	if (devmodel.writeback > 0) {
+		printf("Write-back: %"PRIi64" writes absorbed, %"PRIi64" waited for room\n", devmodel_absorbed, devmodel_waited);
+	}
+	printf("Model: %"PRIi64" calls in %lfs (%.2lf M calls/s)\n", devmodel_nops, devmodel_runtime,
+			devmodel_runtime > 0 ? devmodel_nops / devmodel_runtime / 1e6 : 0.0);
+}
+
+void devmodel_finish() {
+	if ( ! devmodel_on) {
+		return;
+	}
+	hash_table_destroy(&devmodel_files);
+	hash_table_destroy(&devmodel_pids);
+	free(devmodel_ops);
+	free(cache_key);
+	free(cache_prev);
+	free(cache_next);
+	free(cache_slot);
+	devmodel_ops = NULL;
+	cache_key = NULL;
+	cache_prev = cache_next = cache_slot = NULL;
+	devmodel_nops = devmodel_maxops = 0;
+	devmodel_on = 0;
+}
@@ -0,0 +1,87 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _DEVMODEL_H_
+#define _DEVMODEL_H_
+
+/** @file devmodel.h
+ *
+ * What-if device model. Reads and writes noted during simulation (-M) are fed into a discrete-event simulation
+ * of a configurable storage device, which predicts how long the trace would take and how long the calls would
+ * last on it. No IO is done.
+ *
+ * Every process is a closed loop: its next call is issued when the previous one completes plus the think time
+ * the process had in the original run (gap between end of the previous read/write and start of the next one,
+ * other syscalls included). The device serves at most qd calls at once. A call takes a latency sampled from
+ * the distribution of its kind (sequential/random read/write; sequential = continues where the previous call
+ * on the same file ended), then transfers its data through the device bandwidth, which is shared by all calls.
+ *
+ * Optionally, a page cache of given size (LRU of 4KB pages) serves reads of cached pages at memory speed
+ * and a write-back buffer absorbs writes, which are drained at the write bandwidth in the background.
+ *
+ * The model is described by comma separated list of a preset (hdd, ssd, nvme) and key=value pairs overriding
+ * it (see help of the -y option).
+ */
+
+#include <stdint.h>
+#include "common.h"
+#include "adt/hash_table.h"
+
+#define DEVMODEL_PAGE 4096
+#define DEVMODEL_HT_SIZE 1024
+#define DEVMODEL_DIST_FIXED 0
+#define DEVMODEL_DIST_EXP 1
+#define DEVMODEL_DIST_LOGNORMAL 2
+
+/** One read or write noted during simulation. */
+typedef struct devmodel_op {
+	int64_t start; ///< original start in usec
+	int64_t offset;
+	int64_t size; ///< bytes really transferred
+	int64_t next; ///< index of the next call of the same process, -1 if none
+	int32_t dur; ///< original duration in usec
+	int32_t file; ///< number of the file
+	char write;
+	char seq; ///< continues where the previous call on the file ended
+} devmodel_op_t;
+
+typedef struct devmodel_file {
+	item_t item;
+	char name[MAX_STRING];
+	int32_t id;
+	int64_t end; ///< where the last call on the file ended
+} devmodel_file_t;
+
+typedef struct devmodel_pid {
+	item_t item;
+	key_t pid;
+	int64_t first; ///< index of the first call
+	int64_t last; ///< index of the last call noted so far
+	int64_t cur; ///< index of the call to be issued next
+	double ready; ///< time when the call can be issued, in ns since the start
+} devmodel_pid_t;
+
+int devmodel_init(const char * spec);
+int devmodel_enabled();
+void devmodel_add(int32_t pid, const char * name, int64_t offset, int64_t size, int write, struct int32timeval start, int32_t dur);
+void devmodel_run();
+void devmodel_report();
+void devmodel_finish();
+
+#endif
@@ -24,6 +24,19 @@
 #include "fdmap.h"
 #include "namemap.h"
 
+int64_t fdmap_mem = 0; ///< memory currently occupied by fd mappings (fd items, fd maps and process tables)
+int64_t fdmap_mem_peak = 0; ///< maximum of fdmap_mem
+
+/** Accounts @a size bytes of memory allocated (or freed, if negative) for fd mappings.
+ */
+
+void fdmap_mem_add(int64_t size) {
+	fdmap_mem += size;
+	if (fdmap_mem > fdmap_mem_peak) {
+		fdmap_mem_peak = fdmap_mem;
+	}
+}
+
 static int ht_compare_fdusage(key_t *key, item_t *item) {
 	fd_usage_t * fd_usage;
 
@@ -55,12 +68,14 @@ static inline void ht_remove_callback_processhash(item_t * item) {
 	process_hash_item_t * p_item;
 	p_item = hash_table_entry(item, process_hash_item_t, item);
 	free(p_item);
+	fdmap_mem_add(-(int64_t)sizeof(process_hash_item_t));
 	return;
 }
 
 inline void ht_remove_callback_fditem(item_t * item) {
 	fd_item_t * fd_item = hash_table_entry(item, fd_item_t, item);	
 	free(fd_item);
+	fdmap_mem_add(-(int64_t)sizeof(fd_item_t));
 }
 
 /** hash table operations. */
@@ -96,7 +111,7 @@ hash_table_operations_t ht_ops_fdmapping = {
 void fd_item_remove_fd_map(item_t * item) {
 	fd_item_t * fd_item = hash_table_entry(item, fd_item_t, item);
 
-	free(fd_item->fd_map);
+	delete_fd_map(fd_item->fd_map);
 }
 
 
@@ -137,6 +152,8 @@ item_t * new_process_ht(int32_t pid) {
 	item_init(&p_ht_it->item);
 	hash_table_init(p_ht_it->ht, HASH_TABLE_SIZE, &ht_ops_fditem);
 	p_ht_it->pid = pid;
+	p_ht_it->mm_pid = pid;
+	fdmap_mem_add(sizeof(process_hash_item_t) + PROCESS_HT_SIZE(p_ht_it->ht));
 
 	return &p_ht_it->item;
 }
@@ -157,6 +174,18 @@ void delete_process_ht(hash_table_t * fd_mappings, int32_t pid) {
 	}
 }
 
+/** Destroys hash table of fd mappings of a process, including all its fd items. Fd maps
+ * are not freed, use delete_fd_map() on them first if they are not used by any other fd item.
+ *
+ * @arg ht hash table to destroy
+ */
+
+void delete_process_table(hash_table_t * ht) {
+	fdmap_mem_add(-(int64_t)PROCESS_HT_SIZE(ht));
+	hash_table_destroy(ht);
+	free(ht);
+}
+
 /** Duplicates whole hash table of fd mappings
  *
  * @parm h Hash table.
@@ -172,6 +201,7 @@ hash_table_t * duplicate_process_ht(hash_table_t * h, hash_table_t * usage_map)
    hash_table_t * ht = malloc(sizeof(hash_table_t));
 
    hash_table_init(ht, h->entries, h->op);
+	fdmap_mem_add(PROCESS_HT_SIZE(ht));
    for (i = 0; i < h->entries; i++) {
       cur = h->entry[i].head;
       while ( cur != NULL ) {
@@ -179,6 +209,7 @@ hash_table_t * duplicate_process_ht(hash_table_t * h, hash_table_t * usage_map)
 			fd_it_old = list_entry(cur, fd_item_t, item);
 
 			fd_it->old_fd = fd_it_old->old_fd;
+			fd_it->cloexec = fd_it_old->cloexec;
 			item_init(&fd_it->item);
 
 			memcpy(fd_it->fd_map, fd_it_old->fd_map, sizeof(fd_map_t));
@@ -271,16 +302,26 @@ inline fd_item_t * new_fd_item() {
 	fd_item->fd_map = malloc(sizeof(fd_map_t));
 	memset(fd_item->fd_map->parent_fds, -1, MAX_PARENT_IDS * sizeof(int));
 	fd_item->fd_map->last_par_index = -1;
+	fd_item->cloexec = 0;
+	fd_item->fd_map->direct = 0;
+	fd_item->fd_map->channel = 0;
+	fdmap_mem_add(sizeof(fd_item_t) + sizeof(fd_map_t));
 	return fd_item;
 }
 
 inline void delete_fd_item(fd_item_t * item) {
-	free(item->fd_map);
+	delete_fd_map(item->fd_map);
 	item->fd_map = NULL;
 	free(item);
+	fdmap_mem_add(-(int64_t)sizeof(fd_item_t));
 	item = NULL;
 }
 
+void delete_fd_map(fd_map_t * fd_map) {
+	free(fd_map);
+	fdmap_mem_add(-(int64_t)sizeof(fd_map_t));
+}
+
 void insert_parent_fd(fd_item_t * fd_item, int fd) {
 	int i;
 	int index = -1;
@@ -37,6 +37,8 @@ typedef struct fd_map {
 	struct int32timeval time_open; ///< when this file was opened
 	char name[MAX_STRING]; ///< name of the file
 	int created; ///< was it newly created or not?
+	int direct; ///< opened with O_DIRECT, IO has to be aligned
+	int channel; ///< my_fd is an end of a real pipe/socketpair created by the replay (PIPE_CHANNELS)
 	int32_t parent_fds[MAX_PARENT_IDS]; ///< array of parent fd numbers - usefull when deleting duplicated fd
 	int32_t last_par_index;
 } fd_map_t;
@@ -44,6 +46,7 @@ typedef struct fd_map {
 typedef struct fd_item {
 	item_t item;
 	int32_t old_fd; ///< key
+	int32_t cloexec; ///< whether the fd is closed on execve
 	fd_map_t * fd_map;
 } fd_item_t;
 
@@ -54,6 +57,19 @@ typedef struct fd_usage {
 } fd_usage_t;
 
 
+/** This structure serves for mapping among memory mappings of the original process and my mappings.
+ */
+
+typedef struct mem_map {
+	item_t item; // I am part of the list of mappings
+	int32_t pid; ///< original process owning the address space of the mapping (see process_hash_item_t)
+	int64_t old_addr; ///< address of the mapping in the original process
+	char * my_addr; ///< address of my mapping
+	int64_t length;
+	int64_t touch_len; ///< how much of the mapping is backed by the file, so it can be touched
+	int writable; ///< whether touching the mapping should dirty the pages
+} mem_map_t;
+
 /** Structure used in the list of hashmaps of fd mappings for each process.
  */
 
@@ -61,12 +77,21 @@ typedef struct process_hash_item {
 	item_t item; // I am part of the list
 	hash_table_t * ht; // file descriptor table
 	int32_t pid; 
+	int32_t mm_pid; ///< process whose address space (memory mappings) it uses, itself unless cloned with CLONE_VM
 } process_hash_item_t;
 
+/** Memory occupied by the hash table of one process, without its items */
+#define PROCESS_HT_SIZE(ht) (sizeof(hash_table_t) + (ht)->entries * sizeof(list_t))
+
+extern int64_t fdmap_mem;
+extern int64_t fdmap_mem_peak;
+
 hash_table_t * get_process_ht(hash_table_t * fd_mappings, int32_t pid);
 item_t * new_process_ht(int32_t pid);
 hash_table_t * duplicate_process_ht(hash_table_t * h, hash_table_t * usage_map);
 void delete_process_ht(hash_table_t * fd_mappings, int32_t pid);
+void delete_process_table(hash_table_t * ht);
+void fdmap_mem_add(int64_t size);
 
 inline void increase_fd_usage(hash_table_t * h, int32_t fd);
 inline int decrease_fd_usage(hash_table_t * h, int32_t fd);
@@ -76,6 +101,7 @@ void delete_fd_usage(fd_usage_t * fd_usage);
 inline fd_item_t * new_fd_item();
 void fd_item_remove_fd_map(item_t * item);
 void delete_fd_item(fd_item_t * item);
+void delete_fd_map(fd_map_t * fd_map);
 void dump_fd_item(fd_item_t * fd_item);
 void dump_fd_list_item(item_t * it);
 void dump_process_hash_list_item(item_t * it);
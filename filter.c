@@ -0,0 +1,315 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "common.h"
+#include "filter.h"
+#include "namemap.h"
+
+int filter_on = 0;
+int64_t filter_from = 0; ///< start of the window in usec from the start of the trace
+int64_t filter_to = -1; ///< end of the window in usec from the start of the trace, -1 = end of the trace
+int32_t filter_pids[FILTER_MAX_PIDS]; ///< pids given by the user
+int filter_pid_count = 0;
+hash_table_t filter_pid_ht; ///< the pids and their descendants seen so far
+int filter_pid_ht_init = 0;
+uint64_t filter_first = 0; ///< time of the first operation of the trace in usec
+int filter_marking = 0; ///< whether to remember operations to drop
+common_op_item_t ** filter_dropped = NULL; ///< operations to be dropped by filter_apply()
+int64_t filter_dropped_count = 0;
+int64_t filter_dropped_size = 0;
+common_op_item_t ** filter_seek_at = NULL; ///< operations after which filter_apply() inserts the seeks
+lseek_item_t ** filter_seeks = NULL; ///< relative seeks replacing the dropped operations
+int64_t filter_seeks_count = 0;
+int64_t filter_seeks_size = 0;
+
+static int ht_compare_filter(key_t *key, item_t *item) {
+	filter_pid_t * fp;
+
+	fp = hash_table_entry(item, filter_pid_t, item);
+	return fp->pid == *key;
+}
+
+static inline void ht_remove_callback_filter(item_t * item) {
+	filter_pid_t * fp = hash_table_entry(item, filter_pid_t, item);	
+	free(fp);
+	return;
+}
+
+/** hash table operations. */
+static hash_table_operations_t ht_ops_filter = {
+	.hash = ht_hash_int,
+	.compare = ht_compare_filter,
+	.remove_callback = ht_remove_callback_filter
+};
+
+/** Sets the time window. 
+ *
+ * @arg spec "<from>:<to>" in seconds from the start of the trace, any of them can be omitted
+ * @return 0 on success, non-zero on parse error
+ */
+
+int filter_set_window(const char * spec) {
+	char * end;
+	double from = 0, to = -1;
+
+	if (*spec != ':') {
+		from = strtod(spec, &end);
+		if (end == spec || from < 0) {
+			return -1;
+		}
+		spec = end;
+	}
+	if (*spec != ':') {
+		return -1;
+	}
+	spec++;
+	if (*spec) {
+		to = strtod(spec, &end);
+		if (end == spec || *end != 0 || to < from) {
+			return -1;
+		}
+	}
+	filter_from = from * 1000000;
+	filter_to = to < 0 ? -1 : to * 1000000;
+	filter_on = 1;
+	return 0;
+}
+
+/** Sets the processes to replay.
+ *
+ * @arg spec comma separated list of pids
+ * @return 0 on success, non-zero on parse error
+ */
+
+int filter_set_pids(const char * spec) {
+	char * end;
+
+	while (filter_pid_count < FILTER_MAX_PIDS) {
+		filter_pids[filter_pid_count] = strtol(spec, &end, 10);
+		if (end == spec || filter_pids[filter_pid_count] <= 0) {
+			return -1;
+		}
+		filter_pid_count++;
+		if (*end == 0) {
+			filter_on = 1;
+			return 0;
+		} else if (*end != ',') {
+			return -1;
+		}
+		spec = end + 1;
+	}
+	ERRORPRINTF("Too many pids, at most %d can be given.\n", FILTER_MAX_PIDS);
+	return -1;
+}
+
+/** Adds glob pattern of files to replay, see namemap_add_only().
+ *
+ * @return 0 on success, non-zero otherwise
+ */
+
+int filter_add_glob(const char * glob) {
+	if (namemap_add_only(glob) != 0) {
+		return -1;
+	}
+	filter_on = 1;
+	return 0;
+}
+
+int filter_enabled() {
+	return filter_on;
+}
+
+static void filter_add_pid(int32_t pid) {
+	filter_pid_t * fp;
+	key_t key = pid;
+
+	if (hash_table_find(&filter_pid_ht, &key) != NULL) {
+		return;
+	}
+	fp = malloc(sizeof(filter_pid_t));
+	item_init(&fp->item);
+	fp->pid = pid;
+	hash_table_insert(&filter_pid_ht, &fp->pid, &fp->item);
+}
+
+/** Prepares for a new pass over the trace.
+ *
+ * @arg mark whether to remember operations out of the slice for filter_apply()
+ */
+
+void filter_start(int mark) {
+	int i;
+
+	if (filter_pid_ht_init) {
+		hash_table_destroy(&filter_pid_ht);
+	}
+	hash_table_init(&filter_pid_ht, HASH_TABLE_SIZE, &ht_ops_filter);
+	filter_pid_ht_init = 1;
+	for (i = 0; i < filter_pid_count; i++) {
+		filter_add_pid(filter_pids[i]);
+	}
+	filter_first = 0;
+	filter_marking = mark;
+	filter_dropped_count = 0;
+	filter_seeks_count = 0;
+}
+
+/** Returns whether operation of type @a type manages fds or processes, so it has to be replayed even out
+ * of the slice. 
+ */
+
+static int filter_is_state(char type) {
+	switch (type) {
+		case OP_OPEN:
+		case OP_CLOSE:
+		case OP_DUP:
+		case OP_DUP2:
+		case OP_DUP3:
+		case OP_CLONE:
+		case OP_PIPE:
+		case OP_SOCKETPAIR:
+		case OP_SOCKET:
+		case OP_EVENTFD:
+		case OP_EPOLL:
+		case OP_TIMERFD:
+		case OP_LSEEK:
+		case OP_LLSEEK:
+		case OP_GETDENTS: //directory positions are opaque cookies, so they can not be skipped by a relative lseek
+		case OP_EXIT:
+		case OP_EXIT_GROUP:
+		case OP_EXECVE:
+		case OP_WAIT:
+			return 1;
+		default:
+			return 0;
+	}
+}
+
+/** Decides whether the operation is in the slice.
+ *
+ * @arg type type of the operation
+ * @arg info info of the operation
+ * @return FILTER_PASS, FILTER_STATE or FILTER_SKIP
+ */
+
+int filter_check(char type, op_info_t * info) {
+	uint64_t t = (uint64_t) info->start.tv_sec * 1000000 + info->start.tv_usec;
+	int64_t rel;
+	key_t key = info->pid;
+
+	if (filter_first == 0) {
+		filter_first = t;
+	}
+	rel = t - filter_first;
+	if ( rel >= filter_from && (filter_to == -1 || rel < filter_to) && 
+			(filter_pid_count == 0 || hash_table_find(&filter_pid_ht, &key) != NULL) ) {
+		return FILTER_PASS;
+	}
+	return filter_is_state(type) ? FILTER_STATE : FILTER_SKIP;
+}
+
+/** Adds the child created by @a clone_it to the pid set, if its parent is there. */
+void filter_clone(clone_item_t * clone_it) {
+	key_t key = clone_it->o.info.pid;
+
+	if (filter_pid_count > 0 && clone_it->o.retval > 0 && hash_table_find(&filter_pid_ht, &key) != NULL) {
+		filter_add_pid(clone_it->o.retval);
+	}
+}
+
+/** Remembers that operation @a com_it is out of the slice, if marking is enabled. Operations managing fds 
+ * or processes are always kept.
+ */
+
+void filter_drop(common_op_item_t * com_it) {
+	if ( ! filter_marking || filter_is_state(com_it->type) ) {
+		return;
+	}
+	if (filter_dropped_count == filter_dropped_size) {
+		filter_dropped_size = filter_dropped_size ? 2 * filter_dropped_size : 1024;
+		filter_dropped = realloc(filter_dropped, filter_dropped_size * sizeof(common_op_item_t *));
+	}
+	filter_dropped[filter_dropped_count++] = com_it;
+}
+
+/** Remembers that the dropped operation @a com_it moved the position of @a fd by @a bytes to @a pos, if 
+ * marking is enabled. filter_apply() replaces it by a relative lseek, so the fd positions stay right.
+ */
+
+void filter_seek(common_op_item_t * com_it, int32_t fd, int64_t bytes, int64_t pos) {
+	lseek_item_t * seek_it;
+
+	if ( ! filter_marking ) {
+		return;
+	}
+	if (filter_seeks_count == filter_seeks_size) {
+		filter_seeks_size = filter_seeks_size ? 2 * filter_seeks_size : 1024;
+		filter_seek_at = realloc(filter_seek_at, filter_seeks_size * sizeof(common_op_item_t *));
+		filter_seeks = realloc(filter_seeks, filter_seeks_size * sizeof(lseek_item_t *));
+	}
+	seek_it = new_lseek_item();
+	seek_it->type = OP_LSEEK;
+	seek_it->o.fd = fd;
+	seek_it->o.flag = SEEK_CUR;
+	seek_it->o.offset = bytes;
+	seek_it->o.retval = pos;
+	memcpy(&seek_it->o.info, get_item_info(com_it), sizeof(op_info_t));
+	filter_seek_at[filter_seeks_count] = com_it;
+	filter_seeks[filter_seeks_count++] = seek_it;
+}
+
+/** Removes operations remembered by filter_drop() from @a list, the ones moving fd positions are replaced 
+ * by the seeks remembered by filter_seek().
+ *
+ * @return number of operations removed
+ */
+
+int64_t filter_apply(list_t * list) {
+	int64_t i;
+
+	for (i = 0; i < filter_seeks_count; i++) {
+		list_insert_after(&filter_seek_at[i]->item, &filter_seeks[i]->item);
+	}
+	for (i = 0; i < filter_dropped_count; i++) {
+		list_remove(list, &filter_dropped[i]->item);
+		free(filter_dropped[i]);
+	}
+	filter_marking = 0;
+	return filter_dropped_count;
+}
+
+void filter_finish() {
+	if (filter_pid_ht_init) {
+		hash_table_destroy(&filter_pid_ht);
+		filter_pid_ht_init = 0;
+	}
+	free(filter_dropped);
+	filter_dropped = NULL;
+	filter_dropped_count = filter_dropped_size = 0;
+	free(filter_seek_at);
+	free(filter_seeks);
+	filter_seek_at = NULL;
+	filter_seeks = NULL;
+	filter_seeks_count = filter_seeks_size = 0;
+}
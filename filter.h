@@ -0,0 +1,65 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _FILTER_H_
+#define _FILTER_H_
+
+/** @file filter.h
+ *
+ * Slices the trace, so only a part of it is replayed, simulated, checked or converted: a time window, 
+ * a set of processes (with all their descendants created by clone) and files matching glob patterns.
+ *
+ * Operations out of the slice which manage file descriptors or processes (open, close, dup, clone, lseek, 
+ * getdents, exit...) are still replayed, but without timing, so the fd mappings stay valid for the operations in the slice.
+ * All other operations out of the slice are skipped; the positions of fds they would move (read, write,
+ * sendfile) are advanced by relative lseeks instead, both in replay and in the converted trace. Files not matching the globs are ignored the same way 
+ * as files from the ignore file (see namemap.h), so no IO is done on them.
+ *
+ * The set of processes is kept in a hash_table, where the key is a pid and data are filter_pid_t structs.
+ */
+
+#include <stdint.h>
+#include "adt/hash_table.h"
+#include "adt/list.h"
+#include "common.h"
+#include "in_common.h"
+
+#define FILTER_PASS 0 ///< the operation is in the slice
+#define FILTER_STATE 1 ///< the operation is out of the slice, but keeps fd mappings up to date
+#define FILTER_SKIP 2 ///< the operation is out of the slice
+#define FILTER_MAX_PIDS 64 ///< maximum number of pids given by the user
+
+typedef struct filter_pid {
+	item_t item;
+	key_t pid;
+} filter_pid_t;
+
+int filter_set_window(const char * spec);
+int filter_set_pids(const char * spec);
+int filter_add_glob(const char * glob);
+int filter_enabled();
+void filter_start(int mark);
+int filter_check(char type, op_info_t * info);
+void filter_clone(clone_item_t * clone_it);
+void filter_drop(common_op_item_t * com_it);
+void filter_seek(common_op_item_t * com_it, int32_t fd, int64_t bytes, int64_t pos);
+int64_t filter_apply(list_t * list);
+void filter_finish();
+
+#endif
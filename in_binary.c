@@ -24,6 +24,7 @@
 
 #include "common.h"
 #include "in_common.h"
+#include "in_binary.h"
 #include "adt/list.h"
 #include "adt/hash_table.h"
 
@@ -405,10 +406,9 @@ int bin_read_dup(FILE * f, char c, list_t * list, int64_t num) {
 	return 0;
 }
 
-int bin_read_pipe(FILE * f, list_t * list, int64_t num) {
+int bin_read_pipe(FILE * f, char c, list_t * list, int64_t num) {
 	int rv;
 	int32_t i32;
-	char c = OP_PIPE;
 	pipe_item_t * op_it;
 	op_it = new_pipe_item();
 	op_it->type = c;
@@ -481,10 +481,9 @@ int bin_read_stat(FILE * f, list_t * list, int64_t num) {
 	return 0;
 }
 
-int bin_read_socket(FILE * f, list_t * list, int64_t num) {
+int bin_read_socket(FILE * f, char c, list_t * list, int64_t num) {
 	int rv;
 	int32_t i32;
-	char c = OP_SOCKET;
 	socket_item_t * op_it;
 	op_it = new_socket_item();
 	op_it->type = c;
@@ -523,136 +522,482 @@ int bin_read_sendfile(FILE * f, list_t * list, int64_t num) {
 	return 0;
 }
 
+int bin_read_rename(FILE * f, list_t * list, int64_t num) {
+	int rv;
+	int32_t i32;
+	char c = OP_RENAME;
+	char buff[MAX_STRING];
+	rename_item_t * op_it;
+	op_it = new_rename_item();
+	op_it->type = c;
+
+	read_int32(i32);
+	if ( (rv = fread(buff, sizeof(char), i32, f)) != i32 ) {
+		BIN_READ_ERROR_FREE;
+	} else {
+		buff[i32] = 0;
+		strncpy(op_it->o.old_name, buff, i32+1);
+	}
+
+	read_int32(i32);
+	if ( (rv = fread(buff, sizeof(char), i32, f)) != i32 ) {
+		BIN_READ_ERROR_FREE;
+	} else {
+		buff[i32] = 0;
+		strncpy(op_it->o.new_name, buff, i32+1);
+	}
+
+	read_int32(op_it->o.retval);
+	
+	if ( (rv = bin_read_info(f, &op_it->o.info, c, num)) != 0) {
+		BIN_READ_ERROR_FREE;
+	}
+
+	list_append(list, &op_it->item);
+	return 0;
+}
+
+int bin_read_link(FILE * f, char c, list_t * list, int64_t num) {
+	int rv;
+	int32_t i32;
+	char buff[MAX_STRING];
+	link_item_t * op_it;
+	op_it = new_link_item();
+	op_it->type = c;
+
+	read_int32(i32);
+	if ( (rv = fread(buff, sizeof(char), i32, f)) != i32 ) {
+		BIN_READ_ERROR_FREE;
+	} else {
+		buff[i32] = 0;
+		strncpy(op_it->o.old_name, buff, i32+1);
+	}
+
+	read_int32(i32);
+	if ( (rv = fread(buff, sizeof(char), i32, f)) != i32 ) {
+		BIN_READ_ERROR_FREE;
+	} else {
+		buff[i32] = 0;
+		strncpy(op_it->o.new_name, buff, i32+1);
+	}
+
+	read_int32(op_it->o.retval);
+	
+	if ( (rv = bin_read_info(f, &op_it->o.info, c, num)) != 0) {
+		BIN_READ_ERROR_FREE;
+	}
+
+	list_append(list, &op_it->item);
+	return 0;
+}
+
+int bin_read_readlink(FILE * f, list_t * list, int64_t num) {
+	int rv;
+	int32_t i32;
+	int64_t i64;
+	char c = OP_READLINK;
+	char buff[MAX_STRING];
+	readlink_item_t * op_it;
+	op_it = new_readlink_item();
+	op_it->type = c;
+
+	read_int32(i32);
+	if ( (rv = fread(buff, sizeof(char), i32, f)) != i32 ) {
+		BIN_READ_ERROR_FREE;
+	} else {
+		buff[i32] = 0;
+		strncpy(op_it->o.name, buff, i32+1);
+	}
+
+	read_int64(op_it->o.size);
+	read_int64(op_it->o.retval);
+	
+	if ( (rv = bin_read_info(f, &op_it->o.info, c, num)) != 0) {
+		BIN_READ_ERROR_FREE;
+	}
+
+	list_append(list, &op_it->item);
+	return 0;
+}
+
+int bin_read_getdents(FILE * f, list_t * list, int64_t num) {
+	int rv;
+	int32_t i32;
+	int64_t i64;
+	char c = OP_GETDENTS;
+	getdents_item_t * op_it;
+	op_it = new_getdents_item();
+	op_it->type = c;
+
+	read_int32(op_it->o.fd);
+	read_int64(op_it->o.size);
+	read_int32(op_it->o.entries);
+	read_int64(op_it->o.retval);
+	
+	if ( (rv = bin_read_info(f, &op_it->o.info, c, num)) != 0) {
+		BIN_READ_ERROR_FREE;
+	}
+
+	list_append(list, &op_it->item);
+	return 0;
+}
+
+int bin_read_mmap(FILE * f, list_t * list, int64_t num) {
+	int rv;
+	int32_t i32;
+	int64_t i64;
+	char c = OP_MMAP;
+	mmap_item_t * op_it;
+	op_it = new_mmap_item();
+	op_it->type = c;
+
+	read_int64(op_it->o.addr);
+	read_int64(op_it->o.length);
+	read_int32(op_it->o.prot);
+	read_int32(op_it->o.flags);
+	read_int32(op_it->o.fd);
+	read_int64(op_it->o.offset);
+	read_int64(op_it->o.retval);
+	
+	if ( (rv = bin_read_info(f, &op_it->o.info, c, num)) != 0) {
+		BIN_READ_ERROR_FREE;
+	}
+
+	list_append(list, &op_it->item);
+	return 0;
+}
+
+int bin_read_mem(FILE * f, char c, list_t * list, int64_t num) {
+	int rv;
+	int32_t i32;
+	int64_t i64;
+	mem_item_t * op_it;
+	op_it = new_mem_item();
+	op_it->type = c;
+
+	read_int64(op_it->o.addr);
+	read_int64(op_it->o.length);
+	read_int32(op_it->o.flags);
+	read_int32(op_it->o.retval);
+	
+	if ( (rv = bin_read_info(f, &op_it->o.info, c, num)) != 0) {
+		BIN_READ_ERROR_FREE;
+	}
+
+	list_append(list, &op_it->item);
+	return 0;
+}
+
+int bin_read_exit(FILE * f, char c, list_t * list, int64_t num) {
+	int rv;
+	int32_t i32;
+	exit_item_t * op_it;
+	op_it = new_exit_item();
+	op_it->type = c;
+
+	read_int32(op_it->o.status);
+	
+	if ( (rv = bin_read_info(f, &op_it->o.info, c, num)) != 0) {
+		BIN_READ_ERROR_FREE;
+	}
+
+	list_append(list, &op_it->item);
+	return 0;
+}
+
+int bin_read_execve(FILE * f, list_t * list, int64_t num) {
+	int rv;
+	int32_t i32;
+	char c = OP_EXECVE;
+	char buff[MAX_STRING];
+	execve_item_t * op_it;
+	op_it = new_execve_item();
+	op_it->type = c;
+
+	read_int32(i32);
+	if ( (rv = fread(buff, sizeof(char), i32, f)) != i32 ) {
+		BIN_READ_ERROR_FREE;
+	} else {
+		buff[i32] = 0;
+		strncpy(op_it->o.name, buff, i32+1);
+	}
+
+	read_int32(op_it->o.retval);
+	
+	if ( (rv = bin_read_info(f, &op_it->o.info, c, num)) != 0) {
+		BIN_READ_ERROR_FREE;
+	}
+
+	list_append(list, &op_it->item);
+	return 0;
+}
+
+int bin_read_wait(FILE * f, list_t * list, int64_t num) {
+	int rv;
+	int32_t i32;
+	char c = OP_WAIT;
+	wait_item_t * op_it;
+	op_it = new_wait_item();
+	op_it->type = c;
+
+	read_int32(op_it->o.pid);
+	read_int32(op_it->o.retval);
+	
+	if ( (rv = bin_read_info(f, &op_it->o.info, c, num)) != 0) {
+		BIN_READ_ERROR_FREE;
+	}
+
+	list_append(list, &op_it->item);
+	return 0;
+}
+
 int bin_get_items(char * filename, list_t * list) {
-	FILE * f;
-	char c;
-	long long i = 0;
+	return bin_stream_items(filename, list, 0, NULL);
+}
 
-	if ((f = fopen(filename, "rb")) == NULL ) {
+/** Same as bin_get_items(), but every @a chunk items the items loaded so far are passed to @a consume and freed
+ * (see consume_items()), so traces bigger than memory can be processed. The rest is consumed at the end.
+ *
+ * @arg chunk number of items to read before consuming
+ * @arg consume function processing the items, NULL to keep all of them in @a list
+ * @return 0 on success, error code otherwise
+ */
+
+int bin_stream_items(char * filename, list_t * list, int64_t chunk, void (* consume)(list_t * list)) {
+	bin_reader_t r;
+	int64_t items;
+	int retval;
+
+	if ( (retval = bin_open_items(&r, filename)) != 0) {
+		return retval;
+	}
+	do {
+		if ( (items = bin_read_items(&r, list, consume ? chunk : 0)) < 0) {
+			bin_close_items(&r);
+			return -1;
+		}
+		if (consume) {
+			consume_items(list, consume);
+		}
+	} while (consume && items == chunk);
+	bin_close_items(&r);
+	return 0;
+}
+
+/** Opens binary file @a filename for reading by bin_read_items(), so more traces can be read at once.
+ *
+ * @arg r reader to initialize
+ * @arg filename the file, it has to exist until bin_close_items()
+ * @return 0 on success, error code otherwise
+ */
+
+int bin_open_items(bin_reader_t * r, char * filename) {
+	if ((r->f = fopen(filename, "rb")) == NULL ) {
 		ERRORPRINTF("Error opening file %s: %s\n", filename, strerror(errno));
 		return errno;
 	}
-	while((c = getc(f)) != EOF) {
-		i++;
+	r->filename = filename;
+	r->count = 0;
+	return 0;
+}
+
+/** Reads next @a chunk items (all the rest if 0) of the trace opened by bin_open_items() and appends them
+ * to @a list.
+ *
+ * @return number of items read, less than @a chunk at the end of the file, -1 on error
+ */
+
+int64_t bin_read_items(bin_reader_t * r, list_t * list, int64_t chunk) {
+	int64_t items = 0;
+	int c;
+
+	while ((chunk == 0 || items < chunk) && (c = getc(r->f)) != EOF) {
+		r->count++;
+		items++;
 		switch (c) {
 			case OP_WRITE:
-				if ( bin_read_write(f, list, i) != 0 ) {
-					ERRORPRINTF("Error reading binary file: %s\n", filename);
+				if ( bin_read_write(r->f, list, r->count) != 0 ) {
+					ERRORPRINTF("Error reading binary file: %s\n", r->filename);
 					return -1;
 				}
 				break;
 			case OP_READ:
-				if ( bin_read_read(f, list, i) != 0 ) {
-					ERRORPRINTF("Error reading binary file: %s\n", filename);
+				if ( bin_read_read(r->f, list, r->count) != 0 ) {
+					ERRORPRINTF("Error reading binary file: %s\n", r->filename);
 					return -1;
 				}
 				break;
 			case OP_PWRITE:
-				if ( bin_read_pwrite(f, list, i) != 0 ) {
-					ERRORPRINTF("Error reading binary file: %s\n", filename);
+				if ( bin_read_pwrite(r->f, list, r->count) != 0 ) {
+					ERRORPRINTF("Error reading binary file: %s\n", r->filename);
 					return -1;
 				}
 				break;
 			case OP_PREAD:
-				if ( bin_read_pread(f, list, i) != 0 ) {
-					ERRORPRINTF("Error reading binary file: %s\n", filename);
+				if ( bin_read_pread(r->f, list, r->count) != 0 ) {
+					ERRORPRINTF("Error reading binary file: %s\n", r->filename);
 					return -1;
 				}
 				break;
 			case OP_OPEN:
-				if ( bin_read_open(f, list, i) != 0 ) {
-					ERRORPRINTF("Error reading binary file: %s\n", filename);
+				if ( bin_read_open(r->f, list, r->count) != 0 ) {
+					ERRORPRINTF("Error reading binary file: %s\n", r->filename);
 					return -1;
 				}
 				break;
 			case OP_CLOSE:
-				if ( bin_read_close(f, list, i) != 0 ) {
-					ERRORPRINTF("Error reading binary file: %s\n", filename);
+				if ( bin_read_close(r->f, list, r->count) != 0 ) {
+					ERRORPRINTF("Error reading binary file: %s\n", r->filename);
 					return -1;
 				}
 				break;
 			case OP_UNLINK:
-				if ( bin_read_unlink(f, list, i) != 0 ) {
-					ERRORPRINTF("Error reading binary file: %s\n", filename);
+				if ( bin_read_unlink(r->f, list, r->count) != 0 ) {
+					ERRORPRINTF("Error reading binary file: %s\n", r->filename);
 					return -1;
 				}
 				break;
 			case OP_LSEEK:
-				if ( bin_read_lseek(f, list, i) != 0 ) {
-					ERRORPRINTF("Error reading binary file: %s\n", filename);
+				if ( bin_read_lseek(r->f, list, r->count) != 0 ) {
+					ERRORPRINTF("Error reading binary file: %s\n", r->filename);
 					return -1;
 				}
 				break;
 			case OP_LLSEEK:
-				if ( bin_read_llseek(f, list, i) != 0 ) {
-					ERRORPRINTF("Error reading binary file: %s\n", filename);
+				if ( bin_read_llseek(r->f, list, r->count) != 0 ) {
+					ERRORPRINTF("Error reading binary file: %s\n", r->filename);
 					return -1;
 				}
 				break;
 			case OP_CLONE:
-				if ( bin_read_clone(f, list, i) != 0 ) {
-					ERRORPRINTF("Error reading binary file: %s\n", filename);
+				if ( bin_read_clone(r->f, list, r->count) != 0 ) {
+					ERRORPRINTF("Error reading binary file: %s\n", r->filename);
 					return -1;
 				}
 				break;
 			case OP_MKDIR:
-				if ( bin_read_mkdir(f, list, i) != 0 ) {
-					ERRORPRINTF("Error reading binary file: %s\n", filename);
+				if ( bin_read_mkdir(r->f, list, r->count) != 0 ) {
+					ERRORPRINTF("Error reading binary file: %s\n", r->filename);
 					return -1;
 				}
 				break;
 			case OP_RMDIR:
-				if ( bin_read_rmdir(f, list, i) != 0 ) {
-					ERRORPRINTF("Error reading binary file: %s\n", filename);
+				if ( bin_read_rmdir(r->f, list, r->count) != 0 ) {
+					ERRORPRINTF("Error reading binary file: %s\n", r->filename);
 					return -1;
 				}
 				break;
 			case OP_DUP:
 			case OP_DUP2:
 			case OP_DUP3:
-				if ( bin_read_dup(f, c, list, i) != 0 ) {
-					ERRORPRINTF("Error reading binary file: %s\n", filename);
+				if ( bin_read_dup(r->f, c, list, r->count) != 0 ) {
+					ERRORPRINTF("Error reading binary file: %s\n", r->filename);
 					return -1;
 				}
 				break;
 			case OP_PIPE:
-				if ( bin_read_pipe(f, list, i) != 0 ) {
-					ERRORPRINTF("Error reading binary file: %s\n", filename);
+			case OP_SOCKETPAIR:
+				if ( bin_read_pipe(r->f, c, list, r->count) != 0 ) {
+					ERRORPRINTF("Error reading binary file: %s\n", r->filename);
 					return -1;
 				}
 				break;
 			case OP_ACCESS:
-				if ( bin_read_access(f, list, i) != 0 ) {
-					ERRORPRINTF("Error reading binary file: %s\n", filename);
+				if ( bin_read_access(r->f, list, r->count) != 0 ) {
+					ERRORPRINTF("Error reading binary file: %s\n", r->filename);
 					return -1;
 				}
 				break;
 			case OP_STAT:
-				if ( bin_read_stat(f, list, i) != 0 ) {
-					ERRORPRINTF("Error reading binary file: %s\n", filename);
+				if ( bin_read_stat(r->f, list, r->count) != 0 ) {
+					ERRORPRINTF("Error reading binary file: %s\n", r->filename);
 					return -1;
 				}
 				break;
 			case OP_SOCKET:
-				if ( bin_read_socket(f, list, i) != 0 ) {
-					ERRORPRINTF("Error reading binary file: %s\n", filename);
+			case OP_EVENTFD:
+			case OP_EPOLL:
+			case OP_TIMERFD:
+				if ( bin_read_socket(r->f, c, list, r->count) != 0 ) {
+					ERRORPRINTF("Error reading binary file: %s\n", r->filename);
 					return -1;
 				}
 				break;
 			case OP_SENDFILE:
-				if ( bin_read_sendfile(f, list, i) != 0 ) {
-					ERRORPRINTF("Error reading binary file: %s\n", filename);
+				if ( bin_read_sendfile(r->f, list, r->count) != 0 ) {
+					ERRORPRINTF("Error reading binary file: %s\n", r->filename);
+					return -1;
+				}
+				break;
+			case OP_RENAME:
+				if ( bin_read_rename(r->f, list, r->count) != 0 ) {
+					ERRORPRINTF("Error reading binary file: %s\n", r->filename);
+					return -1;
+				}
+				break;
+			case OP_LINK:
+			case OP_SYMLINK:
+				if ( bin_read_link(r->f, c, list, r->count) != 0 ) {
+					ERRORPRINTF("Error reading binary file: %s\n", r->filename);
+					return -1;
+				}
+				break;
+			case OP_READLINK:
+				if ( bin_read_readlink(r->f, list, r->count) != 0 ) {
+					ERRORPRINTF("Error reading binary file: %s\n", r->filename);
+					return -1;
+				}
+				break;
+			case OP_GETDENTS:
+				if ( bin_read_getdents(r->f, list, r->count) != 0 ) {
+					ERRORPRINTF("Error reading binary file: %s\n", r->filename);
+					return -1;
+				}
+				break;
+			case OP_MMAP:
+				if ( bin_read_mmap(r->f, list, r->count) != 0 ) {
+					ERRORPRINTF("Error reading binary file: %s\n", r->filename);
+					return -1;
+				}
+				break;
+			case OP_MUNMAP:
+			case OP_MSYNC:
+			case OP_MADVISE:
+				if ( bin_read_mem(r->f, c, list, r->count) != 0 ) {
+					ERRORPRINTF("Error reading binary file: %s\n", r->filename);
+					return -1;
+				}
+				break;
+			case OP_EXIT:
+			case OP_EXIT_GROUP:
+				if ( bin_read_exit(r->f, c, list, r->count) != 0 ) {
+					ERRORPRINTF("Error reading binary file: %s\n", r->filename);
+					return -1;
+				}
+				break;
+			case OP_EXECVE:
+				if ( bin_read_execve(r->f, list, r->count) != 0 ) {
+					ERRORPRINTF("Error reading binary file: %s\n", r->filename);
+					return -1;
+				}
+				break;
+			case OP_WAIT:
+				if ( bin_read_wait(r->f, list, r->count) != 0 ) {
+					ERRORPRINTF("Error reading binary file: %s\n", r->filename);
 					return -1;
 				}
 				break;
 			default:
-				ERRORPRINTF("Unknown operation identifier: '%c' reading item no %lld at filepos:%ld\n", c, i, ftell(f));
+				ERRORPRINTF("Unknown operation identifier: '%c' reading item no %lld at filepos:%ld\n", c, r->count, ftell(r->f));
 				return -1;
 				break;
 		}
 	}
-	fclose(f);
-	return 0;
+	return items;
+}
+
+void bin_close_items(bin_reader_t * r) {
+	fclose(r->f);
 }
 
 ///////////////////////////////
@@ -911,10 +1256,9 @@ int bin_save_rmdir(FILE * f, rmdir_op_t * op_it) {
 	return 0;
 }
 
-int bin_save_pipe(FILE * f, pipe_op_t * op_it) {
+int bin_save_pipe(FILE * f, char c, pipe_op_t * op_it) {
 	int rv;
 	int32_t i32;
-	char c = OP_PIPE;
 
 	write_char(c);
 	write_int32(op_it->fd1);
@@ -968,10 +1312,9 @@ int bin_save_stat(FILE * f, stat_op_t * op_it) {
 	return 0;
 }
 
-int bin_save_socket(FILE * f, socket_op_t * op_it) {
+int bin_save_socket(FILE * f, char c, socket_op_t * op_it) {
 	int rv;
 	int32_t i32;
-	char c = OP_SOCKET;
 
 	write_char(c);
 	write_int32(op_it->retval);
@@ -1003,11 +1346,203 @@ int bin_save_sendfile(FILE * f, sendfile_op_t * op_it) {
 	return 0;
 }
 
+int bin_save_rename(FILE * f, rename_op_t * op_it) {
+	int rv;
+	int32_t i32;
+	int32_t len;
+	char c = OP_RENAME;
+
+	write_char(c);
+	len = strlen(op_it->old_name);
+	write_int32(len);
+	write_string(op_it->old_name, len);
+	len = strlen(op_it->new_name);
+	write_int32(len);
+	write_string(op_it->new_name, len);
+	write_int32(op_it->retval);
+
+	if ( (rv = bin_write_info(f, &op_it->info)) != 0) {
+		BIN_WRITE_ERROR;
+	}
+
+	return 0;
+}
+
+int bin_save_link(FILE * f, char c, link_op_t * op_it) {
+	int rv;
+	int32_t i32;
+	int32_t len;
+
+	write_char(c);
+	len = strlen(op_it->old_name);
+	write_int32(len);
+	write_string(op_it->old_name, len);
+	len = strlen(op_it->new_name);
+	write_int32(len);
+	write_string(op_it->new_name, len);
+	write_int32(op_it->retval);
+
+	if ( (rv = bin_write_info(f, &op_it->info)) != 0) {
+		BIN_WRITE_ERROR;
+	}
+
+	return 0;
+}
+
+int bin_save_readlink(FILE * f, readlink_op_t * op_it) {
+	int rv;
+	int32_t i32;
+	int64_t i64;
+	int32_t len;
+	char c = OP_READLINK;
+
+	write_char(c);
+	len = strlen(op_it->name);
+	write_int32(len);
+	write_string(op_it->name, len);
+	write_int64(op_it->size);
+	write_int64(op_it->retval);
+
+	if ( (rv = bin_write_info(f, &op_it->info)) != 0) {
+		BIN_WRITE_ERROR;
+	}
+
+	return 0;
+}
+
+int bin_save_getdents(FILE * f, getdents_op_t * op_it) {
+	int rv;
+	int32_t i32;
+	int64_t i64;
+	char c = OP_GETDENTS;
+
+	write_char(c);
+	write_int32(op_it->fd);
+	write_int64(op_it->size);
+	write_int32(op_it->entries);
+	write_int64(op_it->retval);
+
+	if ( (rv = bin_write_info(f, &op_it->info)) != 0) {
+		BIN_WRITE_ERROR;
+	}
+
+	return 0;
+}
+
+int bin_save_mmap(FILE * f, mmap_op_t * op_it) {
+	int rv;
+	int32_t i32;
+	int64_t i64;
+	char c = OP_MMAP;
+
+	write_char(c);
+	write_int64(op_it->addr);
+	write_int64(op_it->length);
+	write_int32(op_it->prot);
+	write_int32(op_it->flags);
+	write_int32(op_it->fd);
+	write_int64(op_it->offset);
+	write_int64(op_it->retval);
+
+	if ( (rv = bin_write_info(f, &op_it->info)) != 0) {
+		BIN_WRITE_ERROR;
+	}
+
+	return 0;
+}
+
+int bin_save_mem(FILE * f, char c, mem_op_t * op_it) {
+	int rv;
+	int32_t i32;
+	int64_t i64;
+
+	write_char(c);
+	write_int64(op_it->addr);
+	write_int64(op_it->length);
+	write_int32(op_it->flags);
+	write_int32(op_it->retval);
+
+	if ( (rv = bin_write_info(f, &op_it->info)) != 0) {
+		BIN_WRITE_ERROR;
+	}
+
+	return 0;
+}
+
+int bin_save_exit(FILE * f, char c, exit_op_t * op_it) {
+	int rv;
+	int32_t i32;
+
+	write_char(c);
+	write_int32(op_it->status);
+
+	if ( (rv = bin_write_info(f, &op_it->info)) != 0) {
+		BIN_WRITE_ERROR;
+	}
+
+	return 0;
+}
+
+int bin_save_execve(FILE * f, execve_op_t * op_it) {
+	int rv;
+	int32_t i32;
+	int32_t len;
+	char c = OP_EXECVE;
+
+	write_char(c);
+	len = strlen(op_it->name);
+	write_int32(len);
+	write_string(op_it->name, len);
+	write_int32(op_it->retval);
+
+	if ( (rv = bin_write_info(f, &op_it->info)) != 0) {
+		BIN_WRITE_ERROR;
+	}
+
+	return 0;
+}
+
+int bin_save_wait(FILE * f, wait_op_t * op_it) {
+	int rv;
+	int32_t i32;
+	char c = OP_WAIT;
+
+	write_char(c);
+	write_int32(op_it->pid);
+	write_int32(op_it->retval);
+
+	if ( (rv = bin_write_info(f, &op_it->info)) != 0) {
+		BIN_WRITE_ERROR;
+	}
+
+	return 0;
+}
+
+/** Saves @a list in binary form to @a filename.
+ *
+ * @return 0 on success, error code otherwise
+ */
+
 int bin_save_items(char * filename, list_t * list) {
 	FILE * f;
-	long long i = 0;
-	item_t * item = list->head;
-	common_op_item_t * com_it;
+	int retval;
+
+	if ((f = fopen(filename, "wb")) == NULL ) {
+		ERRORPRINTF("Error opening file %s: %s\n", filename, strerror(errno));
+		return errno;
+	}
+	retval = bin_write_items(f, filename, list);
+	fclose(f);
+	return retval;
+}
+
+/** Appends @a com_it in binary form to already open file @a f.
+ *
+ * @arg filename name of @a f for error messages
+ * @return 0 on success, -1 on error
+ */
+
+int bin_write_item(FILE * f, char * filename, common_op_item_t * com_it) {
 	write_item_t * write_it;
 	read_item_t * read_it;
 	pwrite_item_t * pwrite_it;
@@ -1026,152 +1561,237 @@ int bin_save_items(char * filename, list_t * list) {
 	stat_item_t * stat_it;
 	socket_item_t * socket_it;
 	sendfile_item_t * sendfile_it;
-
-	
-	if ((f = fopen(filename, "wb")) == NULL ) {
-		ERRORPRINTF("Error opening file %s: %s\n", filename, strerror(errno));
-		return errno;
+	rename_item_t * rename_it;
+	link_item_t * link_it;
+	readlink_item_t * readlink_it;
+	getdents_item_t * getdents_it;
+	mmap_item_t * mmap_it;
+	mem_item_t * mem_it;
+	exit_item_t * exit_it;
+	execve_item_t * execve_it;
+	wait_item_t * wait_it;
+
+	switch (com_it->type) {
+		case OP_WRITE:
+			write_it = (write_item_t *) com_it;
+			if ( bin_save_write(f, &write_it->o) != 0 ) {
+				ERRORPRINTF("Error saving to binary file %s\n", filename);
+				return -1;
+			}
+			break;
+		case OP_READ:
+			read_it = (read_item_t *) com_it;
+			if ( bin_save_read(f, &read_it->o) != 0 ) {
+				ERRORPRINTF("Error saving to binary file %s\n", filename);
+				return -1;
+			}
+			break;
+		case OP_PWRITE:
+			pwrite_it = (pwrite_item_t *) com_it;
+			if ( bin_save_pwrite(f, &pwrite_it->o) != 0 ) {
+				ERRORPRINTF("Error saving to binary file %s\n", filename);
+				return -1;
+			}
+			break;
+		case OP_PREAD:
+			pread_it = (pread_item_t *) com_it;
+			if ( bin_save_pread(f, &pread_it->o) != 0 ) {
+				ERRORPRINTF("Error saving to binary file %s\n", filename);
+				return -1;
+			}
+			break;
+		case OP_OPEN:
+			open_it = (open_item_t *) com_it;
+			if ( bin_save_open(f, &open_it->o) != 0 ) {
+				ERRORPRINTF("Error saving to binary file %s\n", filename);
+				return -1;
+			}
+			break;
+		case OP_CLOSE:
+			close_it = (close_item_t *) com_it;
+			if ( bin_save_close(f, &close_it->o) != 0 ) {
+				ERRORPRINTF("Error saving to binary file %s\n", filename);
+				return -1;
+			}
+			break;
+		case OP_UNLINK:
+			unlink_it = (unlink_item_t *) com_it;
+			if ( bin_save_unlink(f, &unlink_it->o) != 0 ) {
+				ERRORPRINTF("Error saving to binary file %s\n", filename);
+				return -1;
+			}
+			break;
+		case OP_LSEEK:
+			lseek_it = (lseek_item_t *) com_it;
+			if ( bin_save_lseek(f, &lseek_it->o) != 0 ) {
+				ERRORPRINTF("Error saving to binary file %s\n", filename);
+				return -1;
+			}
+			break;
+		case OP_LLSEEK:
+			llseek_it = (llseek_item_t *) com_it;
+			if ( bin_save_llseek(f, &llseek_it->o) != 0 ) {
+				ERRORPRINTF("Error saving to binary file %s\n", filename);
+				return -1;
+			}
+			break;
+		case OP_CLONE:
+			clone_it = (clone_item_t *) com_it;
+			if ( bin_save_clone(f, &clone_it->o) != 0 ) {
+				ERRORPRINTF("Error saving to binary file %s\n", filename);
+				return -1;
+			}
+			break;
+		case OP_MKDIR:
+			mkdir_it = (mkdir_item_t *) com_it;
+			if ( bin_save_mkdir(f, &mkdir_it->o) != 0 ) {
+				ERRORPRINTF("Error saving to binary file %s\n", filename);
+				return -1;
+			}
+			break;
+		case OP_RMDIR:
+			rmdir_it = (rmdir_item_t *) com_it;
+			if ( bin_save_rmdir(f, &rmdir_it->o) != 0 ) {
+				ERRORPRINTF("Error saving to binary file %s\n", filename);
+				return -1;
+			}
+			break;
+		case OP_DUP:
+		case OP_DUP2:
+		case OP_DUP3:
+			dup_it = (dup_item_t *) com_it;
+			if ( bin_save_dup(f, com_it->type, &dup_it->o) != 0 ) {
+				ERRORPRINTF("Error saving to binary file %s\n", filename);
+				return -1;
+			}
+			break;
+		case OP_PIPE:
+		case OP_SOCKETPAIR:
+			pipe_it = (pipe_item_t *) com_it;
+			if ( bin_save_pipe(f, com_it->type, &pipe_it->o) != 0 ) {
+				ERRORPRINTF("Error saving to binary file %s\n", filename);
+				return -1;
+			}
+			break;
+		case OP_ACCESS:
+			access_it = (access_item_t *) com_it;
+			if ( bin_save_access(f, &access_it->o) != 0 ) {
+				ERRORPRINTF("Error saving to binary file %s\n", filename);
+				return -1;
+			}
+			break;
+		case OP_STAT:
+			stat_it = (stat_item_t *) com_it;
+			if ( bin_save_stat(f, &stat_it->o) != 0 ) {
+				ERRORPRINTF("Error saving to binary file %s\n", filename);
+				return -1;
+			}
+			break;
+		case OP_SOCKET:
+		case OP_EVENTFD:
+		case OP_EPOLL:
+		case OP_TIMERFD:
+			socket_it = (socket_item_t *) com_it;
+			if ( bin_save_socket(f, com_it->type, &socket_it->o) != 0 ) {
+				ERRORPRINTF("Error saving to binary file %s\n", filename);
+				return -1;
+			}
+			break;
+		case OP_SENDFILE:
+			sendfile_it = (sendfile_item_t *) com_it;
+			if ( bin_save_sendfile(f, &sendfile_it->o) != 0 ) {
+				ERRORPRINTF("Error saving to binary file %s\n", filename);
+				return -1;
+			}
+			break;
+		case OP_RENAME:
+			rename_it = (rename_item_t *) com_it;
+			if ( bin_save_rename(f, &rename_it->o) != 0 ) {
+				ERRORPRINTF("Error saving to binary file %s\n", filename);
+				return -1;
+			}
+			break;
+		case OP_LINK:
+		case OP_SYMLINK:
+			link_it = (link_item_t *) com_it;
+			if ( bin_save_link(f, com_it->type, &link_it->o) != 0 ) {
+				ERRORPRINTF("Error saving to binary file %s\n", filename);
+				return -1;
+			}
+			break;
+		case OP_READLINK:
+			readlink_it = (readlink_item_t *) com_it;
+			if ( bin_save_readlink(f, &readlink_it->o) != 0 ) {
+				ERRORPRINTF("Error saving to binary file %s\n", filename);
+				return -1;
+			}
+			break;
+		case OP_GETDENTS:
+			getdents_it = (getdents_item_t *) com_it;
+			if ( bin_save_getdents(f, &getdents_it->o) != 0 ) {
+				ERRORPRINTF("Error saving to binary file %s\n", filename);
+				return -1;
+			}
+			break;
+		case OP_MMAP:
+			mmap_it = (mmap_item_t *) com_it;
+			if ( bin_save_mmap(f, &mmap_it->o) != 0 ) {
+				ERRORPRINTF("Error saving to binary file %s\n", filename);
+				return -1;
+			}
+			break;
+		case OP_MUNMAP:
+		case OP_MSYNC:
+		case OP_MADVISE:
+			mem_it = (mem_item_t *) com_it;
+			if ( bin_save_mem(f, com_it->type, &mem_it->o) != 0 ) {
+				ERRORPRINTF("Error saving to binary file %s\n", filename);
+				return -1;
+			}
+			break;
+		case OP_EXIT:
+		case OP_EXIT_GROUP:
+			exit_it = (exit_item_t *) com_it;
+			if ( bin_save_exit(f, com_it->type, &exit_it->o) != 0 ) {
+				ERRORPRINTF("Error saving to binary file %s\n", filename);
+				return -1;
+			}
+			break;
+		case OP_EXECVE:
+			execve_it = (execve_item_t *) com_it;
+			if ( bin_save_execve(f, &execve_it->o) != 0 ) {
+				ERRORPRINTF("Error saving to binary file %s\n", filename);
+				return -1;
+			}
+			break;
+		case OP_WAIT:
+			wait_it = (wait_item_t *) com_it;
+			if ( bin_save_wait(f, &wait_it->o) != 0 ) {
+				ERRORPRINTF("Error saving to binary file %s\n", filename);
+				return -1;
+			}
+			break;
+		default:
+			ERRORPRINTF("Unknown operation identifier: '%c'\n", com_it->type);
+			return -1;
+			break;
 	}
+	return 0;
+}
 
-	while (item) { 
-		i++;
-		com_it = list_entry(item, common_op_item_t, item);
-		switch (com_it->type) {
-			case OP_WRITE:
-				write_it = (write_item_t *) com_it;
-				if ( bin_save_write(f, &write_it->o) != 0 ) {
-					ERRORPRINTF("Error saving to binary file %s\n", filename);
-					return -1;
-				}
-				break;
-			case OP_READ:
-				read_it = (read_item_t *) com_it;
-				if ( bin_save_read(f, &read_it->o) != 0 ) {
-					ERRORPRINTF("Error saving to binary file %s\n", filename);
-					return -1;
-				}
-				break;
-			case OP_PWRITE:
-				pwrite_it = (pwrite_item_t *) com_it;
-				if ( bin_save_pwrite(f, &pwrite_it->o) != 0 ) {
-					ERRORPRINTF("Error saving to binary file %s\n", filename);
-					return -1;
-				}
-				break;
-			case OP_PREAD:
-				pread_it = (pread_item_t *) com_it;
-				if ( bin_save_pread(f, &pread_it->o) != 0 ) {
-					ERRORPRINTF("Error saving to binary file %s\n", filename);
-					return -1;
-				}
-				break;
-			case OP_OPEN:
-				open_it = (open_item_t *) com_it;
-				if ( bin_save_open(f, &open_it->o) != 0 ) {
-					ERRORPRINTF("Error saving to binary file %s\n", filename);
-					return -1;
-				}
-				break;
-			case OP_CLOSE:
-				close_it = (close_item_t *) com_it;
-				if ( bin_save_close(f, &close_it->o) != 0 ) {
-					ERRORPRINTF("Error saving to binary file %s\n", filename);
-					return -1;
-				}
-				break;
-			case OP_UNLINK:
-				unlink_it = (unlink_item_t *) com_it;
-				if ( bin_save_unlink(f, &unlink_it->o) != 0 ) {
-					ERRORPRINTF("Error saving to binary file %s\n", filename);
-					return -1;
-				}
-				break;
-			case OP_LSEEK:
-				lseek_it = (lseek_item_t *) com_it;
-				if ( bin_save_lseek(f, &lseek_it->o) != 0 ) {
-					ERRORPRINTF("Error saving to binary file %s\n", filename);
-					return -1;
-				}
-				break;
-			case OP_LLSEEK:
-				llseek_it = (llseek_item_t *) com_it;
-				if ( bin_save_llseek(f, &llseek_it->o) != 0 ) {
-					ERRORPRINTF("Error saving to binary file %s\n", filename);
-					return -1;
-				}
-				break;
-			case OP_CLONE:
-				clone_it = (clone_item_t *) com_it;
-				if ( bin_save_clone(f, &clone_it->o) != 0 ) {
-					ERRORPRINTF("Error saving to binary file %s\n", filename);
-					return -1;
-				}
-				break;
-			case OP_MKDIR:
-				mkdir_it = (mkdir_item_t *) com_it;
-				if ( bin_save_mkdir(f, &mkdir_it->o) != 0 ) {
-					ERRORPRINTF("Error saving to binary file %s\n", filename);
-					return -1;
-				}
-				break;
-			case OP_RMDIR:
-				rmdir_it = (rmdir_item_t *) com_it;
-				if ( bin_save_rmdir(f, &rmdir_it->o) != 0 ) {
-					ERRORPRINTF("Error saving to binary file %s\n", filename);
-					return -1;
-				}
-				break;
-			case OP_DUP:
-			case OP_DUP2:
-			case OP_DUP3:
-				dup_it = (dup_item_t *) com_it;
-				if ( bin_save_dup(f, com_it->type, &dup_it->o) != 0 ) {
-					ERRORPRINTF("Error saving to binary file %s\n", filename);
-					return -1;
-				}
-				break;
-			case OP_PIPE:
-				pipe_it = (pipe_item_t *) com_it;
-				if ( bin_save_pipe(f, &pipe_it->o) != 0 ) {
-					ERRORPRINTF("Error saving to binary file %s\n", filename);
-					return -1;
-				}
-				break;
-			case OP_ACCESS:
-				access_it = (access_item_t *) com_it;
-				if ( bin_save_access(f, &access_it->o) != 0 ) {
-					ERRORPRINTF("Error saving to binary file %s\n", filename);
-					return -1;
-				}
-				break;
-			case OP_STAT:
-				stat_it = (stat_item_t *) com_it;
-				if ( bin_save_stat(f, &stat_it->o) != 0 ) {
-					ERRORPRINTF("Error saving to binary file %s\n", filename);
-					return -1;
-				}
-				break;
-			case OP_SOCKET:
-				socket_it = (socket_item_t *) com_it;
-				if ( bin_save_socket(f, &socket_it->o) != 0 ) {
-					ERRORPRINTF("Error saving to binary file %s\n", filename);
-					return -1;
-				}
-				break;
-			case OP_SENDFILE:
-				sendfile_it = (sendfile_item_t *) com_it;
-				if ( bin_save_sendfile(f, &sendfile_it->o) != 0 ) {
-					ERRORPRINTF("Error saving to binary file %s\n", filename);
-					return -1;
-				}
-				break;
-			default:
-				ERRORPRINTF("Unknown operation identifier: '%c'\n", com_it->type);
-				return -1;
-				break;
+/** Appends @a list in binary form to already open file @a f, so a trace can be written in chunks.
+ *
+ * @arg filename name of @a f for error messages
+ * @return 0 on success, -1 on error
+ */
+
+int bin_write_items(FILE * f, char * filename, list_t * list) {
+	item_t * item;
+
+	for (item = list->head; item; item = item->next) {
+		if (bin_write_item(f, filename, list_entry(item, common_op_item_t, item)) != 0) {
+			return -1;
 		}
-		item = item->next;
 	}
-	fclose(f);
 	return 0;
 }
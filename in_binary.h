@@ -20,7 +20,20 @@
 #ifndef _REPIO_BINARY_H_
 #define _REPIO_BINARY_H_
 
+/** Binary file being read by bin_read_items(). */
+typedef struct bin_reader {
+	FILE * f;
+	char * filename;
+	long long count; ///< items read so far
+} bin_reader_t;
+
 int bin_save_items(char * filename, list_t * list);
+int bin_write_item(FILE * f, char * filename, common_op_item_t * com_it);
+int bin_write_items(FILE * f, char * filename, list_t * list);
 int bin_get_items(char * filename, list_t * list);
+int bin_stream_items(char * filename, list_t * list, int64_t chunk, void (* consume)(list_t * list));
+int bin_open_items(bin_reader_t * r, char * filename);
+int64_t bin_read_items(bin_reader_t * r, list_t * list, int64_t chunk);
+void bin_close_items(bin_reader_t * r);
 
 #endif
@@ -23,6 +23,7 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <sched.h>
+#include <sys/mman.h>
 #include <string.h>
 #include "in_common.h"
 
@@ -177,6 +178,198 @@ sendfile_item_t * new_sendfile_item() {
 	return i;
 }
 
+rename_item_t * new_rename_item() {
+	rename_item_t * i;
+
+	i = malloc(sizeof(rename_item_t));
+	item_init(&i->item);
+	return i;
+}
+
+link_item_t * new_link_item() {
+	link_item_t * i;
+
+	i = malloc(sizeof(link_item_t));
+	item_init(&i->item);
+	return i;
+}
+
+readlink_item_t * new_readlink_item() {
+	readlink_item_t * i;
+
+	i = malloc(sizeof(readlink_item_t));
+	item_init(&i->item);
+	return i;
+}
+
+getdents_item_t * new_getdents_item() {
+	getdents_item_t * i;
+
+	i = malloc(sizeof(getdents_item_t));
+	item_init(&i->item);
+	return i;
+}
+
+mmap_item_t * new_mmap_item() {
+	mmap_item_t * i;
+
+	i = malloc(sizeof(mmap_item_t));
+	item_init(&i->item);
+	return i;
+}
+
+mem_item_t * new_mem_item() {
+	mem_item_t * i;
+
+	i = malloc(sizeof(mem_item_t));
+	item_init(&i->item);
+	return i;
+}
+
+exit_item_t * new_exit_item() {
+	exit_item_t * i;
+
+	i = malloc(sizeof(exit_item_t));
+	item_init(&i->item);
+	return i;
+}
+
+execve_item_t * new_execve_item() {
+	execve_item_t * i;
+
+	i = malloc(sizeof(execve_item_t));
+	item_init(&i->item);
+	return i;
+}
+
+wait_item_t * new_wait_item() {
+	wait_item_t * i;
+
+	i = malloc(sizeof(wait_item_t));
+	item_init(&i->item);
+	return i;
+}
+
+/** @return information common to all operations (pid, start and duration) of @a com_it, NULL for unknown type */
+
+op_info_t * get_item_info(common_op_item_t * com_it) {
+	switch (com_it->type) {
+		case OP_WRITE:
+			return &((write_item_t *) com_it)->o.info;
+		case OP_READ:
+			return &((read_item_t *) com_it)->o.info;
+		case OP_PWRITE:
+			return &((pwrite_item_t *) com_it)->o.info;
+		case OP_PREAD:
+			return &((pread_item_t *) com_it)->o.info;
+		case OP_OPEN:
+			return &((open_item_t *) com_it)->o.info;
+		case OP_CLOSE:
+			return &((close_item_t *) com_it)->o.info;
+		case OP_UNLINK:
+			return &((unlink_item_t *) com_it)->o.info;
+		case OP_LSEEK:
+			return &((lseek_item_t *) com_it)->o.info;
+		case OP_LLSEEK:
+			return &((llseek_item_t *) com_it)->o.info;
+		case OP_CLONE:
+			return &((clone_item_t *) com_it)->o.info;
+		case OP_MKDIR:
+			return &((mkdir_item_t *) com_it)->o.info;
+		case OP_RMDIR:
+			return &((rmdir_item_t *) com_it)->o.info;
+		case OP_DUP:
+		case OP_DUP2:
+		case OP_DUP3:
+			return &((dup_item_t *) com_it)->o.info;
+		case OP_PIPE:
+		case OP_SOCKETPAIR:
+			return &((pipe_item_t *) com_it)->o.info;
+		case OP_ACCESS:
+			return &((access_item_t *) com_it)->o.info;
+		case OP_STAT:
+			return &((stat_item_t *) com_it)->o.info;
+		case OP_SOCKET:
+		case OP_EVENTFD:
+		case OP_EPOLL:
+		case OP_TIMERFD:
+			return &((socket_item_t *) com_it)->o.info;
+		case OP_SENDFILE:
+			return &((sendfile_item_t *) com_it)->o.info;
+		case OP_RENAME:
+			return &((rename_item_t *) com_it)->o.info;
+		case OP_LINK:
+		case OP_SYMLINK:
+			return &((link_item_t *) com_it)->o.info;
+		case OP_READLINK:
+			return &((readlink_item_t *) com_it)->o.info;
+		case OP_GETDENTS:
+			return &((getdents_item_t *) com_it)->o.info;
+		case OP_MMAP:
+			return &((mmap_item_t *) com_it)->o.info;
+		case OP_MUNMAP:
+		case OP_MSYNC:
+		case OP_MADVISE:
+			return &((mem_item_t *) com_it)->o.info;
+		case OP_EXIT:
+		case OP_EXIT_GROUP:
+			return &((exit_item_t *) com_it)->o.info;
+		case OP_EXECVE:
+			return &((execve_item_t *) com_it)->o.info;
+		case OP_WAIT:
+			return &((wait_item_t *) com_it)->o.info;
+		default:
+			return NULL;
+	}
+}
+
+/** Fills @a names with pointers to file names of @a com_it (open, stat, access, mkdir, rmdir, unlink, rename,
+ * link, symlink, readlink and execve), so they can be read or changed in place.
+ *
+ * @arg names array of at least two pointers
+ * @return number of names, 0 for calls without names
+ */
+
+int get_item_names(common_op_item_t * com_it, char ** names) {
+	switch (com_it->type) {
+		case OP_OPEN:
+			names[0] = ((open_item_t *) com_it)->o.name;
+			return 1;
+		case OP_UNLINK:
+			names[0] = ((unlink_item_t *) com_it)->o.name;
+			return 1;
+		case OP_MKDIR:
+			names[0] = ((mkdir_item_t *) com_it)->o.name;
+			return 1;
+		case OP_RMDIR:
+			names[0] = ((rmdir_item_t *) com_it)->o.name;
+			return 1;
+		case OP_ACCESS:
+			names[0] = ((access_item_t *) com_it)->o.name;
+			return 1;
+		case OP_STAT:
+			names[0] = ((stat_item_t *) com_it)->o.name;
+			return 1;
+		case OP_READLINK:
+			names[0] = ((readlink_item_t *) com_it)->o.name;
+			return 1;
+		case OP_EXECVE:
+			names[0] = ((execve_item_t *) com_it)->o.name;
+			return 1;
+		case OP_RENAME:
+			names[0] = ((rename_item_t *) com_it)->o.old_name;
+			names[1] = ((rename_item_t *) com_it)->o.new_name;
+			return 2;
+		case OP_LINK:
+		case OP_SYMLINK:
+			names[0] = ((link_item_t *) com_it)->o.old_name;
+			names[1] = ((link_item_t *) com_it)->o.new_name;
+			return 2;
+		default:
+			return 0;
+	}
+}
+
 /** Removes and unallocates lists of syscalls.
  *
  * @arg list list of syscalls to delete
@@ -206,6 +399,15 @@ int remove_items(list_t * list) {
 	stat_item_t * stat_it;
 	socket_item_t * socket_it;
 	sendfile_item_t * sendfile_it;
+	rename_item_t * rename_it;
+	link_item_t * link_it;
+	readlink_item_t * readlink_it;
+	getdents_item_t * getdents_it;
+	mmap_item_t * mmap_it;
+	mem_item_t * mem_it;
+	exit_item_t * exit_it;
+	execve_item_t * execve_it;
+	wait_item_t * wait_it;
 
 	while (item) { 
 		i++;
@@ -279,6 +481,7 @@ int remove_items(list_t * list) {
 				free(dup_it);
 				break;
 			case OP_PIPE:
+			case OP_SOCKETPAIR:
 				pipe_it = (pipe_item_t *) com_it;
 				item = pipe_it->item.next;
 				free(pipe_it);
@@ -294,6 +497,9 @@ int remove_items(list_t * list) {
 				free(stat_it);
 				break;
 			case OP_SOCKET:
+			case OP_EVENTFD:
+			case OP_EPOLL:
+			case OP_TIMERFD:
 				socket_it = (socket_item_t *) com_it;
 				item = socket_it->item.next;
 				free(socket_it);
@@ -303,6 +509,55 @@ int remove_items(list_t * list) {
 				item = sendfile_it->item.next;
 				free(sendfile_it);
 				break;
+			case OP_RENAME:
+				rename_it = (rename_item_t *) com_it;
+				item = rename_it->item.next;
+				free(rename_it);
+				break;
+			case OP_LINK:
+			case OP_SYMLINK:
+				link_it = (link_item_t *) com_it;
+				item = link_it->item.next;
+				free(link_it);
+				break;
+			case OP_READLINK:
+				readlink_it = (readlink_item_t *) com_it;
+				item = readlink_it->item.next;
+				free(readlink_it);
+				break;
+			case OP_GETDENTS:
+				getdents_it = (getdents_item_t *) com_it;
+				item = getdents_it->item.next;
+				free(getdents_it);
+				break;
+			case OP_MMAP:
+				mmap_it = (mmap_item_t *) com_it;
+				item = mmap_it->item.next;
+				free(mmap_it);
+				break;
+			case OP_MUNMAP:
+			case OP_MSYNC:
+			case OP_MADVISE:
+				mem_it = (mem_item_t *) com_it;
+				item = mem_it->item.next;
+				free(mem_it);
+				break;
+			case OP_EXIT:
+			case OP_EXIT_GROUP:
+				exit_it = (exit_item_t *) com_it;
+				item = exit_it->item.next;
+				free(exit_it);
+				break;
+			case OP_EXECVE:
+				execve_it = (execve_item_t *) com_it;
+				item = execve_it->item.next;
+				free(execve_it);
+				break;
+			case OP_WAIT:
+				wait_it = (wait_item_t *) com_it;
+				item = wait_it->item.next;
+				free(wait_it);
+				break;
 			default:
 				ERRORPRINTF("Unknown operation identifier: '%c'\n", com_it->type);
 				return -1;
@@ -313,6 +568,15 @@ int remove_items(list_t * list) {
 }
 
 
+/** Passes all items of @a list to @a consume, then frees them and leaves @a list empty. Used by the streaming
+ * loaders (strace_stream_items(), bin_stream_items()).
+ */
+
+void consume_items(list_t * list, void (* consume)(list_t * list)) {
+	consume(list);
+	remove_items(list);
+	list_init(list);
+}
 
 /** Reads integer from string @a str and stores it to the memore referenced by @a num.
  * This function DOES error checking. And it also skips the last possible space char.
@@ -365,8 +629,12 @@ int read_open_flag(char * s) {
 		flag |= O_RDWR;
 	} else if ( !strcmp(s, "O_ASYNC")) {
 		flag |= O_ASYNC;
-	} else if ( !strcmp(s, "O_CLOEXEC")) { //this is only defined on kernels 2.6.23+, which we are not yet using..
+	} else if ( !strcmp(s, "O_CLOEXEC")) { //this is only defined on kernels 2.6.23+
+#ifdef O_CLOEXEC
+		flag |= O_CLOEXEC;
+#else
 		DEBUGPRINTF("Unsuported flag: %s\n", "O_CLOEXEC");			
+#endif
 	} else if ( !strcmp(s, "O_CREAT")) {
 		flag |= O_CREAT;
 #ifdef _GNU_SOURCE			
@@ -439,6 +707,8 @@ int read_clone_flag(char * s) {
 
 	if (!strcmp(s, "CLONE_FILES")) {
 		flag |= CLONE_FILES;
+	} else if (!strcmp(s, "CLONE_VM")) {
+		flag |= CLONE_VM;
 	}
 	return flag;
 }
@@ -508,6 +778,108 @@ int read_dup3_flags(char * str) {
 #endif
 }
 
+int read_mmap_prot_flag(char * s) {
+	int flag = 0;
+
+	if (!strcmp(s, "PROT_READ")) {
+		flag |= PROT_READ;
+	} else if ( !strcmp(s, "PROT_WRITE")) {
+		flag |= PROT_WRITE;
+	} else if ( !strcmp(s, "PROT_EXEC")) {
+		flag |= PROT_EXEC;
+	}
+	return flag;
+}
+
+int read_mmap_prot(char * str) {
+	int flags = 0;
+	char * s = NULL;
+
+	s = strtok(str, "|");
+	while ( s ) {
+		flags |= read_mmap_prot_flag(s);
+		s = strtok(NULL, "|");
+	}
+	return flags;
+}
+
+/** Reads some flag that can be in mmap(2) sys call. Only important ones are parsed.
+ */
+
+int read_mmap_flag(char * s) {
+	int flag = 0;
+
+	if (!strcmp(s, "MAP_SHARED")) {
+		flag |= MAP_SHARED;
+	} else if ( !strcmp(s, "MAP_PRIVATE")) {
+		flag |= MAP_PRIVATE;
+	} else if ( !strcmp(s, "MAP_ANONYMOUS") || !strcmp(s, "MAP_ANON")) {
+		flag |= MAP_ANONYMOUS;
+	} else if ( !strcmp(s, "MAP_FIXED")) {
+		flag |= MAP_FIXED;
+	} else if ( !strcmp(s, "MAP_NORESERVE")) {
+		flag |= MAP_NORESERVE;
+	} else if ( !strcmp(s, "MAP_POPULATE")) {
+		flag |= MAP_POPULATE;
+	} else if ( !strcmp(s, "MAP_LOCKED")) {
+		flag |= MAP_LOCKED;
+	}
+	return flag;
+}
+
+int read_mmap_flags(char * str) {
+	int flags = 0;
+	char * s = NULL;
+
+	s = strtok(str, "|");
+	while ( s ) {
+		flags |= read_mmap_flag(s);
+		s = strtok(NULL, "|");
+	}
+	return flags;
+}
+
+int read_msync_flag(char * s) {
+	int flag = 0;
+
+	if (!strcmp(s, "MS_ASYNC")) {
+		flag |= MS_ASYNC;
+	} else if ( !strcmp(s, "MS_SYNC")) {
+		flag |= MS_SYNC;
+	} else if ( !strcmp(s, "MS_INVALIDATE")) {
+		flag |= MS_INVALIDATE;
+	}
+	return flag;
+}
+
+int read_msync_flags(char * str) {
+	int flags = 0;
+	char * s = NULL;
+
+	s = strtok(str, "|");
+	while ( s ) {
+		flags |= read_msync_flag(s);
+		s = strtok(NULL, "|");
+	}
+	return flags;
+}
+
+int read_madvise_advice(char * s) {
+	if (!strcmp(s, "MADV_NORMAL")) {
+		return MADV_NORMAL;
+	} else if ( !strcmp(s, "MADV_RANDOM")) {
+		return MADV_RANDOM;
+	} else if ( !strcmp(s, "MADV_SEQUENTIAL")) {
+		return MADV_SEQUENTIAL;
+	} else if ( !strcmp(s, "MADV_WILLNEED")) {
+		return MADV_WILLNEED;
+	} else if ( !strcmp(s, "MADV_DONTNEED")) {
+		return MADV_DONTNEED;
+	}
+	DEBUGPRINTF("Unsupported madvise advice: %s\n", s);			
+	return MADV_NORMAL;
+}
+
 struct int32timeval read_time(char * timestr) {
 	struct int32timeval tv;
 	tv.tv_sec = 0;
@@ -155,6 +155,60 @@ typedef struct sendfile_item {
 	sendfile_op_t o;
 } sendfile_item_t;
 
+typedef struct rename_item {	
+	item_t item;
+	char type;
+	rename_op_t o;
+} rename_item_t;
+
+typedef struct link_item {	
+	item_t item;
+	char type;
+	link_op_t o;
+} link_item_t;
+
+typedef struct readlink_item {	
+	item_t item;
+	char type;
+	readlink_op_t o;
+} readlink_item_t;
+
+typedef struct getdents_item {	
+	item_t item;
+	char type;
+	getdents_op_t o;
+} getdents_item_t;
+
+typedef struct mmap_item {	
+	item_t item;
+	char type;
+	mmap_op_t o;
+} mmap_item_t;
+
+typedef struct mem_item {	
+	item_t item;
+	char type;
+	mem_op_t o;
+} mem_item_t;
+
+typedef struct exit_item {	
+	item_t item;
+	char type;
+	exit_op_t o;
+} exit_item_t;
+
+typedef struct execve_item {	
+	item_t item;
+	char type;
+	execve_op_t o;
+} execve_item_t;
+
+typedef struct wait_item {	
+	item_t item;
+	char type;
+	wait_op_t o;
+} wait_item_t;
+
 /* Functions for creating new structures
  */
 
@@ -176,8 +230,20 @@ access_item_t * new_access_item();
 stat_item_t * new_stat_item();
 socket_item_t * new_socket_item();
 sendfile_item_t * new_sendfile_item();
+rename_item_t * new_rename_item();
+link_item_t * new_link_item();
+readlink_item_t * new_readlink_item();
+getdents_item_t * new_getdents_item();
+mmap_item_t * new_mmap_item();
+mem_item_t * new_mem_item();
+exit_item_t * new_exit_item();
+execve_item_t * new_execve_item();
+wait_item_t * new_wait_item();
 
 int remove_items(list_t * list);
+op_info_t * get_item_info(common_op_item_t * com_it);
+int get_item_names(common_op_item_t * com_it, char ** names);
+void consume_items(list_t * list, void (* consume)(list_t * list));
 
 int strccount(char * str, char c);
 
@@ -188,6 +254,10 @@ int read_open_flags(char * flags);
 int read_seek_flag(char * flag);
 int read_access_flags(char * str);
 int read_dup3_flags(char * str);
+int read_mmap_prot(char * str);
+int read_mmap_flags(char * str);
+int read_msync_flags(char * str);
+int read_madvise_advice(char * str);
 struct int32timeval read_time(char * timestr);
 int32_t read_duration(char * timestr);
 #endif
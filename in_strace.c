@@ -488,37 +488,76 @@ int strace_read_unlink(char * line, list_t * list) {
 	return 0;
 }
 
-/** Reads pipe event from strace file.
+/** Returns position of the return value part (i.e. ") = ") of the line. Unlike strstr, it finds the last one, so
+ * it is not confused by arguments printed in full.
+ *
+ * @arg line line to search
+ * @return pointer to the last ") = " in the @a line, NULL if there is none
+ */
+
+char * strace_pos_retval(char * line) {
+	char * c = line;
+	char * last = NULL;
+
+	while ( (c = strstr(c, ") = ")) != NULL ) {
+		last = c;
+		c++;
+	}
+	return last;
+}
+
+/** Reads pipe, pipe2 or socketpair event from strace file.
  * 
  *
  * @arg f file from which to read, must be opened
+ * @arg c type of the operation: OP_PIPE or OP_SOCKETPAIR
  * @arg list list to which to append new structure
  * @return 0 on success, non-zero otherwise
  */
 
-int strace_read_pipe(char * line, list_t * list) {
+int strace_read_pipe(char * line, char c, list_t * list) {
 	pipe_item_t * op_item;
 	int retval;
    char start_time[MAX_TIME_STRING];
-   char dur[MAX_TIME_STRING];
+   char dur[MAX_TIME_STRING] = "0";
+	char flags[MAX_STRING];
+	char * line2;
 
 	op_item = new_pipe_item();
-	op_item->type = OP_PIPE;
+	op_item->type = c;
 	op_item->o.mode = 0;
 	
-	if ((retval = sscanf(line, " %d %s %*[^[][%d, %d]) = %d%*[^<]<%[^>]", &op_item->o.info.pid, start_time, &op_item->o.fd1, &op_item->o.fd2, &op_item->o.retval, dur)) == EOF) {
+	if ((retval = sscanf(line, " %d %s %*[^[][%d, %d]", &op_item->o.info.pid, start_time, &op_item->o.fd1, &op_item->o.fd2)) == EOF) {
 		ERRORPRINTF("Error: unexpected end of file%s", "\n");
 		free(op_item);
 		return -1;
 	} 
 
-	if (retval != 6) { //mode flag was not present there
+	if (retval != 4) {
 		ERRORPRINTF("Error: It was not able to match all fields required.%s", "\n");
 		ERRORPRINTF("Failing line: %s", line);
 		free(op_item);
 		return -1;
 	}
 
+	line2 = strace_pos_retval(line);
+	if (line2 == NULL || (retval = sscanf(line2, ") = %d%*[^<]<%[^>]", &op_item->o.retval, dur)) < 1) {
+		ERRORPRINTF("Error: It was not able to match all fields required while parsing line2.%s", "\n");
+		ERRORPRINTF("Failing line: %s", line);
+		free(op_item);
+		return -1;
+	}
+
+	if (c == OP_SOCKETPAIR) {
+#ifdef O_CLOEXEC
+		if (strstr(line, "SOCK_CLOEXEC") != NULL) {
+			op_item->o.mode = O_CLOEXEC;
+		}
+#endif
+	} else if ((line2 = strstr(line, "]")) != NULL && sscanf(line2, "], %" QUOTE(MAX_STRING) "[^)]", flags) == 1) { //pipe2 flags
+		op_item->o.mode = read_open_flags(flags);
+	}
+
    op_item->o.info.start = read_time(start_time);
    op_item->o.info.dur = read_duration(dur);
 
@@ -990,22 +1029,24 @@ int strace_read_stat(char * line, list_t * list) {
 	return 0;
 }
 
-/** Reads socket event from strace file.
+/** Reads socket event from strace file. Other calls creating a single non-file fd (eventfd, epoll_create,
+ * timerfd_create) are read the same way.
  * 
  *
  * @arg f file from which to read, must be opened
+ * @arg c type of the operation: OP_SOCKET, OP_EVENTFD, OP_EPOLL or OP_TIMERFD
  * @arg list list to which to append new structure
  * @return 0 on success, non-zero otherwise
  */
 
-int read_socket_strace(char * line, list_t * list) {
+int read_socket_strace(char * line, char c, list_t * list) {
 	socket_item_t * op_item;
 	int retval;
    char start_time[MAX_TIME_STRING];
    char dur[MAX_TIME_STRING] = "0";
 
 	op_item = new_socket_item();
-	op_item->type = OP_SOCKET;
+	op_item->type = c;
 
 	if ((retval = sscanf(line, "%d %s %*[^)]) = %d%*[^<]<%[^>]", &op_item->o.info.pid, start_time, &op_item->o.retval, dur)) == EOF) {
 		ERRORPRINTF("Error: unexpected end of file%s", "\n");
@@ -1026,6 +1067,474 @@ int read_socket_strace(char * line, list_t * list) {
 	return 0;
 }
 
+/** Reads rename event from strace file. It handles rename(2), renameat(2) and renameat2(2) calls,
+ * the directory file descriptors of the *at variants are ignored.
+ *
+ * @arg f file from which to read, must be opened
+ * @arg list list to which to append new structure
+ * @return 0 on success, non-zero otherwise
+ */
+
+int strace_read_rename(char * line, list_t * list) {
+	rename_item_t * op_item;
+	int retval;
+   char start_time[MAX_TIME_STRING];
+   char dur[MAX_TIME_STRING] = "0";
+
+	op_item = new_rename_item();
+	op_item->type = OP_RENAME;
+
+	if ((retval = sscanf(line, "%d %s %*[^\"]\"%" QUOTE(MAX_STRING) "[^\"]\"%*[^\"]\"%" QUOTE(MAX_STRING) "[^\"]\"%*[^=]= %d%*[^<]<%[^>]",
+					&op_item->o.info.pid, start_time, op_item->o.old_name, op_item->o.new_name, &op_item->o.retval, dur)) == EOF) {
+		ERRORPRINTF("Error: unexpected end of file%s", "\n");
+		free(op_item);
+		return -1;
+	} 
+
+	if (retval != 6) {
+		ERRORPRINTF("Error: It was not able to match all fields required: %d\n", retval);
+		ERRORPRINTF("Failing line: %s\n", line);
+		free(op_item);
+		return -1;
+	}
+
+   op_item->o.info.start = read_time(start_time);
+   op_item->o.info.dur = read_duration(dur);
+
+	list_append(list, &op_item->item);
+	return 0;
+}
+
+/** Reads link or symlink event from strace file. It handles link(2), linkat(2), symlink(2) and symlinkat(2)
+ * calls, the directory file descriptors of the *at variants are ignored.
+ *
+ * @arg f file from which to read, must be opened
+ * @arg c type of the operation, OP_LINK or OP_SYMLINK
+ * @arg list list to which to append new structure
+ * @return 0 on success, non-zero otherwise
+ */
+
+int strace_read_link(char * line, char c, list_t * list) {
+	link_item_t * op_item;
+	int retval;
+   char start_time[MAX_TIME_STRING];
+   char dur[MAX_TIME_STRING] = "0";
+
+	op_item = new_link_item();
+	op_item->type = c;
+
+	if ((retval = sscanf(line, "%d %s %*[^\"]\"%" QUOTE(MAX_STRING) "[^\"]\"%*[^\"]\"%" QUOTE(MAX_STRING) "[^\"]\"%*[^=]= %d%*[^<]<%[^>]",
+					&op_item->o.info.pid, start_time, op_item->o.old_name, op_item->o.new_name, &op_item->o.retval, dur)) == EOF) {
+		ERRORPRINTF("Error: unexpected end of file%s", "\n");
+		free(op_item);
+		return -1;
+	} 
+
+	if (retval != 6) {
+		ERRORPRINTF("Error: It was not able to match all fields required: %d\n", retval);
+		ERRORPRINTF("Failing line: %s\n", line);
+		free(op_item);
+		return -1;
+	}
+
+   op_item->o.info.start = read_time(start_time);
+   op_item->o.info.dur = read_duration(dur);
+
+	list_append(list, &op_item->item);
+	return 0;
+}
+
+/** Reads readlink event from strace file. It handles both readlink(2) and readlinkat(2) calls.
+ *
+ * @arg f file from which to read, must be opened
+ * @arg list list to which to append new structure
+ * @return 0 on success, non-zero otherwise
+ */
+
+int strace_read_readlink(char * line, list_t * list) {
+	readlink_item_t * op_item;
+	int retval;
+   char start_time[MAX_TIME_STRING];
+   char dur[MAX_TIME_STRING] = "0";
+	char * line2;
+
+	op_item = new_readlink_item();
+	op_item->type = OP_READLINK;
+
+	//first portion - the path
+	if ((retval = sscanf(line, "%d %s %*[^\"]\"%" QUOTE(MAX_STRING) "[^\"]\", ", &op_item->o.info.pid, start_time, op_item->o.name)) == EOF) {
+		ERRORPRINTF("Error: unexpected end of file%s", "\n");
+		free(op_item);
+		return -1;
+	} 
+
+	if (retval != 3) {
+		ERRORPRINTF("Error: It was not able to match all fields required: %d\n", retval);
+		ERRORPRINTF("Failing line: %s\n", line);
+		free(op_item);
+		return -1;
+	}
+
+	//second part - the buffer is printed as a string, skip it
+	line2 = strstr(line, op_item->o.name);
+	line2 = strace_pos_comma(line2 + strlen(op_item->o.name) + 1);
+	if (line2 == NULL || (retval = sscanf(line2, ", %"SCNi64") = %"SCNi64"%*[^<]<%[^>]", &op_item->o.size, &op_item->o.retval, dur)) == EOF) {
+		ERRORPRINTF("Error: unexpected end of line%s", "\n");
+		free(op_item);
+		return -1;
+	}
+	if (retval != 3) {
+		ERRORPRINTF("Error: It was not able to match all fields required while parsing line2:%d\n", retval);
+		ERRORPRINTF("Failing line:%s", line);
+		free(op_item);
+		return -1;
+	}
+
+   op_item->o.info.start = read_time(start_time);
+   op_item->o.info.dur = read_duration(dur);
+
+	list_append(list, &op_item->item);
+	return 0;
+}
+
+/** Reads getdents/getdents64 event from strace file. The entries are either abbreviated by strace
+ * (e.g. / * 5 entries * /) or printed in full when strace runs with -v, in that case they are counted.
+ *
+ * @arg line line to parse
+ * @arg list list to which to append new structure
+ * @return 0 on success, non-zero otherwise
+ */
+
+int strace_read_getdents(char * line, list_t * list) {
+	getdents_item_t * op_item;
+	int retval;
+   char start_time[MAX_TIME_STRING];
+   char dur[MAX_TIME_STRING] = "0";
+	char * line2;
+	char * c;
+
+	op_item = new_getdents_item();
+	op_item->type = OP_GETDENTS;
+	
+	//first portion
+	if ((retval = sscanf(line, " %d %s %*[^(](%d, ", &op_item->o.info.pid, start_time, &op_item->o.fd)) == EOF) {
+		ERRORPRINTF("Error: unexpected end of line%s", "\n");
+		free(op_item);
+		return -1;
+	}
+	if (retval != 3) {
+		ERRORPRINTF("Error: It was not able to match all fields required:%d\n", retval);
+		ERRORPRINTF("Failing line: %s", line);
+		free(op_item);
+		return -1;
+	}
+
+	//number of entries
+	op_item->o.entries = -1;
+	if ( (c = strstr(line, "/* ")) != NULL && sscanf(c, "/* %"SCNi32" entries */", &op_item->o.entries) == 1) {
+		//strace abbreviated them
+	} else if ( (c = strstr(line, "d_ino=")) != NULL ) {
+		op_item->o.entries = 0;
+		while (c) {
+			op_item->o.entries++;
+			c = strstr(c + 1, "d_ino=");
+		}
+	} else if ( strstr(line, "[]") != NULL ) {
+		op_item->o.entries = 0;
+	}
+
+	//second part - the size of the buffer is after the last comma before the return value
+	line2 = strace_pos_retval(line);
+	if (line2 != NULL) {
+		while (line2 > line && *line2 != ',') {
+			line2--;
+		}
+	}
+
+	if (line2 == NULL || line2 == line || (retval = sscanf(line2, ", %"SCNi64") = %"SCNi64"%*[^<]<%[^>]", &op_item->o.size, &op_item->o.retval, dur)) == EOF) {
+		ERRORPRINTF("Error: unexpected end of line%s", "\n");
+		free(op_item);
+		return -1;
+	}
+	if (retval != 3) {
+		ERRORPRINTF("Error: It was not able to match all fields required while parsing line2:%d\n", retval);
+		ERRORPRINTF("Failing line:%s", line);
+		free(op_item);
+		return -1;
+	}
+
+   op_item->o.info.start = read_time(start_time);
+   op_item->o.info.dur = read_duration(dur);
+
+	list_append(list, &op_item->item);
+	return 0;
+}
+
+/** Reads mmap/mmap2 event from strace file. Offset of mmap2 is converted to bytes.
+ *
+ * @arg line line to parse
+ * @arg list list to which to append new structure
+ * @return 0 on success, non-zero otherwise
+ */
+
+int strace_read_mmap(char * line, list_t * list) {
+	mmap_item_t * op_item;
+	int retval;
+   char start_time[MAX_TIME_STRING];
+   char dur[MAX_TIME_STRING] = "0";
+	char addr[MAX_STRING];
+	char prot[MAX_STRING];
+	char flags[MAX_STRING];
+	char offset[MAX_STRING];
+	char ret[MAX_STRING];
+
+	op_item = new_mmap_item();
+	op_item->type = OP_MMAP;
+
+	if ((retval = sscanf(line, " %d %s %*[^(](%[^,], %"SCNi64", %[^,], %[^,], %d, %[^)]) = %s%*[^<]<%[^>]", &op_item->o.info.pid,
+					start_time, addr, &op_item->o.length, prot, flags, &op_item->o.fd, offset, ret, dur)) == EOF) {
+		ERRORPRINTF("Error: unexpected end of line%s", "\n");
+		free(op_item);
+		return -1;
+	}
+	if (retval != 10) {
+		ERRORPRINTF("Error: It was not able to match all fields required:%d\n", retval);
+		ERRORPRINTF("Failing line: %s", line);
+		free(op_item);
+		return -1;
+	}
+
+	op_item->o.addr = strtoull(addr, NULL, 0); // NULL is read as 0
+	op_item->o.offset = strtoull(offset, NULL, 0);
+	if (strstr(line, "mmap2(") != NULL) { //offset is in 4096 units
+		op_item->o.offset *= 4096;
+	}
+	if (ret[0] == '-') {
+		op_item->o.retval = -1;
+	} else {
+		op_item->o.retval = strtoull(ret, NULL, 0);
+	}
+	op_item->o.prot = read_mmap_prot(prot);
+	op_item->o.flags = read_mmap_flags(flags);
+
+   op_item->o.info.start = read_time(start_time);
+   op_item->o.info.dur = read_duration(dur);
+
+	list_append(list, &op_item->item);
+	return 0;
+}
+
+/** Reads munmap, msync or madvise event from strace file.
+ *
+ * @arg line line to parse
+ * @arg c type of the operation: OP_MUNMAP, OP_MSYNC or OP_MADVISE
+ * @arg list list to which to append new structure
+ * @return 0 on success, non-zero otherwise
+ */
+
+int strace_read_mem(char * line, char c, list_t * list) {
+	mem_item_t * op_item;
+	int retval;
+   char start_time[MAX_TIME_STRING];
+   char dur[MAX_TIME_STRING] = "0";
+	char addr[MAX_STRING];
+	char flags[MAX_STRING];
+	char * line2;
+	char * s;
+
+	op_item = new_mem_item();
+	op_item->type = c;
+	op_item->o.flags = 0;
+
+	//first portion
+	if ((retval = sscanf(line, " %d %s %*[^(](%[^,], %"SCNi64, &op_item->o.info.pid, start_time, addr, &op_item->o.length)) == EOF) {
+		ERRORPRINTF("Error: unexpected end of line%s", "\n");
+		free(op_item);
+		return -1;
+	}
+	if (retval != 4) {
+		ERRORPRINTF("Error: It was not able to match all fields required:%d\n", retval);
+		ERRORPRINTF("Failing line: %s", line);
+		free(op_item);
+		return -1;
+	}
+	op_item->o.addr = strtoull(addr, NULL, 0);
+
+	//second part
+	line2 = strstr(line, ") = ");
+	if (line2 == NULL || (retval = sscanf(line2, ") = %d%*[^<]<%[^>]", &op_item->o.retval, dur)) == EOF) {
+		ERRORPRINTF("Error: unexpected end of line%s", "\n");
+		free(op_item);
+		return -1;
+	}
+	if (retval != 2) {
+		ERRORPRINTF("Error: It was not able to match all fields required while parsing line2:%d\n", retval);
+		ERRORPRINTF("Failing line:%s", line);
+		free(op_item);
+		return -1;
+	}
+
+	//flags are the third argument
+	if (c != OP_MUNMAP && (s = strchr(line, ',')) != NULL && (s = strchr(s + 1, ',')) != NULL && s < line2) {
+		if (sscanf(s, ", %[^)]", flags) == 1) {
+			if (c == OP_MSYNC) {
+				op_item->o.flags = read_msync_flags(flags);
+			} else {
+				op_item->o.flags = read_madvise_advice(flags);
+			}
+		}
+	}
+
+   op_item->o.info.start = read_time(start_time);
+   op_item->o.info.dur = read_duration(dur);
+
+	list_append(list, &op_item->item);
+	return 0;
+}
+
+/** Reads exit or exit_group event from strace file. A process killed by a signal (+++ killed by ... +++)
+ * is read as exit_group with status -1.
+ *
+ * @arg line line to parse
+ * @arg c type of the operation: OP_EXIT or OP_EXIT_GROUP
+ * @arg list list to which to append new structure
+ * @return 0 on success, non-zero otherwise
+ */
+
+int strace_read_exit(char * line, char c, list_t * list) {
+	exit_item_t * op_item;
+	int retval;
+   char start_time[MAX_TIME_STRING];
+	int expected = 3;
+
+	op_item = new_exit_item();
+	op_item->type = c;
+
+	if (strstr(line, "+++") != NULL) {
+		op_item->o.status = -1;
+		expected = 2;
+		retval = sscanf(line, "%d %s", &op_item->o.info.pid, start_time);
+	} else {
+		retval = sscanf(line, "%d %s %*[^(](%d", &op_item->o.info.pid, start_time, &op_item->o.status);
+	}
+
+	if (retval == EOF) {
+		ERRORPRINTF("Error: unexpected end of line%s", "\n");
+		free(op_item);
+		return -1;
+	}
+	if (retval != expected) {
+		ERRORPRINTF("Error: It was not able to match all fields required:%d\n", retval);
+		ERRORPRINTF("Failing line: %s", line);
+		free(op_item);
+		return -1;
+	}
+
+   op_item->o.info.start = read_time(start_time);
+   op_item->o.info.dur = 0; // the call never returns
+
+	list_append(list, &op_item->item);
+	return 0;
+}
+
+/** Reads execve event from strace file.
+ *
+ * @arg line line to parse
+ * @arg list list to which to append new structure
+ * @return 0 on success, non-zero otherwise
+ */
+
+int strace_read_execve(char * line, list_t * list) {
+	execve_item_t * op_item;
+	int retval;
+   char start_time[MAX_TIME_STRING];
+   char dur[MAX_TIME_STRING] = "0";
+	char * line2;
+
+	op_item = new_execve_item();
+	op_item->type = OP_EXECVE;
+
+	if ((retval = sscanf(line, "%d %s %*[^\"]\"%" QUOTE(MAX_STRING) "[^\"]\"", &op_item->o.info.pid, start_time, op_item->o.name)) == EOF) {
+		ERRORPRINTF("Error: unexpected end of line%s", "\n");
+		free(op_item);
+		return -1;
+	} 
+	if (retval != 3) {
+		ERRORPRINTF("Error: It was not able to match all fields required: %d\n", retval);
+		ERRORPRINTF("Failing line: %s\n", line);
+		free(op_item);
+		return -1;
+	}
+
+	line2 = strace_pos_retval(line);
+	if (line2 == NULL || (retval = sscanf(line2, ") = %d%*[^<]<%[^>]", &op_item->o.retval, dur)) == EOF) {
+		ERRORPRINTF("Error: unexpected end of line%s", "\n");
+		free(op_item);
+		return -1;
+	}
+	if (retval < 1) {
+		ERRORPRINTF("Error: It was not able to match all fields required while parsing line2:%d\n", retval);
+		ERRORPRINTF("Failing line:%s", line);
+		free(op_item);
+		return -1;
+	}
+
+   op_item->o.info.start = read_time(start_time);
+   op_item->o.info.dur = read_duration(dur);
+
+	list_append(list, &op_item->item);
+	return 0;
+}
+
+/** Reads wait4/waitpid event from strace file.
+ *
+ * @arg line line to parse
+ * @arg list list to which to append new structure
+ * @return 0 on success, non-zero otherwise
+ */
+
+int strace_read_wait(char * line, list_t * list) {
+	wait_item_t * op_item;
+	int retval;
+   char start_time[MAX_TIME_STRING];
+   char dur[MAX_TIME_STRING] = "0";
+	char * line2;
+
+	op_item = new_wait_item();
+	op_item->type = OP_WAIT;
+
+	if ((retval = sscanf(line, "%d %s %*[^(](%d", &op_item->o.info.pid, start_time, &op_item->o.pid)) == EOF) {
+		ERRORPRINTF("Error: unexpected end of line%s", "\n");
+		free(op_item);
+		return -1;
+	}
+	if (retval != 3) {
+		ERRORPRINTF("Error: It was not able to match all fields required:%d\n", retval);
+		ERRORPRINTF("Failing line: %s", line);
+		free(op_item);
+		return -1;
+	}
+
+	line2 = strace_pos_retval(line);
+	if (line2 == NULL || (retval = sscanf(line2, ") = %d%*[^<]<%[^>]", &op_item->o.retval, dur)) == EOF) {
+		ERRORPRINTF("Error: unexpected end of line%s", "\n");
+		free(op_item);
+		return -1;
+	}
+	if (retval != 2) {
+		ERRORPRINTF("Error: It was not able to match all fields required while parsing line2:%d\n", retval);
+		ERRORPRINTF("Failing line:%s", line);
+		free(op_item);
+		return -1;
+	}
+
+   op_item->o.info.start = read_time(start_time);
+   op_item->o.info.dur = read_duration(dur);
+
+	list_append(list, &op_item->item);
+	return 0;
+}
+
 /** Reads operation identifier from @a line.
  * 
  * @arg line one line from strace output
@@ -1054,6 +1563,10 @@ inline void strace_get_operation(char * line, char * operation,  int stats) {
 	operation[i] = 0;
 
 	if (stats) {
+		if (strstr(line, "= ?") != NULL || strstr(line, "+++") != NULL) {
+			//exit calls never return, so there is no duration to count
+			return;
+		}
 		if ((retval = sscanf(line, "%*[^=]= %*[^<]<%d.%d>", &sec, &usec)) == EOF) {
 			//probably unfinished call, ignore it
 			return;
@@ -1095,6 +1608,8 @@ char strace_get_operation_code(char * line, int stats) {
 		return OP_CLOSE;
 	} else if (! strcmp(operation, "open")) {
 		return OP_OPEN;
+	} else if (! strcmp(operation, "openat")) {
+		return OP_OPEN; ///< directory fd is ignored, only AT_FDCWD and absolute paths are handled correctly
 	} else if (! strcmp(operation, "creat")) {
 		return OP_CREAT;
 	} else if (! strcmp(operation, "unlink")) {
@@ -1104,9 +1619,17 @@ char strace_get_operation_code(char * line, int stats) {
 	} else if (! strcmp(operation, "_llseek")) {
 		return OP_LLSEEK;
 	} else if (! strcmp(operation, "pipe2")) {
-		return OP_UNKNOWN; ///< this is on purpose. Change in the future, when pipe2 is supported
+		return OP_PIPE;
 	} else if (! strcmp(operation, "pipe")) {
 		return OP_PIPE;
+	} else if (! strcmp(operation, "socketpair")) {
+		return OP_SOCKETPAIR;
+	} else if (! strcmp(operation, "eventfd") || ! strcmp(operation, "eventfd2")) {
+		return OP_EVENTFD;
+	} else if (! strcmp(operation, "epoll_create") || ! strcmp(operation, "epoll_create1")) {
+		return OP_EPOLL;
+	} else if (! strcmp(operation, "timerfd_create")) {
+		return OP_TIMERFD;
 	} else if (! strcmp(operation, "dup3")) {
 		return OP_DUP3;
 	} else if (! strcmp(operation, "dup2")) {
@@ -1129,6 +1652,50 @@ char strace_get_operation_code(char * line, int stats) {
 		return OP_SENDFILE;
 	} else if (! strcmp(operation, "fcntl")) {
 		return OP_FCNTL;
+	} else if (! strcmp(operation, "rename")) {
+		return OP_RENAME;
+	} else if (! strcmp(operation, "renameat")) {
+		return OP_RENAME;
+	} else if (! strcmp(operation, "renameat2")) {
+		return OP_RENAME;
+	} else if (! strcmp(operation, "link")) {
+		return OP_LINK;
+	} else if (! strcmp(operation, "linkat")) {
+		return OP_LINK;
+	} else if (! strcmp(operation, "symlink")) {
+		return OP_SYMLINK;
+	} else if (! strcmp(operation, "symlinkat")) {
+		return OP_SYMLINK;
+	} else if (! strcmp(operation, "readlink")) {
+		return OP_READLINK;
+	} else if (! strcmp(operation, "readlinkat")) {
+		return OP_READLINK;
+	} else if (! strcmp(operation, "getdents64")) {
+		return OP_GETDENTS;
+	} else if (! strcmp(operation, "getdents")) {
+		return OP_GETDENTS;
+	} else if (! strcmp(operation, "mmap")) {
+		return OP_MMAP;
+	} else if (! strcmp(operation, "mmap2")) {
+		return OP_MMAP;
+	} else if (! strcmp(operation, "munmap")) {
+		return OP_MUNMAP;
+	} else if (! strcmp(operation, "msync")) {
+		return OP_MSYNC;
+	} else if (! strcmp(operation, "madvise")) {
+		return OP_MADVISE;
+	} else if (! strcmp(operation, "exit")) {
+		return OP_EXIT;
+	} else if (! strcmp(operation, "exit_group")) {
+		return OP_EXIT_GROUP;
+	} else if (! strcmp(operation, "+++") && strstr(line, "killed by") != NULL) {
+		return OP_EXIT_GROUP;
+	} else if (! strcmp(operation, "execve")) {
+		return OP_EXECVE;
+	} else if (! strcmp(operation, "wait4")) {
+		return OP_WAIT;
+	} else if (! strcmp(operation, "waitpid")) {
+		return OP_WAIT;
 	}
 	return OP_UNKNOWN;
 }
@@ -1289,7 +1856,8 @@ inline int strace_process_line(char * line, list_t * list, hash_table_t * ht, in
 			}
 			break;
 		case OP_PIPE:
-			if ( (retval = strace_read_pipe(line, list)) != 0) {
+		case OP_SOCKETPAIR:
+			if ( (retval = strace_read_pipe(line, c, list)) != 0) {
 				return retval;
 			}
 			break;
@@ -1314,7 +1882,10 @@ inline int strace_process_line(char * line, list_t * list, hash_table_t * ht, in
 			}
 			break;
 		case OP_SOCKET:
-			if ( (retval = read_socket_strace(line, list)) != 0) {
+		case OP_EVENTFD:
+		case OP_EPOLL:
+		case OP_TIMERFD:
+			if ( (retval = read_socket_strace(line, c, list)) != 0) {
 				return retval;
 			}
 			break;
@@ -1323,9 +1894,69 @@ inline int strace_process_line(char * line, list_t * list, hash_table_t * ht, in
 				return retval;
 			}
 			break;
+		case OP_RENAME:
+			if ( (retval = strace_read_rename(line, list)) != 0) {
+				return retval;
+			}
+			break;
+		case OP_LINK:
+		case OP_SYMLINK:
+			if ( (retval = strace_read_link(line, c, list)) != 0) {
+				return retval;
+			}
+			break;
+		case OP_READLINK:
+			if ( (retval = strace_read_readlink(line, list)) != 0) {
+				return retval;
+			}
+			break;
+		case OP_GETDENTS:
+			if ( (retval = strace_read_getdents(line, list)) != 0) {
+				return retval;
+			}
+			break;
+		case OP_MMAP:
+			if ( (retval = strace_read_mmap(line, list)) != 0) {
+				return retval;
+			}
+			break;
+		case OP_MUNMAP:
+		case OP_MSYNC:
+		case OP_MADVISE:
+			if ( (retval = strace_read_mem(line, c, list)) != 0) {
+				return retval;
+			}
+			break;
+		case OP_EXIT:
+		case OP_EXIT_GROUP:
+			if ( (retval = strace_read_exit(line, c, list)) != 0) {
+				return retval;
+			}
+			break;
+		case OP_EXECVE:
+			if ( (retval = strace_read_execve(line, list)) != 0) {
+				return retval;
+			}
+			break;
+		case OP_WAIT:
+			if ( (retval = strace_read_wait(line, list)) != 0) {
+				return retval;
+			}
+			break;
 		case OP_FCNTL:
 			//just for now.
-			if ( strstr(line, "F_DUPFD")) {
+			if ( strstr(line, "F_DUPFD_CLOEXEC")) {
+				retval = sscanf(line, "%d %s %*[^(](%d, F_DUPFD_CLOEXEC, %d) = %d%*[^<]<%[^>]", &pid, start_time, &old_fd, &tmp, &new_fd, dur);
+				if (retval != 6 ) {
+					ERRORPRINTF("Can not parse line:, %s", line);
+					return -1;
+				} else {
+					sprintf(line, "%d %s dup3(%d, %d, O_CLOEXEC) = %d <%s>", pid, start_time, old_fd, new_fd, new_fd, dur);
+				}
+				if ( (retval = strace_read_dup3(line, list)) != 0) {
+					return retval;
+				}
+			} else if ( strstr(line, "F_DUPFD")) {
 				retval = sscanf(line, "%d %s %*[^(](%d, F_DUPFD, %d) = %d%*[^<]<%[^>]", &pid, start_time, &old_fd, &tmp, &new_fd, dur);
 				if (retval != 6 ) {
 					ERRORPRINTF("Can not parse line:, %s", line);
@@ -1357,37 +1988,86 @@ inline int strace_process_line(char * line, list_t * list, hash_table_t * ht, in
  */
 
 int strace_get_items(char * filename, list_t * list, int stats) {
-	FILE * f;
-	char line[MAX_LINE];
-	hash_table_t ht;
+	return strace_stream_items(filename, list, stats, 0, NULL);
+}
+
+/** Same as strace_get_items(), but every @a chunk lines the items loaded so far are passed to @a consume and freed
+ * (see consume_items()), so traces bigger than memory can be processed. The rest is consumed at the end.
+ *
+ * @arg chunk number of lines to read before consuming
+ * @arg consume function processing the items, NULL to keep all of them in @a list
+ * @return 0 on success, error code otherwise
+ */
+
+int strace_stream_items(char * filename, list_t * list, int stats, int64_t chunk, void (* consume)(list_t * list)) {
+	strace_reader_t r;
+	int64_t lines;
 	int retval;
-	int linenum = 0;
 
-	if ( (f = fopen(filename, "r")) == NULL) {
-		DEBUGPRINTF("Error opening file %s: %s\n", filename, strerror(errno));
-		return errno;
+	if ( (retval = strace_open_items(&r, filename, stats)) != 0) {
+		return retval;
 	}
 
-	hash_table_init(&ht, HASH_TABLE_SIZE, &ht_ops_isyscall);
-
 	if (stats) {
 		stats_init();
 	}
 
-	while(fgets(line, MAX_LINE, f) != NULL) {
-		linenum++;
-		retval = strace_process_line(line, list, &ht, stats);
-		if (retval != 0) {
-			ERRORPRINTF("Error parsing file %s: on line %d, position %ld\n",
-					filename, linenum, ftell(f));
+	do {
+		lines = strace_read_items(&r, list, consume ? chunk : 0);
+		if (consume) {
+			consume_items(list, consume);
 		}
-	}
+	} while (consume && lines == chunk);
 
 	if (stats) {
 		stats_print();
 	}
-	hash_table_destroy(&ht);
+	strace_close_items(&r);
+	return 0;
+}
 
-	fclose(f);
+/** Opens strace file @a filename for reading by strace_read_items(), so more traces can be read at once.
+ *
+ * @arg r reader to initialize
+ * @arg filename the file, it has to exist until strace_close_items()
+ * @arg stats whether to account the calls in stats (see stats.h)
+ * @return 0 on success, error code otherwise
+ */
+
+int strace_open_items(strace_reader_t * r, char * filename, int stats) {
+	if ( (r->f = fopen(filename, "r")) == NULL) {
+		DEBUGPRINTF("Error opening file %s: %s\n", filename, strerror(errno));
+		return errno;
+	}
+	hash_table_init(&r->ht, HASH_TABLE_SIZE, &ht_ops_isyscall);
+	r->filename = filename;
+	r->linenum = 0;
+	r->stats = stats;
 	return 0;
 }
+
+/** Reads next @a chunk lines (all the rest if 0) of the trace opened by strace_open_items() and appends their
+ * items to @a list. Lines which cannot be parsed are reported and skipped.
+ *
+ * @return number of lines read, less than @a chunk at the end of the file
+ */
+
+int64_t strace_read_items(strace_reader_t * r, list_t * list, int64_t chunk) {
+	char line[MAX_LINE];
+	int64_t lines = 0;
+
+	while ((chunk == 0 || lines < chunk) && fgets(line, MAX_LINE, r->f) != NULL) {
+		r->linenum++;
+		lines++;
+		if (strace_process_line(line, list, &r->ht, r->stats) != 0) {
+			ERRORPRINTF("Error parsing file %s: on line %d, position %ld\n",
+					r->filename, r->linenum, ftell(r->f));
+		}
+	}
+	return lines;
+}
+
+void strace_close_items(strace_reader_t * r) {
+	hash_table_destroy(&r->ht);
+	fclose(r->f);
+}
@@ -17,6 +17,9 @@
     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
 */
 
+#ifndef _IN_STRACE_H_
+#define _IN_STRACE_H_
+
 #include <assert.h>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -30,5 +33,20 @@ typedef struct isyscall {
 	char line[MAX_STRING];
 } isyscall_t;
 
+/** Strace file being read by strace_read_items(). */
+typedef struct strace_reader {
+	FILE * f;
+	char * filename;
+	hash_table_t ht; ///< unfinished syscalls
+	int linenum;
+	int stats;
+} strace_reader_t;
+
 int strace_get_items(char * filename, list_t * list, int stats);
+int strace_stream_items(char * filename, list_t * list, int stats, int64_t chunk, void (* consume)(list_t * list));
+int strace_open_items(strace_reader_t * r, char * filename, int stats);
+int64_t strace_read_items(strace_reader_t * r, list_t * list, int64_t chunk);
+void strace_close_items(strace_reader_t * r);
 inline int strace_process_line(char * line, list_t * list, hash_table_t * ht, int stats);
+
+#endif
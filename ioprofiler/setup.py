@@ -31,7 +31,8 @@ setup(name="ioprofiler",
 										define_macros = [('_GNU_SOURCE', None), ('_FILE_OFFSET_BITS',64), ('PY_MODULE', None)],
 										extra_compile_args = ["-g"],
 										sources = ["ioappsmodule.c", "../in_common.c", "../in_binary.c", "../in_strace.c", "../adt/list.c", 
-											"../adt/hash_table.c", "../namemap.c", "../simulate.c", "../replicate.c", "../fdmap.c", "../stats.c", "../simfs.c", "../adt/fs_trie.c"],
+											"../adt/hash_table.c", "../namemap.c", "../simulate.c", "../replicate.c", "../fdmap.c", "../stats.c", "../simfs.c", "../bufpool.c", "../pagecache.c", "../payload.c", "../throttle.c", "../filter.c", "../checkpoint.c", "../coord.c", "../devmodel.c", "../mrc.c", "../critpath.c", "../workload.c", "../adt/fs_trie.c"],
+										libraries = ["m"],
 										include_dirs = ['../'])],
 		py_modules = [ 'grapher' ],
 		scripts=['ioprofiler']
@@ -32,86 +32,535 @@
 #include "simulate.h"
 #include "in_strace.h"
 #include "in_binary.h"
+#include "pagecache.h"
+#include "payload.h"
+#include "throttle.h"
+#include "clones.h"
+#include "namemap.h"
+#include "filter.h"
+#include "checkpoint.h"
+#include "placement.h"
+#include "devmodel.h"
+#include "mrc.h"
+#include "pattern.h"
+#include "timeseries.h"
+#include "critpath.h"
+#include "workload.h"
+#include "anon.h"
+#include "coalesce.h"
+#include "merge.h"
+#include "shard.h"
+#include "coord.h"
 
 #define FORMAT_STRACE "strace"
 #define FORMAT_BIN "bin"
+#define MAX_SPEEDUPS 16 ///< maximum number of speed-up factors given by -x
+#define OPT_START_AT 256 ///< long options without short ones
+#define OPT_COORDINATOR 257
+#define OPT_WORKERS 258
+#define OPT_JOIN 259
 
 static struct option ioreplay_options[] = {
    /* name        has_arg flag  value */
+   { "bandwidth",		1,		NULL,	'B' },
    { "bind",			1,		NULL,	'b' },
+   { "clones",			1,		NULL,	'N' },
+   { "clone-prefix",	1,		NULL,	'A' },
+   { "clone-offset",	1,		NULL,	'O' },
+   { "clone-jitter",	1,		NULL,	'j' },
+   { "cache",			1,		NULL,	'k' },
    { "convert",		0,		NULL,	'c' },
    { "check",			0,		NULL,	'C' },
+   { "checkpoint",		1,		NULL,	'z' },
+   { "checkpoint-interval",	1,		NULL,	'Z' },
    { "dont-fix",		0,		NULL,	'd' },
+   { "direct",			0,		NULL,	'D' },
    { "file",			1,		NULL,	'f' },
    { "format",			1,		NULL,	'F' },
    { "help",			0,		NULL,	'h' },
+   { "hugepages",		0,		NULL,	'H' },
    { "ignore",			1,		NULL,	'i' },
+   { "only",			1,		NULL,	'g' },
+   { "iops",			1,		NULL,	'I' },
+   { "pid-iops",		1,		NULL,	'J' },
    { "map",				0,		NULL,	'm' },
+   { "mmap-touch",	1,		NULL,	'T' },
    { "output",			1,		NULL,	'o' },
+   { "model",			1,		NULL,	'y' },
+   { "mrc",				1,		NULL,	'q' },
+   { "patterns",		1,		NULL,	'a' },
+   { "timeseries",		1,		NULL,	'n' },
+   { "critical-path",	1,		NULL,	'l' },
+   { "extract",		1,		NULL,	'E' },
+   { "generate",		1,		NULL,	'G' },
+   { "anonymize",		1,		NULL,	'U' },
+   { "coalesce",		1,		NULL,	'X' },
+   { "split",			1,		NULL,	'Y' },
+   { "merge",			1,		NULL,	'K' },
+   { "shards",			1,		NULL,	'Q' },
+   { "start-at",		1,		NULL,	OPT_START_AT },
+   { "coordinator",	1,		NULL,	OPT_COORDINATOR },
+   { "workers",		1,		NULL,	OPT_WORKERS },
+   { "join",			1,		NULL,	OPT_JOIN },
+   { "payload",		1,		NULL,	'w' },
+   { "placement",		1,		NULL,	'L' },
+   { "pids",			1,		NULL,	'u' },
+   { "pipes",			0,		NULL,	'e' },
    { "replicate",		0,		NULL,	'r' },
+   { "resume",			1,		NULL,	'R' },
    { "prepare",		0,		NULL,	'p' },
    { "print",		0,		NULL,	'P' },
    { "scale",			1,		NULL,	's' },
+   { "speedup",		1,		NULL,	'x' },
    { "stats",			1,		NULL,	'S' },
    { "timing",			1,		NULL,	't' },
    { "verbose",		0,		NULL,	'v' },
    { "version",		0,		NULL,	'V' },
+   { "window",			1,		NULL,	'W' },
    { NULL,				0,		NULL,	0 }
 };
 
 struct timeval global_start;
 
+/** Parameters of one pass over the trace. The pass is run by every clone (see clones.h). */
+typedef struct pass_args {
+	list_t * list;
+	int cpu;
+	double scale;
+	int action;
+	char * ifilename;
+	char * mfilename;
+	double cache_fraction;
+	double iops;
+	double pid_iops;
+	double bandwidth;
+	char * checkpoint; ///< file to save checkpoints to, NULL to disable
+	double checkpoint_interval;
+	char * resume; ///< checkpoint to resume from, NULL to start from the beginning
+	double start_at; ///< time (seconds since the epoch) to start the replay at, 0 to start at once
+	char * join; ///< address of the coordinator to join, NULL to replay alone
+	char * filename; ///< the trace, to tell the coordinator
+} pass_args_t;
+
+/** Makes name of checkpoint file of the current clone. Every clone has its own checkpoint. */
+static void clone_file_name(char * buf, const char * name) {
+	if (clones_count() > 1) {
+		snprintf(buf, MAX_STRING, "%s.%d", name, clones_index);
+	} else {
+		snprintf(buf, MAX_STRING, "%s", name);
+	}
+}
+
+/** Checks whether the environment is ready for replaying (-C). */
+static int check_pass(void * arg) {
+	pass_args_t * a = arg;
+
+	simulate_init(ACT_CHECK);
+	if (replicate(a->list, a->cpu, a->scale, a->action | ACT_SIMULATE, a->ifilename, a->mfilename) != 0) {
+		ERRORPRINTF("An error occurred during replicating.%s", "\n");
+		simulate_finish();
+		return -1;
+	}
+	simulate_check_files();
+	simulate_finish();
+	return 0;
+}
+
+/** Prepares files and directories needed for replaying (-p). Directories of clones are created
+ * as copies of the original ones. */
+static int prepare_pass(void * arg) {
+	pass_args_t * a = arg;
+
+	namemap_prefix_mkdirs(1);
+	simulate_init(ACT_PREPARE);
+	if (replicate(a->list, a->cpu, a->scale, a->action | ACT_SIMULATE, a->ifilename, a->mfilename) != 0) {
+		ERRORPRINTF("An error occurred during replicating.%s", "\n");
+		simulate_finish();
+		return -1;
+	}
+	///< @todo to change
+	//simulate_prepare_files();
+	simulate_prepare_dirs();
+	simulate_finish();
+	return 0;
+}
+
+/** Finds out files opened by the application and sets their page cache state (-k). Names are translated
+ * the same way the replay translates them, items of the trace are left untouched. */
+static int cache_pass(void * arg) {
+	pass_args_t * a = arg;
+	item_t * item;
+	common_op_item_t * com_it;
+	char * names[2];
+	char * name;
+
+	if (pagecache_init() != 0 || namemap_init(a->ifilename, a->mfilename) != 0) {
+		return -1;
+	}
+	for (item = a->list->head; item; item = item->next) {
+		com_it = list_entry(item, common_op_item_t, item);
+		if (com_it->type != OP_OPEN || ((open_item_t *) com_it)->o.retval < 0) {
+			continue;
+		}
+		get_item_names(com_it, names);
+		if ( (name = namemap_get_name(names[0])) != NULL) {
+			pagecache_add_file(name);
+		}
+	}
+	namemap_finish();
+	pagecache_control(a->action & CACHE_MASK, a->cache_fraction);
+	return 0;
+}
+
+/** Waits until @a start_at (seconds since the epoch), so more replays can start at the same time. */
+static void wait_start(double start_at) {
+	struct timeval now;
+	double left;
+
+	gettimeofday(&now, NULL);
+	left = start_at - (now.tv_sec + now.tv_usec / 1000000.0);
+	if (left <= 0) {
+		if (clones_index == 0) {
+			ERRORPRINTF("Start time passed %.3lf seconds ago, starting at once\n", -left);
+		}
+		return;
+	}
+	if (clones_index == 0 && ! global_quiet) {
+		printf("Waiting %.3lf seconds for the start...\n", left);
+		fflush(stdout);
+	}
+	while (left > 0) {
+		usleep(left > 1 ? 1000000 : left * 1000000);
+		gettimeofday(&now, NULL);
+		left = start_at - (now.tv_sec + now.tv_usec / 1000000.0);
+	}
+}
+
+/** Replays the trace (-r). Clones are placed according to -L, or spread over processors starting with the one
+ * given by -b. */
+static int replay_pass(void * arg) {
+	pass_args_t * a = arg;
+	int cpu = a->cpu;
+	int retval = 0;
+	char name[MAX_STRING];
+
+	if (placement_enabled()) {
+		cpu = placement_cpu(clones_index);
+		placement_bind(cpu);
+	} else {
+#ifdef _SC_NPROCESSORS_ONLN
+		cpu = (cpu + clones_index) % sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	}
+	throttle_init(a->iops, a->pid_iops, a->bandwidth);
+	if (a->checkpoint) {
+		clone_file_name(name, a->checkpoint);
+		checkpoint_init(name, a->checkpoint_interval);
+	}
+	if (a->resume) {
+		clone_file_name(name, a->resume);
+		checkpoint_set_resume(name);
+	}
+	if (a->join && coord_join(a->join, a->filename, clones_index) != 0) {
+		throttle_finish();
+		return -1;
+	}
+	if (a->start_at > 0) {
+		wait_start(a->start_at);
+	}
+	/// < @todo to change
+	if (replicate(a->list, cpu, a->scale, a->action, a->ifilename, a->mfilename) != 0) {
+		ERRORPRINTF("An error occurred during replicating.%s", "\n");
+		retval = -1;
+	}
+	if (a->join) {
+		coord_done(retval);
+	}
+	if (throttle_enabled() && ! global_quiet) {
+		throttle_report();
+	}
+	throttle_finish();
+	return retval;
+}
+
+/** Parses start time of the replay: seconds since the epoch, or +<sec> from now.
+ *
+ * @return the time in seconds since the epoch, or -1 on error
+ */
+
+static double parse_start(const char * str) {
+	struct timeval now;
+	char * end;
+	double t = strtod(str, &end);
+
+	if (end == str || *end != 0 || t < 0) {
+		return -1;
+	}
+	if (str[0] == '+') {
+		gettimeofday(&now, NULL);
+		t += now.tv_sec + now.tv_usec / 1000000.0;
+	}
+	return t;
+}
+
+/** Parses a rate with an optional K, M or G suffix (powers of 1024).
+ *
+ * @return the rate, or -1 on error
+ */
+
+double parse_rate(const char * str) {
+	char * end;
+	double rate = strtod(str, &end);
+
+	switch (*end) {
+		case 'G': case 'g':
+			rate *= 1024;
+		case 'M': case 'm':
+			rate *= 1024;
+		case 'K': case 'k':
+			rate *= 1024;
+			end++;
+			break;
+	}
+	if (end == str || *end != 0) {
+		return -1;
+	}
+	return rate;
+}
+
+/** Parses comma separated list of speed-up factors into @a speedups.
+ *
+ * @return number of factors parsed, -1 on error
+ */
+
+int parse_speedups(const char * str, double * speedups) {
+	char * end;
+	int count = 0;
+
+	while (count < MAX_SPEEDUPS) {
+		speedups[count] = strtod(str, &end);
+		if (end == str || speedups[count] <= 0) {
+			return -1;
+		}
+		count++;
+		if (*end == 0) {
+			return count;
+		} else if (*end != ',') {
+			return -1;
+		}
+		str = end + 1;
+	}
+	return -1;
+}
+
 void help(char * name) {
 	printf("Replicates all IO syscalls defined in file by -f option.\n\n");
 printf("Usage: %s [OPERATION] -f <file> [OPTIONS]\n\n", name);
 printf("%s is primary used to replicate recorded IO system calls.\n\
 In order to do that, several other helper functionality exists.\n\n", name);
 
-printf("Usage: %s -c -f <file> [-F <format>] [-o <out>] [-v]\n", name);
+printf("Usage: %s -c -f <file> [-F <format>] [-o <out>] [-U <key>] [-X <size>[:<window>]] [-Y <size>] [-Q <n>[:<mode>]] [-W <from>:<to>] [-u <pids>] [-g <glob>] [-v]\n", name);
 printf("   converts <file> in format <format> to binary form into file <out>\n\n");
 printf("Usage: %s -S -f <file> [-v]\n", name);
 printf("   displays some statistics about syscalls recorded in <file> (must be in " FORMAT_STRACE " format)\n\n");
 printf("Usage: %s -P -f <file> [-F <format>] [-v]\n", name);
 printf("   prints syscalls in normalized format\n\n");
-printf("Usage: %s -C -f <file> [-F <format>] [-i <file>] [-m <file>] [-v]\n", name);
+printf("Usage: %s -C -f <file> [-F <format>] [-i <file>] [-m <file>] [-N <n> [-A <prefix>]] [-W <from>:<to>] [-u <pids>] [-g <glob>] [-v]\n", name);
 printf("   checks whether local enviroment is ready for replaying traces recorded in <file>.\n\n");
-printf("Usage: %s -r -f <file> [-F <format>] [-t <mode>] [-s <factor>] [-b <number>] [-i <file>] [-m <file>] [-v]\n", name);
-printf("   replicates traces recorded in <file>. Use -C prior to running this.\n");
+printf("Usage: %s -r -f <file> [-F <format>] [-t <mode>] [-s <factor>] [-b <number>] [-i <file>] [-m <file>] [-T <mode>] [-D] [-H] [-e] [-L <policy>] [-k <mode>] [-w <mode>] [-x <factor>[,<factor>...]] [-I <iops>] [-J <iops>] [-B <rate>] [-N <n> [-A <prefix>] [-O <sec>] [-j <sec>]] [-W <from>:<to>] [-u <pids>] [-g <glob>] [-z <file> [-Z <sec>]] [-R <file>] [--start-at <time>] [--join <address>] [-v]\n", name);
+printf("   replicates traces recorded in <file>. Use -C prior to running this.\n\n");
+printf("Usage: %s -y <model> -f <file> [-F <format>] [-i <file>] [-m <file>] [-W <from>:<to>] [-u <pids>] [-g <glob>] [-v]\n", name);
+printf("   predicts how long IO of <file> would take on a modeled device, without doing any IO.\n\n");
+printf("Usage: %s -q <rate> -f <file> [-F <format>] [-i <file>] [-m <file>] [-W <from>:<to>] [-u <pids>] [-g <glob>] [-v]\n", name);
+printf("   prints hit and miss ratio of LRU page cache of <file> as a function of the cache size.\n\n");
+printf("Usage: %s -a <count> -f <file> [-F <format>] [-i <file>] [-m <file>] [-W <from>:<to>] [-u <pids>] [-g <glob>] [-v]\n", name);
+printf("   classifies access patterns of files and processes of <file> and prints the <count> heaviest ones.\n\n");
+printf("Usage: %s -l <count> -f <file> [-F <format>] [-i <file>] [-m <file>] [-W <from>:<to>] [-u <pids>] [-g <glob>] [-v]\n", name);
+printf("   splits wall time of processes of <file> to IO and the rest and attributes IO on the critical path to files.\n\n");
+printf("Usage: %s -n <length>[:<name>] -f <file> [-F <format>] [-v]\n", name);
+printf("   writes IOPS, bandwidth and latencies of <file> in windows of <length> to <name>.csv and <name>.tsb.\n\n");
+printf("Usage: %s -E <model> -f <file> [-F <format>] [-i <file>] [-m <file>] [-W <from>:<to>] [-u <pids>] [-g <glob>] [-v]\n", name);
+printf("   extracts a synthetic workload model of <file> to <model>.\n\n");
+printf("Usage: %s -G <model>[:<seconds>[:<scale>[:<root>]]] [-o <out>] [-v]\n", name);
+printf("   generates a binary trace <out> from workload model <model>.\n\n");
+printf("Usage: %s -K <file>[,<file>...][:<align>] [-K ...] [-F <format>] [-o <out>] [-v]\n", name);
+printf("   merges traces of more hosts into binary trace <out>.\n\n");
+printf("Usage: %s --coordinator <address> [--workers <n>]\n", name);
+printf("   starts replays joining <address> (--join) at once and merges their results.\n");
 printf("\n\
+ -a --patterns <count> classifies reads and writes of every file and process of the trace as sequential,\n\
+                     strided, random or mixed instead of replaying it, and prints run lengths, request\n\
+                     sizes, read/write ratio and page reuse of the <count> heaviest files and processes\n\
+                     (0 for all of them).\n\
+ -A --clone-prefix <prefix> file names of clone number <k> are prefixed by <prefix><k>.\n\
+                     Default: " CLONES_DEFAULT_PREFIX ".\n\
  -b --bind <number>  bind replicating process to processor number <number>\n\
+ -B --bandwidth <rate> limits bytes read and written per second by all processes together to <rate>.\n\
+                     Suffixes K, M and G are accepted. Used with -r, together with any timing mode.\n\
  -c --convert        file to binary form, see also -o\n\
  -C --check          checks that all operations recorded in the file specied by -f will\n\
                      succeed (ie. will result in same return code).\n\
                      It takes -i and -m into account. See also -p.\n\
+    --coordinator <address> coordinates replays instead of replaying: waits until --workers\n\
+                     replays join it (--join) and load their traces, starts them at once, prints\n\
+                     their throughput every second and merges their results (including latency\n\
+                     histograms) into one report. <address> is a Unix socket path (with '/'),\n\
+                     or [<host>:]<port> of TCP, <host> is a name or an address (localhost by\n\
+                     default).\n\
  -d --dont-fix       turns off fixing of missing system calls (uncomplete strace output support)\n\
+ -D --direct         opens all regular files with O_DIRECT to take the page cache out of the\n\
+                     measurements. O_DIRECT recorded in the trace is always honoured. Unaligned\n\
+                     reads on such files are rounded to 4096 bytes, unaligned writes are done\n\
+                     through the page cache. Both are reported at the end.\n\
+ -e --pipes          replays pipes and socketpairs as real channels between the replayed\n\
+                     processes, reads and writes on them transfer the recorded number of bytes.\n\
+                     The channels never block (the trace order is kept), reads that find no\n\
+                     data are reported as stalled calls at the end.\n\
+ -E --extract <model> instead of replaying, writes a synthetic workload model of the trace to <model>:\n\
+                     file sizes, access patterns and request sizes, per process call mix, gaps\n\
+                     and files used, and call durations. No file names are kept. See -G.\n\
  -f --file <file>    sets filename to <file>\n\
  -F --format <fmt>   specifies input format of the file.\n\
                      Options: " FORMAT_STRACE ", " FORMAT_BIN ".\n\
                      Check README for details. Default is " FORMAT_STRACE ".\n\
+ -g --only <glob>    replays only files matching shell pattern <glob>, all other files are\n\
+                     ignored as with -i. Can be given more times. See also -W.\n\
+ -G --generate <model>[:<seconds>[:<scale>[:<root>]]] generates a binary trace (see -o) of <seconds>\n\
+                     (the original length by default) from model <model>, running every process\n\
+                     <scale> times with its own files under <root> (" WORKLOAD_ROOT " by default).\n\
+                     Files which are read first are created by a setup process at the start.\n\
  -h --help           prints this message\n\
+ -H --hugepages      backs IO buffers of 2MB and more by huge pages, if available.\n\
  -i --ignore <file>  sets file containing names which we should not touch during\n\
                      replaying. I.e. no syscall operation will be performed on given file.\n\
+ -I --iops <iops>    limits reads and writes per second of all processes together to <iops>.\n\
+ -j --clone-jitter <sec> delays start of every clone by a random time up to <sec> seconds.\n\
+ -J --pid-iops <iops> limits reads and writes per second of every process to <iops>.\n\
+                     Calls exceeding the -I, -J or -B limits are delayed (token bucket).\n\
+    --join <address> joins the coordinator at <address> (see --coordinator) when replaying (-r):\n\
+                     the loaded replay waits for the start and sends its progress and results.\n\
+                     With -N, every clone joins.\n\
+ -k --cache <mode>   controls page cache state of all files used by the application before\n\
+                     replaying. Options available:\n\
+                      evict        - evict the files from the page cache.\n\
+                      warm[:<f>]   - cache fraction <f> (0-1, default 1) of pages of every file.\n\
+                      leave        - leave the page cache as it is.\n\
+                     Cache state at the start and at the end of replay and estimated hit ratio\n\
+                     of reads (sampled by mincore) are reported.\n\
+ -K --merge <file>[,<file>...][:<align>] merges traces (all in format -F) into one binary trace\n\
+                     (see -o) by time. Every -K gives a group of files of one host (e.g. of strace\n\
+                     -ff), sharing pids and clock. Colliding pids of different groups are renumbered\n\
+                     and processes of every group get their own descriptors. <align> is an offset\n\
+                     in seconds added to times of the group, or a path: the first calls on the path\n\
+                     in all groups aligned by a path are put at the same time. Traces are\n\
+                     streamed, so they do not have to fit into memory.\n\
+ -l --critical-path <count> instead of replaying, splits wall time of every process to IO calls, waiting\n\
+                     for children and the rest, walks the critical path of the job through clones and\n\
+                     waits and prints the <count> processes, IO chains and files with the most IO time\n\
+                     on the critical path, i.e. where faster storage would shorten the job.\n\
+ -L --placement <policy> places the replay (every clone) on a processor and prefers memory\n\
+                     of its NUMA node. Policies: compact[:<cpus>] fills node after node,\n\
+                     spread[:<cpus>] alternates nodes, cpus:<cpus> uses just the list\n\
+                     (e.g. 0-3,8), node:<n> uses node <n>, near:<path> uses the node the\n\
+                     device holding <path> is attached to. Overrides -b. The placement\n\
+                     is printed before replaying.\n\
  -m --map <file>     sets containing file names mapping. When opening file,\n\
                      if there is mapping for it, it will open mapped file instead.\n\
                      See README for more information.\n\
- -o --output <file>  output filename when converting. Default: strace.bin.\n\
+ -n --timeseries <length>[:<name>] streams the trace and writes reads, writes, bytes, latency percentiles\n\
+                     (p50, p99, max), opens, stats and other metadata calls in windows of <length>\n\
+                     (e.g. 10ms, 1s, 1min; us, ms, s or min, seconds by default), for the whole trace\n\
+                     and every process, to <name>.csv and binary <name>.tsb (\"timeseries\" by default).\n\
+                     The trace is not loaded into memory, so it can be bigger than RAM.\n\
+ -N --clones <n>     replays <n> isolated copies of the trace at once, each in its own process\n\
+                     and with its own file names (see -A). A combined throughput and latency\n\
+                     report is printed at the end. With -C and -p, files of every clone are\n\
+                     checked or prepared. Rate limits (-I, -J, -B) apply to every clone separately.\n\
+ -o --output <file>  output filename when converting or generating (-G). Default: strace.bin.\n\
+ -O --clone-offset <sec> starts clone number <k> <k>*<sec> seconds after the first one.\n\
  -p --prepare        will prepare all files accesses recorded in file specified by -f,\n\
                      so every IO operation will return with same exit code as in original\n\
                      application. See also -i and/or -m parameters.\n\
-                     Do nothing at the moment.\n\
+                     At the moment, it only populates directories with empty files, so\n\
+                     directory scans (getdents) return as many entries as in the original run.\n\
  -P --print          prints recorded syscalls in normalized format regardless the format\n\
                      in which are the syscalls stored now\n\
+ -q --mrc <rate>     computes miss ratio curve of LRU page cache (4KB pages) for reads and writes of\n\
+                     the trace, for the whole trace and for every file and process, instead of\n\
+                     replaying it. Only fraction <rate> (0-1] of pages is tracked (spatial sampling),\n\
+                     e.g. 0.01 for traces with billions of page accesses, 1 gives exact curves.\n\
+ -Q --shards <n>[:<mode>] when converting, splits the trace into <n> binary traces <out>.0 to\n\
+                     <out>.<n-1> (see -o), so that no descriptor or changed path is used by more\n\
+                     of them, to be replayed at once (see --start-at). Modes available:\n\
+                      tree         - every process tree goes to one shard (default).\n\
+                      files        - calls go with the files they use, processes are copied\n\
+                                     to all shards with their calls.\n\
+                     Calls, bytes and duration of every shard are printed.\n\
  -r --replicate      will replicate every operation stored in file specified by -f\n\
+ -R --resume <file>  continues interrupted replay from checkpoint <file> saved by -z. Files open\n\
+                     at the checkpoint are reopened at their recorded positions. Use the same\n\
+                     trace and options as the interrupted replay.\n\
  -s --scale <factor> scales delays between calls by the factor <factor>. Used with -r.\n\
  -S --stats          generate stats when processing the file. Can be combined with other\n\
                      options.\n\
+    --start-at <time> waits with the replay until <time>, in seconds since the epoch, or +<sec>\n\
+                     from now, so replays of shards (-Q) on more machines start together.\n\
  -t --timing         sets timing mode for replication. Options available:\n\
                       diff  - default mode. makes sure that gaps between calls are the same as in the original run.\n\
                       asap  - makes calls one just after another.\n\
                       exact - makes sure that calls are (approximately) done in the same time as in the original run\n\
                               (relative from start of the application)\n\
+ -T --mmap-touch     touches pages of replicated file mappings to cause page faults. Options available:\n\
+                      seq     - touch all pages of a new mapping sequentially.\n\
+                      random  - touch all pages of a new mapping in random order.\n\
+                      derived - touch only ranges passed to following msync/madvise calls.\n\
+                     Page faults are reported at the end of replication of mapped files.\n\
+ -u --pids <pid>[,<pid>...] replays only operations of the given processes and their descendants\n\
+                     (through clone). See also -W.\n\
+ -U --anonymize <key> when converting, replaces every component of every path by its keyed hash,\n\
+                     keeping the directory structure, extensions, \".\" and \"..\" and paths under /dev,\n\
+                     /proc and /sys. The same <key> gives the same names. @<file> reads the key\n\
+                     from the first line of <file>.\n\
  -v --verbose be more verbose (do nothing at the moment)\n\
- -V --version prints version and exits.\n");
+ -V --version prints version and exits.\n\
+ -w --payload <mode> sets content of replayed writes, so compressing and deduplicating storage\n\
+                     gets realistic data. The data are precomputed before replaying. Options available:\n\
+                      zero              - zeros (default).\n\
+                      random            - random, incompressible and unique data.\n\
+                      compress:<ratio>  - data compressible approximately <ratio> times.\n\
+                      dedup:<ratio>     - only every <ratio>-th block (4096B) is unique.\n\
+                      pattern:<string>  - <string> repeated.\n\
+ -W --window <from>:<to> replays only operations from <from> to <to> seconds since the start\n\
+                     of the trace. Any of them can be omitted. Operations out of the slice given by\n\
+                     -W, -u and -g which manage fds and processes (open, close, dup, clone, lseek,\n\
+                     exit...) are still done, without timing, so fds stay valid. Other operations\n\
+                     are skipped. Works with -r, -M, -C and -c (which removes skipped operations).\n\
+    --workers <n>    number of replays the coordinator waits for. Default: 1.\n\
+ -z --checkpoint <file> saves position of the replay and all fd mappings to <file> periodically,\n\
+                     so the replay can be resumed by -R. With -N, clone number <k> uses <file>.<k>.\n\
+ -Z --checkpoint-interval <sec> seconds between checkpoints. Default: 60.\n\
+ -x --speedup <factor>[,<factor>...] replays <factor> times faster by dividing the time between\n\
+                     calls (diff and exact timing), sizes of IO stay the same. With more factors,\n\
+                     the trace is replayed once for every factor (e.g. 2,4,8 for a load ramp).\n\
+ -X --coalesce <size>[:<window>] when converting, merges sequential reads and writes of a process on\n\
+                     one descriptor issued within <window> of the first one (usec, or with unit\n\
+                     us, ms or s, 10ms by default) into calls of up to <size> bytes (K, M and G\n\
+                     suffixes are accepted).\n\
+                     Any other call of the process ends the merging. Replaying the original and\n\
+                     the converted trace shows what bigger application buffers would give.\n\
+ -Y --split <size>   when converting, splits reads and writes bigger than <size> into calls of <size>.\n\
+ -y --model <spec>   simulates the trace on a modeled device instead of replaying it and predicts\n\
+                     its IO time and latency of reads and writes. No IO is done. <spec> is comma\n\
+                     separated list of a preset (nvme - default, ssd, hdd) and parameters:\n\
+                      qd=<n>                   - calls served by the device at once.\n\
+                      seq-read=<t>, rand-read=<t>, seq-write=<t>, rand-write=<t>\n\
+                                               - mean latencies (ns, us - default, ms, s suffix).\n\
+                      dist=fixed|exp|lognormal[:<sigma>] - distribution of the latencies.\n\
+                      read-bw=<rate>, write-bw=<rate> - bandwidth in bytes/s (K, M, G suffix).\n\
+                      cache=<size>             - page cache size, 0 - no cache (default).\n\
+                      writeback=<size>         - write-back buffer size, 0 - write through (default).\n\
+                      hit=<t>                  - latency of cache hits and buffered writes.\n\
+                     E.g. -y ssd,qd=8,cache=2G,writeback=256M\n");
 }
 
 void print_version() {
@@ -133,14 +582,39 @@ int main(int argc, char * * argv) {
 	char output[MAX_STRING] = "strace.bin";
 	char ignorefile[MAX_STRING] = "";
 	char mapfile[MAX_STRING] = "";
+	char payload[MAX_STRING] = PAYLOAD_ZERO_STR;
+	char placement[MAX_STRING] = "";
+	char model[MAX_STRING] = "";
+	double mrc_rate = 0;
+	int patterns = -1;
+	int critical = 0;
+	char timeseries[MAX_STRING] = "";
+	char workload[MAX_STRING] = "";
+	char generate[MAX_STRING] = "";
 	list_t * list;
 	int len = 0;
 	int retval;
 	int action = FIX_MISSING;
 	int verbose = 0;
-	char c;
+	int c;
 	int cpu;
 	double scale = 1.0;
+	double cache_fraction = 0.0;
+	double speedups[MAX_SPEEDUPS] = { 1.0 };
+	int speedup_count = 1;
+	double iops = 0, pid_iops = 0, bandwidth = 0;
+	int step;
+	int clones = 1;
+	char clone_prefix[MAX_STRING] = CLONES_DEFAULT_PREFIX;
+	double clone_offset = 0, clone_jitter = 0;
+	pass_args_t pass;
+	char checkpoint[MAX_STRING] = "";
+	char resume[MAX_STRING] = "";
+	double checkpoint_interval = CHECKPOINT_DEFAULT_INTERVAL;
+	double start_at = 0;
+	char coordinator[MAX_STRING] = "";
+	char join[MAX_STRING] = "";
+	int workers = 1;
 #ifdef _SC_NPROCESSORS_ONLN	 //we can determine how many processors we have
 	srandom((int)time(NULL));
 	cpu = random() % sysconf(_SC_NPROCESSORS_ONLN);
@@ -151,11 +625,78 @@ int main(int argc, char * * argv) {
 	gettimeofday(&global_start, NULL);
 
 	/* Parse parameters */
-	while ((c = getopt_long (argc, argv, "b:cCdf:F:hi:m:Mo:pPrs:St:vV", ioreplay_options, NULL)) != -1 ) {
+	while ((c = getopt_long (argc, argv, "a:A:b:B:cCdDeE:f:F:g:G:hHi:I:j:J:k:K:l:L:m:Mn:N:o:O:pPQ:rR:s:St:T:u:U:vVw:W:q:x:X:y:Y:z:Z:", ioreplay_options, NULL)) != -1 ) {
 		switch (c) {
 			case 'b':
 				cpu = atoi(optarg);
 				break;
+			case 'B':
+				if ( (bandwidth = parse_rate(optarg)) <= 0) {
+					fprintf(stderr, "Error parsing bandwidth parameter\n");
+					exit(-1);
+				}
+				break;
+			case 'I':
+				if ( (iops = parse_rate(optarg)) <= 0) {
+					fprintf(stderr, "Error parsing iops parameter\n");
+					exit(-1);
+				}
+				break;
+			case 'g':
+				if (filter_add_glob(optarg) != 0) {
+					exit(-1);
+				}
+				break;
+			case 'u':
+				if (filter_set_pids(optarg) != 0) {
+					fprintf(stderr, "Error parsing pids parameter\n");
+					exit(-1);
+				}
+				break;
+			case 'W':
+				if (filter_set_window(optarg) != 0) {
+					fprintf(stderr, "Error parsing window parameter\n");
+					exit(-1);
+				}
+				break;
+			case 'z':
+				strncpy(checkpoint, optarg, MAX_STRING);
+				checkpoint[MAX_STRING-1] = 0;
+				break;
+			case 'Z':
+				checkpoint_interval = atof(optarg);
+				if (checkpoint_interval <= 0) {
+					fprintf(stderr, "Error parsing checkpoint interval parameter\n");
+					exit(-1);
+				}
+				break;
+			case 'R':
+				strncpy(resume, optarg, MAX_STRING);
+				resume[MAX_STRING-1] = 0;
+				break;
+			case 'N':
+				clones = atoi(optarg);
+				if (clones < 1) {
+					fprintf(stderr, "Error parsing clones parameter\n");
+					exit(-1);
+				}
+				break;
+			case 'A':
+				strncpy(clone_prefix, optarg, MAX_STRING);
+				clone_prefix[MAX_STRING-1] = 0;
+				break;
+			case 'O':
+				clone_offset = atof(optarg);
+				break;
+			case 'j':
+				clone_jitter = atof(optarg);
+				break;
+			case 'J':
+				if ( (pid_iops = parse_rate(optarg)) <= 0) {
+					fprintf(stderr, "Error parsing pid-iops parameter\n");
+					exit(-1);
+				}
+				break;
 			case 'c':
 				action |= ACT_CONVERT;
 				break;
@@ -166,6 +707,9 @@ int main(int argc, char * * argv) {
 				action &= ~FIX_MISSING; //turn off fixing missing calls feature
 				fprintf(stderr, "Turning off fix_missing...\n");
 				break;
+			case 'D':
+				action |= DIRECT_FORCE;
+				break;
 			case 'f':
 				strncpy(filename, optarg, MAX_STRING);
 				break;
@@ -176,9 +720,39 @@ int main(int argc, char * * argv) {
 				help(basename(argv[0]));
 				return 0;
 				break;
+			case 'H':
+				action |= BUF_HUGEPAGES;
+				break;
+			case 'e':
+				action |= PIPE_CHANNELS;
+				break;
+			case 'L':
+				strncpy(placement, optarg, MAX_STRING);
+				placement[MAX_STRING-1] = 0;
+				break;
 			case 'i':
 				strncpy(ignorefile, optarg, MAX_STRING);
 				break;
+			case 'k':
+				if ( ! strcmp(CACHE_EVICT_STR, optarg) ) {
+					action = (action & ~CACHE_MASK) | CACHE_EVICT;
+				} else if ( ! strncmp(CACHE_WARM_STR, optarg, strlen(CACHE_WARM_STR)) ) {
+					action = (action & ~CACHE_MASK) | CACHE_WARM;
+					cache_fraction = 1.0;
+					if (optarg[strlen(CACHE_WARM_STR)] == ':') {
+						cache_fraction = atof(optarg + strlen(CACHE_WARM_STR) + 1);
+					}
+					if (cache_fraction < 0 || cache_fraction > 1) {
+						fprintf(stderr, "Cache fraction has to be between 0 and 1.\n");
+						exit(-1);
+					}
+				} else if ( ! strcmp(CACHE_LEAVE_STR, optarg) ) {
+					action = (action & ~CACHE_MASK) | CACHE_LEAVE;
+				} else {
+					fprintf(stderr, "Unknown cache mode specified.\n");
+					exit(-1);
+				}
+				break;
 			case 'm':
 				strncpy(mapfile, optarg, MAX_STRING);
 				break;
@@ -219,6 +793,18 @@ int main(int argc, char * * argv) {
 					exit(-1);
 				}
 				break;
+			case 'T':
+				if ( ! strcmp(MMAP_TOUCH_SEQ_STR, optarg) ) {
+					action = (action & ~MMAP_TOUCH_MASK) | MMAP_TOUCH_SEQ;
+				} else if ( ! strcmp(MMAP_TOUCH_RANDOM_STR, optarg) ) {
+					action = (action & ~MMAP_TOUCH_MASK) | MMAP_TOUCH_RANDOM;
+				} else if ( ! strcmp(MMAP_TOUCH_DERIVED_STR, optarg) ) {
+					action = (action & ~MMAP_TOUCH_MASK) | MMAP_TOUCH_DERIVED;
+				} else {
+					fprintf(stderr, "Unknown mmap touch mode specified.\n");
+					exit(-1);
+				}
+				break;
 			case 'v':
 				verbose = 1;
 				break;
@@ -226,6 +812,98 @@ int main(int argc, char * * argv) {
 				print_version();
 				return 0;
 				break;
+			case 'a':
+				patterns = atoi(optarg);
+				action |= ACT_SIMULATE;
+				break;
+			case 'l':
+				critical = atoi(optarg);
+				action |= ACT_SIMULATE;
+				break;
+			case 'E':
+				strncpy(workload, optarg, MAX_STRING);
+				workload[MAX_STRING-1] = 0;
+				action |= ACT_SIMULATE;
+				break;
+			case 'G':
+				strncpy(generate, optarg, MAX_STRING);
+				generate[MAX_STRING-1] = 0;
+				break;
+			case 'U':
+				if (anon_init(optarg) != 0) {
+					exit(-1);
+				}
+				break;
+			case 'X':
+				if (coalesce_init(optarg) != 0) {
+					fprintf(stderr, "Error parsing coalescing parameter\n");
+					exit(-1);
+				}
+				break;
+			case 'Y':
+				if (coalesce_split_init(optarg) != 0) {
+					fprintf(stderr, "Error parsing split size\n");
+					exit(-1);
+				}
+				break;
+			case 'K':
+				if (merge_add(optarg) != 0) {
+					fprintf(stderr, "Error parsing traces to merge\n");
+					exit(-1);
+				}
+				break;
+			case 'Q':
+				if (shard_init(optarg) != 0) {
+					fprintf(stderr, "Error parsing shards parameter\n");
+					exit(-1);
+				}
+				break;
+			case OPT_START_AT:
+				if ( (start_at = parse_start(optarg)) <= 0) {
+					fprintf(stderr, "Error parsing start time\n");
+					exit(-1);
+				}
+				break;
+			case OPT_COORDINATOR:
+				strncpy(coordinator, optarg, MAX_STRING);
+				coordinator[MAX_STRING-1] = 0;
+				break;
+			case OPT_WORKERS:
+				if ( (workers = atoi(optarg)) <= 0) {
+					fprintf(stderr, "Error parsing number of workers\n");
+					exit(-1);
+				}
+				break;
+			case OPT_JOIN:
+				strncpy(join, optarg, MAX_STRING);
+				join[MAX_STRING-1] = 0;
+				break;
+			case 'n':
+				strncpy(timeseries, optarg, MAX_STRING);
+				timeseries[MAX_STRING-1] = 0;
+				break;
+			case 'q':
+				if ( (mrc_rate = atof(optarg)) <= 0 || mrc_rate > 1) {
+					fprintf(stderr, "Error parsing sampling rate of the miss ratio curve\n");
+					exit(-1);
+				}
+				action |= ACT_SIMULATE;
+				break;
+			case 'y':
+				strncpy(model, optarg, MAX_STRING);
+				model[MAX_STRING-1] = 0;
+				action |= ACT_SIMULATE;
+				break;
+			case 'w':
+				strncpy(payload, optarg, MAX_STRING);
+				payload[MAX_STRING-1] = 0;
+				break;
+			case 'x':
+				if ( (speedup_count = parse_speedups(optarg, speedups)) <= 0) {
+					fprintf(stderr, "Error parsing speedup parameter\n");
+					exit(-1);
+				}
+				break;
 			default:
 				fprintf(stderr, "Unknown parameter: %s\n", argv[optind-1]);
 				return -1;
@@ -236,6 +914,42 @@ int main(int argc, char * * argv) {
 	list = (list_t *)malloc(sizeof(list_t));
 	list_init(list);
 
+	if (coordinator[0]) { //no trace is loaded
+		return coord_serve(coordinator, workers) ? -1 : 0;
+	}
+
+	if (generate[0]) { //no trace is loaded
+		return workload_generate(generate, output);
+	}
+
+	if (merge_enabled()) { //merged traces are streamed
+		if (strcmp(format, FORMAT_STRACE) && strcmp(format, FORMAT_BIN)) {
+			ERRORPRINTF("Unknown format identifier: %s\n", format);
+			return -1;
+		}
+		retval = merge_run( ! strcmp(format, FORMAT_STRACE), output);
+		merge_finish();
+		return retval;
+	}
+
+	if (timeseries[0]) { //streams the trace, nothing else is done
+		if (timeseries_init(timeseries) != 0) {
+			return -1;
+		}
+		if ( !strcmp(format, FORMAT_STRACE)) {
+			retval = strace_stream_items(filename, list, action & ACT_STATS, TIMESERIES_CHUNK, timeseries_consume);
+		} else if ( !strcmp(format, FORMAT_BIN)) {
+			retval = bin_stream_items(filename, list, TIMESERIES_CHUNK, timeseries_consume);
+		} else {
+			ERRORPRINTF("Unknown format identifier: %s\n", format);
+			retval = -1;
+		}
+		if (timeseries_finish() != 0 && retval == 0) {
+			retval = -1;
+		}
+		return retval;
+	}
+
 	if ( !strcmp(format, FORMAT_STRACE)) {
 		if ( (retval = strace_get_items(filename, list, action & ACT_STATS)) != 0) {
 			DEBUGPRINTF("Error parsing file %s, exiting\n", filename);
@@ -266,46 +980,155 @@ int main(int argc, char * * argv) {
 		fprintf(stdout, "No items loaded, nothin to do --> exiting.\n");
 		return 0;
 	}
+
+	clones_init(clones, clone_prefix, clone_offset, clone_jitter);
+	pass.list = list;
+	pass.cpu = cpu;
+	pass.scale = scale;
+	pass.action = action;
+	pass.ifilename = ifilename;
+	pass.mfilename = mfilename;
+	pass.cache_fraction = cache_fraction;
+	pass.iops = iops;
+	pass.pid_iops = pid_iops;
+	pass.bandwidth = bandwidth;
+	pass.checkpoint = checkpoint[0] ? checkpoint : NULL;
+	pass.checkpoint_interval = checkpoint_interval;
+	pass.resume = resume[0] ? resume : NULL;
+	pass.start_at = start_at;
+	pass.join = join[0] ? join : NULL;
+	pass.filename = filename;
 	if (action & ACT_PRINT) {
 		DEBUGPRINTF("Listing all syscalls in normalized format...%s", "\n");
 		print_items(list);
 	} else if (action & ACT_CONVERT) {
-		DEBUGPRINTF("Saving in binary form...%s", "\n");
-		bin_save_items(output, list);
+		if (filter_enabled()) { //find out operations out of the slice by simulating the trace
+			simulate_init(ACT_SIMULATE);
+			global_quiet = 1;
+			if (replicate(list, cpu, scale, ACT_SIMULATE | FILTER_MARK | (action & FIX_MISSING), NULL, NULL) != 0) {
+				ERRORPRINTF("An error occurred during simulation.%s", "\n");
+			}
+			global_quiet = 0;
+			simulate_finish();
+			DEBUGPRINTF("%"PRIi64" operations out of the slice removed.\n", filter_apply(list));
+		}
+		if (coalesce_enabled()) {
+			coalesce_apply(list);
+			coalesce_finish();
+		}
+		if (anon_enabled()) {
+			if (anon_apply(list) < 0) {
+				return -1;
+			}
+			anon_finish();
+		}
+		if (shard_enabled()) {
+			retval = shard_run(list, output);
+			shard_finish();
+			if (retval != 0) {
+				return -1;
+			}
+		} else {
+			DEBUGPRINTF("Saving in binary form...%s", "\n");
+			bin_save_items(output, list);
+		}
 	} else if (action & ACT_SIMULATE) {
+		if (model[0] && devmodel_init(model) != 0) {
+			return -1;
+		}
+		if (mrc_rate > 0 && mrc_init(mrc_rate) != 0) {
+			return -1;
+		}
+		if (patterns != -1 && pattern_init(patterns) != 0) {
+			return -1;
+		}
+		if (critical && critpath_init(critical) != 0) {
+			return -1;
+		}
+		if (workload[0] && workload_init(workload) != 0) {
+			return -1;
+		}
 		simulate_init(ACT_SIMULATE);
+		global_quiet = devmodel_enabled() || mrc_enabled() || pattern_enabled() || critpath_enabled() || workload_enabled(); //the replay summary means nothing here
 		if (replicate(list, cpu, scale, action, ifilename, mfilename) != 0) {
 			ERRORPRINTF("An error occurred during replicating.%s", "\n");
 		}
-		simulate_finish();
-	} else if (action & ACT_CHECK) {
-		simulate_init(ACT_CHECK);
-		if (replicate(list, cpu, scale, action | ACT_SIMULATE, ifilename, mfilename) != 0) {
-			ERRORPRINTF("An error occurred during replicating.%s", "\n");
+		global_quiet = 0;
+		if (devmodel_enabled()) {
+			devmodel_run();
+			devmodel_report();
+			devmodel_finish();
 		}
-		simulate_check_files();
-		simulate_finish();
-	} else if (action & ACT_PREPARE) {
-		simulate_init(ACT_PREPARE);
-		if (replicate(list, cpu, scale, action, ifilename, mfilename) != 0) {
-			ERRORPRINTF("An error occurred during replicating.%s", "\n");
+		if (mrc_enabled()) {
+			mrc_report();
+			mrc_finish();
+		}
+		if (pattern_enabled()) {
+			pattern_report();
+			pattern_finish();
+		}
+		if (critpath_enabled()) {
+			critpath_scan(list);
+			critpath_report();
+			critpath_finish();
+		}
+		if (workload_enabled()) {
+			workload_scan(list);
+			retval = workload_extract();
+			workload_finish();
+			if (retval != 0) {
+				return -1;
+			}
 		}
-		///< @todo to change
-		//simulate_prepare_files();
 		simulate_finish();
+	} else if (action & ACT_CHECK) {
+		clones_run(check_pass, &pass, 0);
+	} else if (action & ACT_PREPARE) {
+		clones_run(prepare_pass, &pass, 0);
 	} else if (action & ACT_REPLICATE) {
 		DEBUGPRINTF("Starting of replicating...%s", "\n");
 		if ( ! (action & TIME_MASK) ) { //time mode not defined
-			action |= TIME_DIFF; //use time diff as default
+			pass.action |= TIME_DIFF; //use time diff as default
 		}
-		/// < @todo to change
-		if (replicate(list, cpu, scale, action, ifilename, mfilename) != 0) {
-			ERRORPRINTF("An error occurred during replicating.%s", "\n");
+		if (placement_init(placement) != 0) {
+			return -1;
+		}
+		if (placement_enabled()) {
+			placement_report(clones_count());
+			if (clones_count() == 1) { //precompute the payload on the node of the replay
+				placement_bind(placement_cpu(0));
+			}
+		}
+		if (payload_init(payload) != 0) {
+			return -1;
+		}
+		if (action & CACHE_MASK) { //find out files used by the application first
+			clones_run(cache_pass, &pass, 0);
+		}
+		replicate_clock_init(pass.action);
+		for (step = 0; step < speedup_count; step++) {
+			if (speedup_count > 1) {
+				printf("Speed-up %gx:\n", speedups[step]);
+			}
+			global_speedup = speedups[step];
+			clones_run(replay_pass, &pass, 1);
+			pass.start_at = 0; //only the first replay is synchronized
+			pass.resume = NULL; //only the first replay continues from the checkpoint
+			pass.join = NULL;
+		}
+		if (action & CACHE_MASK && clones_count() == 1) {
+			pagecache_report();
+			pagecache_finish();
+		}
+		if (payload_enabled() && clones_count() == 1) {
+			payload_report();
 		}
+		payload_finish();
 	} else {
 		ERRORPRINTF("No action specified!%s", "\n");
 	}
 
+	filter_finish();
 	remove_items(list);
 	free(list);
 	return 0;
@@ -0,0 +1,446 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+
+#include "common.h"
+#include "merge.h"
+
+merge_group_t ** merge_groups = NULL;
+int32_t merge_ngroups = 0;
+merge_input_t ** merge_inputs = NULL;
+int32_t merge_ninputs = 0;
+hash_table_t merge_used; ///< pids of the merged trace
+int32_t merge_next_pid = MERGE_PID_BASE;
+int64_t merge_renamed = 0; ///< number of renumbered pids
+int64_t merge_cloned = 0; ///< number of clones added
+
+static const char * merge_marker; ///< marker being looked for by merge_find_marker()
+static int64_t merge_marker_time;
+
+list_t merge_out; ///< merged items not written yet
+int64_t merge_out_count;
+FILE * merge_out_file;
+char * merge_out_name;
+
+static int ht_compare_merge(key_t *key, item_t *item) {
+	return hash_table_entry(item, merge_pid_t, item)->pid == *key;
+}
+
+static void ht_remove_callback_merge(item_t * item) {
+	free(hash_table_entry(item, merge_pid_t, item));
+}
+
+static hash_table_operations_t ht_ops_merge = {
+	.hash = ht_hash_int,
+	.compare = ht_compare_merge,
+	.remove_callback = ht_remove_callback_merge
+};
+
+/** Adds a group of traces.
+ *
+ * @arg spec <file>[,<file>...][:<align>], where <align> is either an offset in seconds added to all times of the
+ *           group (may be negative), or a marker path (starting with '/')
+ * @return 0 on success, -1 on error
+ */
+
+int merge_add(const char * spec) {
+	char buf[MAX_STRING];
+	char * align, * file, * next;
+	merge_group_t * group;
+	merge_input_t * input;
+	double offset = 0;
+
+	strncpy(buf, spec, MAX_STRING);
+	buf[MAX_STRING-1] = 0;
+	if ( (align = strrchr(buf, ':')) != NULL) {
+		*align++ = 0;
+		if (*align != '/') {
+			offset = strtod(align, &next);
+			if (next == align || *next) {
+				return -1;
+			}
+		}
+	}
+	if ( ! buf[0]) {
+		return -1;
+	}
+
+	group = calloc(1, sizeof(merge_group_t));
+	if (align && *align == '/') {
+		strncpy(group->marker, align, MAX_STRING - 1);
+		group->marker[MAX_STRING-1] = 0;
+	}
+	group->offset = offset * 1000000;
+	group->marker_time = -1;
+	hash_table_init(&group->pids, MERGE_HT_SIZE, &ht_ops_merge);
+	merge_groups = realloc(merge_groups, (merge_ngroups + 1) * sizeof(merge_group_t *));
+	merge_groups[merge_ngroups++] = group;
+
+	for (file = buf; file; file = next) {
+		if ( (next = strchr(file, ',')) != NULL) {
+			*next++ = 0;
+		}
+		input = calloc(1, sizeof(merge_input_t));
+		input->group = group;
+		input->id = merge_ninputs;
+		strncpy(input->filename, file, MAX_STRING);
+		list_init(&input->items);
+		merge_inputs = realloc(merge_inputs, (merge_ninputs + 1) * sizeof(merge_input_t *));
+		merge_inputs[merge_ninputs++] = input;
+	}
+	return 0;
+}
+
+int merge_enabled() {
+	return merge_ninputs > 0;
+}
+
+static inline int64_t merge_usec(struct int32timeval t) {
+	return (int64_t) t.tv_sec * 1000000 + t.tv_usec;
+}
+
+/** Finds the first call on merge_marker in @a list. Passed to the streaming loaders. */
+
+static void merge_find_marker(list_t * list) {
+	common_op_item_t * com_it;
+	op_info_t * info;
+	item_t * item;
+	char * names[2];
+	int i, n;
+
+	for (item = list->head; item; item = item->next) {
+		com_it = list_entry(item, common_op_item_t, item);
+		n = get_item_names(com_it, names);
+		for (i = 0; i < n; i++) {
+			if ( ! strcmp(names[i], merge_marker) && (info = get_item_info(com_it)) != NULL
+					&& (merge_marker_time < 0 || merge_usec(info->start) < merge_marker_time)) {
+				merge_marker_time = merge_usec(info->start);
+			}
+		}
+	}
+}
+
+/** Computes offsets of groups aligned by a marker.
+ *
+ * @return 0 on success, -1 if a marker was not found
+ */
+
+static int merge_align(int strace) {
+	merge_group_t * group, * ref = NULL;
+	list_t list;
+	int32_t i;
+
+	for (i = 0; i < merge_ninputs; i++) {
+		group = merge_inputs[i]->group;
+		if ( ! group->marker[0]) {
+			continue;
+		}
+		merge_marker = group->marker;
+		merge_marker_time = group->marker_time;
+		list_init(&list);
+		if (strace) {
+			strace_stream_items(merge_inputs[i]->filename, &list, 0, MERGE_CHUNK, merge_find_marker);
+		} else {
+			bin_stream_items(merge_inputs[i]->filename, &list, MERGE_CHUNK, merge_find_marker);
+		}
+		group->marker_time = merge_marker_time;
+	}
+	for (i = 0; i < merge_ngroups; i++) {
+		group = merge_groups[i];
+		if ( ! group->marker[0]) {
+			continue;
+		}
+		if (group->marker_time < 0) {
+			ERRORPRINTF("Marker %s not found in group %d\n", group->marker, i + 1);
+			return -1;
+		}
+		if ( ! ref) {
+			ref = group;
+		}
+		group->offset = ref->marker_time - group->marker_time;
+		DEBUGPRINTF("Group %d aligned by %s, offset %.6lf s\n", i + 1, group->marker, group->offset / 1000000.0);
+	}
+	return 0;
+}
+
+static int merge_flush() {
+	int retval = bin_write_items(merge_out_file, merge_out_name, &merge_out);
+
+	remove_items(&merge_out);
+	list_init(&merge_out);
+	merge_out_count = 0;
+	return retval;
+}
+
+static int merge_emit(common_op_item_t * com_it) {
+	list_append(&merge_out, &com_it->item);
+	if (++merge_out_count >= MERGE_CHUNK) {
+		return merge_flush();
+	}
+	return 0;
+}
+
+static int merge_is_used(int32_t pid) {
+	key_t key = pid;
+
+	return hash_table_find(&merge_used, &key) != NULL;
+}
+
+static void merge_reserve(int32_t pid) {
+	merge_pid_t * mp = malloc(sizeof(merge_pid_t));
+
+	item_init(&mp->item);
+	mp->pid = mp->newpid = pid;
+	hash_table_insert(&merge_used, &mp->pid, &mp->item);
+}
+
+/** @return new pid of @a pid of @a group, which is numbered (and its number reserved) if not seen yet */
+
+static int32_t merge_pid(merge_group_t * group, int32_t pid, int * created) {
+	merge_pid_t * mp;
+	item_t * item;
+	key_t key = pid;
+	int32_t newpid = pid;
+
+	if ( (item = hash_table_find(&group->pids, &key)) != NULL) {
+		*created = 0;
+		return hash_table_entry(item, merge_pid_t, item)->newpid;
+	}
+	if (merge_is_used(pid)) {
+		while (merge_is_used(merge_next_pid)) {
+			merge_next_pid++;
+		}
+		newpid = merge_next_pid++;
+		merge_renamed++;
+	}
+	mp = malloc(sizeof(merge_pid_t));
+	item_init(&mp->item);
+	mp->pid = pid;
+	mp->newpid = newpid;
+	hash_table_insert(&group->pids, &mp->pid, &mp->item);
+
+	merge_reserve(newpid);
+	*created = 1;
+	return newpid;
+}
+
+/** Aligns time and renumbers pids of @a com_it of group @a group, adds clone of a new process if needed and
+ * appends the item to the output.
+ *
+ * @return 0 on success, -1 on error
+ */
+
+static int merge_item(merge_group_t * group, common_op_item_t * com_it) {
+	op_info_t * info = get_item_info(com_it);
+	clone_item_t * clone_it;
+	wait_item_t * wait_it;
+	int64_t start;
+	int created;
+
+	if (info == NULL) {
+		return merge_emit(com_it);
+	}
+	start = merge_usec(info->start) + group->offset;
+	info->start.tv_sec = start / 1000000;
+	info->start.tv_usec = start % 1000000;
+	info->pid = merge_pid(group, info->pid, &created);
+	if (created) { //not cloned in the group
+		clone_it = new_clone_item();
+		clone_it->type = OP_CLONE;
+		clone_it->o.mode = 0; //descriptors of the init process, i.e. just the standard ones
+		clone_it->o.retval = info->pid;
+		clone_it->o.info.pid = MERGE_INIT_PID;
+		clone_it->o.info.dur = 0;
+		clone_it->o.info.start = info->start;
+		merge_cloned++;
+		if (merge_emit((common_op_item_t *) clone_it) != 0) {
+			return -1;
+		}
+	}
+	if (com_it->type == OP_CLONE) {
+		clone_it = (clone_item_t *) com_it;
+		if (clone_it->o.retval > 0) {
+			clone_it->o.retval = merge_pid(group, clone_it->o.retval, &created);
+		}
+	} else if (com_it->type == OP_WAIT) {
+		wait_it = (wait_item_t *) com_it;
+		if (wait_it->o.pid > 0) {
+			wait_it->o.pid = merge_pid(group, wait_it->o.pid, &created);
+		}
+		if (wait_it->o.retval > 0) {
+			wait_it->o.retval = merge_pid(group, wait_it->o.retval, &created);
+		}
+	}
+	return merge_emit(com_it);
+}
+
+/** Reads next items of @a input, until some are read or the file ends.
+ *
+ * @return 0 on success, -1 on error
+ */
+
+static int merge_fill(merge_input_t * input, int strace) {
+	op_info_t * info;
+	int64_t n;
+
+	while ( ! input->items.head && ! input->eof) {
+		if (strace) {
+			n = strace_read_items(&input->strace, &input->items, MERGE_CHUNK);
+		} else if ( (n = bin_read_items(&input->bin, &input->items, MERGE_CHUNK)) < 0) {
+			return -1;
+		}
+		input->eof = n < MERGE_CHUNK;
+	}
+	if (input->items.head) {
+		info = get_item_info(list_entry(input->items.head, common_op_item_t, item));
+		input->next = info ? merge_usec(info->start) + input->group->offset : INT64_MIN;
+	}
+	return 0;
+}
+
+static inline int merge_before(merge_input_t * a, merge_input_t * b) {
+	return a->next < b->next || (a->next == b->next && a->id < b->id);
+}
+
+static void merge_heap_down(merge_input_t ** heap, int32_t n, int32_t i) {
+	merge_input_t * tmp;
+	int32_t c;
+
+	while ( (c = 2 * i + 1) < n) {
+		if (c + 1 < n && merge_before(heap[c+1], heap[c])) {
+			c++;
+		}
+		if ( ! merge_before(heap[c], heap[i])) {
+			break;
+		}
+		tmp = heap[i];
+		heap[i] = heap[c];
+		heap[c] = tmp;
+		i = c;
+	}
+}
+
+/** Merges all traces added by merge_add() into binary trace @a output.
+ *
+ * @arg strace whether the traces are in strace format, binary otherwise
+ * @return 0 on success, -1 on error
+ */
+
+int merge_run(int strace, char * output) {
+	merge_input_t ** heap;
+	merge_input_t * input;
+	item_t * item;
+	int64_t count = 0;
+	int32_t i, n = 0;
+	int retval = 0;
+
+	if (merge_align(strace) != 0) {
+		return -1;
+	}
+	if ( (merge_out_file = fopen(output, "wb")) == NULL) {
+		ERRORPRINTF("Error opening file %s: %s\n", output, strerror(errno));
+		return -1;
+	}
+	merge_out_name = output;
+	list_init(&merge_out);
+	merge_out_count = 0;
+	hash_table_init(&merge_used, MERGE_HT_SIZE, &ht_ops_merge);
+	merge_reserve(MERGE_INIT_PID);
+
+	heap = malloc(merge_ninputs * sizeof(merge_input_t *));
+	for (i = 0; i < merge_ninputs && retval == 0; i++) {
+		input = merge_inputs[i];
+		if (strace) {
+			retval = strace_open_items(&input->strace, input->filename, 0);
+		} else {
+			retval = bin_open_items(&input->bin, input->filename);
+		}
+		if (retval != 0) {
+			ERRORPRINTF("Error opening file %s\n", input->filename);
+			break;
+		}
+		input->opened = 1;
+		if ( (retval = merge_fill(input, strace)) == 0 && input->items.head) {
+			heap[n++] = input;
+		}
+	}
+	for (i = n / 2; i >= 0 && n; i--) {
+		merge_heap_down(heap, n, i);
+	}
+
+	while (n > 0 && retval == 0) {
+		input = heap[0];
+		item = input->items.head;
+		list_remove(&input->items, item);
+		retval = merge_item(input->group, list_entry(item, common_op_item_t, item));
+		count++;
+		if (retval == 0 && (retval = merge_fill(input, strace)) == 0 && ! input->items.head) {
+			heap[0] = heap[--n];
+		}
+		merge_heap_down(heap, n, 0);
+	}
+	if (retval == 0) {
+		retval = merge_flush();
+	} else {
+		merge_flush();
+	}
+	if (fclose(merge_out_file) != 0) {
+		ERRORPRINTF("Error writing file %s: %s\n", output, strerror(errno));
+		retval = -1;
+	}
+	DEBUGPRINTF("%"PRIi64" calls of %d files merged to %s, %"PRIi64" pids renumbered, %"PRIi64" clones added\n",
+			count, merge_ninputs, output, merge_renamed, merge_cloned);
+
+	for (i = 0; i < merge_ninputs; i++) {
+		input = merge_inputs[i];
+		remove_items(&input->items);
+		list_init(&input->items);
+		if (input->opened && strace) {
+			strace_close_items(&input->strace);
+		} else if (input->opened) {
+			bin_close_items(&input->bin);
+		}
+		input->opened = 0;
+	}
+	free(heap);
+	hash_table_destroy(&merge_used);
+	return retval;
+}
+
+void merge_finish() {
+	int32_t i;
+
+	for (i = 0; i < merge_ngroups; i++) {
+		hash_table_destroy(&merge_groups[i]->pids);
+		free(merge_groups[i]);
+	}
+	for (i = 0; i < merge_ninputs; i++) {
+		free(merge_inputs[i]);
+	}
+	free(merge_groups);
+	free(merge_inputs);
+	merge_groups = NULL;
+	merge_inputs = NULL;
+	merge_ngroups = merge_ninputs = 0;
+}
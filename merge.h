@@ -0,0 +1,84 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _MERGE_H_
+#define _MERGE_H_
+
+/** @file merge.h
+ *
+ * Merges more traces (e.g. of more hosts sharing storage) into one binary trace, so they can be replayed as one
+ * workload. Traces are given in groups: files of one group come from one host (e.g. per process files of
+ * strace -ff) and share pids and clock. Pids of different groups are kept unless they collide, colliding ones
+ * are renumbered from MERGE_PID_BASE on, including pids in clone and wait calls.
+ *
+ * Clocks of groups are aligned either by a given offset or by a marker: the first call on a given path (e.g. a
+ * file all hosts stat when the job starts). Marker calls of all groups aligned by a marker are put at the time
+ * of the marker call of the first such group.
+ *
+ * Processes not cloned in their group (e.g. the first process of every host) are cloned at their first call from
+ * an init process (MERGE_INIT_PID), which does nothing else. So they start with just the standard descriptors
+ * and descriptors of different hosts do not mix during replay.
+ *
+ * Files are read in chunks of MERGE_CHUNK items and merged by start time (k-way merge using a heap), the output
+ * is written in chunks too, so traces bigger than memory can be merged.
+ */
+
+#include <stdint.h>
+#include "common.h"
+#include "in_common.h"
+#include "in_strace.h"
+#include "in_binary.h"
+#include "adt/hash_table.h"
+
+#define MERGE_CHUNK 4096
+#define MERGE_HT_SIZE 1024
+#define MERGE_INIT_PID 4194304 ///< above the highest pid Linux can give, so it never collides
+#define MERGE_PID_BASE (MERGE_INIT_PID + 1) ///< renumbered pids
+
+typedef struct merge_pid {
+	item_t item;
+	key_t pid;
+	int32_t newpid;
+} merge_pid_t;
+
+typedef struct merge_group {
+	char marker[MAX_STRING]; ///< empty if aligned by an offset
+	int64_t marker_time; ///< start of the marker call, -1 if not found
+	int64_t offset; ///< added to all times of the group, in usec
+	hash_table_t pids; ///< pids of the group and their new numbers
+} merge_group_t;
+
+typedef struct merge_input {
+	merge_group_t * group;
+	int32_t id;
+	char filename[MAX_STRING];
+	strace_reader_t strace;
+	bin_reader_t bin;
+	list_t items; ///< items read, but not merged yet
+	int opened;
+	int eof;
+	int64_t next; ///< aligned start of the first item
+} merge_input_t;
+
+int merge_add(const char * spec);
+int merge_enabled();
+int merge_run(int strace, char * output);
+void merge_finish();
+
+#endif
@@ -0,0 +1,413 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "common.h"
+#include "mrc.h"
+
+double mrc_rate = 0; ///< sampling rate, 0 = analysis not enabled
+uint64_t mrc_threshold; ///< pages with hash below this are sampled
+mrc_hist_t mrc_total;
+hash_table_t mrc_files;
+hash_table_t mrc_pids;
+int32_t mrc_nfiles = 0;
+int64_t mrc_pages = 0; ///< all page accesses, sampled or not
+
+/** Last access time of every sampled page, open addressing table. Time 0 = empty slot. */
+uint64_t * mrc_key = NULL;
+uint32_t * mrc_time = NULL;
+uint32_t mrc_size = 0; ///< number of slots, power of two
+uint32_t mrc_used = 0;
+
+/** Fenwick tree over access times, 1 at the time of the last access of every page. */
+int32_t * mrc_tree = NULL;
+uint32_t mrc_tree_size = 0;
+uint32_t mrc_now = 0; ///< time of the last access
+
+static int ht_compare_mrc_file(key_t *key, item_t *item) {
+	return ! strncmp(hash_table_entry(item, mrc_file_t, item)->name, (char *) key, MAX_STRING);
+}
+
+static int ht_compare_mrc_pid(key_t *key, item_t *item) {
+	return hash_table_entry(item, mrc_pid_t, item)->pid == *key;
+}
+
+static void ht_remove_callback_mrc_file(item_t * item) {
+	free(hash_table_entry(item, mrc_file_t, item));
+}
+
+static void ht_remove_callback_mrc_pid(item_t * item) {
+	free(hash_table_entry(item, mrc_pid_t, item));
+}
+
+static hash_table_operations_t ht_ops_mrc_file = {
+	.hash = ht_hash_str,
+	.compare = ht_compare_mrc_file,
+	.remove_callback = ht_remove_callback_mrc_file
+};
+
+static hash_table_operations_t ht_ops_mrc_pid = {
+	.hash = ht_hash_int,
+	.compare = ht_compare_mrc_pid,
+	.remove_callback = ht_remove_callback_mrc_pid
+};
+
+static inline uint64_t mrc_hash(uint64_t key) {
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdULL;
+	key ^= key >> 33;
+	key *= 0xc4ceb9fe1a85ec53ULL;
+	key ^= key >> 33;
+	return key;
+}
+
+/** Starts the analysis.
+ *
+ * @arg rate fraction of pages to sample, from (0, 1]
+ * @return 0 on success, -1 on error
+ */
+
+int mrc_init(double rate) {
+	if (rate <= 0 || rate > 1) {
+		ERRORPRINTF("Sampling rate has to be from (0, 1]: %lf\n", rate);
+		return -1;
+	}
+	mrc_rate = rate;
+	mrc_threshold = (uint64_t) (rate * (1 << MRC_SAMPLE_BITS));
+	memset(&mrc_total, 0, sizeof(mrc_total));
+	hash_table_init(&mrc_files, MRC_HT_SIZE, &ht_ops_mrc_file);
+	hash_table_init(&mrc_pids, MRC_HT_SIZE, &ht_ops_mrc_pid);
+
+	mrc_size = MRC_TREE_MIN;
+	mrc_key = malloc(mrc_size * sizeof(uint64_t));
+	mrc_time = calloc(mrc_size, sizeof(uint32_t));
+	mrc_tree_size = MRC_TREE_MIN;
+	mrc_tree = calloc(mrc_tree_size + 1, sizeof(int32_t));
+	if ( ! mrc_key || ! mrc_time || ! mrc_tree) {
+		ERRORPRINTF("Not enough memory for the miss ratio curve%s", "\n");
+		return -1;
+	}
+	return 0;
+}
+
+int mrc_enabled() {
+	return mrc_rate > 0;
+}
+
+static inline void mrc_tree_add(uint32_t i, int32_t v) {
+	for (; i <= mrc_tree_size; i += i & -i) {
+		mrc_tree[i] += v;
+	}
+}
+
+static inline int64_t mrc_tree_sum(uint32_t i) {
+	int64_t sum = 0;
+
+	for (; i > 0; i -= i & -i) {
+		sum += mrc_tree[i];
+	}
+	return sum;
+}
+
+/** @return slot of @a key in the table of last accesses, or the empty slot where it belongs. The slot is taken
+ * from the upper half of the hash, the lower one decides about sampling. */
+
+static inline uint32_t mrc_slot(uint64_t key) {
+	uint32_t s;
+
+	for (s = (mrc_hash(key) >> 32) & (mrc_size - 1); mrc_time[s] && mrc_key[s] != key; s = (s + 1) & (mrc_size - 1))
+		;
+	return s;
+}
+
+static int mrc_compare_time(const void * a, const void * b) {
+	uint32_t ta = mrc_time[*(const uint32_t *) a];
+	uint32_t tb = mrc_time[*(const uint32_t *) b];
+
+	return ta < tb ? -1 : ta > tb;
+}
+
+/** Renumbers the last access times to 1..n in their order and rebuilds the Fenwick tree, which is then twice
+ * as big as the number of tracked pages. Called when the times run out of the tree.
+ */
+
+static void mrc_compact() {
+	uint32_t * order = malloc(mrc_used * sizeof(uint32_t));
+	uint32_t s, n = 0;
+
+	for (s = 0; s < mrc_size; s++) {
+		if (mrc_time[s]) {
+			order[n++] = s;
+		}
+	}
+	qsort(order, n, sizeof(uint32_t), mrc_compare_time);
+
+	free(mrc_tree);
+	mrc_tree_size = 2 * n > MRC_TREE_MIN ? 2 * n : MRC_TREE_MIN;
+	mrc_tree = calloc(mrc_tree_size + 1, sizeof(int32_t));
+	for (s = 0; s < n; s++) {
+		mrc_time[order[s]] = s + 1;
+		mrc_tree_add(s + 1, 1);
+	}
+	mrc_now = n;
+	free(order);
+}
+
+/** Doubles the table of last accesses. */
+
+static void mrc_grow() {
+	uint64_t * keys = mrc_key;
+	uint32_t * times = mrc_time;
+	uint32_t size = mrc_size, s, n;
+
+	mrc_size *= 2;
+	mrc_key = malloc(mrc_size * sizeof(uint64_t));
+	mrc_time = calloc(mrc_size, sizeof(uint32_t));
+	if ( ! mrc_key || ! mrc_time) {
+		ERRORPRINTF("Not enough memory for %u pages of the miss ratio curve\n", mrc_size);
+		exit(1);
+	}
+	for (s = 0; s < size; s++) {
+		if (times[s]) {
+			n = mrc_slot(keys[s]);
+			mrc_key[n] = keys[s];
+			mrc_time[n] = times[s];
+		}
+	}
+	free(keys);
+	free(times);
+}
+
+static inline void mrc_hist_add(mrc_hist_t * h, int bucket) {
+	h->accesses++;
+	if (bucket < 0) {
+		h->cold++;
+	} else {
+		h->hist[bucket]++;
+	}
+}
+
+/** Accesses one sampled page.
+ *
+ * @return bucket of its scaled stack distance, -1 for the first access
+ */
+
+static int mrc_access(uint64_t key) {
+	uint32_t s = mrc_slot(key);
+	double dist;
+	uint64_t d;
+	int b = 0;
+
+	if (mrc_now == mrc_tree_size) {
+		mrc_compact();
+	}
+	mrc_now++;
+	if (mrc_time[s] == 0) { //the first access
+		mrc_key[s] = key;
+		mrc_time[s] = mrc_now;
+		mrc_tree_add(mrc_now, 1);
+		if (++mrc_used > mrc_size / 2) {
+			mrc_grow();
+		}
+		return -1;
+	}
+
+	dist = (mrc_tree_sum(mrc_now - 1) - mrc_tree_sum(mrc_time[s])) / mrc_rate;
+	mrc_tree_add(mrc_time[s], -1);
+	mrc_tree_add(mrc_now, 1);
+	mrc_time[s] = mrc_now;
+
+	for (d = (uint64_t) dist; d && b < MRC_BUCKETS - 1; d >>= 1) {
+		b++;
+	}
+	return b;
+}
+
+/** Notes one read or write. Called by simulate_* functions.
+ *
+ * @arg pid process which did the call
+ * @arg name name of the file
+ * @arg offset offset of the call
+ * @arg size number of bytes the call transferred
+ */
+
+void mrc_add(int32_t pid, const char * name, int64_t offset, int64_t size) {
+	mrc_file_t * file;
+	mrc_pid_t * p;
+	item_t * item;
+	key_t key = pid;
+	int64_t page, last;
+	uint64_t page_key;
+	int b;
+
+	if (size <= 0) {
+		return;
+	}
+	if ( (item = hash_table_find(&mrc_files, (key_t *) name)) == NULL) {
+		file = calloc(1, sizeof(mrc_file_t));
+		item_init(&file->item);
+		strncpy(file->name, name, MAX_STRING);
+		file->name[MAX_STRING-1] = 0;
+		file->id = mrc_nfiles++;
+		hash_table_insert(&mrc_files, (key_t *) file->name, &file->item);
+	} else {
+		file = hash_table_entry(item, mrc_file_t, item);
+	}
+	if ( (item = hash_table_find(&mrc_pids, &key)) == NULL) {
+		p = calloc(1, sizeof(mrc_pid_t));
+		item_init(&p->item);
+		p->pid = pid;
+		hash_table_insert(&mrc_pids, &p->pid, &p->item);
+	} else {
+		p = hash_table_entry(item, mrc_pid_t, item);
+	}
+
+	last = (offset + size - 1) / MRC_PAGE;
+	for (page = offset / MRC_PAGE; page <= last; page++) {
+		mrc_pages++;
+		page_key = (uint64_t) file->id << 36 | page;
+		if ( (mrc_hash(page_key) & ((1 << MRC_SAMPLE_BITS) - 1)) >= mrc_threshold) {
+			continue;
+		}
+		b = mrc_access(page_key);
+		mrc_hist_add(&mrc_total, b);
+		mrc_hist_add(&file->hist, b);
+		mrc_hist_add(&p->hist, b);
+	}
+}
+
+/** @return hit ratio of a cache of 2^k pages */
+
+static double mrc_hit_ratio(mrc_hist_t * h, int k) {
+	int64_t hits = 0;
+	int b;
+
+	for (b = 0; b <= k && b < MRC_BUCKETS; b++) {
+		hits += h->hist[b];
+	}
+	return h->accesses ? (double) hits / h->accesses : 0.0;
+}
+
+/** Formats size of 2^k pages into @a buf. */
+
+static char * mrc_size_str(char * buf, int k) {
+	const char * units = "KMGTPE";
+	int shift = k + 2; //pages are 4K = 2^2 K
+
+	snprintf(buf, 16, "%d%c", 1 << (shift % 10), units[shift / 10]);
+	return buf;
+}
+
+/** @return the smallest k such that the hit ratio of 2^k pages is the maximal one of @a h */
+
+static int mrc_max_bucket(mrc_hist_t * h) {
+	int b, k = 0;
+
+	for (b = 0; b < MRC_BUCKETS; b++) {
+		if (h->hist[b]) {
+			k = b;
+		}
+	}
+	return k;
+}
+
+static int mrc_cols; ///< number of columns of per file/process tables, sizes 4^c pages
+
+static void mrc_print_row(const char * label, mrc_hist_t * h) {
+	int c;
+
+	printf("%12"PRIi64" %6.1lf%%", h->accesses, h->accesses ? 100.0 * h->cold / h->accesses : 0.0);
+	for (c = 0; c < mrc_cols; c++) {
+		printf(" %6.1lf%%", 100.0 * (1 - mrc_hit_ratio(h, 2 * c)));
+	}
+	printf("  %s\n", label);
+}
+
+static void mrc_print_file(item_t * item) {
+	mrc_file_t * file = hash_table_entry(item, mrc_file_t, item);
+
+	if (file->hist.accesses) {
+		mrc_print_row(file->name, &file->hist);
+	}
+}
+
+static void mrc_print_pid(item_t * item) {
+	mrc_pid_t * p = hash_table_entry(item, mrc_pid_t, item);
+	char label[32];
+
+	if (p->hist.accesses) {
+		snprintf(label, sizeof(label), "pid %d", p->pid);
+		mrc_print_row(label, &p->hist);
+	}
+}
+
+static void mrc_print_header(const char * what) {
+	char buf[16];
+	int c;
+
+	printf("%12s %7s", "accesses", "cold");
+	for (c = 0; c < mrc_cols; c++) {
+		printf(" %7s", mrc_size_str(buf, 2 * c));
+	}
+	printf("  %s\n", what);
+}
+
+/** Prints the miss ratio curve of the whole trace and miss ratios of every file and process. */
+
+void mrc_report() {
+	char buf[16];
+	int k, max = mrc_max_bucket(&mrc_total);
+
+	printf("Miss ratio curve of LRU page cache (%d byte pages, sampling rate %g): %"PRIi64" page accesses, %"PRIi64" sampled, %u distinct pages sampled\n",
+			MRC_PAGE, mrc_rate, mrc_pages, mrc_total.accesses, mrc_used);
+	printf("%8s %9s %9s\n", "cache", "hit", "miss");
+	for (k = 0; k <= max; k++) {
+		printf("%8s %8.2lf%% %8.2lf%%\n", mrc_size_str(buf, k), 100.0 * mrc_hit_ratio(&mrc_total, k),
+				100.0 * (1 - mrc_hit_ratio(&mrc_total, k)));
+	}
+	printf("Cold misses: %.2lf%%\n", mrc_total.accesses ? 100.0 * mrc_total.cold / mrc_total.accesses : 0.0);
+
+	mrc_cols = max / 2 + 1;
+	printf("Miss ratio per file by cache size:\n");
+	mrc_print_header("file");
+	hash_table_apply(&mrc_files, mrc_print_file);
+	printf("Miss ratio per process by cache size:\n");
+	mrc_print_header("process");
+	hash_table_apply(&mrc_pids, mrc_print_pid);
+}
+
+void mrc_finish() {
+	if ( ! mrc_enabled()) {
+		return;
+	}
+	hash_table_destroy(&mrc_files);
+	hash_table_destroy(&mrc_pids);
+	free(mrc_key);
+	free(mrc_time);
+	free(mrc_tree);
+	mrc_key = NULL;
+	mrc_time = NULL;
+	mrc_tree = NULL;
+	mrc_size = mrc_used = mrc_tree_size = mrc_now = 0;
+	mrc_rate = 0;
+}
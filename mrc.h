@@ -0,0 +1,76 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _MRC_H_
+#define _MRC_H_
+
+/** @file mrc.h
+ *
+ * Miss ratio curve of an LRU page cache, i.e. the hit ratio of reads and writes as a function of the cache size.
+ *
+ * Every read and write noted during simulation (-M) is split into 4KB pages. For every page access, the LRU stack
+ * distance (number of distinct pages accessed since the last access of the same page) is computed: a cache of
+ * C pages hits exactly the accesses with distance smaller than C. Distances are counted by a Fenwick tree over
+ * times of the last accesses, which is compacted when it gets full, so every access costs O(log n).
+ *
+ * To scale to billions of accesses, pages are spatially sampled as in SHARDS: only pages whose hash falls below
+ * rate * 2^24 are tracked, and their distances are divided by the rate. A page is either always or never sampled,
+ * so reuse is preserved. Rate 1 gives exact curves.
+ *
+ * Distances are kept in log2 histograms for the whole trace and for every file and process, so all the curves
+ * come from one pass over the trace.
+ */
+
+#include <stdint.h>
+#include "common.h"
+#include "adt/hash_table.h"
+
+#define MRC_PAGE 4096
+#define MRC_BUCKETS 48 ///< bucket b holds distances (in pages) with b bits, i.e. from 2^(b-1) to 2^b - 1
+#define MRC_SAMPLE_BITS 24
+#define MRC_HT_SIZE 1024
+#define MRC_TREE_MIN 65536 ///< initial size of the Fenwick tree
+
+/** Histogram of stack distances of accesses of the whole trace, one file or one process. */
+typedef struct mrc_hist {
+	int64_t accesses; ///< sampled accesses
+	int64_t cold; ///< accesses of pages never seen before
+	int64_t hist[MRC_BUCKETS];
+} mrc_hist_t;
+
+typedef struct mrc_file {
+	item_t item;
+	char name[MAX_STRING];
+	int32_t id;
+	mrc_hist_t hist;
+} mrc_file_t;
+
+typedef struct mrc_pid {
+	item_t item;
+	key_t pid;
+	mrc_hist_t hist;
+} mrc_pid_t;
+
+int mrc_init(double rate);
+int mrc_enabled();
+void mrc_add(int32_t pid, const char * name, int64_t offset, int64_t size);
+void mrc_report();
+void mrc_finish();
+
+#endif
@@ -23,6 +23,7 @@
 #include <errno.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/stat.h>
 
 #include "common.h"
 #include "namemap.h"
@@ -30,6 +31,13 @@
 
 hash_table_t ht_map;
 list_t l_igns;
+char namemap_prefix[MAX_STRING] = ""; ///< prepended to every name, empty to disable
+char namemap_bufs[NAMEMAP_BUFS][MAX_STRING]; ///< names with the prefix are returned in these buffers, round robin
+int namemap_buf_idx = 0;
+int namemap_mkdirs = 0; ///< whether to create directories under the prefix
+list_t l_only; ///< glob patterns of files to replay, all other files are ignored. Kept across namemap_init() calls.
+int namemap_only_count = 0;
+int64_t namemap_ignored = 0; ///< number of names ignored so far
 
 static int ht_compare_namemap(key_t *key, item_t *item) {
 	namemap_item_t * namemap_item;
@@ -215,8 +223,105 @@ void namemap_finish() {
 	}
 }
 
+/** Sets @a prefix which is prepended to every file name returned by namemap_get_name(). Relative names
+ * are put under the prefix as well. The prefix is kept across namemap_init() calls.
+ *
+ * @arg prefix the prefix, NULL or empty string to disable it
+ */
+
+void namemap_set_prefix(const char * prefix) {
+	if (prefix == NULL) {
+		namemap_prefix[0] = 0;
+		return;
+	}
+	strncpy(namemap_prefix, prefix, MAX_STRING);
+	namemap_prefix[MAX_STRING-1] = 0;
+}
+
+/** Adds glob pattern @a glob of files to replay. Once a pattern is added, names not matching any of them
+ * are ignored.
+ *
+ * @return 0 on success, non-zero if the pattern is too long
+ */
+
+int namemap_add_only(const char * glob) {
+	namemap_item_t * nm_item;
+
+	if (strlen(glob) >= MAX_STRING) {
+		ERRORPRINTF("Pattern %s is too long.\n", glob);
+		return -1;
+	}
+	if (namemap_only_count == 0) {
+		list_init(&l_only);
+	}
+	nm_item = malloc(sizeof(namemap_item_t));
+	item_init(&nm_item->item);
+	strcpy(nm_item->old_name, glob);
+	nm_item->new_name[0] = 0;
+	list_append(&l_only, &nm_item->item);
+	namemap_only_count++;
+	return 0;
+}
+
+/** Returns number of names ignored by namemap_get_name() so far. */
+int64_t namemap_ignored_count() {
+	return namemap_ignored;
+}
+
+/** Sets whether directories of names are created under the prefix when the names are translated, 
+ * so the prefixed tree mirrors the original one. Only directories existing in the original tree are created.
+ */
+
+void namemap_prefix_mkdirs(int enable) {
+	namemap_mkdirs = enable;
+}
+
+/** Creates the prefix and parent directories of @a name under it, if they exist without it. @a buf is 
+ * the name with the prefix.
+ */
+
+static void namemap_make_dirs(const char * name, char * buf) {
+	char * c;
+	int skip = strlen(buf) - strlen(name);
+	struct stat st;
+
+	for (c = strchr(buf + 1, '/'); c != NULL; c = strchr(c + 1, '/')) {
+		*c = 0;
+		if (c <= buf + skip) { //the prefix itself
+			if (mkdir(buf, 0755) == -1 && errno != EEXIST) {
+				ERRORPRINTF("Cannot create directory %s: %s\n", buf, strerror(errno));
+			}
+		} else if (stat(buf + skip, &st) == 0 && S_ISDIR(st.st_mode)) {
+			if (mkdir(buf, st.st_mode & 07777) == -1 && errno != EEXIST) {
+				ERRORPRINTF("Cannot create directory %s: %s\n", buf, strerror(errno));
+			}
+		}
+		*c = '/';
+	}
+}
+
+/** Prepends the prefix to @a name. Result is valid until NAMEMAP_BUFS more names are translated.
+ */
+
+static char * namemap_add_prefix(char * name) {
+	char * buf;
+
+	if ( ! namemap_prefix[0] ) {
+		return name;
+	}
+	buf = namemap_bufs[namemap_buf_idx];
+	namemap_buf_idx = (namemap_buf_idx + 1) % NAMEMAP_BUFS;
+	if (snprintf(buf, MAX_STRING, "%s%s%s", namemap_prefix, name[0] == '/' ? "" : "/", name) >= MAX_STRING) {
+		ERRORPRINTF("File name %s with prefix %s is too long, truncated.\n", name, namemap_prefix);
+	} else if (namemap_mkdirs) {
+		namemap_make_dirs(name, buf);
+	}
+	return buf;
+}
+
 /** Searches for mapping for given filename. It returns NULL if the file should be ignored,
  * mapped file name in case mapping was found or simply @a name if no change is necessary.
+ * If a prefix is set, it is prepended to the result.
  *
  * @arg name file name for which to find mapping
  * @return old/new filename or NULL if the file should be ignored
@@ -231,22 +336,37 @@ char * namemap_get_name(char * name) {
 		nm_item = list_entry(item, namemap_item_t, item);
 		rv = fnmatch(nm_item->old_name, name, 0);
 		if (rv == 0) {
+			namemap_ignored++;
 			return NULL;
 		} else if ( rv != FNM_NOMATCH ) {
 			ERRORPRINTF("Error occured during matching name %s to string %s.\n", name, nm_item->old_name);
+			namemap_ignored++;
 			return NULL; // it will be best to ignore this file...
 		}
 		item = item->next;
 	}
 
+	if (namemap_only_count > 0) { //only some files should be replayed
+		for (item = l_only.head; item; item = item->next) {
+			nm_item = list_entry(item, namemap_item_t, item);
+			if (fnmatch(nm_item->old_name, name, 0) == 0) {
+				break;
+			}
+		}
+		if ( ! item ) {
+			namemap_ignored++;
+			return NULL;
+		}
+	}
+
 	//it was not in ignore items, maybe it is in mapped items
 	item = hash_table_find(&ht_map, (key_t *) name);
 
 	if (item) {
 		nm_item = list_entry(item, namemap_item_t, item);
-		return nm_item->new_name;
+		return namemap_add_prefix(nm_item->new_name);
 	} else {
 		//no change necessary:
-		return name;
+		return namemap_add_prefix(name);
 	}
 }
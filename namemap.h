@@ -25,6 +25,11 @@
  * Takes care of mapping file names to null string (when given file shoud be ignores) or to another filename.
  *
  * It uses hash_table, where the key is an original filename and data new filenames.
+ *
+ * If patterns of files to replay are given, all other files are ignored as well (see filter.h).
+ *
+ * Optionally, a prefix is prepended to every (mapped) file name, so several copies of one trace can be replayed
+ * in separate directory trees (see clones.h).
  */
 
 #include <time.h>
@@ -37,7 +42,13 @@ typedef struct namemap_item {
 	char new_name[MAX_STRING];
 } namemap_item_t;
 
+#define NAMEMAP_BUFS 4 ///< number of names with prefix that can be used at the same time
+
 int namemap_init(char *ifilename, char *mfilename);
+void namemap_set_prefix(const char * prefix);
+void namemap_prefix_mkdirs(int enable);
+int namemap_add_only(const char * glob);
+int64_t namemap_ignored_count();
 char * namemap_get_name(char * name);
 void namemap_finish();
 #endif
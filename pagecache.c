@@ -0,0 +1,329 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "common.h"
+#include "pagecache.h"
+
+hash_table_t pc_files;
+int pc_initialized = 0;
+int64_t pc_page_size = 4096;
+int64_t pc_file_count = 0; ///< number of files in pc_files
+int64_t pc_reads = 0; ///< number of reads seen during replay
+int64_t pc_sampled_reads = 0; ///< number of reads sampled
+int64_t pc_sampled_pages = 0; ///< pages touched by sampled reads
+int64_t pc_sampled_hits = 0; ///< pages of sampled reads that were resident
+int64_t pc_pages_before = 0; ///< total pages of all files, before the control stage
+int64_t pc_resident_before = 0; ///< resident pages before the control stage
+int64_t pc_pages_start = 0; ///< total pages at the start of the replay
+int64_t pc_resident_start = 0; ///< resident pages at the start of the replay
+char * pc_mode_str = "leave";
+
+static int ht_compare_pc(key_t *key, item_t *item) {
+	pc_file_t * pc_file;
+
+	pc_file = hash_table_entry(item, pc_file_t, item);
+	return ! strncmp(pc_file->name, (char *) key, MAX_STRING);
+}
+
+static inline void ht_remove_callback_pc(item_t * item) {
+	pc_file_t * pc_file = hash_table_entry(item, pc_file_t, item);	
+
+	if (pc_file->fd != -1) {
+		close(pc_file->fd);
+	}
+	free(pc_file);
+	return;
+}
+
+/** hash table operations. */
+static hash_table_operations_t ht_ops_pc = {
+	.hash = ht_hash_str,
+	.compare = ht_compare_pc,
+	.remove_callback = ht_remove_callback_pc
+};
+
+/** Initializes the module. 
+ *
+ * @return 0 on success, non-zero otherwise
+ */
+
+int pagecache_init() {
+	hash_table_init(&pc_files, HASH_TABLE_SIZE, &ht_ops_pc);
+	pc_page_size = sysconf(_SC_PAGESIZE);
+	pc_initialized = 1;
+	return 0;
+}
+
+/** Adds file @a name to the set of files whose page cache state is controlled. 
+ *
+ * @arg name name of the file (already mapped by namemap)
+ */
+
+void pagecache_add_file(const char * name) {
+	pc_file_t * pc_file;
+
+	if (hash_table_find(&pc_files, (key_t *) name) != NULL) {
+		return;
+	}
+
+	pc_file = malloc(sizeof(pc_file_t));
+	item_init(&pc_file->item);
+	strncpy(pc_file->name, name, MAX_STRING);
+	pc_file->name[MAX_STRING-1] = 0;
+	pc_file->fd = -1;
+	hash_table_insert(&pc_files, (key_t *) pc_file->name, &pc_file->item);
+	pc_file_count++;
+}
+
+/** Counts pages of the file @a fd that are resident in the page cache.
+ *
+ * @arg fd file descriptor of the file
+ * @arg offset start of the range
+ * @arg len length of the range, it is cut at the end of the file
+ * @arg pages if not NULL, number of pages in the range is stored here
+ * @return number of resident pages, -1 on error
+ */
+
+static int64_t pagecache_resident(int fd, int64_t offset, int64_t len, int64_t * pages) {
+	struct stat st;
+	unsigned char * vec;
+	char * addr;
+	int64_t start, end, win, i;
+	int64_t resident = 0;
+
+	if (fstat(fd, &st) != 0) {
+		return -1;
+	}
+	end = offset + len;
+	if (end > st.st_size) {
+		end = st.st_size;
+	}
+	start = offset & ~(pc_page_size - 1);
+	if (pages) {
+		*pages = start < end ? (end - start + pc_page_size - 1) / pc_page_size : 0;
+	}
+
+	vec = malloc(PAGECACHE_WINDOW / pc_page_size);
+	for (; start < end; start += PAGECACHE_WINDOW) {
+		win = end - start < PAGECACHE_WINDOW ? end - start : PAGECACHE_WINDOW;
+		if ( (addr = mmap(NULL, win, PROT_READ, MAP_SHARED, fd, start)) == MAP_FAILED) {
+			free(vec);
+			return -1;
+		}
+		if (mincore(addr, win, vec) == 0) {
+			for (i = 0; i < (win + pc_page_size - 1) / pc_page_size; i++) {
+				resident += vec[i] & 1;
+			}
+		}
+		munmap(addr, win);
+	}
+	free(vec);
+	return resident;
+}
+
+/** Measures residency of all files.
+ *
+ * @arg pages total number of pages of all files
+ * @return number of resident pages of all files
+ */
+
+static int64_t pagecache_measure(int64_t * pages) {
+	int i;
+	item_t * cur;
+	pc_file_t * pc_file;
+	int64_t resident = 0;
+	int64_t file_pages, file_resident;
+	int fd;
+
+	*pages = 0;
+	for (i = 0; i < pc_files.entries; i++) {
+		for (cur = pc_files.entry[i].head; cur != NULL; cur = cur->next) {
+			pc_file = hash_table_entry(cur, pc_file_t, item);
+			if ( (fd = open(pc_file->name, O_RDONLY)) == -1) {
+				continue; //not created yet
+			}
+			if ( (file_resident = pagecache_resident(fd, 0, INT64_MAX / 2, &file_pages)) >= 0) {
+				resident += file_resident;
+				*pages += file_pages;
+			}
+			close(fd);
+		}
+	}
+	return resident;
+}
+
+/** Evicts pages of the file @a fd from the page cache. Dirty pages are written first, as they
+ * can't be dropped otherwise.
+ */
+
+static void pagecache_evict(int fd, const char * name) {
+	fdatasync(fd);
+	if ( (errno = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED)) != 0) {
+		ERRORPRINTF("%s: Can not evict from the page cache: %s\n", name, strerror(errno));
+	}
+}
+
+/** Reads pages of the file @a fd, so @a fraction of them is cached. Pages are spread evenly over the file
+ * and readahead is turned off, so no other pages are read. The file should be evicted first.
+ */
+
+static void pagecache_warm(int fd, const char * name, double fraction, char * buffer) {
+	struct stat st;
+	int64_t pages, page, run_start, run_len;
+
+	if (fstat(fd, &st) != 0) {
+		return;
+	}
+	pages = (st.st_size + pc_page_size - 1) / pc_page_size;
+	posix_fadvise(fd, 0, 0, POSIX_FADV_RANDOM);
+
+	run_len = 0;
+	run_start = 0;
+	for (page = 0; page <= pages; page++) {
+		//page is selected if the number of selected pages grows on it
+		if (page < pages && (int64_t)((page + 1) * fraction) > (int64_t)(page * fraction)) {
+			if (run_len == 0) {
+				run_start = page;
+			}
+			run_len++;
+			if (run_len * pc_page_size < PAGECACHE_WINDOW / 256) {
+				continue;
+			}
+		}
+		if (run_len > 0 && pread(fd, buffer, run_len * pc_page_size, run_start * pc_page_size) == -1) {
+			ERRORPRINTF("%s: Can not read: %s\n", name, strerror(errno));
+			break;
+		}
+		run_len = 0;
+	}
+	posix_fadvise(fd, 0, 0, POSIX_FADV_NORMAL);
+}
+
+/** Applies the page cache control to all files and measures their state before and after that.
+ *
+ * @arg mode CACHE_EVICT, CACHE_WARM or CACHE_LEAVE
+ * @arg fraction fraction of pages to cache in CACHE_WARM mode, 0 to 1
+ */
+
+void pagecache_control(int mode, double fraction) {
+	int i;
+	item_t * cur;
+	pc_file_t * pc_file;
+	int fd;
+	char * buffer = malloc(PAGECACHE_WINDOW / 256);
+
+	pc_resident_before = pagecache_measure(&pc_pages_before);
+
+	if (mode == CACHE_EVICT) {
+		pc_mode_str = CACHE_EVICT_STR;
+	} else if (mode == CACHE_WARM) {
+		pc_mode_str = CACHE_WARM_STR;
+	}
+
+	if (mode != CACHE_LEAVE) {
+		for (i = 0; i < pc_files.entries; i++) {
+			for (cur = pc_files.entry[i].head; cur != NULL; cur = cur->next) {
+				pc_file = hash_table_entry(cur, pc_file_t, item);
+				if ( (fd = open(pc_file->name, O_RDONLY)) == -1) {
+					continue;
+				}
+				pagecache_evict(fd, pc_file->name);
+				if (mode == CACHE_WARM && fraction > 0) {
+					pagecache_warm(fd, pc_file->name, fraction, buffer);
+				}
+				close(fd);
+			}
+		}
+	}
+	free(buffer);
+
+	pc_resident_start = pagecache_measure(&pc_pages_start);
+}
+
+/** Called for every replayed read. Every PAGECACHE_SAMPLE_EVERY-th read is sampled: residency of its
+ * pages is checked before the read is done.
+ *
+ * @arg name name of the file being read
+ * @arg offset offset of the read
+ * @arg size size of the read
+ */
+
+void pagecache_sample(const char * name, int64_t offset, int64_t size) {
+	item_t * item;
+	pc_file_t * pc_file;
+	int64_t pages, resident;
+
+	if ( ! pc_initialized || (pc_reads++ % PAGECACHE_SAMPLE_EVERY) != 0) {
+		return;
+	}
+
+	if ( (item = hash_table_find(&pc_files, (key_t *) name)) == NULL) {
+		pagecache_add_file(name);
+		item = hash_table_find(&pc_files, (key_t *) name);
+	}
+	pc_file = hash_table_entry(item, pc_file_t, item);
+	if (pc_file->fd == -1 && (pc_file->fd = open(pc_file->name, O_RDONLY)) == -1) {
+		return;
+	}
+
+	if ( (resident = pagecache_resident(pc_file->fd, offset, size, &pages)) >= 0) {
+		pc_sampled_reads++;
+		pc_sampled_pages += pages;
+		pc_sampled_hits += resident;
+	}
+}
+
+/** Prints state of the page cache before and after the control stage and at the end, together
+ * with the estimated hit ratio.
+ */
+
+void pagecache_report() {
+	int64_t pages_end;
+	int64_t resident_end = pagecache_measure(&pages_end);
+
+	fprintf(stdout, "Page cache (%s): %"PRIi64" files, %.1lf%% of %"PRIi64" pages cached before control\n",
+			pc_mode_str, pc_file_count, pc_pages_before ? 100.0 * pc_resident_before / pc_pages_before : 0.0,
+			pc_pages_before);
+	fprintf(stdout, "Page cache: %.1lf%% of %"PRIi64" pages cached at start, %.1lf%% of %"PRIi64" at the end\n",
+			pc_pages_start ? 100.0 * pc_resident_start / pc_pages_start : 0.0, pc_pages_start,
+			pages_end ? 100.0 * resident_end / pages_end : 0.0, pages_end);
+	fprintf(stdout, "Page cache: estimated hit ratio %.1lf%% (%"PRIi64" of %"PRIi64" reads sampled, %"PRIi64" pages)\n",
+			pc_sampled_pages ? 100.0 * pc_sampled_hits / pc_sampled_pages : 0.0, pc_sampled_reads, pc_reads, 
+			pc_sampled_pages);
+}
+
+/** Frees all resources used by the module.
+ */
+
+void pagecache_finish() {
+	if (pc_initialized) {
+		hash_table_destroy(&pc_files);
+		pc_initialized = 0;
+	}
+}
@@ -0,0 +1,55 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _PAGECACHE_H_
+#define _PAGECACHE_H_
+
+/** @file pagecache.h
+ *
+ * Controls and measures page cache state of files accessed by the replayed application.
+ *
+ * Before replay, every file from the trace can be evicted from the page cache, pre-warmed so a given fraction
+ * of its pages is cached, or left alone. Residency of the pages is measured by mincore(2) before and after
+ * this control stage and after the replay. During the replay, reads are sampled and residency of their pages 
+ * is checked before they are replayed, which gives an estimate of the page cache hit ratio.
+ *
+ * It uses hash_table, where the key is a filename and data are pc_file_t structs.
+ */
+
+#include <stdint.h>
+#include "adt/hash_table.h"
+#include "common.h"
+
+#define PAGECACHE_SAMPLE_EVERY 16 ///< sample every n-th read during replay
+#define PAGECACHE_WINDOW (256*1024*1024) ///< files are mapped by windows of this size when measuring residency
+
+typedef struct pc_file {
+	item_t item;
+	char name[MAX_STRING];
+	int fd; ///< fd used for sampling during replay, -1 if not opened yet
+} pc_file_t;
+
+int pagecache_init();
+void pagecache_add_file(const char * name);
+void pagecache_control(int mode, double fraction);
+void pagecache_sample(const char * name, int64_t offset, int64_t size);
+void pagecache_report();
+void pagecache_finish();
+
+#endif
@@ -0,0 +1,433 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "common.h"
+#include "simulate.h"
+#include "pattern.h"
+
+static const char * pattern_names[PATTERN_CLASSES] = { "single", "sequential", "strided", "random", "mixed" };
+
+int pattern_top = -1; ///< number of the heaviest files and processes to print, 0 = all, -1 = not enabled
+pattern_file_t * pattern_files = NULL;
+int64_t pattern_nfiles = 0;
+int64_t pattern_files_size = 0;
+hash_table_t pattern_pids;
+int64_t pattern_pids_count = 0;
+int64_t pattern_sizes[PATTERN_BUCKETS]; ///< request sizes of the whole trace
+
+/** Page accesses of the file being analyzed, sorted to find reuses. */
+typedef struct pattern_page {
+	int64_t page;
+	int64_t index; ///< order of the access within the file
+} pattern_page_t;
+
+pattern_page_t * pattern_pages = NULL;
+int64_t pattern_pages_size = 0;
+
+static int ht_compare_pattern_pid(key_t *key, item_t *item) {
+	return hash_table_entry(item, pattern_pid_t, item)->pid == *key;
+}
+
+static void ht_remove_callback_pattern_pid(item_t * item) {
+	free(hash_table_entry(item, pattern_pid_t, item));
+}
+
+static hash_table_operations_t ht_ops_pattern_pid = {
+	.hash = ht_hash_int,
+	.compare = ht_compare_pattern_pid,
+	.remove_callback = ht_remove_callback_pattern_pid
+};
+
+/** Enables the classifier.
+ *
+ * @arg top number of the heaviest files and processes to print, 0 for all
+ * @return 0 on success, -1 on error
+ */
+
+int pattern_init(int top) {
+	if (top < 0) {
+		ERRORPRINTF("Number of files to print has to be positive or 0 for all: %d\n", top);
+		return -1;
+	}
+	pattern_top = top;
+	memset(pattern_sizes, 0, sizeof(pattern_sizes));
+	hash_table_init(&pattern_pids, PATTERN_HT_SIZE, &ht_ops_pattern_pid);
+	return 0;
+}
+
+int pattern_enabled() {
+	return pattern_top >= 0;
+}
+
+static inline int pattern_bucket(int64_t v) {
+	int b = 0;
+
+	for (; v && b < PATTERN_BUCKETS - 1; v >>= 1) {
+		b++;
+	}
+	return b;
+}
+
+/** @return lower bound of the bucket holding the median of histogram @a hist with @a n values */
+
+static int64_t pattern_median(int64_t * hist, int64_t n) {
+	int64_t sum = 0;
+	int b;
+
+	for (b = 0; b < PATTERN_BUCKETS; b++) {
+		sum += hist[b];
+		if (2 * sum >= n) {
+			break;
+		}
+	}
+	return b ? (int64_t) 1 << (b - 1) : 0;
+}
+
+static int pattern_class(pattern_stats_t * s) {
+	int64_t n = s->seq + s->strided + s->random;
+
+	if (n == 0) {
+		return PATTERN_SINGLE;
+	}
+	if (s->seq >= PATTERN_DOMINANT * n) {
+		return PATTERN_SEQ;
+	}
+	if (s->strided >= PATTERN_DOMINANT * n) {
+		return PATTERN_STRIDED;
+	}
+	if (s->random >= PATTERN_DOMINANT * n) {
+		return PATTERN_RANDOM;
+	}
+	return PATTERN_MIXED;
+}
+
+static pattern_pid_t * pattern_get_pid(int32_t pid) {
+	item_t * item;
+	pattern_pid_t * p;
+	key_t key = pid;
+
+	if ( (item = hash_table_find(&pattern_pids, &key)) != NULL) {
+		return hash_table_entry(item, pattern_pid_t, item);
+	}
+	p = calloc(1, sizeof(pattern_pid_t));
+	item_init(&p->item);
+	p->pid = pid;
+	hash_table_insert(&pattern_pids, &p->pid, &p->item);
+	pattern_pids_count++;
+	return p;
+}
+
+static int pattern_compare_page(const void * a, const void * b) {
+	const pattern_page_t * pa = a, * pb = b;
+
+	if (pa->page != pb->page) {
+		return pa->page < pb->page ? -1 : 1;
+	}
+	return pa->index < pb->index ? -1 : pa->index > pb->index;
+}
+
+static int pattern_compare_int64(const void * a, const void * b) {
+	int64_t va = *(const int64_t *) a, vb = *(const int64_t *) b;
+
+	return va < vb ? -1 : va > vb;
+}
+
+/** Notes page accesses of one call for the reuse analysis. */
+
+static void pattern_note_pages(pattern_file_t * file, int64_t offset, int64_t size) {
+	int64_t page, last = (offset + size - 1) / PATTERN_PAGE;
+
+	for (page = offset / PATTERN_PAGE; page <= last && file->pages < PATTERN_MAX_PAGES; page++) {
+		if (file->pages == pattern_pages_size) {
+			pattern_pages_size = pattern_pages_size ? 2 * pattern_pages_size : 4096;
+			if ( (pattern_pages = realloc(pattern_pages, pattern_pages_size * sizeof(pattern_page_t))) == NULL) {
+				ERRORPRINTF("Not enough memory for %"PRIi64" page accesses\n", pattern_pages_size);
+				exit(1);
+			}
+		}
+		pattern_pages[file->pages].page = page;
+		pattern_pages[file->pages].index = file->pages;
+		file->pages++;
+	}
+}
+
+/** Finds reuses among the page accesses noted by pattern_note_pages() and their median distance. */
+
+static void pattern_reuse(pattern_file_t * file) {
+	int64_t * dist = (int64_t *) pattern_pages; //distances overwrite the already processed accesses
+	int64_t i;
+
+	file->reuses = 0;
+	file->med_reuse = -1;
+	if (file->pages < 2) {
+		return;
+	}
+	qsort(pattern_pages, file->pages, sizeof(pattern_page_t), pattern_compare_page);
+	for (i = 1; i < file->pages; i++) {
+		if (pattern_pages[i].page == pattern_pages[i-1].page) {
+			dist[file->reuses++] = pattern_pages[i].index - pattern_pages[i-1].index - 1;
+		}
+	}
+	if (file->reuses) {
+		qsort(dist, file->reuses, sizeof(int64_t), pattern_compare_int64);
+		file->med_reuse = dist[file->reuses / 2];
+	}
+}
+
+static inline int pattern_before(rw_op_t * a, rw_op_t * b) {
+	return a->start.tv_sec < b->start.tv_sec || (a->start.tv_sec == b->start.tv_sec && a->start.tv_usec <= b->start.tv_usec);
+}
+
+/** Classifies reads and writes of one file, merged in the order of their start.
+ *
+ * @arg name name of the file
+ * @arg reads list of reads, may be NULL
+ * @arg writes list of writes, may be NULL
+ */
+
+static void pattern_analyze(const char * name, list_t * reads, list_t * writes) {
+	item_t * r = reads ? reads->head : NULL;
+	item_t * w = writes ? writes->head : NULL;
+	int64_t sizes[PATTERN_BUCKETS];
+	int64_t prev_offset = 0, prev_end = 0, prev_delta = 0, run = 0, delta;
+	pattern_file_t * file;
+	pattern_pid_t * p;
+	rw_op_t * op;
+	int write, b;
+
+	if (pattern_nfiles == pattern_files_size) {
+		pattern_files_size = pattern_files_size ? 2 * pattern_files_size : 1024;
+		if ( (pattern_files = realloc(pattern_files, pattern_files_size * sizeof(pattern_file_t))) == NULL) {
+			ERRORPRINTF("Not enough memory for %"PRIi64" files\n", pattern_files_size);
+			exit(1);
+		}
+	}
+	file = &pattern_files[pattern_nfiles];
+	memset(file, 0, sizeof(pattern_file_t));
+	memset(sizes, 0, sizeof(sizes));
+	file->name = name;
+
+	while (r || w) {
+		if (r && ( ! w || pattern_before(list_entry(r, rw_op_t, item), list_entry(w, rw_op_t, item)))) {
+			op = list_entry(r, rw_op_t, item);
+			r = r->next;
+			write = 0;
+		} else {
+			op = list_entry(w, rw_op_t, item);
+			w = w->next;
+			write = 1;
+		}
+		if ((int64_t) op->size <= 0) {
+			continue;
+		}
+
+		p = pattern_get_pid(op->pid);
+		p->stats.calls++;
+		p->stats.bytes += op->size;
+		file->stats.bytes += op->size;
+		if ( ! write) {
+			p->stats.read_bytes += op->size;
+			file->stats.read_bytes += op->size;
+		}
+		b = pattern_bucket(op->size);
+		sizes[b]++;
+		p->sizes[b]++;
+		pattern_sizes[b]++;
+		pattern_note_pages(file, op->offset, op->size);
+
+		delta = op->offset - prev_offset;
+		if (file->stats.calls++ == 0) {
+			run = op->size; //the first call only starts a run
+			file->runs = 1;
+		} else if (op->offset == prev_end) {
+			file->stats.seq++;
+			p->stats.seq++;
+			run += op->size;
+		} else {
+			if (delta != 0 && delta == prev_delta) {
+				file->stats.strided++;
+				p->stats.strided++;
+			} else {
+				file->stats.random++;
+				p->stats.random++;
+			}
+			if (run > file->max_run) {
+				file->max_run = run;
+			}
+			run = op->size;
+			file->runs++;
+		}
+		prev_delta = delta;
+		prev_offset = op->offset;
+		prev_end = op->offset + op->size;
+	}
+	if (file->stats.calls == 0) {
+		return;
+	}
+	if (run > file->max_run) {
+		file->max_run = run;
+	}
+	file->med_size = pattern_median(sizes, file->stats.calls);
+	file->class = pattern_class(&file->stats);
+	pattern_reuse(file);
+	pattern_nfiles++;
+}
+
+static hash_table_t * pattern_writes; ///< write table looked up while the read one is walked
+
+static void pattern_analyze_read(item_t * item) {
+	sim_item_t * sim_item = hash_table_entry(item, sim_item_t, item);
+	item_t * w = hash_table_find(pattern_writes, (key_t *) sim_item->name);
+
+	pattern_analyze(sim_item->name, &sim_item->list, w ? &hash_table_entry(w, sim_item_t, item)->list : NULL);
+}
+
+static hash_table_t * pattern_reads;
+
+static void pattern_analyze_write(item_t * item) {
+	sim_item_t * sim_item = hash_table_entry(item, sim_item_t, item);
+
+	if (hash_table_find(pattern_reads, (key_t *) sim_item->name) == NULL) { //otherwise already done
+		pattern_analyze(sim_item->name, NULL, &sim_item->list);
+	}
+}
+
+/** Orders files by bytes transferred, the heaviest first. */
+
+static int pattern_compare_file(const void * a, const void * b) {
+	int64_t ba = ((const pattern_file_t *) a)->stats.bytes, bb = ((const pattern_file_t *) b)->stats.bytes;
+
+	return ba > bb ? -1 : ba < bb;
+}
+
+static int pattern_compare_pid(const void * a, const void * b) {
+	int64_t ba = (*(pattern_pid_t * const *) a)->stats.bytes, bb = (*(pattern_pid_t * const *) b)->stats.bytes;
+
+	return ba > bb ? -1 : ba < bb;
+}
+
+/** Prints calls of @a s as percentages of the classified ones. */
+
+static void pattern_print_stats(pattern_stats_t * s) {
+	int64_t n = s->seq + s->strided + s->random;
+
+	printf("%10.1lf %10"PRIi64" %6.1lf%%", s->bytes / 1048576.0, s->calls, s->bytes ? 100.0 * s->read_bytes / s->bytes : 0.0);
+	if (n) {
+		printf(" %6.1lf%% %6.1lf%% %6.1lf%%", 100.0 * s->seq / n, 100.0 * s->strided / n, 100.0 * s->random / n);
+	} else {
+		printf(" %7s %7s %7s", "-", "-", "-");
+	}
+	printf(" %-10s", pattern_names[pattern_class(s)]);
+}
+
+static pattern_pid_t ** pattern_pid_list;
+static int64_t pattern_npids;
+
+static void pattern_collect_pid(item_t * item) {
+	pattern_pid_list[pattern_npids++] = hash_table_entry(item, pattern_pid_t, item);
+}
+
+/** Classifies all files noted during simulation and prints the heaviest files and processes. Has to be called
+ * before simulate_finish().
+ */
+
+void pattern_report() {
+	int64_t files[PATTERN_CLASSES], bytes[PATTERN_CLASSES];
+	int64_t i, n, total = 0;
+	pattern_file_t * f;
+	pattern_pid_t * p;
+	int c, b;
+
+	pattern_reads = simulate_get_map_read();
+	pattern_writes = simulate_get_map_write();
+	hash_table_apply(pattern_reads, pattern_analyze_read);
+	hash_table_apply(pattern_writes, pattern_analyze_write);
+	free(pattern_pages);
+	pattern_pages = NULL;
+	pattern_pages_size = 0;
+	qsort(pattern_files, pattern_nfiles, sizeof(pattern_file_t), pattern_compare_file);
+
+	memset(files, 0, sizeof(files));
+	memset(bytes, 0, sizeof(bytes));
+	for (i = 0; i < pattern_nfiles; i++) {
+		files[pattern_files[i].class]++;
+		bytes[pattern_files[i].class] += pattern_files[i].stats.bytes;
+		total += pattern_files[i].stats.bytes;
+	}
+	printf("Access patterns of %"PRIi64" files, %.1lf MB transferred:\n", pattern_nfiles, total / 1048576.0);
+	printf("%-10s %10s %10s %7s\n", "pattern", "files", "MB", "bytes");
+	for (c = 0; c < PATTERN_CLASSES; c++) {
+		printf("%-10s %10"PRIi64" %10.1lf %6.1lf%%\n", pattern_names[c], files[c], bytes[c] / 1048576.0, total ? 100.0 * bytes[c] / total : 0.0);
+	}
+
+	printf("Request sizes:\n");
+	for (b = 0; b < PATTERN_BUCKETS; b++) {
+		if (pattern_sizes[b]) {
+			printf("%14"PRIi64" - %14"PRIi64" B %12"PRIi64"\n", b ? (int64_t) 1 << (b - 1) : 0, b ? ((int64_t) 1 << b) - 1 : 0, pattern_sizes[b]);
+		}
+	}
+
+	n = pattern_top && pattern_top < pattern_nfiles ? pattern_top : pattern_nfiles;
+	printf("Heaviest %"PRIi64" files:\n", n);
+	printf("%10s %10s %7s %7s %7s %7s %-10s %10s %10s %9s %7s %10s  %s\n", "MB", "calls", "read", "seq", "strided",
+			"random", "pattern", "avg run", "max run", "med size", "reuse", "med reuse", "file");
+	for (i = 0; i < n; i++) {
+		f = &pattern_files[i];
+		pattern_print_stats(&f->stats);
+		printf(" %10"PRIi64" %10"PRIi64" %9"PRIi64" %6.1lf%%", f->stats.bytes / f->runs, f->max_run, f->med_size,
+				f->pages ? 100.0 * f->reuses / f->pages : 0.0);
+		if (f->med_reuse >= 0) {
+			printf(" %10"PRIi64, f->med_reuse);
+		} else {
+			printf(" %10s", "-");
+		}
+		printf("  %s\n", f->name);
+	}
+
+	pattern_pid_list = malloc((pattern_pids_count + 1) * sizeof(pattern_pid_t *));
+	pattern_npids = 0;
+	hash_table_apply(&pattern_pids, pattern_collect_pid);
+	qsort(pattern_pid_list, pattern_npids, sizeof(pattern_pid_t *), pattern_compare_pid);
+	n = pattern_top && pattern_top < pattern_npids ? pattern_top : pattern_npids;
+	printf("Heaviest %"PRIi64" processes:\n", n);
+	printf("%10s %10s %7s %7s %7s %7s %-10s %9s  %s\n", "MB", "calls", "read", "seq", "strided", "random", "pattern",
+			"med size", "process");
+	for (i = 0; i < n; i++) {
+		p = pattern_pid_list[i];
+		pattern_print_stats(&p->stats);
+		printf(" %9"PRIi64"  pid %d\n", pattern_median(p->sizes, p->stats.calls), p->pid);
+	}
+	free(pattern_pid_list);
+}
+
+void pattern_finish() {
+	if ( ! pattern_enabled()) {
+		return;
+	}
+	hash_table_destroy(&pattern_pids);
+	free(pattern_files);
+	pattern_files = NULL;
+	pattern_nfiles = pattern_files_size = pattern_pids_count = 0;
+	pattern_top = -1;
+}
@@ -0,0 +1,89 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _PATTERN_H_
+#define _PATTERN_H_
+
+/** @file pattern.h
+ *
+ * Access pattern classifier. After simulation (-M), reads and writes of every file noted in the simulation hash
+ * tables (see simulate_get_map_read()) are merged in the order of their start and every call is classified:
+ * sequential (starts where the previous call on the file ended), strided (jumps by the same distance as the
+ * previous call did) or random. A file or process is sequential, strided or random when at least
+ * PATTERN_DOMINANT of its calls are so, otherwise it is mixed.
+ *
+ * For every file, run lengths of sequential calls, request sizes, read/write ratio and reuse of 4KB pages are
+ * reported too. Reuse distance is the number of page accesses of the file between two accesses of the same page.
+ *
+ * Only a small summary is kept for every file, so the report scales to traces with millions of files.
+ */
+
+#include <stdint.h>
+#include "common.h"
+#include "adt/hash_table.h"
+
+#define PATTERN_PAGE 4096
+#define PATTERN_BUCKETS 48 ///< bucket b holds sizes with b bits
+#define PATTERN_DOMINANT 0.75
+#define PATTERN_MAX_PAGES (1 << 24) ///< page accesses of one file used for its reuse, the rest is ignored
+#define PATTERN_HT_SIZE 1024
+
+#define PATTERN_SINGLE 0
+#define PATTERN_SEQ 1
+#define PATTERN_STRIDED 2
+#define PATTERN_RANDOM 3
+#define PATTERN_MIXED 4
+#define PATTERN_CLASSES 5
+
+/** Counters shared by files and processes. */
+typedef struct pattern_stats {
+	int64_t calls; ///< reads and writes transferring at least one byte
+	int64_t bytes;
+	int64_t read_bytes;
+	int64_t seq;
+	int64_t strided;
+	int64_t random;
+} pattern_stats_t;
+
+/** Summary of one file. */
+typedef struct pattern_file {
+	const char * name; ///< points to the simulation hash tables
+	pattern_stats_t stats;
+	int64_t runs; ///< number of sequential runs
+	int64_t max_run; ///< bytes of the longest run
+	int64_t med_size; ///< median request size, rounded down to a power of two
+	int64_t pages; ///< page accesses
+	int64_t reuses; ///< page accesses of pages accessed before
+	int64_t med_reuse; ///< median reuse distance, -1 if no page was reused
+	int class;
+} pattern_file_t;
+
+typedef struct pattern_pid {
+	item_t item;
+	key_t pid;
+	pattern_stats_t stats;
+	int64_t sizes[PATTERN_BUCKETS];
+} pattern_pid_t;
+
+int pattern_init(int top);
+int pattern_enabled();
+void pattern_report();
+void pattern_finish();
+
+#endif
@@ -0,0 +1,229 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <sys/mman.h>
+
+#include "common.h"
+#include "payload.h"
+
+#define PAYLOAD_MODE_ZERO 0
+#define PAYLOAD_MODE_RANDOM 1
+#define PAYLOAD_MODE_COMPRESS 2
+#define PAYLOAD_MODE_DEDUP 3
+#define PAYLOAD_MODE_PATTERN 4
+
+int payload_mode = PAYLOAD_MODE_ZERO;
+char payload_spec[MAX_STRING] = PAYLOAD_ZERO_STR;
+char * payload_buffer = NULL; ///< precomputed data, PAYLOAD_SIZE bytes
+unsigned char * payload_unique = NULL; ///< for every block of payload_buffer, whether it should be stamped
+int64_t payload_pos = 0; ///< offset of the next window
+uint64_t payload_seq = 0; ///< sequence number stamped into unique blocks
+int64_t payload_bytes = 0; ///< bytes handed out
+int64_t payload_large = 0; ///< writes larger than the payload buffer
+char * payload_large_buffer = NULL;
+int64_t payload_large_size = 0;
+
+/** Simple and fast pseudo random number generator, good enough to make data incompressible. */
+static inline uint64_t payload_xorshift(uint64_t * state) {
+	uint64_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	*state = x;
+	return x;
+}
+
+static void payload_fill_random(char * data, int64_t len, uint64_t * state) {
+	uint64_t r;
+	int64_t i;
+
+	for (i = 0; i + 8 <= len; i += 8) {
+		r = payload_xorshift(state);
+		memcpy(data + i, &r, 8);
+	}
+	for (; i < len; i++) {
+		data[i] = payload_xorshift(state);
+	}
+}
+
+/** Parses @a spec and precomputes the payload buffer.
+ *
+ * @arg spec payload mode, see payload.h
+ * @return 0 on success, non-zero if @a spec is not valid or memory can't be allocated
+ */
+
+int payload_init(const char * spec) {
+	uint64_t state = 0x9E3779B97F4A7C15ULL;
+	double ratio = 1.0;
+	const char * arg = strchr(spec, ':');
+	int64_t blocks = PAYLOAD_SIZE / PAYLOAD_BLOCK;
+	int64_t i, len, random_len;
+	char * block;
+
+	strncpy(payload_spec, spec, MAX_STRING);
+	payload_spec[MAX_STRING-1] = 0;
+	arg = arg ? arg + 1 : NULL;
+
+	if ( ! strcmp(spec, PAYLOAD_ZERO_STR)) {
+		payload_mode = PAYLOAD_MODE_ZERO;
+		return 0;
+	} else if ( ! strcmp(spec, PAYLOAD_RANDOM_STR)) {
+		payload_mode = PAYLOAD_MODE_RANDOM;
+	} else if ( ! strncmp(spec, PAYLOAD_COMPRESS_STR ":", strlen(PAYLOAD_COMPRESS_STR) + 1)) {
+		payload_mode = PAYLOAD_MODE_COMPRESS;
+		ratio = atof(arg);
+	} else if ( ! strncmp(spec, PAYLOAD_DEDUP_STR ":", strlen(PAYLOAD_DEDUP_STR) + 1)) {
+		payload_mode = PAYLOAD_MODE_DEDUP;
+		ratio = atof(arg);
+	} else if ( ! strncmp(spec, PAYLOAD_PATTERN_STR ":", strlen(PAYLOAD_PATTERN_STR) + 1) && strlen(arg) > 0) {
+		payload_mode = PAYLOAD_MODE_PATTERN;
+	} else {
+		ERRORPRINTF("Unknown payload mode: %s\n", spec);
+		return -1;
+	}
+
+	if (ratio < 1.0) {
+		ERRORPRINTF("Payload ratio has to be at least 1: %s\n", spec);
+		return -1;
+	}
+
+	payload_buffer = mmap(NULL, PAYLOAD_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (payload_buffer == MAP_FAILED) {
+		ERRORPRINTF("Can not allocate payload buffer%s", "\n");
+		payload_buffer = NULL;
+		return -1;
+	}
+	payload_unique = calloc(blocks, 1);
+
+	switch (payload_mode) {
+		case PAYLOAD_MODE_RANDOM:
+			payload_fill_random(payload_buffer, PAYLOAD_SIZE, &state);
+			memset(payload_unique, 1, blocks);
+			break;
+		case PAYLOAD_MODE_COMPRESS: //random start of each block, zeros in the rest
+			random_len = PAYLOAD_BLOCK / ratio;
+			for (i = 0; i < blocks; i++) {
+				payload_fill_random(payload_buffer + i * PAYLOAD_BLOCK, random_len, &state);
+				payload_unique[i] = random_len >= sizeof(uint64_t);
+			}
+			break;
+		case PAYLOAD_MODE_DEDUP: //the same block everywhere, except every ratio-th one
+			block = malloc(PAYLOAD_BLOCK);
+			payload_fill_random(block, PAYLOAD_BLOCK, &state);
+			for (i = 0; i < blocks; i++) {
+				if ( (int64_t)((i + 1) / ratio) > (int64_t)(i / ratio) ) {
+					payload_fill_random(payload_buffer + i * PAYLOAD_BLOCK, PAYLOAD_BLOCK, &state);
+					payload_unique[i] = 1;
+				} else {
+					memcpy(payload_buffer + i * PAYLOAD_BLOCK, block, PAYLOAD_BLOCK);
+				}
+			}
+			free(block);
+			break;
+		case PAYLOAD_MODE_PATTERN:
+			len = strlen(arg);
+			for (i = 0; i < PAYLOAD_SIZE; i++) {
+				payload_buffer[i] = arg[i % len];
+			}
+			break;
+	}
+	return 0;
+}
+
+/** Returns non-zero if writes should use payload_get() instead of plain zeroed buffers.
+ */
+
+int payload_enabled() {
+	return payload_mode != PAYLOAD_MODE_ZERO;
+}
+
+/** Returns data for a write of @a size bytes. The pointer is aligned to PAYLOAD_BLOCK and it is valid until the
+ * next call.
+ *
+ * @arg size size of the write
+ * @return pointer to the data
+ */
+
+char * payload_get(int64_t size) {
+	char * data;
+	int64_t first, blocks, i, off;
+
+	payload_bytes += size;
+
+	if (size > PAYLOAD_SIZE) { //rare, the data are copied here
+		payload_large++;
+		if (size > payload_large_size) {
+			free(payload_large_buffer);
+			if (posix_memalign((void **) &payload_large_buffer, PAYLOAD_BLOCK, size) != 0) {
+				payload_large_buffer = NULL;
+				payload_large_size = 0;
+				return NULL;
+			}
+			payload_large_size = size;
+		}
+		for (off = 0; off < size; off += PAYLOAD_SIZE) {
+			memcpy(payload_large_buffer + off, payload_buffer, size - off < PAYLOAD_SIZE ? size - off : PAYLOAD_SIZE);
+		}
+		return payload_large_buffer;
+	}
+
+	if (payload_pos + size > PAYLOAD_SIZE) {
+		payload_pos = 0;
+	}
+	data = payload_buffer + payload_pos;
+	first = payload_pos / PAYLOAD_BLOCK;
+	blocks = (size + PAYLOAD_BLOCK - 1) / PAYLOAD_BLOCK;
+	payload_pos += blocks * PAYLOAD_BLOCK;
+
+	for (i = first; i < first + blocks; i++) {
+		if (payload_unique[i]) {
+			payload_seq++;
+			memcpy(payload_buffer + i * PAYLOAD_BLOCK, &payload_seq, sizeof(payload_seq));
+		}
+	}
+
+	return data;
+}
+
+/** Prints statistics of generated payload to stdout.
+ */
+
+void payload_report() {
+	fprintf(stdout, "Payload (%s): %"PRIi64" bytes written, %"PRIu64" unique blocks stamped, %"PRIi64" writes larger than %d bytes\n",
+			payload_spec, payload_bytes, payload_seq, payload_large, PAYLOAD_SIZE);
+}
+
+/** Frees the payload buffers.
+ */
+
+void payload_finish() {
+	if (payload_buffer) {
+		munmap(payload_buffer, PAYLOAD_SIZE);
+		payload_buffer = NULL;
+	}
+	free(payload_unique);
+	payload_unique = NULL;
+	free(payload_large_buffer);
+	payload_large_buffer = NULL;
+	payload_large_size = 0;
+}
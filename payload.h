@@ -0,0 +1,55 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _PAYLOAD_H_
+#define _PAYLOAD_H_
+
+/** @file payload.h
+ *
+ * Generates content of replayed writes, so compressing and deduplicating storage behaves as with real data.
+ *
+ * All the data are precomputed into one buffer at the start. Writes take consecutive windows of this buffer,
+ * the only work done per write is stamping a sequence number into blocks that should be unique.
+ *
+ * Supported modes:
+ *  - zero              - zeros (the default, no payload buffer is used)
+ *  - random            - incompressible and unique data
+ *  - compress:<ratio>  - every block compresses approximately <ratio> times (e.g. 2.5)
+ *  - dedup:<ratio>     - only every <ratio>-th block is unique, the others are the same
+ *  - pattern:<string>  - <string> repeated over and over
+ */
+
+#include <stdint.h>
+
+#define PAYLOAD_ZERO_STR "zero"
+#define PAYLOAD_RANDOM_STR "random"
+#define PAYLOAD_COMPRESS_STR "compress"
+#define PAYLOAD_DEDUP_STR "dedup"
+#define PAYLOAD_PATTERN_STR "pattern"
+
+#define PAYLOAD_BLOCK 4096 ///< granularity of unique blocks, same as BUFPOOL_ALIGN
+#define PAYLOAD_SIZE (32*1024*1024) ///< size of the precomputed buffer
+
+int payload_init(const char * spec);
+int payload_enabled();
+char * payload_get(int64_t size);
+void payload_report();
+void payload_finish();
+
+#endif
@@ -0,0 +1,323 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+
+#include "common.h"
+#include "placement.h"
+
+#ifndef MPOL_PREFERRED
+#define MPOL_PREFERRED 1
+#endif
+
+int placement_node_of[PLACEMENT_MAX_CPUS]; ///< node of every processor, -1 if offline
+int placement_nodes = 0; ///< number of nodes (highest node number + 1)
+int placement_order[PLACEMENT_MAX_CPUS]; ///< processors in the order they are given to workers
+int placement_count = 0; ///< length of placement_order, 0 = placement not used
+char placement_policy[MAX_STRING];
+
+/** Parses list of processors in the cpulist format (e.g. 0-3,8,10-11) into @a set.
+ *
+ * @return 0 on success, -1 on error
+ */
+
+static int placement_parse_list(const char * str, char * set) {
+	char * end;
+	long from, to;
+
+	memset(set, 0, PLACEMENT_MAX_CPUS);
+	while (*str && *str != '\n') {
+		from = strtol(str, &end, 10);
+		if (end == str || from < 0) {
+			return -1;
+		}
+		to = from;
+		if (*end == '-') {
+			str = end + 1;
+			to = strtol(str, &end, 10);
+			if (end == str || to < from) {
+				return -1;
+			}
+		}
+		if (to >= PLACEMENT_MAX_CPUS) {
+			return -1;
+		}
+		for (; from <= to; from++) {
+			set[from] = 1;
+		}
+		if (*end == ',') {
+			end++;
+		} else if (*end && *end != '\n') {
+			return -1;
+		}
+		str = end;
+	}
+	return 0;
+}
+
+/** Reads one line of a sysfs file into @a buf.
+ *
+ * @return 0 on success, -1 on error
+ */
+
+static int placement_read_file(const char * name, char * buf, int size) {
+	FILE * f;
+
+	if ( (f = fopen(name, "r")) == NULL) {
+		return -1;
+	}
+	if (fgets(buf, size, f) == NULL) {
+		buf[0] = 0;
+	}
+	fclose(f);
+	return 0;
+}
+
+/** Reads online processors and their nodes from sysfs. Without NUMA information, all processors are on node 0. */
+
+static void placement_read_topology() {
+	char name[MAX_STRING];
+	char buf[MAX_STRING];
+	char set[PLACEMENT_MAX_CPUS];
+	int cpu, node;
+	long cpus;
+
+	for (cpu = 0; cpu < PLACEMENT_MAX_CPUS; cpu++) {
+		placement_node_of[cpu] = -1;
+	}
+	if (placement_read_file("/sys/devices/system/cpu/online", buf, MAX_STRING) != 0 || placement_parse_list(buf, set) != 0) {
+		cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		for (cpu = 0; cpu < PLACEMENT_MAX_CPUS; cpu++) {
+			set[cpu] = cpu < cpus;
+		}
+	}
+	for (cpu = 0; cpu < PLACEMENT_MAX_CPUS; cpu++) {
+		if (set[cpu]) {
+			placement_node_of[cpu] = 0;
+		}
+	}
+
+	placement_nodes = 1;
+	for (node = 0; node < PLACEMENT_MAX_NODES; node++) {
+		snprintf(name, MAX_STRING, "/sys/devices/system/node/node%d/cpulist", node);
+		if (placement_read_file(name, buf, MAX_STRING) != 0 || placement_parse_list(buf, set) != 0) {
+			continue;
+		}
+		for (cpu = 0; cpu < PLACEMENT_MAX_CPUS; cpu++) {
+			if (set[cpu] && placement_node_of[cpu] != -1) {
+				placement_node_of[cpu] = node;
+			}
+		}
+		placement_nodes = node + 1;
+	}
+}
+
+/** Finds NUMA node of the block device holding @a path, by walking up its sysfs device directory until
+ * a numa_node attribute is found.
+ *
+ * @return node number, -1 on error
+ */
+
+static int placement_path_node(const char * path) {
+	char name[MAX_STRING];
+	char dir[PATH_MAX];
+	char buf[MAX_STRING];
+	struct stat st;
+	char * slash;
+	int node;
+
+	if (stat(path, &st) != 0) {
+		ERRORPRINTF("Can not stat %s: %s\n", path, strerror(errno));
+		return -1;
+	}
+	snprintf(name, MAX_STRING, "/sys/dev/block/%u:%u", major(st.st_dev), minor(st.st_dev));
+	if (realpath(name, dir) == NULL) {
+		ERRORPRINTF("%s is not on a block device\n", path);
+		return -1;
+	}
+	while ( (slash = strrchr(dir, '/')) != NULL && slash != dir) {
+		if (snprintf(name, MAX_STRING, "%s/numa_node", dir) < MAX_STRING && placement_read_file(name, buf, MAX_STRING) == 0) {
+			node = atoi(buf);
+			if (node < 0) { //the device knows nothing about NUMA
+				node = 0;
+			}
+			DEBUGPRINTF("Device of %s (%s) is attached to node %d\n", path, dir, node);
+			return node;
+		}
+		*slash = 0;
+	}
+	DEBUGPRINTF("NUMA node of device of %s not found, using node 0\n", path);
+	return 0;
+}
+
+/** Sets the placement policy, see placement.h. Reads the topology and orders the allowed processors.
+ *
+ * @arg policy the policy, NULL or empty string to leave placement to the -b option
+ * @return 0 on success, -1 on error
+ */
+
+int placement_init(const char * policy) {
+	char allowed[PLACEMENT_MAX_CPUS];
+	const char * arg;
+	int spread = 0;
+	int only_node = -1;
+	int cpu, node, added;
+	int next[PLACEMENT_MAX_NODES];
+
+	placement_count = 0;
+	if (policy == NULL || policy[0] == 0) {
+		return 0;
+	}
+	strncpy(placement_policy, policy, MAX_STRING);
+	placement_policy[MAX_STRING-1] = 0;
+	placement_read_topology();
+
+	arg = strchr(policy, ':');
+	arg = arg ? arg + 1 : NULL;
+	memset(allowed, 1, PLACEMENT_MAX_CPUS);
+	if ( ! strncmp(policy, PLACEMENT_COMPACT_STR, strlen(PLACEMENT_COMPACT_STR))) {
+		spread = 0;
+	} else if ( ! strncmp(policy, PLACEMENT_SPREAD_STR, strlen(PLACEMENT_SPREAD_STR))) {
+		spread = 1;
+	} else if ( ! strncmp(policy, PLACEMENT_CPUS_STR, strlen(PLACEMENT_CPUS_STR)) && arg) {
+		spread = 0;
+	} else if ( ! strncmp(policy, PLACEMENT_NODE_STR, strlen(PLACEMENT_NODE_STR)) && arg) {
+		only_node = atoi(arg);
+		arg = NULL;
+	} else if ( ! strncmp(policy, PLACEMENT_NEAR_STR, strlen(PLACEMENT_NEAR_STR)) && arg) {
+		if ( (only_node = placement_path_node(arg)) == -1) {
+			return -1;
+		}
+		arg = NULL;
+	} else {
+		ERRORPRINTF("Unknown placement policy: %s\n", policy);
+		return -1;
+	}
+	if (arg && placement_parse_list(arg, allowed) != 0) {
+		ERRORPRINTF("Can not parse list of processors: %s\n", arg);
+		return -1;
+	}
+
+	for (cpu = 0; cpu < PLACEMENT_MAX_CPUS; cpu++) {
+		if (placement_node_of[cpu] == -1 || (only_node != -1 && placement_node_of[cpu] != only_node)) {
+			allowed[cpu] = 0;
+		}
+	}
+
+	if (spread) { //one processor from every node in turn
+		memset(next, 0, sizeof(next));
+		do {
+			added = 0;
+			for (node = 0; node < placement_nodes; node++) {
+				for (cpu = next[node]; cpu < PLACEMENT_MAX_CPUS; cpu++) {
+					if (allowed[cpu] && placement_node_of[cpu] == node) {
+						placement_order[placement_count++] = cpu;
+						added = 1;
+						break;
+					}
+				}
+				next[node] = cpu + 1;
+			}
+		} while (added);
+	} else { //node after node
+		for (node = 0; node < placement_nodes; node++) {
+			for (cpu = 0; cpu < PLACEMENT_MAX_CPUS; cpu++) {
+				if (allowed[cpu] && placement_node_of[cpu] == node) {
+					placement_order[placement_count++] = cpu;
+				}
+			}
+		}
+	}
+
+	if (placement_count == 0) {
+		ERRORPRINTF("No online processor matches placement %s\n", policy);
+		return -1;
+	}
+	return 0;
+}
+
+int placement_enabled() {
+	return placement_count > 0;
+}
+
+/** @return processor for worker (clone) number @a worker */
+
+int placement_cpu(int worker) {
+	return placement_order[worker % placement_count];
+}
+
+/** @return NUMA node of processor @a cpu, 0 if unknown */
+
+int placement_node(int cpu) {
+	if (cpu < 0 || cpu >= PLACEMENT_MAX_CPUS || placement_node_of[cpu] == -1) {
+		return 0;
+	}
+	return placement_node_of[cpu];
+}
+
+/** Binds the calling process to processor @a cpu and makes it prefer memory of the processor's node, so buffers
+ * allocated (touched) afterwards are node local.
+ *
+ * @return 0 on success, -1 if the process could not be bound
+ */
+
+int placement_bind(int cpu) {
+	cpu_set_t mask;
+	unsigned long nodemask[PLACEMENT_MAX_NODES / (8 * sizeof(unsigned long)) + 1];
+	int node = placement_node(cpu);
+
+	CPU_ZERO(&mask);
+	CPU_SET(cpu, &mask);
+	if (sched_setaffinity(0, sizeof(mask), &mask) != 0) {
+		ERRORPRINTF("Can not bind to processor %d: %s\n", cpu, strerror(errno));
+		return -1;
+	}
+	if (placement_nodes > 1) {
+		memset(nodemask, 0, sizeof(nodemask));
+		nodemask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+		if (syscall(SYS_set_mempolicy, MPOL_PREFERRED, nodemask, PLACEMENT_MAX_NODES + 1) != 0) {
+			DEBUGPRINTF("Can not prefer memory of node %d: %s\n", node, strerror(errno));
+		}
+	}
+	return 0;
+}
+
+/** Prints the placement of @a workers workers. */
+
+void placement_report(int workers) {
+	int i;
+
+	fprintf(stdout, "Placement %s: %d processors allowed on %d node(s)\n", placement_policy, placement_count, placement_nodes);
+	if (workers == 1) {
+		fprintf(stdout, "  replay: processor %d, node %d\n", placement_cpu(0), placement_node(placement_cpu(0)));
+	}
+	for (i = 0; i < workers && workers > 1; i++) {
+		fprintf(stdout, "  clone %d: processor %d, node %d\n", i, placement_cpu(i), placement_node(placement_cpu(i)));
+	}
+}
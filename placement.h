@@ -0,0 +1,53 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _PLACEMENT_H_
+#define _PLACEMENT_H_
+
+/** @file placement.h
+ *
+ * Placement of replay workers (the replaying process and every clone) on processors and NUMA nodes.
+ *
+ * The topology is read from sysfs (/sys/devices/system/node/node<N>/cpulist, /sys/devices/system/cpu/online).
+ * A policy orders the allowed processors and worker k gets k-th processor of the order (modulo its length):
+ *  - compact[:<cpus>] fills node after node,
+ *  - spread[:<cpus>] takes processors from all nodes round robin,
+ *  - cpus:<cpus> is compact over the given list only,
+ *  - node:<n> and near:<path> use processors of node n, or of the node the device holding <path> is attached to.
+ * <cpus> is a list in the cpulist format, e.g. 0-3,8,10-11.
+ *
+ * A bound worker also prefers memory of its node, so IO buffers allocated afterwards are node local.
+ */
+
+#define PLACEMENT_MAX_CPUS 1024
+#define PLACEMENT_MAX_NODES 64
+#define PLACEMENT_COMPACT_STR "compact"
+#define PLACEMENT_SPREAD_STR "spread"
+#define PLACEMENT_CPUS_STR "cpus"
+#define PLACEMENT_NODE_STR "node"
+#define PLACEMENT_NEAR_STR "near"
+
+int placement_init(const char * policy);
+int placement_enabled();
+int placement_cpu(int worker);
+int placement_node(int cpu);
+int placement_bind(int cpu);
+void placement_report(int workers);
+
+#endif
@@ -58,8 +58,9 @@ void print_pwrite(pwrite_item_t * op_it) {
 
 
 void print_pipe(pipe_item_t * op_it) {
-	printf("%"PRIi32".%"PRIi32"\t%"PRIi32"\tpipe(%"PRIi32", %"PRIi32", 0x%"PRIx32") = %"PRIi32" <%"PRIi32">\n",\
-               op_it->o.info.start.tv_sec, op_it->o.info.start.tv_usec, op_it->o.info.pid, op_it->o.fd1,\
+	printf("%"PRIi32".%"PRIi32"\t%"PRIi32"\t%s(%"PRIi32", %"PRIi32", 0x%"PRIx32") = %"PRIi32" <%"PRIi32">\n",\
+               op_it->o.info.start.tv_sec, op_it->o.info.start.tv_usec, op_it->o.info.pid,\
+               op_it->type == OP_SOCKETPAIR ? "socketpair" : "pipe", op_it->o.fd1,\
                op_it->o.fd2, op_it->o.mode, op_it->o.retval, op_it->o.info.dur);
 }
 
@@ -146,12 +147,96 @@ void print_stat(stat_item_t * op_it) {
 }
 
 void print_socket(socket_item_t * op_it) {
-	printf("%"PRIi32".%"PRIi32"\t%"PRIi32"\tsocket(domain, type, protocol) = %"PRIi32" <%"PRIi32">\n",\
+	char * name;
+
+	switch (op_it->type) {
+		case OP_EVENTFD:
+			name = "eventfd(args..)";
+			break;
+		case OP_EPOLL:
+			name = "epoll_create(args..)";
+			break;
+		case OP_TIMERFD:
+			name = "timerfd_create(args..)";
+			break;
+		default:
+			name = "socket(domain, type, protocol)";
+			break;
+	}
+	printf("%"PRIi32".%"PRIi32"\t%"PRIi32"\t%s = %"PRIi32" <%"PRIi32">\n",\
                op_it->o.info.start.tv_sec, op_it->o.info.start.tv_usec, op_it->o.info.pid,\
-               op_it->o.retval, op_it->o.info.dur);
+               name, op_it->o.retval, op_it->o.info.dur);
+}
+
+
+
+void print_rename(rename_item_t * op_it) {
+	printf("%"PRIi32".%"PRIi32"\t%"PRIi32"\trename(%s, %s) = %"PRIi32" <%"PRIi32">\n",\
+               op_it->o.info.start.tv_sec, op_it->o.info.start.tv_usec, op_it->o.info.pid, op_it->o.old_name,\
+               op_it->o.new_name, op_it->o.retval, op_it->o.info.dur);
+}
+
+void print_link(link_item_t * op_it) {
+	printf("%"PRIi32".%"PRIi32"\t%"PRIi32"\t%s(%s, %s) = %"PRIi32" <%"PRIi32">\n",\
+               op_it->o.info.start.tv_sec, op_it->o.info.start.tv_usec, op_it->o.info.pid,\
+               op_it->type == OP_SYMLINK ? "symlink" : "link", op_it->o.old_name,\
+               op_it->o.new_name, op_it->o.retval, op_it->o.info.dur);
 }
 
+void print_readlink(readlink_item_t * op_it) {
+	printf("%"PRIi32".%"PRIi32"\t%"PRIi32"\treadlink(%s, addr, %"PRIi64") = %"PRIi64" <%"PRIi32">\n",\
+               op_it->o.info.start.tv_sec, op_it->o.info.start.tv_usec, op_it->o.info.pid, op_it->o.name,\
+               op_it->o.size, op_it->o.retval, op_it->o.info.dur);
+}
+
+void print_getdents(getdents_item_t * op_it) {
+	printf("%"PRIi32".%"PRIi32"\t%"PRIi32"\tgetdents(%"PRIi32", /* %"PRIi32" entries */, %"PRIi64") = %"PRIi64" <%"PRIi32">\n",\
+               op_it->o.info.start.tv_sec, op_it->o.info.start.tv_usec, op_it->o.info.pid, op_it->o.fd,\
+               op_it->o.entries, op_it->o.size, op_it->o.retval, op_it->o.info.dur);
+}
+
+void print_mmap(mmap_item_t * op_it) {
+	printf("%"PRIi32".%"PRIi32"\t%"PRIi32"\tmmap(0x%"PRIx64", %"PRIi64", 0x%"PRIx32", 0x%"PRIx32", %"PRIi32", %"PRIi64") = 0x%"PRIx64" <%"PRIi32">\n",\
+               op_it->o.info.start.tv_sec, op_it->o.info.start.tv_usec, op_it->o.info.pid, op_it->o.addr,\
+               op_it->o.length, op_it->o.prot, op_it->o.flags, op_it->o.fd, op_it->o.offset, op_it->o.retval, op_it->o.info.dur);
+}
 
+void print_mem(mem_item_t * op_it) {
+	char * name;
+
+	switch (op_it->type) {
+		case OP_MUNMAP:
+			name = "munmap";
+			break;
+		case OP_MSYNC:
+			name = "msync";
+			break;
+		default:
+			name = "madvise";
+			break;
+	}
+	printf("%"PRIi32".%"PRIi32"\t%"PRIi32"\t%s(0x%"PRIx64", %"PRIi64", 0x%"PRIx32") = %"PRIi32" <%"PRIi32">\n",\
+               op_it->o.info.start.tv_sec, op_it->o.info.start.tv_usec, op_it->o.info.pid, name, op_it->o.addr,\
+               op_it->o.length, op_it->o.flags, op_it->o.retval, op_it->o.info.dur);
+}
+
+void print_exit(exit_item_t * op_it) {
+	printf("%"PRIi32".%"PRIi32"\t%"PRIi32"\t%s(%"PRIi32") = ? <%"PRIi32">\n",\
+               op_it->o.info.start.tv_sec, op_it->o.info.start.tv_usec, op_it->o.info.pid,\
+               op_it->type == OP_EXIT ? "exit" : "exit_group", op_it->o.status, op_it->o.info.dur);
+}
+
+void print_execve(execve_item_t * op_it) {
+	printf("%"PRIi32".%"PRIi32"\t%"PRIi32"\texecve(%s, argv, envp) = %"PRIi32" <%"PRIi32">\n",\
+               op_it->o.info.start.tv_sec, op_it->o.info.start.tv_usec, op_it->o.info.pid, op_it->o.name,\
+               op_it->o.retval, op_it->o.info.dur);
+}
+
+void print_wait(wait_item_t * op_it) {
+	printf("%"PRIi32".%"PRIi32"\t%"PRIi32"\twait4(%"PRIi32", status, options, rusage) = %"PRIi32" <%"PRIi32">\n",\
+               op_it->o.info.start.tv_sec, op_it->o.info.start.tv_usec, op_it->o.info.pid, op_it->o.pid,\
+               op_it->o.retval, op_it->o.info.dur);
+}
 
 int print_items(list_t * list) {
 	long long i = 0;
@@ -204,6 +289,7 @@ int print_items(list_t * list) {
 				print_dup((dup_item_t *) com_it);
 				break;
 			case OP_PIPE:
+			case OP_SOCKETPAIR:
 				print_pipe((pipe_item_t *) com_it);
 				break;
 			case OP_ACCESS:
@@ -213,11 +299,45 @@ int print_items(list_t * list) {
 				print_stat((stat_item_t *) com_it);
 				break;
 			case OP_SOCKET:
+			case OP_EVENTFD:
+			case OP_EPOLL:
+			case OP_TIMERFD:
 				print_socket((socket_item_t *) com_it);
 				break;
 			case OP_SENDFILE:
 				print_sendfile((sendfile_item_t *) com_it);
 				break;
+			case OP_RENAME:
+				print_rename((rename_item_t *) com_it);
+				break;
+			case OP_LINK:
+			case OP_SYMLINK:
+				print_link((link_item_t *) com_it);
+				break;
+			case OP_READLINK:
+				print_readlink((readlink_item_t *) com_it);
+				break;
+			case OP_GETDENTS:
+				print_getdents((getdents_item_t *) com_it);
+				break;
+			case OP_MMAP:
+				print_mmap((mmap_item_t *) com_it);
+				break;
+			case OP_MUNMAP:
+			case OP_MSYNC:
+			case OP_MADVISE:
+				print_mem((mem_item_t *) com_it);
+				break;
+			case OP_EXIT:
+			case OP_EXIT_GROUP:
+				print_exit((exit_item_t *) com_it);
+				break;
+			case OP_EXECVE:
+				print_execve((execve_item_t *) com_it);
+				break;
+			case OP_WAIT:
+				print_wait((wait_item_t *) com_it);
+				break;
 			default:
 				ERRORPRINTF("Unknown operation identifier: '%c'\n", com_it->type);
 				return -1;
@@ -22,6 +22,8 @@
 #include <sys/syscall.h>
 #include <sys/sendfile.h>
 #include <sys/resource.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
 #include <limits.h>
 #include <fcntl.h>
 #include <assert.h>
@@ -30,6 +32,7 @@
 #include <string.h>
 #include <errno.h>
 #include <sched.h>
+#include <time.h>
 
 #include "replicate.h"
 #include "fdmap.h"
@@ -37,6 +40,13 @@
 #include "in_common.h"
 #include "simulate.h"
 #include "adt/hash_table.h"
+#include "bufpool.h"
+#include "pagecache.h"
+#include "payload.h"
+#include "throttle.h"
+#include "filter.h"
+#include "checkpoint.h"
+#include "coord.h"
 
 #define TIMEVAL_DIFF(t1, t2) (((uint64_t)(t1.tv_sec) * 1000000 + (uint64_t)(t1.tv_usec)) - ((uint64_t)(t2.tv_sec) * 1000000 + (uint64_t)(t2.tv_usec)))
 #define CALL_TIME(x) ((uint64_t)(x->o.info.start.tv_sec) * 1000000 + (uint64_t)(x->o.info.start.tv_usec))
@@ -57,7 +67,24 @@ hash_table_t * usage_map; /** hashtables of fds which are used by this process -
 int32_t global_parent_pid = 0;
 int global_fix_missing = 1; /** whether to try to fix missing clone/open calls in trace */
 int global_devnull_fd = 0;
+int global_quiet = 0; /** don't print summary at the end, used for helper passes over the trace */
+replay_stats_t replay_stats; /** statistics of reads and writes of the last replay */
+double global_speedup = 1.0; /** think time between calls is divided by this factor in TIME_DIFF and TIME_EXACT modes */
 int global_devzero_fd = 0;
+list_t mem_maps; /** list of memory mappings (mem_map_t) created by replicated mmap calls */
+struct rusage start_rusage; /** resource usage at the beginning of replication, used to count page faults */
+int64_t count_pipe_fds = 0; /** number of placeholder fds created for pipes (pipe, pipe2) */
+int64_t count_socket_fds = 0; /** number of placeholder fds created for sockets (socket, socketpair) */
+int64_t count_anon_fds = 0; /** number of placeholder fds created for eventfd, epoll and timerfd */
+int64_t count_missing_fds = 0; /** number of fds opened as UNKNOWN_FILE because their open call was missing */
+int64_t count_unaligned_io = 0; /** number of unaligned reads on O_DIRECT files that had to be rounded */
+int64_t count_unaligned_writes = 0; /** number of unaligned writes on O_DIRECT files done through the page cache */
+int64_t count_direct_fallback = 0; /** number of O_DIRECT opens not supported by the file system */
+int64_t count_ignored_ops = 0; /** number of operations on fds of ignored files */
+int64_t count_channel_fds = 0; /** number of real pipe/socketpair ends created for PIPE_CHANNELS */
+int64_t count_channel_bytes = 0; /** number of bytes that went through the channels */
+int64_t count_channel_stalls = 0; /** number of channel reads that found no data and writes that found no room */
+int64_t count_mmaps = 0; /** number of file mappings created by replicated mmap calls */
 
 #ifndef PY_MODULE
 extern struct timeval global_start;
@@ -112,7 +139,7 @@ unsigned long long  get_clock_rate() {
 }
 
 #define REPLICATE(x) x##_it = (x##_item_t *) com_it; \
-				if ( i==1 ) /*first thing on the list!*/ {\
+				if ( i==1 && ! resumed ) /*first thing on the list!*/ {\
 					if( replicate_init(x##_it->o.info.pid, cpu, ifilename, mfilename))\
 						return -1; \
 					last_call_orig = CALL_TIME(x##_it); \
@@ -120,10 +147,21 @@ unsigned long long  get_clock_rate() {
 					counter_first = rdtsc(); \
 					counter_last = rdtsc(); \
 				}\
+				/** skip operations out of the slice, operations keeping fd mappings are done without timing */\
+				filter = filter_enabled() ? filter_check(com_it->type, &x##_it->o.info) : FILTER_PASS; \
+				if ( filter == FILTER_SKIP ) { \
+					replicate_skip(com_it, op_mask); \
+					filter_drop(com_it); \
+					break; \
+				} else if ( filter == FILTER_PASS && ! slice_started ) { \
+					slice_started = 1; \
+					first_call_orig = CALL_TIME(x##_it); \
+					counter_first = rdtsc(); \
+				} \
 				/** wait for delivering of next call, if enabled */\
-				if ( op_mask & TIME_DIFF ) { \
+				if ( filter == FILTER_PASS && (op_mask & TIME_DIFF) ) { \
 					diff_orig = CALL_TIME(x##_it) - last_call_orig; \
-					diff_orig = diff_orig * scale; \
+					diff_orig = diff_orig * scale / global_speedup; \
 					counter_real = rdtsc(); \
 					diff_real = ((counter_real - counter_last)*1000000)/(clock_rate); \
 					diff = diff_orig - diff_real; \
@@ -137,8 +175,8 @@ unsigned long long  get_clock_rate() {
 						diff_real = ((counter_real - counter_last)*1000000)/(clock_rate); \
 						diff = diff_orig - diff_real; \
 					} \
-				} else if ( op_mask & TIME_EXACT ) { \
-					diff_orig = CALL_TIME(x##_it) - first_call_orig; \
+				} else if ( filter == FILTER_PASS && (op_mask & TIME_EXACT) ) { \
+					diff_orig = (CALL_TIME(x##_it) - first_call_orig) / global_speedup; \
 					counter_real = rdtsc(); \
 					diff_real = ((counter_real - counter_first)*1000000)/(clock_rate); \
 					diff = diff_orig - diff_real; \
@@ -153,7 +191,12 @@ unsigned long long  get_clock_rate() {
 					} \
 					\
 				}\
+				ignored = count_ignored_ops + namemap_ignored_count(); \
 				replicate_##x(x##_it, op_mask);\
+				last_done_orig = CALL_TIME(x##_it); \
+				if ( ignored != count_ignored_ops + namemap_ignored_count() ) { \
+					filter_drop(com_it); \
+				} \
 				if ( op_mask & TIME_DIFF ) { \
 					last_call_orig = CALL_TIME(x##_it) + DUR_TIME(x##_it); \
 					counter_last = rdtsc(); \
@@ -198,10 +241,14 @@ item_t * replicate_get_fd_map(hash_table_t * ht, int fd, op_info_t * info, int o
 			op_it->o.flags = O_RDWR;
 			op_it->o.info.start = info->start;
 
+			count_missing_fds++;
 			replicate_open(op_it, op_mask);
 			return hash_table_find(ht, &fd);
 		}
 	} else {
+		if (hash_table_entry(fd_map, fd_item_t, item)->fd_map->type == S_IFIGNORE) {
+			count_ignored_ops++;
+		}
 		return fd_map;
 	}
 }
@@ -214,6 +261,260 @@ int supported_type(mode_t type) {
 	}
 }
 
+/** Moves the position of @a fd by @a bytes, as the skipped operation @a com_it out of the slice would do,
+ * so the operations in the slice start at the recorded offsets. When marking for conversion, the skipped
+ * operation is replaced by an equivalent relative lseek (see filter_seek()).
+ */
+
+static void replicate_skip_fd(common_op_item_t * com_it, int32_t fd, int64_t bytes, int op_mask) {
+	item_t * fd_map;
+	fd_item_t * fd_item;
+	hash_table_t * ht;
+
+	if (bytes <= 0 || (ht = get_process_ht(fd_mappings, get_item_info(com_it)->pid)) == NULL 
+			|| (fd_map = hash_table_find(ht, &fd)) == NULL) {
+		return;
+	}
+	fd_item = hash_table_entry(fd_map, fd_item_t, item);
+	if ( ! supported_type(fd_item->fd_map->type)) {
+		return;
+	}
+	if (op_mask & ACT_REPLICATE) {
+		if (lseek(fd_item->fd_map->my_fd, bytes, SEEK_CUR) == (off_t) -1) {
+			ERRORPRINTF("%d: Can not skip %"PRIi64" bytes of fd %d->%d: %s\n", get_item_info(com_it)->pid, 
+					bytes, fd, fd_item->fd_map->my_fd, strerror(errno));
+		}
+	}
+	fd_item->fd_map->cur_pos += bytes;
+	filter_seek(com_it, fd, bytes, fd_item->fd_map->cur_pos);
+}
+
+/** Keeps fd positions of operation @a com_it, which is out of the slice and will not be replayed. 
+ * pread and pwrite do not move the position, so there is nothing to do for them.
+ */
+
+static void replicate_skip(common_op_item_t * com_it, int op_mask) {
+	switch (com_it->type) {
+		case OP_READ:
+			replicate_skip_fd(com_it, ((read_item_t *) com_it)->o.fd, ((read_item_t *) com_it)->o.retval, op_mask);
+			break;
+		case OP_WRITE:
+			replicate_skip_fd(com_it, ((write_item_t *) com_it)->o.fd, ((write_item_t *) com_it)->o.retval, op_mask);
+			break;
+		case OP_SENDFILE: {
+			sendfile_item_t * op_it = (sendfile_item_t *) com_it;
+
+			if (op_it->o.offset == OFFSET_INVAL) {
+				replicate_skip_fd(com_it, op_it->o.in_fd, op_it->o.retval, op_mask);
+			}
+			replicate_skip_fd(com_it, op_it->o.out_fd, op_it->o.retval, op_mask);
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+/** Rounds offset and size of a read on a file opened with O_DIRECT to BUFPOOL_ALIGN, otherwise the
+ * call would fail with EINVAL. The rounded range always covers the original one.
+ *
+ * @arg offset offset of the IO, rounded down
+ * @arg size size of the IO, rounded up
+ * @return non-zero if the IO was not aligned
+ */
+
+static inline int replicate_direct_round(int64_t * offset, int64_t * size) {
+	int64_t start = BUFPOOL_ROUND_DOWN(*offset);
+	int64_t end = BUFPOOL_ROUND_UP(*offset + *size);
+
+	if (start == *offset && end - start == *size) {
+		return 0;
+	}
+	*offset = start;
+	*size = end - start;
+	return 1;
+}
+
+/** Performs one read or write of @a size bytes using a buffer from the buffer pool, or generated payload for
+ * writes (see payload.h). Unaligned reads on files opened with O_DIRECT are aligned first, the file position is
+ * then set as if the original call was made. Unaligned writes are done without O_DIRECT instead, as rounding
+ * them would overwrite data around the recorded range.
+ *
+ * @arg fd_map mapping of the file on which to do the IO
+ * @arg size size of the IO
+ * @arg offset offset of the IO for pread/pwrite, -1 to use current file position (read/write)
+ * @arg is_write whether to write or read
+ * @return number of bytes of the original range read/written, -1 on error
+ */
+
+static int64_t replicate_do_io_call(fd_map_t * fd_map, int64_t size, int64_t offset, int is_write) {
+	int64_t pos = offset;
+	int64_t r_offset, r_size;
+	int64_t retval;
+	int myfd = fd_map->my_fd;
+	int flags, err;
+	char * data;
+
+	if (fd_map->direct) {
+		if (offset == -1 && (pos = lseek(myfd, 0, SEEK_CUR)) == -1) {
+			return -1;
+		}
+		r_offset = pos;
+		r_size = size;
+		if (replicate_direct_round(&r_offset, &r_size)) {
+			if (is_write) { //rounding would overwrite data around the range, write it through the page cache
+				count_unaligned_writes++;
+				if ( (data = payload_enabled() ? payload_get(size) : bufpool_get(size)) == NULL) {
+					errno = ENOMEM;
+					return -1;
+				}
+				if ( (flags = fcntl(myfd, F_GETFL)) == -1 || fcntl(myfd, F_SETFL, flags & ~O_DIRECT) == -1) {
+					return -1;
+				}
+				retval = (offset == -1) ? write(myfd, data, size) : pwrite(myfd, data, size, offset);
+				err = errno;
+				fcntl(myfd, F_SETFL, flags);
+				errno = err;
+				return retval;
+			}
+			count_unaligned_io++;
+			if ( (data = bufpool_get(r_size)) == NULL) {
+				errno = ENOMEM;
+				return -1;
+			}
+			if ( (retval = pread(myfd, data, r_size, r_offset)) == -1) {
+				return -1;
+			}
+			retval -= pos - r_offset; //bytes before the original range don't count
+			if (retval < 0) {
+				retval = 0;
+			} else if (retval > size) {
+				retval = size;
+			}
+			if (offset == -1) {
+				lseek(myfd, pos + retval, SEEK_SET);
+			}
+			return retval;
+		}
+	}
+
+	if ( (data = (is_write && payload_enabled()) ? payload_get(size) : bufpool_get(size)) == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+	if (offset == -1) {
+		return is_write ? write(myfd, data, size) : read(myfd, data, size);
+	} else {
+		return is_write ? pwrite(myfd, data, size, offset) : pread(myfd, data, size, offset);
+	}
+}
+
+/** Accounts one call which transferred @a bytes and lasted @a lat ns into @a stats. */
+
+void replay_stats_add(replay_stats_t * stats, int64_t bytes, uint64_t lat) {
+	int b = 0;
+
+	stats->io_calls++;
+	if (bytes > 0) {
+		stats->io_bytes += bytes;
+	}
+	stats->io_time += lat;
+	if (lat > stats->io_max) {
+		stats->io_max = lat;
+	}
+	while (lat && b < REPLAY_HIST_BUCKETS - 1) {
+		lat >>= 1;
+		b++;
+	}
+	stats->hist[b]++;
+}
+
+/** Adds reads and writes of @a stats to @a total, e.g. to report more replays together. */
+
+void replay_stats_merge(replay_stats_t * total, replay_stats_t * stats) {
+	int b;
+
+	total->io_calls += stats->io_calls;
+	total->io_bytes += stats->io_bytes;
+	total->io_time += stats->io_time;
+	if (stats->io_max > total->io_max) {
+		total->io_max = stats->io_max;
+	}
+	for (b = 0; b < REPLAY_HIST_BUCKETS; b++) {
+		total->hist[b] += stats->hist[b];
+	}
+}
+
+/** Returns latency in ns below which fraction @a p of calls in histogram of @a stats falls
+ * (the upper bound of the bucket).
+ */
+
+uint64_t replay_stats_percentile(replay_stats_t * stats, double p) {
+	int64_t sum = 0;
+	int b;
+
+	for (b = 0; b < REPLAY_HIST_BUCKETS; b++) {
+		sum += stats->hist[b];
+		if (sum >= p * stats->io_calls) {
+			return b ? (uint64_t) 1 << b : 0;
+		}
+	}
+	return stats->io_max;
+}
+
+/** Performs one read or write (see replicate_do_io_call()) and accounts its latency into replay_stats.
+ *
+ * @return number of bytes of the original range read/written, -1 on error
+ */
+
+int64_t replicate_do_io(fd_map_t * fd_map, int64_t size, int64_t offset, int is_write) {
+	struct timespec t1, t2;
+	int64_t retval;
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	retval = replicate_do_io_call(fd_map, size, offset, is_write);
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+
+	replay_stats_add(&replay_stats, retval, (uint64_t) (t2.tv_sec - t1.tv_sec) * 1000000000 + t2.tv_nsec - t1.tv_nsec);
+	return retval;
+}
+
+/** Reads or writes @a size bytes from/to a real channel (see PIPE_CHANNELS). The channels are non-blocking: the
+ * replay is done by one thread in the order of the trace, so a read that would block could never be satisfied.
+ * Such reads (and writes to a full channel) are counted as stalls instead, the rest of the data goes through
+ * the kernel the same way as it did between the original processes.
+ *
+ * @arg fd_map mapping of the channel end
+ * @arg size number of bytes the original call transferred
+ * @arg is_write whether to write or read
+ * @return number of bytes transferred, -1 on error
+ */
+
+static int64_t replicate_channel_io(fd_map_t * fd_map, int64_t size, int is_write) {
+	int64_t retval;
+	char * data;
+
+	if (size <= 0) {
+		return 0;
+	}
+	if ( (data = bufpool_get(size)) == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+	retval = is_write ? write(fd_map->my_fd, data, size) : read(fd_map->my_fd, data, size);
+	if (retval == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+		count_channel_stalls++;
+		return 0;
+	}
+	if (retval > 0) {
+		count_channel_bytes += retval;
+		if (retval < size) {
+			count_channel_stalls++;
+		}
+	}
+	return retval;
+}
+
 /** Replicates one read read(2) call.
  * @arg op_it operation item structure in which are information about the read(2) call
  * @arg op_mask whether really replicate or just simulate it. ACT_SIMULATE or ACT_REPLICATE.
@@ -225,7 +526,6 @@ void replicate_read(read_item_t * op_it, int op_mask) {
 	fd_item_t * fd_item;
 	int myfd;
 	item_t * fd_map;
-	char * data;
 	int32_t pid = op_it->o.info.pid;
 	hash_table_t * ht;
 
@@ -244,11 +544,80 @@ void replicate_read(read_item_t * op_it, int op_mask) {
 		fd_item = hash_table_entry(fd_map, fd_item_t, item);
 		myfd = fd_item->fd_map->my_fd;
 
+		if (fd_item->fd_map->channel) {
+			if (replicate_channel_io(fd_item->fd_map, op_it->o.retval, 0) == -1) {
+				ERRORPRINTF("%d: Read from channel fd %d->%d failed: %s\n", pid, fd, myfd, strerror(errno));
+			}
+			return;
+		}
+
 		if ( ! supported_type(fd_item->fd_map->type)) {
 			//DEBUGPRINTF("Unsupported fd (%d -> %d) type: %d\n", fd, myfd, fd_item->fd_map->type);
 			return;
 		}
 		
+		if (op_mask & ACT_SIMULATE) {
+			retval = op_it->o.retval;
+			if (op_it->o.retval != -1) { //do not take unsuccessfull reads into account
+				simulate_read(fd_item, op_it);
+			}
+		} else if ( op_mask & ACT_REPLICATE) {
+			if (op_mask & CACHE_MASK) {
+				pagecache_sample(fd_item->fd_map->name, fd_item->fd_map->cur_pos, op_it->o.size);
+			}
+			throttle_io(op_it->o.info.pid, op_it->o.size);
+			retval = replicate_do_io(fd_item->fd_map, op_it->o.size, -1, 0);
+		} else {
+			assert(0);
+		}
+		fd_item->fd_map->cur_pos += retval; ///< @todo this should be moved to simulate class!
+
+	
+		if (retval == -1 && retval != op_it->o.retval) {
+			ERRORPRINTF("%d: Read from fd %d->%d failed: %s\n", pid, fd, myfd, strerror(errno));
+//			hash_table_dump2(ht, dump_fd_list_item);
+		} else if (retval != op_it->o.size && retval != op_it->o.retval) {
+			DEBUGPRINTF("Warning, %"PRIi64" bytes were successfully read \
+(expected: %"PRIi64")\n", retval, op_it->o.retval);
+		}
+	}
+}
+
+/** Replicates one getdents(2)/getdents64(2) call. It is always replayed as getdents64 with the same buffer size
+ * as in the original run, so the number of calls needed to scan the directory is the same (given the same directory).
+ * @arg op_it operation item structure in which are information about the getdents call
+ * @arg op_mask whether really replicate or just simulate it. ACT_SIMULATE or ACT_REPLICATE.
+ */
+
+void replicate_getdents(getdents_item_t * op_it, int op_mask) {
+	int64_t retval = 0;
+	int fd = op_it->o.fd;
+	fd_item_t * fd_item;
+	int myfd;
+	item_t * fd_map;
+	char * data;
+	int32_t pid = op_it->o.info.pid;
+	hash_table_t * ht;
+
+	ht = get_process_ht(fd_mappings, pid);
+
+	if (! ht) {
+		ht = replicate_missing_ht(pid, op_mask);
+		if (! ht) {
+			return;
+		}
+	}
+
+	if ( (fd_map = replicate_get_fd_map(ht, fd, &(op_it->o.info), op_mask)) == NULL) {
+		return;
+	} else {
+		fd_item = hash_table_entry(fd_map, fd_item_t, item);
+		myfd = fd_item->fd_map->my_fd;
+
+		if ( ! supported_type(fd_item->fd_map->type)) {
+			return;
+		}
+		
 		if (op_it->o.size > MAX_DATA) {
 			data = malloc(op_it->o.size);
 		} else {
@@ -257,28 +626,260 @@ void replicate_read(read_item_t * op_it, int op_mask) {
 
 		if (op_mask & ACT_SIMULATE) {
 			retval = op_it->o.retval;
-			if (op_it->o.retval != -1) { //do not take unsuccessfull reads into account
-				simulate_read(fd_item, op_it);
+			if (op_it->o.retval != -1) {
+				simulate_getdents(fd_item, op_it);
 			}
 		} else if ( op_mask & ACT_REPLICATE) {
-			retval = read(myfd, data_buffer, op_it->o.size);
+			retval = syscall(SYS_getdents64, myfd, data, op_it->o.size);
 		} else {
 			assert(0);
 		}
-		fd_item->fd_map->cur_pos += retval; ///< @todo this should be moved to simulate class!
-
 	
 		if ( op_it->o.size > MAX_DATA) {
 			free(data);
 		}
 
-		if (retval == -1 && retval != op_it->o.retval) {
-			ERRORPRINTF("%d: Read from fd %d->%d failed: %s\n", pid, fd, myfd, strerror(errno));
-//			hash_table_dump2(ht, dump_fd_list_item);
-		} else if (retval != op_it->o.size && retval != op_it->o.retval) {
-			DEBUGPRINTF("Warning, %"PRIi64" bytes were successfully read \
-(expected: %"PRIi64")\n", retval, op_it->o.retval);
-		}
+		if (retval == -1 && retval != op_it->o.retval) {
+			ERRORPRINTF("%d: Getdents from fd %d->%d failed: %s\n", pid, fd, myfd, strerror(errno));
+		} else if (retval != op_it->o.retval) {
+			DEBUGPRINTF("Warning, getdents returned %"PRIi64" bytes (expected: %"PRIi64")\n", retval, op_it->o.retval);
+		}
+	}
+}
+
+/** Touches pages of the mapping @a mm in range from @a off of length @a len to cause page faults the same way
+ * the original application did by accessing the mapping. Only part of the mapping that is backed by the file is
+ * touched. Writable shared mappings are touched by writing the same value back, so the pages get dirty.
+ * @arg mm mapping to touch
+ * @arg off offset from the beginning of the mapping
+ * @arg len length of the range to touch
+ * @arg random_order whether to touch the pages in random order or sequentially
+ */
+
+void replicate_mem_touch(mem_map_t * mm, int64_t off, int64_t len, int random_order) {
+	int64_t page_size = sysconf(_SC_PAGESIZE);
+	int64_t first, count, i, j, tmp;
+	int64_t * order = NULL;
+	volatile char * p;
+	char sink = 0;
+
+	if (off < 0 || off >= mm->touch_len || len <= 0) {
+		return;
+	}
+	if (off + len > mm->touch_len) {
+		len = mm->touch_len - off;
+	}
+
+	first = off / page_size;
+	count = (off + len - 1) / page_size - first + 1;
+
+	if (random_order) {
+		order = malloc(sizeof(int64_t) * count);
+		for (i = 0; i < count; i++) {
+			order[i] = i;
+		}
+		for (i = count - 1; i > 0; i--) {
+			j = random() % (i + 1);
+			tmp = order[i];
+			order[i] = order[j];
+			order[j] = tmp;
+		}
+	}
+
+	for (i = 0; i < count; i++) {
+		p = mm->my_addr + (first + (order ? order[i] : i)) * page_size;
+		if (mm->writable) {
+			*p = *p;
+		} else {
+			sink += *p;
+		}
+	}
+
+	free(order);
+}
+
+/** Returns the original process owning the address space of process @a pid, i.e. the one it was cloned from
+ * with CLONE_VM (transitively), so threads share their mappings.
+ */
+
+static int32_t replicate_mm_pid(int32_t pid) {
+	item_t * item;
+
+	if ( (item = hash_table_find(fd_mappings, &pid)) != NULL) {
+		return hash_table_entry(item, process_hash_item_t, item)->mm_pid;
+	}
+	return pid;
+}
+
+/** Returns mapping in the address space of the original process @a pid which contains address @a addr.
+ * @arg pid the original process owning the address space (see replicate_mm_pid())
+ * @arg addr address in the original process
+ * @return the mapping or NULL if there is no such mapping
+ */
+
+mem_map_t * replicate_find_mem_map(int32_t pid, int64_t addr) {
+	item_t * i;
+	mem_map_t * mm;
+
+	for (i = mem_maps.head; i; i = i->next) {
+		mm = list_entry(i, mem_map_t, item);
+		if (mm->pid == pid && addr >= mm->old_addr && addr < mm->old_addr + mm->length) {
+			return mm;
+		}
+	}
+	return NULL;
+}
+
+/** Replicates one mmap(2) call. Only mappings of files are replicated, anonymous ones do not do any IO.
+ * Depending on the touch mode, pages of the new mapping are touched to cause page faults.
+ * @arg op_it operation item structure in which are information about the mmap call
+ * @arg op_mask whether really replicate or just simulate it. ACT_SIMULATE or ACT_REPLICATE.
+ */
+
+void replicate_mmap(mmap_item_t * op_it, int op_mask) {
+	int fd = op_it->o.fd;
+	fd_item_t * fd_item;
+	int myfd;
+	item_t * fd_map;
+	int32_t pid = op_it->o.info.pid;
+	hash_table_t * ht;
+	char * addr;
+	mem_map_t * mm;
+	struct stat st;
+
+	if (op_it->o.retval == -1 || op_it->o.flags & MAP_ANONYMOUS || fd < 0) {
+		return;
+	}
+
+	ht = get_process_ht(fd_mappings, pid);
+
+	if (! ht) {
+		ht = replicate_missing_ht(pid, op_mask);
+		if (! ht) {
+			return;
+		}
+	}
+
+	if ( (fd_map = replicate_get_fd_map(ht, fd, &(op_it->o.info), op_mask)) == NULL) {
+		return;
+	} else {
+		fd_item = hash_table_entry(fd_map, fd_item_t, item);
+		myfd = fd_item->fd_map->my_fd;
+
+		if ( ! supported_type(fd_item->fd_map->type)) {
+			return;
+		}
+
+		if ( ! (op_mask & ACT_REPLICATE)) {
+			return;
+		}
+
+		addr = mmap(NULL, op_it->o.length, op_it->o.prot, op_it->o.flags & ~MAP_FIXED, myfd, op_it->o.offset);
+		if (addr == MAP_FAILED) {
+			ERRORPRINTF("%d: Mmap of fd %d->%d failed: %s\n", pid, fd, myfd, strerror(errno));
+			return;
+		}
+
+		mm = malloc(sizeof(mem_map_t));
+		item_init(&mm->item);
+		mm->pid = replicate_mm_pid(pid);
+		mm->old_addr = op_it->o.retval;
+		mm->my_addr = addr;
+		mm->length = op_it->o.length;
+		mm->writable = (op_it->o.prot & PROT_WRITE) && (op_it->o.flags & MAP_SHARED);
+		mm->touch_len = 0;
+		if (fstat(myfd, &st) == 0 && st.st_size > op_it->o.offset) {
+			mm->touch_len = st.st_size - op_it->o.offset;
+			if (mm->touch_len > mm->length) {
+				mm->touch_len = mm->length;
+			}
+		}
+		list_append(&mem_maps, &mm->item);
+		count_mmaps++;
+
+		if (op_mask & MMAP_TOUCH_SEQ) {
+			replicate_mem_touch(mm, 0, mm->length, 0);
+		} else if (op_mask & MMAP_TOUCH_RANDOM) {
+			replicate_mem_touch(mm, 0, mm->length, 1);
+		}
+	}
+}
+
+/** Replicates one munmap(2), msync(2) or madvise(2) call on the mapping created by replicated mmap call.
+ * In the derived touch mode, ranges passed to msync and madvise are touched first, as the original application
+ * had to access them.
+ * @arg op_it operation item structure in which are information about the call
+ * @arg op_mask whether really replicate or just simulate it. ACT_SIMULATE or ACT_REPLICATE.
+ */
+
+void replicate_mem(mem_item_t * op_it, int op_mask) {
+	mem_map_t * mm;
+	mem_map_t * tail;
+	int64_t off;
+	int64_t len;
+	char * addr;
+	int retval = 0;
+
+	if ( ! (op_mask & ACT_REPLICATE)) {
+		return;
+	}
+
+	if ( (mm = replicate_find_mem_map(replicate_mm_pid(op_it->o.info.pid), op_it->o.addr)) == NULL) { //anonymous or ignored mapping
+		return;
+	}
+
+	off = op_it->o.addr - mm->old_addr;
+	len = op_it->o.length;
+	if (off + len > mm->length) {
+		len = mm->length - off;
+	}
+	addr = mm->my_addr + off;
+
+	switch (op_it->type) {
+		case OP_MUNMAP:
+			retval = munmap(addr, len);
+			if (off == 0 && len == mm->length) { //whole mapping
+				list_remove2(&mm->item);
+				free(mm);
+			} else if (off == 0) { //beginning of the mapping
+				mm->old_addr += len;
+				mm->my_addr += len;
+				mm->length -= len;
+				mm->touch_len = (mm->touch_len > len) ? mm->touch_len - len : 0;
+			} else { //the end or middle of the mapping, the rest after the hole is a mapping of its own
+				if (off + len < mm->length) {
+					tail = malloc(sizeof(mem_map_t));
+					item_init(&tail->item);
+					tail->pid = mm->pid;
+					tail->old_addr = mm->old_addr + off + len;
+					tail->my_addr = mm->my_addr + off + len;
+					tail->length = mm->length - off - len;
+					tail->touch_len = (mm->touch_len > off + len) ? mm->touch_len - off - len : 0;
+					tail->writable = mm->writable;
+					list_append(&mem_maps, &tail->item);
+				}
+				mm->length = off;
+				if (mm->touch_len > off) {
+					mm->touch_len = off;
+				}
+			}
+			break;
+		case OP_MSYNC:
+			if (op_mask & MMAP_TOUCH_DERIVED) {
+				replicate_mem_touch(mm, off, len, 0);
+			}
+			retval = msync(addr, len, op_it->o.flags);
+			break;
+		case OP_MADVISE:
+			if (op_mask & MMAP_TOUCH_DERIVED && op_it->o.flags != MADV_DONTNEED) {
+				replicate_mem_touch(mm, off, len, op_it->o.flags == MADV_RANDOM);
+			}
+			retval = madvise(addr, len, op_it->o.flags);
+			break;
+	}
+
+	if (retval == -1 && retval != op_it->o.retval) {
+		ERRORPRINTF("%d: Call '%c' on mapping 0x%"PRIx64" failed: %s\n", op_it->o.info.pid, op_it->type, op_it->o.addr, strerror(errno));
 	}
 }
 
@@ -294,7 +895,6 @@ void replicate_write(write_item_t * op_it, int op_mask) {
 	int myfd;
 	int32_t pid = op_it->o.info.pid;
 	item_t * fd_map;
-	char * data;
 	hash_table_t * ht;
 
 	ht = get_process_ht(fd_mappings, pid);
@@ -312,35 +912,33 @@ void replicate_write(write_item_t * op_it, int op_mask) {
 		fd_item = hash_table_entry(fd_map, fd_item_t, item);
 		myfd = fd_item->fd_map->my_fd;
 
+		if (fd_item->fd_map->channel) {
+			if (replicate_channel_io(fd_item->fd_map, op_it->o.retval, 1) == -1) {
+				ERRORPRINTF("%d: Write to channel fd %d->%d failed: %s\n", pid, fd, myfd, strerror(errno));
+			}
+			return;
+		}
+
 		mode_t type = fd_item->fd_map->type;
 		if ( ! supported_type(type)) {
 			//DEBUGPRINTF("Unsupported fd (%d -> %d) type: %d\n", fd, myfd, type);
 			return;
 		}
 
-		if (op_it->o.size > MAX_DATA) {
-			data = malloc(op_it->o.size);
-		} else {
-			data = data_buffer;
-		}		
-
 		if (op_mask & ACT_SIMULATE) {
 			retval = op_it->o.retval;
 			if (op_it->o.retval != -1) { //do not take unsuccessfull writes into account
 				simulate_write(fd_item, op_it);
 			}
 		} else if ( op_mask & ACT_REPLICATE) {
-			retval = write(myfd, data_buffer, op_it->o.size);
+			throttle_io(op_it->o.info.pid, op_it->o.size);
+			retval = replicate_do_io(fd_item->fd_map, op_it->o.size, -1, 1);
 		} else {
 			assert(0);
 		}
 
 		fd_item->fd_map->cur_pos += retval; ///< @todo this should be moved to simulate class!
 
-		if ( op_it->o.size > MAX_DATA) {
-			free(data);
-		}
-
 		if (retval == -1) {
 			ERRORPRINTF("Write to original fd %d (myfd: %d), name: %s failed: %s\n", fd, myfd, fd_item->fd_map->name, strerror(errno));
 		} else if (retval != op_it->o.retval) {
@@ -360,7 +958,6 @@ void replicate_pread(pread_item_t * op_it, int op_mask) {
 	fd_item_t * fd_item;
 	int myfd;
 	item_t * fd_map;
-	char * data;
 	int32_t pid = op_it->o.info.pid;
 	hash_table_t * ht;
 
@@ -383,27 +980,21 @@ void replicate_pread(pread_item_t * op_it, int op_mask) {
 			return;
 		}
 		
-		if (op_it->o.size > MAX_DATA) {
-			data = malloc(op_it->o.size);
-		} else {
-			data = data_buffer;
-		}		
-
 		if (op_mask & ACT_SIMULATE) {
 			retval = op_it->o.retval;
 			if (op_it->o.retval != -1) { //do not take unsuccessfull reads into account
 				simulate_pread(fd_item, op_it);
 			}
 		} else if (op_mask & ACT_REPLICATE) {
-			retval = pread(myfd, data_buffer, op_it->o.size, op_it->o.offset);
+			if (op_mask & CACHE_MASK) {
+				pagecache_sample(fd_item->fd_map->name, op_it->o.offset, op_it->o.size);
+			}
+			throttle_io(op_it->o.info.pid, op_it->o.size);
+			retval = replicate_do_io(fd_item->fd_map, op_it->o.size, op_it->o.offset, 0);
 		} else {
 			assert(0);
 		}
 	
-		if ( op_it->o.size > MAX_DATA) {
-			free(data);
-		}
-
 		if (retval == -1 && retval != op_it->o.retval) {
 			ERRORPRINTF("%d: Pread from fd %d->%d failed: %s\n", pid, fd, myfd, strerror(errno));
 //			hash_table_dump2(ht, dump_fd_list_item);
@@ -426,7 +1017,6 @@ void replicate_pwrite(pwrite_item_t * op_it, int op_mask) {
 	int myfd;
 	int32_t pid = op_it->o.info.pid;
 	item_t * fd_map;
-	char * data;
 	hash_table_t * ht;
 
 	ht = get_process_ht(fd_mappings, pid);
@@ -449,29 +1039,20 @@ void replicate_pwrite(pwrite_item_t * op_it, int op_mask) {
 			return;
 		}
 
-		if (op_it->o.size > MAX_DATA) {
-			data = malloc(op_it->o.size);
-		} else {
-			data = data_buffer;
-		}		
-
 		if (op_mask & ACT_SIMULATE) {
 			retval = op_it->o.retval;
 			if (op_it->o.retval != -1) { //do not take unsuccessfull writes into account
 				simulate_pwrite(fd_item, op_it);
 			}
 		} else if ( op_mask & ACT_REPLICATE) {
-			retval = pwrite(myfd, data_buffer, op_it->o.size, op_it->o.offset);
+			throttle_io(op_it->o.info.pid, op_it->o.size);
+			retval = replicate_do_io(fd_item->fd_map, op_it->o.size, op_it->o.offset, 1);
 		} else {
 			assert(0);
 		}
 
-		if ( op_it->o.size > MAX_DATA) {
-			free(data);
-		}
-
 		if (retval == -1) {
-			ERRORPRINTF("Pwrite to fd %d failed: %s\n", fd, strerror(errno));
+			ERRORPRINTF("Pwrite to fd %d->%d failed: %s\n", fd, myfd, strerror(errno));
 		} else if (retval != op_it->o.retval) {
 			DEBUGPRINTF("Warning, %"PRIi64" bytes were successfully outputed (%"PRIi64" expected)\n", retval, op_it->o.retval);
 		}
@@ -479,19 +1060,51 @@ void replicate_pwrite(pwrite_item_t * op_it, int op_mask) {
 }
 
 
+int32_t next_pipe_fd = INT_MAX; /** placeholder fds of pipes are counted down from here */
+int32_t next_socket_fd = 100000000+1; /** placeholder fds of sockets are counted down from here */
+
 inline int32_t get_pipe_fd() {
-	static int32_t fd = INT_MAX;
-	fd--;
-	return fd;
+	next_pipe_fd--;
+	return next_pipe_fd;
 }
 
 inline int32_t get_socket_fd() {
-	static int32_t fd = 100000000+1;
-	fd--;
-	return fd;
+	next_socket_fd--;
+	return next_socket_fd;
+}
+
+/** Creates a real pipe or socketpair for replicate_pipe(). Both ends are non-blocking and the buffer is enlarged
+ * to REPLICATE_CHANNEL_SIZE (if allowed), so the data of a producer that got ahead of its consumer in the trace fits in.
+ *
+ * @arg fds array where to store the two ends
+ * @arg is_socket whether to create socketpair or pipe
+ * @return 0 on success, -1 on error
+ */
+
+static int replicate_channel_create(int fds[2], int is_socket) {
+	int size = REPLICATE_CHANNEL_SIZE;
+
+	if (is_socket) {
+		if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds) == -1) {
+			return -1;
+		}
+		setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+		setsockopt(fds[1], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+	} else {
+		if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) == -1) {
+			return -1;
+		}
+#ifdef F_SETPIPE_SZ
+		fcntl(fds[0], F_SETPIPE_SZ, size);
+#endif
+	}
+	count_channel_fds += 2;
+	return 0;
 }
 
-/** Replicates one pipe(2) operation. It actually does not call pipe syscall, but just keep track of fds.
+/** Replicates one pipe(2)/pipe2(2)/socketpair(2) operation. Unless PIPE_CHANNELS is set, it actually does not call
+ * pipe syscall, but just keep track of fds. With PIPE_CHANNELS, a real channel is created when replicating and
+ * reads and writes on its ends transfer the recorded amount of data.
  * @arg op_it operation item structure in which are information about the open/creat operation
  */
 
@@ -502,6 +1115,13 @@ void replicate_pipe(pipe_item_t * op_it, int op_mask) {
 	fd_item_t * fd_item;;
 	int32_t fd1 = op_it->o.fd1;
 	int32_t fd2 = op_it->o.fd2;
+	int is_socket = op_it->type == OP_SOCKETPAIR;
+	int cloexec = 0;
+	int channel[2] = {-1, -1};
+
+#ifdef O_CLOEXEC
+	cloexec = (op_it->o.mode & O_CLOEXEC) != 0;
+#endif
 
 	if (retval == -1) { //original open call failed, don't do anything
 		DEBUGPRINTF("Original pipe(2) call failed, skipping%s", "\n");
@@ -518,21 +1138,37 @@ void replicate_pipe(pipe_item_t * op_it, int op_mask) {
 	}
 
 	if ( hash_table_find(ht, &fd1) == NULL && hash_table_find(ht, &fd2) == NULL ) { //we didn't open any fd before
+		if ((op_mask & ACT_REPLICATE) && (op_mask & PIPE_CHANNELS) && replicate_channel_create(channel, is_socket) == -1) {
+			ERRORPRINTF("%d: Can not create %s, using placeholder fds: %s\n", pid, is_socket ? "socketpair" : "pipe", strerror(errno));
+		}
+
 		fd_item = new_fd_item();
-		fd_item->fd_map->my_fd = get_pipe_fd();
-		fd_item->fd_map->type = S_IFIFO;
+		fd_item->fd_map->my_fd = channel[0] != -1 ? channel[0] : is_socket ? get_socket_fd() : get_pipe_fd();
+		fd_item->fd_map->type = is_socket ? S_IFSOCK : S_IFIFO;
+		fd_item->fd_map->channel = channel[0] != -1;
 		fd_item->old_fd = fd1;
+		fd_item->cloexec = cloexec;
 		insert_parent_fd(fd_item, fd1);
 		hash_table_insert(ht, &fd1, &fd_item->item);
-		increase_fd_usage(usage_map, fd1);
+		increase_fd_usage(usage_map, channel[0] != -1 ? channel[0] : fd1);
 
 		fd_item = new_fd_item();
-		fd_item->fd_map->my_fd = get_pipe_fd();
-		fd_item->fd_map->type = S_IFIFO;
+		fd_item->fd_map->my_fd = channel[1] != -1 ? channel[1] : is_socket ? get_socket_fd() : get_pipe_fd();
+		fd_item->fd_map->type = is_socket ? S_IFSOCK : S_IFIFO;
+		fd_item->fd_map->channel = channel[1] != -1;
 		fd_item->old_fd = fd2;
+		fd_item->cloexec = cloexec;
 		insert_parent_fd(fd_item, fd2);
 		hash_table_insert(ht, &fd2, &fd_item->item);
-		increase_fd_usage(usage_map, fd2);
+		increase_fd_usage(usage_map, channel[1] != -1 ? channel[1] : fd2);
+
+		if (channel[0] != -1) {
+			//counted in replicate_channel_create()
+		} else if (is_socket) {
+			count_socket_fds += 2;
+		} else {
+			count_pipe_fds += 2;
+		}
 
 //		DEBUGPRINTF("%d: Pipes %d and %d inserted.\n", pid, fd1, fd2);
 	} else {
@@ -553,6 +1189,7 @@ void replicate_open(open_item_t * op_it, int op_mask) {
 	hash_table_t * ht;
 	int32_t pid = op_it->o.info.pid;
 	fd_item_t * fd_item = new_fd_item();
+	open_op_t sim_op;
 
 	if (fd == -1) { //original open call failed, just replicate it	
 		name = namemap_get_name(op_it->o.name);
@@ -564,10 +1201,9 @@ void replicate_open(open_item_t * op_it, int op_mask) {
 			retval = open(name, flags);
 		} else {
 			if (op_mask & ACT_SIMULATE) {
-				if (name != op_it->o.name) {
-					strcpy(op_it->o.name, name);
-				}
-				simulate_creat(&op_it->o);
+				sim_op = op_it->o;
+				strcpy(sim_op.name, name);
+				simulate_creat(&sim_op);
 			}
 			retval = -1;
 		}
@@ -600,17 +1236,29 @@ void replicate_open(open_item_t * op_it, int op_mask) {
 	if ( hash_table_find(ht, &fd) == NULL ) { //we didn't open this file before
 
 		if (op_mask & ACT_REPLICATE && ! (flags & O_IGNORE) ) { //i should replicate and not ignore it
+			if (op_mask & DIRECT_FORCE && ! (flags & O_DIRECTORY)) {
+				flags |= O_DIRECT;
+			}
 			if (op_it->o.mode == MODE_UNDEF) { //we know, that we don't want to use mode flag at all
 				retval = open(name, flags);
 			} else {
 				retval = open(name, flags, op_it->o.mode);
 			}
-		} else { // ACT_SIMULATE or O_IGNORE
-			if (op_it->o.name != name) {
-				strcpy(op_it->o.name, name);
+			if (retval == -1 && errno == EINVAL && (flags & O_DIRECT)) { //file system doesn't support O_DIRECT
+				DEBUGPRINTF("O_DIRECT not supported for file %s, using buffered IO\n", name);
+				count_direct_fallback++;
+				flags &= ~O_DIRECT;
+				if (op_it->o.mode == MODE_UNDEF) {
+					retval = open(name, flags);
+				} else {
+					retval = open(name, flags, op_it->o.mode);
+				}
 			}
+		} else { // ACT_SIMULATE or O_IGNORE
 			if (op_mask & ACT_SIMULATE && ! (flags & O_IGNORE)) {
-				simulate_creat(&op_it->o);
+				sim_op = op_it->o;
+				strcpy(sim_op.name, name);
+				simulate_creat(&sim_op);
 			}
 			retval = simulate_get_open_fd();
 		}
@@ -625,6 +1273,8 @@ void replicate_open(open_item_t * op_it, int op_mask) {
 			fd_item->fd_map->name[MAX_STRING-1] = 0; //just to make sure it will be terminated
 			fd_item->old_fd = op_it->o.retval;
 			fd_item->fd_map->created = flags & O_CREAT;
+			fd_item->cloexec = (flags & O_CLOEXEC) != 0;
+			fd_item->fd_map->direct = (op_mask & ACT_REPLICATE) && (flags & O_DIRECT);
 
 			insert_parent_fd(fd_item, op_it->o.retval);
 			
@@ -667,11 +1317,14 @@ void replicate_clone(clone_item_t * op_it, int op_mask) {
 
 	item_t * item = new_process_ht(pid);
 	process_hash_item_t * h_it = hash_table_entry(item, process_hash_item_t, item);
+	if (op_it->o.mode & CLONE_VM) { //a thread, it shares mappings of the parent
+		h_it->mm_pid = replicate_mm_pid(op_it->o.info.pid);
+	}
 	if (op_it->o.mode & CLONE_FILES) { //we should have the same FD table
-		free(h_it->ht); //we don't want our own ht, because we just want a pointer to the same list
+		delete_process_table(h_it->ht); //we don't want our own ht, because we just want a pointer to the same list
 		h_it->ht = get_process_ht(fd_mappings, op_it->o.info.pid);
 	} else { //we will just copy FD table
-		free(h_it->ht);
+		delete_process_table(h_it->ht);
 		h_it->ht  = duplicate_process_ht(get_process_ht(fd_mappings, op_it->o.info.pid), usage_map);	
 	}
 
@@ -714,7 +1367,7 @@ void replicate_close(close_item_t * op_it, int op_mask) {
 		myfd = fd_item->fd_map->my_fd;
 	
 		//Maybe it was just a pipe or socket?
-		if ( ! supported_type(fd_item->fd_map->type)) {
+		if ( ! supported_type(fd_item->fd_map->type) && ! fd_item->fd_map->channel) {
 			retval = 0;
 		} else {
 			if (decrease_fd_usage(usage_map, myfd)) { // it was the last one, really close it
@@ -737,7 +1390,7 @@ void replicate_close(close_item_t * op_it, int op_mask) {
 			hash_table_remove(ht, &fd);
 			if (last) {
 				assert(fd_map);
-				free(fd_map); //See comment 4 lines above
+				delete_fd_map(fd_map); //See comment 4 lines above
 			}
 //			DEBUGPRINTF("%d: Mapping of fd: %d->%d removed\n", pid, fd, myfd);
 		}
@@ -745,6 +1398,178 @@ void replicate_close(close_item_t * op_it, int op_mask) {
 	}
 }
 
+/** Closes file descriptors of the process @a pid the same way as close call would do. This is how
+ * the kernel cleans up the fd table on execve and when the last user of the table exits.
+ *
+ * @arg pid process id whose file descriptors should be closed
+ * @arg cloexec_only close only descriptors marked as close-on-exec
+ * @arg op_mask whether really replicate or just simulate it. ACT_SIMULATE or ACT_REPLICATE.
+ */
+
+void replicate_close_fds(int32_t pid, int cloexec_only, int op_mask) {
+	hash_table_t * ht;
+	item_t * cur;
+	fd_item_t * fd_item;
+	close_item_t * close_item;
+	int32_t * fds;
+	int count = 0;
+	int i;
+
+	if ( (ht = get_process_ht(fd_mappings, pid)) == NULL) {
+		return;
+	}
+
+	//collect them first, replicate_close modifies the table
+	for (i = 0; i < ht->entries; i++) {
+		for (cur = ht->entry[i].head; cur != NULL; cur = cur->next) {
+			count++;
+		}
+	}
+	fds = malloc((count + 1) * sizeof(int32_t));
+	count = 0;
+	for (i = 0; i < ht->entries; i++) {
+		for (cur = ht->entry[i].head; cur != NULL; cur = cur->next) {
+			fd_item = hash_table_entry(cur, fd_item_t, item);
+			if ( ! cloexec_only || fd_item->cloexec) {
+				fds[count++] = fd_item->old_fd;
+			}
+		}
+	}
+
+	close_item = new_close_item();
+	close_item->o.info.pid = pid;
+	close_item->o.retval = 0;
+	for (i = 0; i < count; i++) {
+		close_item->o.fd = fds[i];
+		replicate_close(close_item, op_mask);
+	}
+	free(close_item);
+	free(fds);
+}
+
+/** Removes processes from fd_mappings after they have terminated. If no other process shares the
+ * fd table, all its file descriptors are closed and the table is released, so the usage counts of
+ * my file descriptors drop and they are really closed when nobody else uses them.
+ *
+ * @arg pid process id of the terminated process
+ * @arg whole_group remove all processes sharing the fd table with @a pid (i.e. threads of exit_group)
+ * @arg op_mask whether really replicate or just simulate it. ACT_SIMULATE or ACT_REPLICATE.
+ */
+
+void replicate_release_process(int32_t pid, int whole_group, int op_mask) {
+	hash_table_t * ht;
+	item_t * cur;
+	process_hash_item_t * p_item;
+	int32_t * pids;
+	int count = 0;
+	int sharing = 0;
+	int i;
+
+	if ( (ht = get_process_ht(fd_mappings, pid)) == NULL) {
+		return;
+	}
+
+	//tables of missing processes are cloned from the parent one, keep it
+	if ( pid == global_parent_pid || ht == get_process_ht(fd_mappings, global_parent_pid)) {
+		return;
+	}
+
+	for (i = 0; i < fd_mappings->entries; i++) {
+		for (cur = fd_mappings->entry[i].head; cur != NULL; cur = cur->next) {
+			p_item = hash_table_entry(cur, process_hash_item_t, item);
+			if (p_item->ht == ht) {
+				sharing++;
+			}
+		}
+	}
+	pids = malloc(sharing * sizeof(int32_t));
+	if (whole_group) {
+		for (i = 0; i < fd_mappings->entries; i++) {
+			for (cur = fd_mappings->entry[i].head; cur != NULL; cur = cur->next) {
+				p_item = hash_table_entry(cur, process_hash_item_t, item);
+				if (p_item->ht == ht) {
+					pids[count++] = p_item->pid;
+				}
+			}
+		}
+	} else {
+		pids[count++] = pid;
+	}
+
+	if (count == sharing) { //nobody else uses this table
+		replicate_close_fds(pid, 0, op_mask);
+		delete_process_table(ht);
+	}
+
+	for (i = 0; i < count; i++) {
+		delete_process_ht(fd_mappings, pids[i]);
+	}
+	free(pids);
+}
+
+/** Replicates one exit or exit_group operation.
+ * @arg op_it operation item structure in which are information about the exit operation
+ * @arg op_mask whether really replicate or just simulate it. ACT_SIMULATE or ACT_REPLICATE.
+ */
+
+void replicate_exit(exit_item_t * op_it, int op_mask) {
+	replicate_release_process(op_it->o.info.pid, op_it->type == OP_EXIT_GROUP, op_mask);
+}
+
+/** Replicates one execve operation. Successfull execve unshares the fd table and closes all
+ * close-on-exec file descriptors.
+ * @arg op_it operation item structure in which are information about the execve operation
+ * @arg op_mask whether really replicate or just simulate it. ACT_SIMULATE or ACT_REPLICATE.
+ */
+
+void replicate_execve(execve_item_t * op_it, int op_mask) {
+	int32_t pid = op_it->o.info.pid;
+	hash_table_t * ht;
+	item_t * cur;
+	process_hash_item_t * p_item;
+	process_hash_item_t * my_item = NULL;
+	int sharing = 0;
+	int i;
+
+	if (op_it->o.retval != 0) {
+		return;
+	}
+
+	if ( (ht = get_process_ht(fd_mappings, pid)) == NULL) {
+		return;
+	}
+
+	for (i = 0; i < fd_mappings->entries; i++) {
+		for (cur = fd_mappings->entry[i].head; cur != NULL; cur = cur->next) {
+			p_item = hash_table_entry(cur, process_hash_item_t, item);
+			if (p_item->ht == ht) {
+				sharing++;
+				if (p_item->pid == pid) {
+					my_item = p_item;
+				}
+			}
+		}
+	}
+
+	if (sharing > 1) { //the table is shared (CLONE_FILES), get our own copy first
+		my_item->ht = duplicate_process_ht(ht, usage_map);
+	}
+
+	replicate_close_fds(pid, 1, op_mask);
+}
+
+/** Replicates one wait4 operation. The reaped child is removed from fd mappings, in case
+ * its exit was not recorded in the trace.
+ * @arg op_it operation item structure in which are information about the wait operation
+ * @arg op_mask whether really replicate or just simulate it. ACT_SIMULATE or ACT_REPLICATE.
+ */
+
+void replicate_wait(wait_item_t * op_it, int op_mask) {
+	if (op_it->o.retval > 0) {
+		replicate_release_process(op_it->o.retval, 1, op_mask);
+	}
+}
+
 /** Replicates one unlink operation.
  * @arg op_it operation item structure in which are information about the unlink operation
  * @arg op_mask whether really replicate or just simulate it. ACT_SIMULATE or ACT_REPLICATE.
@@ -1134,9 +1959,10 @@ void replicate_dup(dup_item_t * op_it, int op_mask) {
       fd_item = hash_table_entry(it, fd_item_t, item);
 		fd_item_new = new_fd_item();
 		fd_item_new->old_fd = new_fd;
-		free(fd_item_new->fd_map); // we will use the same fd_map as previous fd, because we are just duplicate.
+		delete_fd_map(fd_item_new->fd_map); // we will use the same fd_map as previous fd, because we are just duplicate.
 		fd_item_new->fd_map = fd_item->fd_map;
-		if ( hash_table_find(ht, &fd) != NULL) { //dup2 call can be called on already opened files, they are closed first
+		fd_item_new->cloexec = op_it->type == OP_DUP3 && (op_it->o.flags & O_CLOEXEC);
+		if ( hash_table_find(ht, &new_fd) != NULL) { //dup2 call can be called on already opened files, they are closed first
 			close_item_t * close_item = new_close_item();
 			close_item->o.info.pid = op_it->o.info.pid;
 			close_item->o.fd = new_fd;
@@ -1159,26 +1985,25 @@ void replicate_dup(dup_item_t * op_it, int op_mask) {
 void replicate_access(access_item_t * op_it, int op_mask) {
 	int retval;
 	char * name;
+	access_op_t sim_op;
 
 	name = namemap_get_name(op_it->o.name);
 	if ( name == NULL ) { // I should ignore it
 		return;
-	} else {
-		if (name != op_it->o.name) {
-			strcpy(op_it->o.name, name);
-		}
 	}
 	
 	if (op_mask & ACT_REPLICATE) {
-		retval = access(op_it->o.name, op_it->o.mode);
+		retval = access(name, op_it->o.mode);
 
 		if (retval == -1 && retval != op_it->o.retval) {
-			ERRORPRINTF("Access of file with %s failed (which was not expected): %s\n", op_it->o.name, strerror(errno));
+			ERRORPRINTF("Access of file with %s failed (which was not expected): %s\n", name, strerror(errno));
 		} else if (retval != op_it->o.retval) {
-			ERRORPRINTF("Access result of file %s other than expected: %d\n", op_it->o.name, retval);
+			ERRORPRINTF("Access result of file %s other than expected: %d\n", name, retval);
 		}
 	} else if (op_mask & ACT_SIMULATE) {
-		simulate_access(&op_it->o);
+		sim_op = op_it->o;
+		strcpy(sim_op.name, name);
+		simulate_access(&sim_op);
 	}
 }
 
@@ -1190,30 +2015,148 @@ void replicate_stat(stat_item_t * op_it, int op_mask) {
 	int retval;
 	char * name;
 	struct stat st_buf;
+	stat_op_t sim_op;
 
 	name = namemap_get_name(op_it->o.name);
 	if ( name == NULL ) { // I should ignore it
 		return;
-	} else {
-		if (name != op_it->o.name) {
-			strcpy(op_it->o.name, name);
+	}
+	
+	if (op_mask & ACT_REPLICATE) {
+		retval = stat(name, &st_buf);
+
+		if (retval == -1 && retval != op_it->o.retval) {
+			ERRORPRINTF("Stat on file with %s failed (which was not expected): %s\n", name, strerror(errno));
+		} else if (retval != op_it->o.retval) {
+			ERRORPRINTF("Stat result of file %s other than expected: %d\n", name, retval);
+		}
+	} else if (op_mask & ACT_SIMULATE) {
+		sim_op = op_it->o;
+		strcpy(sim_op.name, name);
+		simulate_stat(&sim_op);
+	}
+}
+
+/** Replicates one rename operation. Both old and new names are translated using the name mapping, the item
+ * itself is left untouched, so the trace can be replayed again.
+ * @arg op_it operation item structure in which are information about the rename operation
+ * @arg op_mask whether really replicate or just simulate it. ACT_SIMULATE or ACT_REPLICATE.
+ */
+
+void replicate_rename(rename_item_t * op_it, int op_mask) {
+	int retval;
+	char * old_name;
+	char * new_name;
+	rename_op_t sim_op;
+
+	old_name = namemap_get_name(op_it->o.old_name);
+	new_name = namemap_get_name(op_it->o.new_name);
+	if ( old_name == NULL || new_name == NULL ) { // I should ignore it
+		return;
+	}
+
+	if (op_mask & ACT_REPLICATE) {
+		retval = rename(old_name, new_name);
+
+		if (retval == -1 && retval != op_it->o.retval) {
+			ERRORPRINTF("Rename of file %s to %s failed (which was not expected): %s\n", old_name, new_name, strerror(errno));
+		} else if (retval != op_it->o.retval) {
+			ERRORPRINTF("Rename result of file %s other than expected: %d\n", old_name, retval);
+		}
+	} else if (op_mask & ACT_SIMULATE) {
+		sim_op = op_it->o;
+		strcpy(sim_op.old_name, old_name);
+		strcpy(sim_op.new_name, new_name);
+		simulate_rename(&sim_op);
+	}
+}
+
+/** Replicates one link or symlink operation. For link(2), both names are translated using the name mapping.
+ * For symlink(2), the target is translated only if there is a mapping for it, as it does not have to exist
+ * at all.
+ *
+ * @arg op_it operation item structure in which are information about the link operation
+ * @arg op_mask whether really replicate or just simulate it. ACT_SIMULATE or ACT_REPLICATE.
+ */
+
+void replicate_link(link_item_t * op_it, int op_mask) {
+	int retval;
+	char * old_name;
+	char * new_name;
+	link_op_t sim_op;
+
+	old_name = namemap_get_name(op_it->o.old_name);
+	new_name = namemap_get_name(op_it->o.new_name);
+	if ( new_name == NULL ) { // I should ignore it
+		return;
+	}
+	if ( old_name == NULL ) {
+		if ( op_it->type == OP_LINK ) { // the source is ignored, so ignore the link as well
+			return;
+		}
+		old_name = op_it->o.old_name;
+	}
+
+	if (op_mask & ACT_REPLICATE) {
+		if (op_it->type == OP_SYMLINK) {
+			retval = symlink(old_name, new_name);
+		} else {
+			retval = link(old_name, new_name);
+		}
+
+		if (retval == -1 && retval != op_it->o.retval) {
+			ERRORPRINTF("Link of file %s to %s failed (which was not expected): %s\n", new_name, old_name, strerror(errno));
+		} else if (retval != op_it->o.retval) {
+			ERRORPRINTF("Link result of file %s other than expected: %d\n", new_name, retval);
+		}
+	} else if (op_mask & ACT_SIMULATE) {
+		sim_op = op_it->o;
+		strcpy(sim_op.old_name, old_name);
+		strcpy(sim_op.new_name, new_name);
+		if (op_it->type == OP_SYMLINK) {
+			simulate_symlink(&sim_op);
+		} else {
+			simulate_link(&sim_op);
 		}
 	}
+}
+
+/** Replicates one readlink operation.
+ * @arg op_it operation item structure in which are information about the readlink operation
+ * @arg op_mask whether really replicate or just simulate it. ACT_SIMULATE or ACT_REPLICATE.
+ */
+
+void replicate_readlink(readlink_item_t * op_it, int op_mask) {
+	int64_t retval;
+	char * name;
+	int64_t size = op_it->o.size;
+	readlink_op_t sim_op;
+
+	name = namemap_get_name(op_it->o.name);
+	if ( name == NULL ) { // I should ignore it
+		return;
+	}
+
+	if (size > MAX_DATA) {
+		size = MAX_DATA;
+	}
 	
 	if (op_mask & ACT_REPLICATE) {
-		retval = stat(op_it->o.name, &st_buf);
+		retval = readlink(name, data_buffer, size);
 
 		if (retval == -1 && retval != op_it->o.retval) {
-			ERRORPRINTF("Stat on file with %s failed (which was not expected): %s\n", op_it->o.name, strerror(errno));
+			ERRORPRINTF("Readlink of file %s failed (which was not expected): %s\n", name, strerror(errno));
 		} else if (retval != op_it->o.retval) {
-			ERRORPRINTF("Stat result of file %s other than expected: %d\n", op_it->o.name, retval);
+			DEBUGPRINTF("Readlink result of file %s other than expected: %"PRIi64" (expected: %"PRIi64")\n", name, retval, op_it->o.retval);
 		}
 	} else if (op_mask & ACT_SIMULATE) {
-		simulate_stat(&op_it->o);
+		sim_op = op_it->o;
+		strcpy(sim_op.name, name);
+		simulate_readlink(&sim_op);
 	}
 }
 
-/** Replicates one socket(2) operation. It just keep tracks track of fd_mapping, no actual socket
+/** Replicates one socket(2), eventfd(2), epoll_create(2) or timerfd_create(2) operation. It just keep tracks track of fd_mapping, no actual socket
  * calls are performed.
  *
  * @arg op_it operation item structure in which are information about the open/creat operation
@@ -1241,13 +2184,21 @@ void replicate_socket(socket_item_t * op_it, int op_mask) {
 
 	if ( hash_table_find(ht, &fd) == NULL ) { //we didn't open this file before
 		fd_item_t * fd_item = new_fd_item();	
-		retval = get_socket_fd();
+
+		if (op_it->type == OP_SOCKET) {
+			retval = get_socket_fd();
+			fd_item->fd_map->type = S_IFSOCK;
+			count_socket_fds++;
+		} else { //eventfd, epoll and timerfd are just read/written like a pipe
+			retval = get_pipe_fd();
+			fd_item->fd_map->type = S_IFIFO;
+			count_anon_fds++;
+		}
 
 		fd_item->fd_map->my_fd = retval;
 		fd_item->old_fd = fd;
 		fd_item->fd_map->time_open = op_it->o.info.start;
 		fd_item->fd_map->name[MAX_STRING-1] = 0; //just to make sure it will be terminated
-		fd_item->fd_map->type = S_IFSOCK;
 		insert_parent_fd(fd_item, op_it->o.retval);
 		hash_table_insert(ht, &fd, &fd_item->item);
 		increase_fd_usage(usage_map, retval);
@@ -1295,6 +2246,15 @@ int replicate_init(int32_t pid, int cpu, char * ifilename, char * mfilename) {
 	//Init usage_map
 	hash_table_init(usage_map, HASH_TABLE_SIZE, &ht_ops_fdusage);
 
+	list_init(&mem_maps);
+
+	//the trace may be replayed more times (e.g. simulation pass before the replay)
+	count_pipe_fds = count_socket_fds = count_anon_fds = count_missing_fds = 0;
+	count_unaligned_io = count_unaligned_writes = count_direct_fallback = 0;
+	count_channel_fds = count_channel_bytes = count_channel_stalls = 0;
+	count_mmaps = 0;
+	fdmap_mem_peak = fdmap_mem;
+	memset(&replay_stats, 0, sizeof(replay_stats));
 
 	//create a new ht for the process
 	DEBUGPRINTF("Initializing with pid %d\n", pid);
@@ -1342,6 +2302,7 @@ int replicate_init(int32_t pid, int cpu, char * ifilename, char * mfilename) {
 	gettimeofday(&start_time, NULL);
 	DEBUGPRINTF("Time elapsed so far: %lf\n", TIMEVAL_DIFF(start_time, global_start)/1000000.0);
 #endif
+	getrusage(RUSAGE_SELF, &start_rusage);
 	
 	global_devnull_fd = open("/dev/null", O_WRONLY);
 	if ( global_devnull_fd == -1 ) {
@@ -1364,14 +2325,49 @@ int replicate_init(int32_t pid, int cpu, char * ifilename, char * mfilename) {
 void replicate_finish() {
 //	item_t * i;
 //	process_hash_item_t * process_ht_item;
+	item_t * i;
+	mem_map_t * mm;
 
 #ifndef PY_MODULE	
 	struct timeval cur_time;
+	struct rusage usage;
 	gettimeofday(&cur_time, NULL);
+	getrusage(RUSAGE_SELF, &usage);
 	DEBUGPRINTF("The replication itself lasted for %lf\n", TIMEVAL_DIFF(cur_time, start_time)/(1000000.0));
-	fprintf(stdout, "Result: %lf\n", TIMEVAL_DIFF(cur_time, start_time)/(1000000.0));
+	replay_stats.duration = TIMEVAL_DIFF(cur_time, start_time)/(1000000.0);
+	if ( ! global_quiet ) {
+		fprintf(stdout, "Result: %lf\n", TIMEVAL_DIFF(cur_time, start_time)/(1000000.0));
+		fprintf(stdout, "Reads and writes: %"PRIi64" calls, %"PRIi64" bytes, mean latency %.1lfus\n", replay_stats.io_calls,
+				replay_stats.io_bytes, replay_stats.io_calls ? replay_stats.io_time / 1000.0 / replay_stats.io_calls : 0.0);
+		if (count_mmaps) {
+			fprintf(stdout, "Page faults: %ld major, %ld minor (%"PRIi64" file mappings)\n",
+					usage.ru_majflt - start_rusage.ru_majflt, usage.ru_minflt - start_rusage.ru_minflt, count_mmaps);
+		}
+		fprintf(stdout, "Peak fd map memory: %"PRIi64" bytes\n", fdmap_mem_peak);
+		fprintf(stdout, "Placeholder fds: %"PRIi64" pipes, %"PRIi64" sockets, %"PRIi64" eventfd/epoll/timerfd\n",
+				count_pipe_fds, count_socket_fds, count_anon_fds);
+		if (count_channel_fds) {
+			fprintf(stdout, "Pipe channels: %"PRIi64" fds, %"PRIi64" bytes written and read, %"PRIi64" stalled calls\n",
+					count_channel_fds, count_channel_bytes, count_channel_stalls);
+		}
+		fprintf(stdout, "Missing fds opened as UNKNOWN_FILE: %"PRIi64"\n", count_missing_fds);
+		fprintf(stdout, "Direct IO: %"PRIi64" unaligned reads rounded to %d bytes, %"PRIi64" unaligned writes buffered, "
+				"%"PRIi64" files fell back to buffered IO\n", count_unaligned_io, BUFPOOL_ALIGN, count_unaligned_writes,
+				count_direct_fallback);
+		bufpool_report();
+	}
 #endif
 
+	i = mem_maps.head;
+	while (i) {
+		mm = list_entry(i, mem_map_t, item);
+		i = i->next;
+		munmap(mm->my_addr, mm->length);
+		free(mm);
+	}
+	list_init(&mem_maps);
+
+	bufpool_finish();
 	namemap_finish();
 
 ///< @todo get rid of process_map_hts & fd_maps & fd_mappings hashmap. This is tricky, as they are shared across processes,
@@ -1388,12 +2384,27 @@ void replicate_finish() {
 
 }
 
+/** Determines the clock rate used for timing of the calls, if the timing mode needs it and it was not 
+ * determined yet. It takes a second, so it is done only once, before processes replaying clones are forked.
+ *
+ * @arg op_mask mode of replication
+ */
+
+void replicate_clock_init(int op_mask) {
+	if ( (op_mask & ACT_REPLICATE) && ! (op_mask & TIME_ASAP) && clock_rate == 0) {
+		fprintf(stderr, "Determining clock rate..");
+		clock_rate = get_clock_rate();
+		fprintf(stderr, ": %lfMHz\n", (double)(clock_rate)/1000000.0);
+	}	
+}
+
 /** This function replicates every file operation in the @a list.
  * @arg list list of operations to replicate
  * @arg cpu cpu number to bind this process.
  * @arg scale factor by which to scale time window between calls in TIME_DIFF mode
  * @arg op_mask mode of replication, it can only simulate replication or really duplicate.
- *              This also affects timing behaviour.
+ *              This also affects timing behaviour. With FILTER_MARK, operations out of the slice
+ *              (see filter.h) are remembered, so they can be removed by filter_apply().
  * @arg ifile name of the file containing file names to ignore. NULL to disable this feature.     
  * @arg mfile name of the file containing mapping of file names. Operation will be performed 
  *      on mapped file instead of the recorded one. NULL to disable this feature.     
@@ -1423,21 +2434,49 @@ int replicate(list_t * list, int cpu, double scale, int op_mask, char * ifilenam
 	stat_item_t * stat_it;
 	socket_item_t * socket_it;
 	sendfile_item_t * sendfile_it;
+	rename_item_t * rename_it;
+	link_item_t * link_it;
+	readlink_item_t * readlink_it;
+	getdents_item_t * getdents_it;
+	mmap_item_t * mmap_it;
+	mem_item_t * mem_it;
+	exit_item_t * exit_it;
+	execve_item_t * execve_it;
+	wait_item_t * wait_it;
 	uint64_t last_call_orig; ///< when was the last original call made
 	uint64_t first_call_orig; ///< when was the first original call made
 	int64_t diff_orig, diff_real;
 	int64_t diff;
 	uint64_t counter_first, counter_last, counter_real;
+	int filter;
+	int slice_started = 0; ///< whether the first operation of the slice was done
+	int64_t ignored;
+	uint64_t last_done_orig = 0; ///< when was the last replayed call made originally
+	int resumed = 0;
+	const char * resume;
+	int64_t resume_index;
 
 	if ( ! (op_mask & FIX_MISSING) ) {
 		global_fix_missing = 0;	
 	}
 
-	if ( (op_mask & ACT_REPLICATE) && ! (op_mask & TIME_ASAP) ) {
-		fprintf(stderr, "Determining clock rate..");
-		clock_rate = get_clock_rate();
-		fprintf(stderr, ": %lfMHz\n", (double)(clock_rate)/1000000.0);
-	}	
+	replicate_clock_init(op_mask);
+
+	bufpool_init(op_mask & BUF_HUGEPAGES);
+	filter_start(op_mask & FILTER_MARK);
+
+	if ( (op_mask & ACT_REPLICATE) && (resume = checkpoint_get_resume()) != NULL ) {
+		if ( replicate_init(0, cpu, ifilename, mfilename) || checkpoint_restore(resume, &resume_index, &last_done_orig) ) {
+			return -1;
+		}
+		while (item && i < resume_index) { //skip operations done before the checkpoint
+			item = item->next;
+			i++;
+		}
+		last_call_orig = first_call_orig = last_done_orig;
+		counter_first = counter_last = rdtsc();
+		resumed = 1;
+	}
 
 	while (item) { 
 		i++;
@@ -1471,6 +2510,7 @@ int replicate(list_t * list, int cpu, double scale, int op_mask, char * ifilenam
 				REPLICATE(llseek);
 				break;
 			case OP_CLONE:
+				filter_clone((clone_item_t *) com_it);
 				REPLICATE(clone);
 				break;
 			case OP_MKDIR:
@@ -1485,6 +2525,7 @@ int replicate(list_t * list, int cpu, double scale, int op_mask, char * ifilenam
 				REPLICATE(dup);
 				break;
 			case OP_PIPE:
+			case OP_SOCKETPAIR:
 				REPLICATE(pipe);
 				break;
 			case OP_ACCESS:
@@ -1494,17 +2535,57 @@ int replicate(list_t * list, int cpu, double scale, int op_mask, char * ifilenam
 				REPLICATE(stat);
 				break;
 			case OP_SOCKET:
+			case OP_EVENTFD:
+			case OP_EPOLL:
+			case OP_TIMERFD:
 				REPLICATE(socket);
 				break;
 			case OP_SENDFILE:
 				REPLICATE(sendfile);
 				break;
+			case OP_RENAME:
+				REPLICATE(rename);
+				break;
+			case OP_LINK:
+			case OP_SYMLINK:
+				REPLICATE(link);
+				break;
+			case OP_READLINK:
+				REPLICATE(readlink);
+				break;
+			case OP_GETDENTS:
+				REPLICATE(getdents);
+				break;
+			case OP_MMAP:
+				REPLICATE(mmap);
+				break;
+			case OP_MUNMAP:
+			case OP_MSYNC:
+			case OP_MADVISE:
+				REPLICATE(mem);
+				break;
+			case OP_EXIT:
+			case OP_EXIT_GROUP:
+				REPLICATE(exit);
+				break;
+			case OP_EXECVE:
+				REPLICATE(execve);
+				break;
+			case OP_WAIT:
+				REPLICATE(wait);
+				break;
 			default:
 				ERRORPRINTF("Unknown operation identifier: '%c'\n", com_it->type);
 				return -1;
 				break;
 		}
 		item = item->next;
+		if ( (op_mask & ACT_REPLICATE) && checkpoint_due(i) ) {
+			checkpoint_save(i, last_done_orig);
+		}
+		if ( (op_mask & ACT_REPLICATE) && coord_due(i) ) {
+			coord_tick();
+		}
 	}
 	replicate_finish();
 	return 0;
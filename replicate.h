@@ -28,6 +28,27 @@
 #define O_IGNORE 020000000000  //31st bit
 #define S_IFIGNORE ((1 << 30)-1) // first 30 bits are 1
 
+#define REPLICATE_CHANNEL_SIZE (1 << 20) ///< requested buffer size of pipes and socketpairs created for PIPE_CHANNELS
+#define REPLAY_HIST_BUCKETS 40 ///< latency histogram buckets, bucket b holds latencies from 2^(b-1) to 2^b ns
+
+/** Statistics of replayed reads and writes. */
+typedef struct replay_stats {
+	int64_t io_calls; ///< number of reads and writes
+	int64_t io_bytes; ///< bytes read and written
+	uint64_t io_time; ///< total time spent in the calls, in ns
+	uint64_t io_max; ///< the longest call, in ns
+	int64_t hist[REPLAY_HIST_BUCKETS]; ///< log2 histogram of call latencies
+	double duration; ///< duration of the whole replay, in seconds
+} replay_stats_t;
+
+extern int global_quiet;
+extern replay_stats_t replay_stats;
+extern double global_speedup;
+
+void replay_stats_add(replay_stats_t * stats, int64_t bytes, uint64_t lat);
+void replay_stats_merge(replay_stats_t * total, replay_stats_t * stats);
+uint64_t replay_stats_percentile(replay_stats_t * stats, double p);
+void replicate_clock_init(int op_mask);
 int replicate(list_t * list, int cpu, double scale, int sim_mode, char * ifile, char * mfile);
 void replicate_clone(clone_item_t * op_it, int op_mask);
 void replicate_open(open_item_t * op_it, int op_mask);
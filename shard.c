@@ -0,0 +1,841 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <inttypes.h>
+
+#include "common.h"
+#include "shard.h"
+#include "merge.h"
+
+int shard_count = 0; ///< number of shards, 0 = splitting not enabled
+int shard_mode = SHARD_TREE;
+hash_table_t shard_procs;
+hash_table_t shard_paths;
+shard_proc_t ** shard_proc_list = NULL; ///< processes in the order of their creation
+int32_t shard_nprocs = 0;
+int32_t shard_procs_size = 0;
+
+/** Units joined by union-find, work of units and shards of their representatives. */
+int32_t * shard_uf = NULL;
+int64_t * shard_weight = NULL;
+int32_t * shard_of = NULL;
+int32_t shard_nunits = 0;
+int32_t shard_units_size = 0;
+
+/** Unit and process of every call of the trace, by its position. */
+int32_t * shard_item_units = NULL;
+shard_proc_t ** shard_item_procs = NULL;
+
+FILE * shard_files[SHARD_MAX];
+char shard_names[SHARD_MAX][MAX_STRING];
+shard_stats_t shard_stats[SHARD_MAX];
+int64_t shard_first = -1; ///< start of the trace in usec
+int64_t shard_copied = 0; ///< calls written to more shards
+
+static int ht_compare_shard_proc(key_t *key, item_t *item) {
+	return hash_table_entry(item, shard_proc_t, item)->pid == *key;
+}
+
+static int ht_compare_shard_path(key_t *key, item_t *item) {
+	return ! strncmp(hash_table_entry(item, shard_path_t, item)->name, (char *) key, MAX_STRING);
+}
+
+static void shard_put_fds(shard_fds_t * fds) {
+	if (fds && --fds->refs == 0) {
+		free(fds->units);
+		free(fds);
+	}
+}
+
+static void shard_put_maps(shard_maps_t * maps) {
+	if (maps && --maps->refs == 0) {
+		free(maps->regions);
+		free(maps);
+	}
+}
+
+static void ht_remove_callback_shard_proc(item_t * item) {
+	shard_proc_t * p = hash_table_entry(item, shard_proc_t, item);
+
+	shard_put_fds(p->fds);
+	shard_put_maps(p->maps);
+	free(p);
+}
+
+static void ht_remove_callback_shard_path(item_t * item) {
+	free(hash_table_entry(item, shard_path_t, item));
+}
+
+static hash_table_operations_t ht_ops_shard_proc = {
+	.hash = ht_hash_int,
+	.compare = ht_compare_shard_proc,
+	.remove_callback = ht_remove_callback_shard_proc
+};
+
+static hash_table_operations_t ht_ops_shard_path = {
+	.hash = ht_hash_str,
+	.compare = ht_compare_shard_path,
+	.remove_callback = ht_remove_callback_shard_path
+};
+
+/** Enables splitting.
+ *
+ * @arg spec <n>[:tree|files], number of shards and how the trace is split (by process trees by default)
+ * @return 0 on success, -1 on error
+ */
+
+int shard_init(const char * spec) {
+	char * end;
+	long n = strtol(spec, &end, 10);
+
+	if (end == spec || n < 1 || n > SHARD_MAX) {
+		ERRORPRINTF("Number of shards has to be between 1 and %d: %s\n", SHARD_MAX, spec);
+		return -1;
+	}
+	shard_mode = SHARD_TREE;
+	if (*end == ':') {
+		if ( ! strcmp(end + 1, SHARD_FILES_STR)) {
+			shard_mode = SHARD_FILES;
+		} else if (strcmp(end + 1, SHARD_TREE_STR)) {
+			ERRORPRINTF("Unknown sharding mode: %s\n", end + 1);
+			return -1;
+		}
+	} else if (*end) {
+		return -1;
+	}
+	shard_count = n;
+	return 0;
+}
+
+int shard_enabled() {
+	return shard_count > 0;
+}
+
+static inline int64_t shard_usec(struct int32timeval t) {
+	return (int64_t) t.tv_sec * 1000000 + t.tv_usec;
+}
+
+static int32_t shard_new_unit() {
+	if (shard_nunits == shard_units_size) {
+		shard_units_size = shard_units_size ? 2 * shard_units_size : 1024;
+		shard_uf = realloc(shard_uf, shard_units_size * sizeof(int32_t));
+		shard_weight = realloc(shard_weight, shard_units_size * sizeof(int64_t));
+	}
+	shard_uf[shard_nunits] = shard_nunits;
+	shard_weight[shard_nunits] = 0;
+	return shard_nunits++;
+}
+
+static int32_t shard_find(int32_t unit) {
+	while (shard_uf[unit] != unit) {
+		shard_uf[unit] = shard_uf[shard_uf[unit]];
+		unit = shard_uf[unit];
+	}
+	return unit;
+}
+
+static void shard_union(int32_t a, int32_t b) {
+	if (a < 0 || b < 0) {
+		return;
+	}
+	a = shard_find(a);
+	b = shard_find(b);
+	if (a < b) {
+		shard_uf[b] = a;
+	} else if (b < a) {
+		shard_uf[a] = b;
+	}
+}
+
+/** @return names of @a com_it which are paths the call depends on (see get_item_names()) */
+
+static int shard_item_names(common_op_item_t * com_it, char ** names) {
+	int n = get_item_names(com_it, names);
+
+	if (com_it->type == OP_EXECVE) { //belongs to the process
+		return 0;
+	} else if (com_it->type == OP_SYMLINK) { //the target is just a string
+		names[0] = names[1];
+		return 1;
+	}
+	return n;
+}
+
+static shard_path_t * shard_find_path(const char * name) {
+	item_t * item;
+
+	if ( (item = hash_table_find(&shard_paths, (key_t *) name)) == NULL) {
+		return NULL;
+	}
+	return hash_table_entry(item, shard_path_t, item);
+}
+
+static shard_path_t * shard_get_path(const char * name) {
+	shard_path_t * path;
+
+	if ( (path = shard_find_path(name)) != NULL) {
+		return path;
+	}
+	path = calloc(1, sizeof(shard_path_t));
+	item_init(&path->item);
+	strncpy(path->name, name, MAX_STRING);
+	path->name[MAX_STRING-1] = 0;
+	path->unit = shard_new_unit();
+	hash_table_insert(&shard_paths, (key_t *) path->name, &path->item);
+	return path;
+}
+
+static shard_proc_t * shard_new_proc(int32_t pid, shard_proc_t * parent, int files) {
+	shard_proc_t * p = calloc(1, sizeof(shard_proc_t));
+	int32_t i;
+
+	item_init(&p->item);
+	p->pid = pid;
+	p->parent = parent;
+	if (shard_mode == SHARD_TREE) {
+		p->unit = parent && parent->pid != MERGE_INIT_PID ? parent->unit : shard_new_unit();
+	} else if (parent && files) { //threads share descriptors and memory
+		p->fds = parent->fds;
+		p->fds->refs++;
+		p->maps = parent->maps;
+		p->maps->refs++;
+	} else {
+		p->fds = calloc(1, sizeof(shard_fds_t));
+		p->fds->refs = 1;
+		p->maps = calloc(1, sizeof(shard_maps_t));
+		p->maps->refs = 1;
+		if (parent) {
+			p->fds->size = parent->fds->size;
+			p->fds->units = malloc(p->fds->size * sizeof(int32_t));
+			memcpy(p->fds->units, parent->fds->units, p->fds->size * sizeof(int32_t));
+			p->maps->size = p->maps->count = parent->maps->count;
+			p->maps->regions = malloc(p->maps->size * sizeof(shard_region_t));
+			memcpy(p->maps->regions, parent->maps->regions, p->maps->count * sizeof(shard_region_t));
+		}
+	}
+	if (pid == MERGE_INIT_PID) { //init of a merged trace exists in all shards
+		for (i = 0; i < shard_count; i++) {
+			p->started |= (uint64_t) 1 << i;
+		}
+	}
+	hash_table_insert(&shard_procs, &p->pid, &p->item);
+	if (shard_nprocs == shard_procs_size) {
+		shard_procs_size = shard_procs_size ? 2 * shard_procs_size : 1024;
+		shard_proc_list = realloc(shard_proc_list, shard_procs_size * sizeof(shard_proc_t *));
+	}
+	shard_proc_list[shard_nprocs++] = p;
+	return p;
+}
+
+static shard_proc_t * shard_find_proc(int32_t pid) {
+	item_t * item;
+	key_t key = pid;
+
+	if ( (item = hash_table_find(&shard_procs, &key)) == NULL) {
+		return NULL;
+	}
+	return hash_table_entry(item, shard_proc_t, item);
+}
+
+static shard_proc_t * shard_get_proc(int32_t pid) {
+	shard_proc_t * p;
+
+	if ( (p = shard_find_proc(pid)) != NULL) {
+		return p;
+	}
+	return shard_new_proc(pid, NULL, 0);
+}
+
+static int32_t shard_fd_unit(shard_proc_t * p, int32_t fd) {
+	if (fd < 0 || fd >= p->fds->size) {
+		return SHARD_HOME;
+	}
+	return p->fds->units[fd];
+}
+
+static void shard_set_fd(shard_proc_t * p, int32_t fd, int32_t unit) {
+	shard_fds_t * fds = p->fds;
+	int32_t i;
+
+	if (fd < 0) {
+		return;
+	}
+	if (fd >= fds->size) {
+		i = fds->size;
+		fds->size = fd + 16;
+		fds->units = realloc(fds->units, fds->size * sizeof(int32_t));
+		for ( ; i < fds->size; i++) {
+			fds->units[i] = SHARD_HOME;
+		}
+	}
+	fds->units[fd] = unit;
+}
+
+static void shard_add_region(shard_proc_t * p, int64_t addr, int64_t length, int32_t unit) {
+	shard_maps_t * maps = p->maps;
+
+	if (maps->count == maps->size) {
+		maps->size = maps->size ? 2 * maps->size : 16;
+		maps->regions = realloc(maps->regions, maps->size * sizeof(shard_region_t));
+	}
+	maps->regions[maps->count].addr = addr;
+	maps->regions[maps->count].length = length;
+	maps->regions[maps->count].unit = unit;
+	maps->count++;
+}
+
+/** @return unit of the newest mapping containing @a addr */
+
+static int32_t shard_region_unit(shard_proc_t * p, int64_t addr) {
+	shard_region_t * r;
+	int32_t i;
+
+	for (i = p->maps->count - 1; i >= 0; i--) {
+		r = &p->maps->regions[i];
+		if (addr >= r->addr && addr < r->addr + r->length) {
+			return r->unit;
+		}
+	}
+	return SHARD_HOME;
+}
+
+/** Finds out which paths are changed and which are directories created, removed or renamed in the trace. */
+
+static void shard_scan_paths(list_t * list) {
+	common_op_item_t * com_it;
+	item_t * item;
+	char * names[2];
+	int i, n, flags;
+
+	for (item = list->head; item; item = item->next) {
+		com_it = list_entry(item, common_op_item_t, item);
+		n = shard_item_names(com_it, names);
+		switch (com_it->type) {
+			case OP_OPEN:
+				flags = ((open_item_t *) com_it)->o.flags & (O_WRONLY | O_RDWR | O_CREAT | O_TRUNC) ? SHARD_MODIFIED : 0;
+				break;
+			case OP_MKDIR:
+			case OP_RMDIR:
+			case OP_RENAME:
+				flags = SHARD_MODIFIED | SHARD_STRUCTURAL;
+				break;
+			case OP_UNLINK:
+			case OP_LINK:
+			case OP_SYMLINK:
+				flags = SHARD_MODIFIED;
+				break;
+			default:
+				flags = 0;
+				break;
+		}
+		for (i = 0; i < n; i++) {
+			shard_get_path(names[i])->flags |= flags;
+		}
+	}
+}
+
+/** Joins path @a item with directories above it which are created, removed or renamed in the trace. */
+
+static void shard_join_dirs(item_t * item) {
+	shard_path_t * path = hash_table_entry(item, shard_path_t, item);
+	shard_path_t * dir;
+	char buf[MAX_STRING];
+	char * slash;
+
+	if (path->flags & SHARD_MODIFIED) {
+		path->flags |= SHARD_BOUND;
+	}
+	strncpy(buf, path->name, MAX_STRING);
+	buf[MAX_STRING-1] = 0;
+	while ( (slash = strrchr(buf, '/')) != NULL && slash != buf) {
+		*slash = 0;
+		if ( (dir = shard_find_path(buf)) != NULL && (dir->flags & SHARD_STRUCTURAL)) {
+			shard_union(path->unit, dir->unit);
+			path->flags |= SHARD_BOUND;
+		}
+	}
+}
+
+/** @return unit of @a com_it of process @a p when splitting by process trees */
+
+static int32_t shard_tree_unit(shard_proc_t * p, common_op_item_t * com_it) {
+	shard_path_t * path;
+	char * names[2];
+	int i, n;
+
+	n = shard_item_names(com_it, names);
+	for (i = 0; i < n; i++) {
+		path = shard_find_path(names[i]);
+		if (path->flags & SHARD_BOUND) {
+			shard_union(p->unit, path->unit);
+		}
+	}
+	return p->unit;
+}
+
+/** @return unit of @a com_it of process @a p when splitting by files, keeps descriptors and mappings of @a p */
+
+static int32_t shard_files_unit(shard_proc_t * p, common_op_item_t * com_it) {
+	open_item_t * open_it;
+	dup_item_t * dup_it;
+	pipe_item_t * pipe_it;
+	socket_item_t * socket_it;
+	sendfile_item_t * sendfile_it;
+	mmap_item_t * mmap_it;
+	char * names[2];
+	int32_t unit, unit2;
+	int i, n;
+
+	switch (com_it->type) {
+		case OP_OPEN:
+			open_it = (open_item_t *) com_it;
+			unit = shard_find_path(open_it->o.name)->unit;
+			shard_set_fd(p, open_it->o.retval, unit);
+			return unit;
+		case OP_CLOSE:
+			unit = shard_fd_unit(p, ((close_item_t *) com_it)->o.fd);
+			shard_set_fd(p, ((close_item_t *) com_it)->o.fd, SHARD_HOME);
+			return unit;
+		case OP_READ:
+			return shard_fd_unit(p, ((read_item_t *) com_it)->o.fd);
+		case OP_WRITE:
+			return shard_fd_unit(p, ((write_item_t *) com_it)->o.fd);
+		case OP_PREAD:
+			return shard_fd_unit(p, ((pread_item_t *) com_it)->o.fd);
+		case OP_PWRITE:
+			return shard_fd_unit(p, ((pwrite_item_t *) com_it)->o.fd);
+		case OP_LSEEK:
+			return shard_fd_unit(p, ((lseek_item_t *) com_it)->o.fd);
+		case OP_LLSEEK:
+			return shard_fd_unit(p, ((llseek_item_t *) com_it)->o.fd);
+		case OP_GETDENTS:
+			return shard_fd_unit(p, ((getdents_item_t *) com_it)->o.fd);
+		case OP_DUP:
+		case OP_DUP2:
+		case OP_DUP3:
+			dup_it = (dup_item_t *) com_it;
+			unit = shard_fd_unit(p, dup_it->o.old_fd);
+			shard_set_fd(p, dup_it->o.retval, unit);
+			return unit;
+		case OP_PIPE:
+		case OP_SOCKETPAIR:
+			pipe_it = (pipe_item_t *) com_it;
+			if (pipe_it->o.retval >= 0) {
+				shard_set_fd(p, pipe_it->o.fd1, SHARD_PROC);
+				shard_set_fd(p, pipe_it->o.fd2, SHARD_PROC);
+			}
+			return SHARD_PROC;
+		case OP_SOCKET:
+		case OP_EVENTFD:
+		case OP_EPOLL:
+		case OP_TIMERFD:
+			socket_it = (socket_item_t *) com_it;
+			shard_set_fd(p, socket_it->o.retval, SHARD_PROC);
+			return SHARD_PROC;
+		case OP_SENDFILE:
+			sendfile_it = (sendfile_item_t *) com_it;
+			unit = shard_fd_unit(p, sendfile_it->o.in_fd);
+			unit2 = shard_fd_unit(p, sendfile_it->o.out_fd);
+			shard_union(unit, unit2);
+			if (unit >= 0 || unit2 >= 0) {
+				return unit >= 0 ? unit : unit2;
+			}
+			return unit == SHARD_PROC || unit2 == SHARD_PROC ? SHARD_PROC : SHARD_HOME;
+		case OP_MMAP:
+			mmap_it = (mmap_item_t *) com_it;
+			unit = shard_fd_unit(p, mmap_it->o.fd);
+			if (mmap_it->o.retval != -1 && unit >= 0) {
+				shard_add_region(p, mmap_it->o.retval, mmap_it->o.length, unit);
+			}
+			return unit;
+		case OP_MUNMAP:
+		case OP_MSYNC:
+		case OP_MADVISE:
+			return shard_region_unit(p, ((mem_item_t *) com_it)->o.addr);
+		default:
+			break;
+	}
+	if ( (n = shard_item_names(com_it, names)) == 0) { //clone, exit, wait, execve...
+		return SHARD_PROC;
+	}
+	unit = shard_find_path(names[0])->unit;
+	for (i = 1; i < n; i++) { //rename and link
+		shard_union(unit, shard_find_path(names[i])->unit);
+	}
+	return unit;
+}
+
+/** @return bytes transferred by @a com_it */
+
+static int64_t shard_bytes(common_op_item_t * com_it) {
+	int64_t bytes;
+
+	switch (com_it->type) {
+		case OP_READ:
+			bytes = ((read_item_t *) com_it)->o.retval;
+			break;
+		case OP_WRITE:
+			bytes = ((write_item_t *) com_it)->o.retval;
+			break;
+		case OP_PREAD:
+			bytes = ((pread_item_t *) com_it)->o.retval;
+			break;
+		case OP_PWRITE:
+			bytes = ((pwrite_item_t *) com_it)->o.retval;
+			break;
+		case OP_SENDFILE:
+			bytes = ((sendfile_item_t *) com_it)->o.retval;
+			break;
+		default:
+			bytes = 0;
+			break;
+	}
+	return bytes > 0 ? bytes : 0;
+}
+
+/** Finds out the unit and process of every call of @a list. */
+
+static void shard_assign(list_t * list) {
+	common_op_item_t * com_it;
+	clone_item_t * clone_it;
+	item_t * item;
+	op_info_t * info;
+	shard_proc_t * p;
+	int32_t unit;
+	int64_t i;
+
+	for (i = 0, item = list->head; item; item = item->next, i++) {
+		com_it = list_entry(item, common_op_item_t, item);
+		if ( (info = get_item_info(com_it)) == NULL) {
+			shard_item_units[i] = SHARD_HOME;
+			shard_item_procs[i] = NULL;
+			continue;
+		}
+		if (shard_first < 0) {
+			shard_first = shard_usec(info->start);
+		}
+		p = shard_get_proc(info->pid);
+		if (p->pid == MERGE_INIT_PID) { //just clones the first processes of every host
+			unit = SHARD_PROC;
+		} else if (shard_mode == SHARD_TREE) {
+			unit = shard_tree_unit(p, com_it);
+		} else {
+			unit = shard_files_unit(p, com_it);
+		}
+		if (com_it->type == OP_CLONE) {
+			clone_it = (clone_item_t *) com_it;
+			if (clone_it->o.retval > 0 && shard_find_proc(clone_it->o.retval) == NULL) {
+				shard_new_proc(clone_it->o.retval, p, clone_it->o.mode & CLONE_FILES);
+			}
+		}
+		if (unit >= 0) {
+			shard_weight[unit] += SHARD_OP_BYTES + shard_bytes(com_it);
+		}
+		shard_item_units[i] = unit;
+		shard_item_procs[i] = p;
+	}
+}
+
+static int shard_compare_units(const void * a, const void * b) {
+	int64_t wa = shard_weight[*(const int32_t *) a];
+	int64_t wb = shard_weight[*(const int32_t *) b];
+
+	if (wa != wb) {
+		return wa > wb ? -1 : 1;
+	}
+	return *(const int32_t *) a - *(const int32_t *) b;
+}
+
+/** Spreads units over the shards, the biggest first, each to the shard with the least work so far. */
+
+static void shard_balance() {
+	int64_t loads[SHARD_MAX], total;
+	int32_t * roots;
+	int32_t i, k, best, n = 0;
+
+	for (i = 0; i < shard_nunits; i++) {
+		if ( (k = shard_find(i)) != i) {
+			shard_weight[k] += shard_weight[i];
+			shard_weight[i] = 0;
+		}
+	}
+	roots = malloc(shard_nunits * sizeof(int32_t) + 1);
+	for (i = 0; i < shard_nunits; i++) {
+		if (shard_uf[i] == i && shard_weight[i] > 0) {
+			roots[n++] = i;
+		}
+	}
+	qsort(roots, n, sizeof(int32_t), shard_compare_units);
+
+	memset(loads, 0, sizeof(loads));
+	shard_of = malloc(shard_nunits * sizeof(int32_t) + 1);
+	for (i = 0; i < n; i++) {
+		for (best = 0, k = 1; k < shard_count; k++) {
+			if (loads[k] < loads[best]) {
+				best = k;
+			}
+		}
+		shard_of[roots[i]] = best;
+		loads[best] += shard_weight[roots[i]];
+		shard_stats[best].units++;
+	}
+	for (total = 0, k = 0; k < shard_count; k++) {
+		total += loads[k];
+	}
+	if (n > 0 && shard_weight[roots[0]] * shard_count > total) {
+		DEBUGPRINTF("The biggest unit does %.1lf%% of the work, shards cannot be balanced\n",
+				100.0 * shard_weight[roots[0]] / total);
+	}
+	free(roots);
+}
+
+/** Finds out shards of all processes: shards of their calls and of their children. */
+
+static void shard_spread_procs(int64_t count) {
+	shard_proc_t * p;
+	uint64_t mask;
+	int64_t i;
+	int32_t k;
+
+	for (i = 0; i < count; i++) {
+		if (shard_item_procs[i] && shard_item_units[i] >= 0) {
+			shard_item_procs[i]->mask |= (uint64_t) 1 << shard_of[shard_find(shard_item_units[i])];
+		}
+	}
+	for (i = shard_nprocs - 1; i >= 0; i--) { //children are created after their parents
+		p = shard_proc_list[i];
+		if (p->parent) {
+			p->parent->mask |= p->mask;
+		}
+	}
+	for (i = 0; i < shard_nprocs; i++) {
+		p = shard_proc_list[i];
+		if ( ! p->mask) { //no calls of its own, replayed with its parent
+			mask = p->parent ? p->parent->mask : 1;
+			p->mask = mask & (~mask + 1);
+		}
+		for (k = 0; k < shard_count; k++) {
+			if (p->mask & ((uint64_t) 1 << k)) {
+				shard_stats[k].procs++;
+			}
+		}
+	}
+}
+
+/** @return shards call number @a i of the trace (@a com_it) is written to */
+
+static uint64_t shard_item_mask(common_op_item_t * com_it, int64_t i) {
+	shard_proc_t * p = shard_item_procs[i], * child;
+	int32_t unit = shard_item_units[i];
+	int32_t pid = 0;
+
+	if (p == NULL) {
+		return 1;
+	} else if (unit >= 0) {
+		return (uint64_t) 1 << shard_of[shard_find(unit)];
+	} else if (unit == SHARD_HOME) {
+		return p->mask & (~p->mask + 1);
+	}
+	if (com_it->type == OP_CLONE) {
+		pid = ((clone_item_t *) com_it)->o.retval;
+	} else if (com_it->type == OP_WAIT) {
+		pid = ((wait_item_t *) com_it)->o.retval;
+	}
+	if (pid > 0 && (child = shard_find_proc(pid)) != NULL && child->parent == p) {
+		return child->mask;
+	}
+	return p->mask;
+}
+
+/** Writes @a com_it of process @a p to shard @a k, the process is cloned from the init process first if it does
+ * not exist in the shard yet.
+ *
+ * @return 0 on success, -1 on error
+ */
+
+static int shard_write(int32_t k, common_op_item_t * com_it, shard_proc_t * p) {
+	shard_stats_t * st = &shard_stats[k];
+	op_info_t * info = get_item_info(com_it);
+	clone_item_t clone_it;
+	shard_proc_t * child;
+	int64_t start;
+
+	if (p && ! (p->started & ((uint64_t) 1 << k))) {
+		start = st->first < 0 ? shard_first : shard_usec(info->start);
+		memset(&clone_it, 0, sizeof(clone_it));
+		clone_it.type = OP_CLONE;
+		clone_it.o.mode = 0; //descriptors of the init process, i.e. just the standard ones
+		clone_it.o.retval = p->pid;
+		clone_it.o.info.pid = MERGE_INIT_PID;
+		clone_it.o.info.start.tv_sec = start / 1000000;
+		clone_it.o.info.start.tv_usec = start % 1000000;
+		if (bin_write_item(shard_files[k], shard_names[k], (common_op_item_t *) &clone_it) != 0) {
+			return -1;
+		}
+		p->started |= (uint64_t) 1 << k;
+		if (st->first < 0) {
+			st->first = start;
+		}
+	} else if (p && st->first < 0 && com_it->type == OP_CLONE) { //a clone by the init process of a merged trace
+		memcpy(&clone_it, com_it, sizeof(clone_it));
+		clone_it.o.info.start.tv_sec = shard_first / 1000000;
+		clone_it.o.info.start.tv_usec = shard_first % 1000000;
+		com_it = (common_op_item_t *) &clone_it;
+		info = &clone_it.o.info;
+	}
+	if (bin_write_item(shard_files[k], shard_names[k], com_it) != 0) {
+		return -1;
+	}
+	if (com_it->type == OP_CLONE && ((clone_item_t *) com_it)->o.retval > 0
+			&& (child = shard_find_proc(((clone_item_t *) com_it)->o.retval)) != NULL) {
+		child->started |= (uint64_t) 1 << k;
+	}
+	st->calls++;
+	st->bytes += shard_bytes(com_it);
+	if (info) {
+		start = shard_usec(info->start);
+		if (st->first < 0) {
+			st->first = start;
+		}
+		if (start + info->dur > st->last) {
+			st->last = start + info->dur;
+		}
+	}
+	return 0;
+}
+
+static void shard_report() {
+	shard_stats_t * st;
+	double max_calls = 0, max_bytes = 0, max_dur = 0, sum_calls = 0, sum_bytes = 0, sum_dur = 0, dur;
+	int32_t k;
+
+	printf("Trace split into %d shards by %s:\n", shard_count, shard_mode == SHARD_TREE ? "process trees" : "files");
+	printf("%6s %8s %10s %12s %12s %12s  %s\n", "shard", "units", "processes", "calls", "MB", "duration s", "file");
+	for (k = 0; k < shard_count; k++) {
+		st = &shard_stats[k];
+		dur = st->first < 0 ? 0 : (st->last - st->first) / 1000000.0;
+		printf("%6d %8"PRIi64" %10"PRIi64" %12"PRIi64" %12.1lf %12.3lf  %s\n", k, st->units, st->procs, st->calls,
+				st->bytes / 1048576.0, dur, shard_names[k]);
+		max_calls = st->calls > max_calls ? st->calls : max_calls;
+		max_bytes = st->bytes > max_bytes ? st->bytes : max_bytes;
+		max_dur = dur > max_dur ? dur : max_dur;
+		sum_calls += st->calls;
+		sum_bytes += st->bytes;
+		sum_dur += dur;
+	}
+	printf("Imbalance (max/mean): calls %.2lf, bytes %.2lf, duration %.2lf\n",
+			sum_calls > 0 ? max_calls * shard_count / sum_calls : 1.0,
+			sum_bytes > 0 ? max_bytes * shard_count / sum_bytes : 1.0,
+			sum_dur > 0 ? max_dur * shard_count / sum_dur : 1.0);
+	if (shard_copied) {
+		printf("Calls of processes copied to more shards: %"PRIi64"\n", shard_copied);
+	}
+}
+
+/** Splits @a list into shards <output>.<k> and prints how balanced they are.
+ *
+ * @return 0 on success, -1 on error
+ */
+
+int shard_run(list_t * list, char * output) {
+	common_op_item_t * com_it;
+	item_t * item;
+	uint64_t mask;
+	int64_t i, count = list_length(list);
+	int32_t k, opened = 0;
+	int retval = 0;
+
+	hash_table_init(&shard_procs, SHARD_HT_SIZE, &ht_ops_shard_proc);
+	hash_table_init(&shard_paths, SHARD_HT_SIZE, &ht_ops_shard_path);
+	memset(shard_stats, 0, sizeof(shard_stats));
+	shard_item_units = malloc(count * sizeof(int32_t) + 1);
+	shard_item_procs = malloc(count * sizeof(shard_proc_t *) + 1);
+
+	shard_scan_paths(list);
+	hash_table_apply(&shard_paths, shard_join_dirs);
+	shard_assign(list);
+	shard_balance();
+	shard_spread_procs(count);
+
+	for (k = 0; k < shard_count; k++) {
+		shard_stats[k].first = -1;
+		if (snprintf(shard_names[k], MAX_STRING, "%s.%d", output, k) >= MAX_STRING) {
+			ERRORPRINTF("Name of shard %d of %s is too long\n", k, output);
+			retval = -1;
+			break;
+		}
+		if ( (shard_files[k] = fopen(shard_names[k], "wb")) == NULL) {
+			ERRORPRINTF("Error opening file %s: %s\n", shard_names[k], strerror(errno));
+			retval = -1;
+			break;
+		}
+		opened++;
+	}
+	for (i = 0, item = list->head; item && retval == 0; item = item->next, i++) {
+		com_it = list_entry(item, common_op_item_t, item);
+		mask = shard_item_mask(com_it, i);
+		if (mask & (mask - 1)) {
+			shard_copied++;
+		}
+		for (k = 0; k < shard_count && retval == 0; k++) {
+			if (mask & ((uint64_t) 1 << k)) {
+				retval = shard_write(k, com_it, shard_item_procs[i]);
+			}
+		}
+	}
+	for (k = 0; k < opened; k++) {
+		if (fclose(shard_files[k]) != 0) {
+			ERRORPRINTF("Error writing file %s: %s\n", shard_names[k], strerror(errno));
+			retval = -1;
+		}
+	}
+	if (retval == 0) {
+		shard_report();
+	}
+	return retval;
+}
+
+void shard_finish() {
+	if (shard_count == 0) {
+		return;
+	}
+	hash_table_destroy(&shard_procs);
+	hash_table_destroy(&shard_paths);
+	free(shard_proc_list);
+	free(shard_uf);
+	free(shard_weight);
+	free(shard_of);
+	free(shard_item_units);
+	free(shard_item_procs);
+	shard_proc_list = NULL;
+	shard_uf = shard_of = shard_item_units = NULL;
+	shard_weight = NULL;
+	shard_item_procs = NULL;
+	shard_nprocs = shard_procs_size = shard_nunits = shard_units_size = 0;
+	shard_first = -1;
+	shard_copied = 0;
+	shard_count = 0;
+	shard_mode = SHARD_TREE;
+}
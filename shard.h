@@ -0,0 +1,121 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _SHARD_H_
+#define _SHARD_H_
+
+/** @file shard.h
+ *
+ * Splits a trace into shards when converting, so one workload can be replayed by more ioreplay instances (on one
+ * or more machines) at once. Every shard is a self-contained binary trace <output>.<k>.
+ *
+ * Calls are grouped into units no dependency crosses, units are then spread over the shards, the biggest first,
+ * each to the shard with the least work so far (work of a call is SHARD_OP_BYTES plus bytes it transfers):
+ *
+ * - tree: a unit is a process tree. Trees are joined when they share a path one of them changes (open for writing,
+ *   unlink, mkdir, rename...) or a path under a directory created, removed or renamed in the trace. Every process
+ *   is replayed in just one shard.
+ * - files: a unit is a path, joined with the paths it is renamed or linked to and with directories above it which
+ *   are created, removed or renamed in the trace. Calls on descriptors and mappings go with the path they were
+ *   opened on, sendfile joins both paths. A process is replayed in every shard with its calls, calls of the
+ *   process itself (clone, execve, exit, pipe, socket and calls on their descriptors) are copied to all of them.
+ *   Calls on descriptors not opened in the trace go to the first shard of the process.
+ *
+ * Processes not created in a shard (e.g. the first process) are cloned there from an idle init process
+ * (MERGE_INIT_PID) at their first call, the first clone of every shard is put at the start of the whole trace,
+ * so all shards keep their timing relative to the same start. See --start-at of the replay to start them together.
+ */
+
+#include <stdint.h>
+#include "common.h"
+#include "in_common.h"
+#include "adt/hash_table.h"
+
+#define SHARD_MAX 64 ///< shards are kept in 64 bit masks
+#define SHARD_HT_SIZE 1024
+#define SHARD_OP_BYTES 4096 ///< every call counts as a transfer of this many bytes when balancing
+
+#define SHARD_TREE 0
+#define SHARD_TREE_STR "tree"
+#define SHARD_FILES 1
+#define SHARD_FILES_STR "files"
+
+// Units of calls, which are not units
+#define SHARD_PROC -1 ///< call of the process itself, done in all its shards
+#define SHARD_HOME -2 ///< done in the first shard of the process
+
+// Flags of paths
+#define SHARD_MODIFIED 0x1 ///< changed by some call of the trace
+#define SHARD_STRUCTURAL 0x2 ///< created, removed or renamed directory (or file)
+#define SHARD_BOUND 0x4 ///< joins process trees using it
+
+/** Units of descriptors of one or more processes (CLONE_FILES). */
+typedef struct shard_fds {
+	int32_t * units; ///< SHARD_PROC for pipes and sockets, SHARD_HOME for descriptors not opened in the trace
+	int32_t size;
+	int32_t refs;
+} shard_fds_t;
+
+typedef struct shard_region {
+	int64_t addr;
+	int64_t length;
+	int32_t unit;
+} shard_region_t;
+
+/** Mappings of files of one or more processes (threads). */
+typedef struct shard_maps {
+	shard_region_t * regions;
+	int32_t count;
+	int32_t size;
+	int32_t refs;
+} shard_maps_t;
+
+typedef struct shard_proc {
+	item_t item;
+	key_t pid;
+	struct shard_proc * parent; ///< NULL if not cloned in the trace
+	int32_t unit; ///< process tree, tree mode only
+	shard_fds_t * fds; ///< files mode only
+	shard_maps_t * maps; ///< files mode only
+	uint64_t mask; ///< shards the process is replayed in
+	uint64_t started; ///< shards the process was created in so far
+} shard_proc_t;
+
+typedef struct shard_path {
+	item_t item;
+	char name[MAX_STRING];
+	int32_t unit;
+	int flags;
+} shard_path_t;
+
+typedef struct shard_stats {
+	int64_t units;
+	int64_t procs;
+	int64_t calls;
+	int64_t bytes;
+	int64_t first; ///< start of the first call in usec, -1 if there is none
+	int64_t last; ///< end of the last call in usec
+} shard_stats_t;
+
+int shard_init(const char * spec);
+int shard_enabled();
+int shard_run(list_t * list, char * output);
+void shard_finish();
+
+#endif
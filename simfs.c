@@ -711,6 +711,231 @@ int simfs_creat(open_op_t * open_op) {
 
 
 
+/** Checks whether @a name (absolute path) exists in SimFS. Parts of the path that are not yet known to SimFS
+ * are looked up on the disk first.
+ * @arg name absolute path name to look up
+ * @return 1 if the whole path exists, 0 otherwise.
+ */
+
+static int simfs_lookup(const char * name) {
+	int i = 0;
+	int exists;
+	char * buff = malloc(MAX_LINE);
+	char * missing = strdup(name);
+
+	trie_longest_prefix(fs, name, buff);
+
+	if (strcmp(name, buff) == 0) {
+		exists = 1;
+	} else {
+		while (buff[i] && buff[i] == name[i]) //skip common part
+			i++;
+
+		strcpy(missing, name + i);
+		exists = simfs_populate(buff, missing);
+	}
+	free(missing);
+	free(buff);
+	return exists;
+}
+
+/** Checks whether the directory in which @a name (absolute path) lies exists in SimFS.
+ * @arg name absolute path name
+ * @return 1 if the parent directory exists, 0 otherwise.
+ */
+
+static int simfs_lookup_parent(const char * name) {
+	int exists;
+	char * strtmp = strdup(name);
+	char * s = rindex(strtmp, '/');
+
+	if ( s == NULL || s == strtmp ) { //root directory always exists
+		free(strtmp);
+		return 1;
+	}
+	*s = 0;
+	exists = simfs_lookup(strtmp);
+	free(strtmp);
+	return exists;
+}
+
+/** Simulates rename(2) system call on the SimFS. It takes appropriate actions to fix the fs, if needed. On success,
+ * the whole subtree of the old name is moved to the new name, replacing it if it already exists.
+ * @arg rename_op structure with all information about the call.
+ * @return zero if successful, SIMFS_ENOENT in case of missing file/dir and SIMFS_EENT in case of previously failed 
+ *         rename operation that would now succeed.
+ */
+
+int simfs_rename(rename_op_t * rename_op) {
+	int rv = 0;
+	int old_exists;
+	int parent_exists;
+	char old_name[MAX_LINE];
+	char new_name[MAX_LINE];
+
+	simfs_absolute_name(rename_op->old_name, old_name, MAX_LINE); 
+	simfs_absolute_name(rename_op->new_name, new_name, MAX_LINE); 
+
+	old_exists = simfs_lookup(old_name);
+	parent_exists = simfs_lookup_parent(new_name);
+	simfs_lookup(new_name); //make sure the target is known, if it exists on the disk
+
+	if (rename_op->retval == 0) { //previous rename succeeded
+		if ( ! old_exists ) {
+			ERRORPRINTF("Rename can't succeed as the file %s is not there. Create it.\n", old_name);
+			trie_insert(fs, old_name);
+			if (simfs_mask & ACT_PREPARE) {
+				///< @todo really create it
+			}
+			rv = SIMFS_ENOENT;
+		}
+		if ( ! parent_exists ) {
+			ERRORPRINTF("Rename can't succeed as the path is not ready, create missing entries for rename to %s\n", new_name);
+			if (simfs_mask & ACT_PREPARE) {
+				///< @todo really create it
+			}
+			rv = SIMFS_ENOENT;
+		}
+		trie_move(fs, old_name, new_name);
+	} else { //previous rename failed
+		if ( old_exists && parent_exists ) {
+			ERRORPRINTF("Previous rename call of %s to %s failed, but we would succeed. Delete the file %s.\n",
+					old_name, new_name, old_name);
+			trie_delete(fs, old_name);
+			if (simfs_mask & ACT_PREPARE) {
+				///< @todo really delete it 
+			}
+			rv = SIMFS_EENT;
+		}
+	}
+
+	return rv;
+}
+
+/** Simulates link(2) system call on the SimFS. It takes appropriate actions to fix the fs, if needed.
+ * @arg link_op structure with all information about the call.
+ * @return zero if successful, SIMFS_ENOENT in case of missing file/dir and SIMFS_EENT in case the new name
+ *         already exists or the previously failed link would now succeed.
+ */
+
+int simfs_link(link_op_t * link_op) {
+	int rv = 0;
+	int old_exists;
+	int new_exists;
+	int parent_exists;
+	char old_name[MAX_LINE];
+	char new_name[MAX_LINE];
+	trie_node_t * n;
+	simfs_t * simfs;
+
+	simfs_absolute_name(link_op->old_name, old_name, MAX_LINE); 
+	simfs_absolute_name(link_op->new_name, new_name, MAX_LINE); 
+
+	old_exists = simfs_lookup(old_name);
+	new_exists = simfs_lookup(new_name);
+	parent_exists = simfs_lookup_parent(new_name);
+
+	if (link_op->retval == 0) { //previous link succeeded
+		if ( ! old_exists ) {
+			ERRORPRINTF("Link can't succeed as the file %s is not there. Create it.\n", old_name);
+			trie_insert(fs, old_name);
+			if (simfs_mask & ACT_PREPARE) {
+				///< @todo really create it
+			}
+			rv = SIMFS_ENOENT;
+		}
+		if ( new_exists ) {
+			ERRORPRINTF("Previous link call to %s succeeded. But the file already exists. Delete it.\n", new_name);
+			trie_delete(fs, new_name);
+			if (simfs_mask & ACT_PREPARE) {
+				///< @todo really delete it 
+			}
+			rv = SIMFS_EENT;
+		} else if ( ! parent_exists ) {
+			ERRORPRINTF("Link can't succeed as the path is not ready, create missing entries for link %s\n", new_name);
+			if (simfs_mask & ACT_PREPARE) {
+				///< @todo really create it
+			}
+			rv = SIMFS_ENOENT;
+		}
+		n = trie_insert(fs, new_name);
+		simfs = trie_get_instance(n, simfs_t, node);
+		simfs->created = 1;
+	} else { //previous link failed
+		if ( old_exists && ! new_exists && parent_exists ) {
+			ERRORPRINTF("Previous link call of %s to %s failed, but we would succeed.\n", old_name, new_name);
+			rv = SIMFS_EENT;
+		}
+	}
+
+	return rv;
+}
+
+/** Simulates symlink(2) system call on the SimFS. It takes appropriate actions to fix the fs, if needed. The target
+ * of the symlink doesn't have to exist, so only the new name is checked.
+ * @arg link_op structure with all information about the call.
+ * @return zero if successful, SIMFS_ENOENT in case of missing path and SIMFS_EENT in case the new name
+ *         already exists or the previously failed symlink would now succeed.
+ */
+
+int simfs_symlink(link_op_t * link_op) {
+	int rv = 0;
+	int new_exists;
+	int parent_exists;
+	char new_name[MAX_LINE];
+	trie_node_t * n;
+	simfs_t * simfs;
+
+	simfs_absolute_name(link_op->new_name, new_name, MAX_LINE); 
+
+	new_exists = simfs_lookup(new_name);
+	parent_exists = simfs_lookup_parent(new_name);
+
+	if (link_op->retval == 0) { //previous symlink succeeded
+		if ( new_exists ) {
+			ERRORPRINTF("Previous symlink call to %s succeeded. But the file already exists. Delete it.\n", new_name);
+			trie_delete(fs, new_name);
+			if (simfs_mask & ACT_PREPARE) {
+				///< @todo really delete it 
+			}
+			rv = SIMFS_EENT;
+		} else if ( ! parent_exists ) {
+			ERRORPRINTF("Symlink can't succeed as the path is not ready, create missing entries for symlink %s\n", new_name);
+			if (simfs_mask & ACT_PREPARE) {
+				///< @todo really create it
+			}
+			rv = SIMFS_ENOENT;
+		}
+		n = trie_insert(fs, new_name);
+		simfs = trie_get_instance(n, simfs_t, node);
+		simfs->created = 1;
+	} else { //previous symlink failed
+		if ( ! new_exists && parent_exists ) {
+			ERRORPRINTF("Previous symlink call to %s failed, but we would succeed.\n", new_name);
+			rv = SIMFS_EENT;
+		}
+	}
+
+	return rv;
+}
+
+/** Simulates readlink(2) system call on the SimFS. As SimFS doesn't distinguish symlinks from regular files, it 
+ * only checks the existence of the file the same way stat(2) does.
+ * @arg readlink_op structure with all information about the call.
+ * @return the same values as simfs_stat()
+ */
+
+int simfs_readlink(readlink_op_t * readlink_op) {
+	int rv;
+	stat_op_t * stat_op = malloc(sizeof(stat_op_t));
+	stat_op->retval = (readlink_op->retval >= 0) ? 0 : -1;
+	strcpy(stat_op->name, readlink_op->name);
+	stat_op->info = readlink_op->info;
+	rv = simfs_stat(stat_op);
+	free(stat_op);
+	return rv;
+}
+
 /** Checks whether given file @a name exists in virutal filesystem and if it was only virtually created or it
  * exists on the disk too.
  *
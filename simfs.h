@@ -23,7 +23,7 @@
 
 /** @file simfs.h
  *
- * The SimFS module is inteded for simulating FS system calls such as access/mkdir/unlink/creat and maybe others in future.
+ * The SimFS module is inteded for simulating FS system calls such as access/mkdir/unlink/creat/rename and maybe others in future.
  * The purpose of it is tracking down inconsistencies with current file system and file system used by straced process - it
  * should warn you about files/directories that are not present and are needed by straced process (e.g. it tries to create
  * file in directory that doesn't exist). It also warns about files/directories that exist but should not (i.e. system call
@@ -65,6 +65,10 @@ int simfs_mkdir(mkdir_op_t * mkdir_op);
 int simfs_rmdir(rmdir_op_t * rmdir_op);
 int simfs_unlink(unlink_op_t * unlink_op);
 int simfs_creat(open_op_t * open_op);
+int simfs_rename(rename_op_t * rename_op);
+int simfs_link(link_op_t * link_op);
+int simfs_symlink(link_op_t * link_op);
+int simfs_readlink(readlink_op_t * readlink_op);
 int simfs_has_file(const char * name);
 simfs_t * simfs_find(const char * name);
 void simfs_apply(void (* function)(simfs_t * item));
@@ -23,11 +23,18 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
 #include "simulate.h"
 #include "simfs.h"
+#include "devmodel.h"
+#include "mrc.h"
+#include "critpath.h"
+#include "workload.h"
 
 hash_table_t * sim_map_read = NULL;
 hash_table_t * sim_map_write = NULL;
+hash_table_t * sim_map_dirs = NULL;
 list_t * sim_list_special = NULL;
 int sim_mode = 0;
 
@@ -63,6 +70,28 @@ static hash_table_operations_t ht_ops_sim = {
 	.remove_callback = ht_remove_callback_sim /* = NULL if not used */
 };
 
+static int ht_compare_sim_dir(key_t *key, item_t *item) {
+	sim_dir_t * sim_dir;
+
+	sim_dir = hash_table_entry(item, sim_dir_t, item);
+
+	return ! strncmp(sim_dir->name, (char *) key, MAX_STRING);
+}
+
+static inline void ht_remove_callback_sim_dir(item_t * item) {
+	sim_dir_t * sim_dir = hash_table_entry(item, sim_dir_t, item);	
+
+	free(sim_dir);
+	return;
+}
+
+/** hash table operations for directories. */
+static hash_table_operations_t ht_ops_sim_dir = {
+	.hash = ht_hash_str,
+	.compare = ht_compare_sim_dir,
+	.remove_callback = ht_remove_callback_sim_dir /* = NULL if not used */
+};
+
 /** Inits all structures needed for simulation. You have to call this function before calling any
  * of other simulate_* functions.
  * @arg mode mode in which to simulateing. Possible options are: ACT_PREPARE, ACT_CHECK and ACT_SIMULATE.
@@ -88,6 +117,8 @@ void simulate_init(int mode) {
 
 	hash_table_init(sim_map_read, HASH_TABLE_SIZE, &ht_ops_sim);
 	hash_table_init(sim_map_write, HASH_TABLE_SIZE, &ht_ops_sim);
+	sim_map_dirs = malloc(sizeof(hash_table_t));
+	hash_table_init(sim_map_dirs, HASH_TABLE_SIZE, &ht_ops_sim_dir);
 	simfs_init(mode);
 }
 
@@ -106,12 +137,15 @@ void simulate_finish() {
 	}
 	hash_table_destroy(sim_map_read);
 	hash_table_destroy(sim_map_write);
+	hash_table_destroy(sim_map_dirs);
 	
 				
 	free(sim_map_read);
 	free(sim_map_write);
+	free(sim_map_dirs);
 	sim_map_read = NULL;
 	sim_map_write = NULL;
+	sim_map_dirs = NULL;
 
 	DEBUGPRINTF("going to finish simfs%s","\n");
 	simfs_finish();
@@ -136,18 +170,37 @@ inline sim_item_t * simulate_get_sim_item(fd_item_t * fd_item, hash_table_t * ht
 }
 
 
-inline void simulate_append_rw(sim_item_t * sim_item, int64_t size, int64_t offset, struct int32timeval start, int32_t dur, int64_t retval) {
+inline void simulate_append_rw(sim_item_t * sim_item, int64_t size, int64_t offset, struct int32timeval start, int32_t dur, int64_t retval, int32_t pid) {
 	rw_op_t * rw_op = malloc(sizeof(rw_op_t));
 	item_init(&rw_op->item);
 	rw_op->size = retval; //we notice only how many bytes were actually read/written, not tried
 	rw_op->offset = offset;
 	rw_op->start = start;
 	rw_op->dur = dur;
+	rw_op->pid = pid;
 
 	list_append(&sim_item->list, &rw_op->item);
 }
 
 
+/** Passes one read or write to the device model, the miss ratio curve and the critical path analysis, if they
+ * are enabled. */
+
+void simulate_note_rw(fd_item_t * fd_item, op_info_t * info, int64_t offset, int64_t retval, int write) {
+	if (devmodel_enabled()) {
+		devmodel_add(info->pid, fd_item->fd_map->name, offset, retval, write, info->start, info->dur);
+	}
+	if (mrc_enabled()) {
+		mrc_add(info->pid, fd_item->fd_map->name, offset, retval);
+	}
+	if (critpath_enabled()) {
+		critpath_add_io(info->pid, fd_item->fd_map->name, info->start, info->dur);
+	}
+	if (workload_enabled()) {
+		workload_add_rw(info->pid, fd_item->fd_map->name, offset, retval, write, info->dur);
+	}
+}
+
 inline void simulate_write(fd_item_t * fd_item, write_item_t * op_it) {
 	simfs_t * simfs = simfs_find(fd_item->fd_map->name);
 	sim_item_t * sim_item = NULL;
@@ -180,7 +233,8 @@ inline void simulate_write(fd_item_t * fd_item, write_item_t * op_it) {
 
 	if ( sim_mode & ACT_SIMULATE) {
 		sim_item = simulate_get_sim_item(fd_item, sim_map_write);
-		simulate_append_rw(sim_item, op_it->o.size, fd_item->fd_map->cur_pos, op_it->o.info.start, op_it->o.info.dur, op_it->o.retval);
+		simulate_append_rw(sim_item, op_it->o.size, fd_item->fd_map->cur_pos, op_it->o.info.start, op_it->o.info.dur, op_it->o.retval, op_it->o.info.pid);
+		simulate_note_rw(fd_item, &op_it->o.info, fd_item->fd_map->cur_pos, op_it->o.retval, 1);
 	}
 }
 
@@ -203,7 +257,8 @@ inline void simulate_read(fd_item_t * fd_item, read_item_t * op_it) {
 	}
 	if (sim_mode & ACT_SIMULATE) {
 		sim_item = simulate_get_sim_item(fd_item, sim_map_read);
-		simulate_append_rw(sim_item, op_it->o.size, fd_item->fd_map->cur_pos, op_it->o.info.start, op_it->o.info.dur, op_it->o.retval);
+		simulate_append_rw(sim_item, op_it->o.size, fd_item->fd_map->cur_pos, op_it->o.info.start, op_it->o.info.dur, op_it->o.retval, op_it->o.info.pid);
+		simulate_note_rw(fd_item, &op_it->o.info, fd_item->fd_map->cur_pos, op_it->o.retval, 0);
 	}
 }
 
@@ -241,7 +296,8 @@ inline void simulate_sendfile(fd_item_t * in_fd_item, fd_item_t * out_fd_item, s
 			} else {
 				off = op_it->o.offset;
 			}
-			simulate_append_rw(sim_item_read, op_it->o.size, off, op_it->o.info.start, op_it->o.info.dur, op_it->o.retval);
+			simulate_append_rw(sim_item_read, op_it->o.size, off, op_it->o.info.start, op_it->o.info.dur, op_it->o.retval, op_it->o.info.pid);
+			simulate_note_rw(in_fd_item, &op_it->o.info, off, op_it->o.retval, 0);
 		}
 	}
 	if (out_fd_item) {
@@ -261,7 +317,8 @@ inline void simulate_sendfile(fd_item_t * in_fd_item, fd_item_t * out_fd_item, s
 		if (sim_mode & ACT_SIMULATE) {
 			sim_item_write = simulate_get_sim_item(out_fd_item, sim_map_write);
 			off = out_fd_item->fd_map->cur_pos;
-			simulate_append_rw(sim_item_write, op_it->o.size, off, op_it->o.info.start, op_it->o.info.dur, op_it->o.retval);
+			simulate_append_rw(sim_item_write, op_it->o.size, off, op_it->o.info.start, op_it->o.info.dur, op_it->o.retval, op_it->o.info.pid);
+			simulate_note_rw(out_fd_item, &op_it->o.info, off, op_it->o.retval, 1);
 		}
 	}
 }
@@ -296,7 +353,8 @@ inline void simulate_pwrite(fd_item_t * fd_item, pwrite_item_t * op_it) {
 
 	if ( sim_mode & ACT_SIMULATE) {
 		sim_item = simulate_get_sim_item(fd_item, sim_map_write);
-		simulate_append_rw(sim_item, op_it->o.size, op_it->o.offset, op_it->o.info.start, op_it->o.info.dur, op_it->o.retval);
+		simulate_append_rw(sim_item, op_it->o.size, op_it->o.offset, op_it->o.info.start, op_it->o.info.dur, op_it->o.retval, op_it->o.info.pid);
+		simulate_note_rw(fd_item, &op_it->o.info, op_it->o.offset, op_it->o.retval, 1);
 	}
 }
 
@@ -319,11 +377,57 @@ inline void simulate_pread(fd_item_t * fd_item, pread_item_t * op_it) {
 	}
 	if (sim_mode & ACT_SIMULATE) {
 		sim_item = simulate_get_sim_item(fd_item, sim_map_read);
-		simulate_append_rw(sim_item, op_it->o.size, op_it->o.offset, op_it->o.info.start, op_it->o.info.dur, op_it->o.retval);
+		simulate_append_rw(sim_item, op_it->o.size, op_it->o.offset, op_it->o.info.start, op_it->o.info.dur, op_it->o.retval, op_it->o.info.pid);
+		simulate_note_rw(fd_item, &op_it->o.info, op_it->o.offset, op_it->o.retval, 0);
 	}
 }
 
 
+/** Notes number of entries returned by getdents call, so we know how big the directory has to be
+ * to make the scan as expensive as in the original run. One scan lasts from opening of the directory
+ * until getdents returns zero.
+ */
+
+void simulate_getdents(fd_item_t * fd_item, getdents_item_t * op_it) {
+	item_t * item;
+	sim_dir_t * sim_dir;
+
+	if (sim_mode & ACT_SIMULATE && critpath_enabled()) {
+		critpath_add_io(op_it->o.info.pid, fd_item->fd_map->name, op_it->o.info.start, op_it->o.info.dur);
+	}
+
+	if (sim_mode & ACT_CHECK || sim_mode & ACT_PREPARE) {
+		if ( (item = hash_table_find(sim_map_dirs, (key_t *)(fd_item->fd_map->name))) == NULL) {
+			sim_dir = malloc(sizeof(sim_dir_t));
+			strncpy(sim_dir->name, fd_item->fd_map->name, MAX_STRING);
+			sim_dir->time_open = fd_item->fd_map->time_open;
+			sim_dir->entries = 0;
+			sim_dir->max_entries = 0;
+			item_init(&sim_dir->item);
+			hash_table_insert(sim_map_dirs, (key_t *) sim_dir->name, &sim_dir->item);
+		} else {
+			sim_dir = hash_table_entry(item, sim_dir_t, item);
+		}
+
+		if ( memcmp(&sim_dir->time_open, &fd_item->fd_map->time_open, sizeof(struct int32timeval)) ) { //new scan
+			sim_dir->time_open = fd_item->fd_map->time_open;
+			sim_dir->entries = 0;
+		}
+
+		if (op_it->o.retval == 0) { //end of the directory
+			sim_dir->entries = 0;
+		} else if (op_it->o.entries >= 0) {
+			sim_dir->entries += op_it->o.entries;
+		} else {
+			sim_dir->entries += op_it->o.retval / SIM_DIRENT_SIZE;
+		}
+
+		if (sim_dir->entries > sim_dir->max_entries) {
+			sim_dir->max_entries = sim_dir->entries;
+		}
+	}
+}
+
 void simulate_access(access_op_t * op_it) {
 	if (sim_mode & ACT_CHECK || sim_mode & ACT_PREPARE) {
 		simfs_access(op_it);
@@ -360,6 +464,30 @@ void simulate_creat(open_op_t * op_it) {
 	}
 }
 
+void simulate_rename(rename_op_t * op_it) {
+	if (sim_mode & ACT_CHECK || sim_mode & ACT_PREPARE) {
+		simfs_rename(op_it);
+	}
+}
+
+void simulate_link(link_op_t * op_it) {
+	if (sim_mode & ACT_CHECK || sim_mode & ACT_PREPARE) {
+		simfs_link(op_it);
+	}
+}
+
+void simulate_symlink(link_op_t * op_it) {
+	if (sim_mode & ACT_CHECK || sim_mode & ACT_PREPARE) {
+		simfs_symlink(op_it);
+	}
+}
+
+void simulate_readlink(readlink_op_t * op_it) {
+	if (sim_mode & ACT_CHECK || sim_mode & ACT_PREPARE) {
+		simfs_readlink(op_it);
+	}
+}
+
 hash_table_t * simulate_get_map_read() {
 	return sim_map_read;
 }
@@ -481,6 +609,67 @@ void simulate_check_file(simfs_t * simfs, char * full_name) {
 	*/
 }
 
+/** Counts entries (including "." and "..") of directory @a name on the disk.
+ * @arg name directory name
+ * @return number of entries or -1 if the directory can't be opened
+ */
+
+static int64_t simulate_count_dir(const char * name) {
+	DIR * dir;
+	int64_t count = 0;
+
+	if ( (dir = opendir(name)) == NULL ) {
+		return -1;
+	}
+	while (readdir(dir) != NULL) {
+		count++;
+	}
+	closedir(dir);
+	return count;
+}
+
+/** Checks whether given directory has at least as many entries as the original application saw.
+ * @arg item item pointer in sim_dir_t
+ */
+
+void simulate_check_dir(item_t * item) {
+	sim_dir_t * sim_dir = hash_table_entry(item, sim_dir_t, item);
+	int64_t count = simulate_count_dir(sim_dir->name);
+
+	if (count >= 0 && count < sim_dir->max_entries) {
+		fprintf(stderr, "%s %"PRIi64": Directory has only %"PRIi64" entries, populate it.\n",
+				sim_dir->name, sim_dir->max_entries, count);
+	}
+}
+
+/** Creates as many empty files in given directory as needed to make it as big as in the original run.
+ * @arg item item pointer in sim_dir_t
+ */
+
+void simulate_prepare_dir(item_t * item) {
+	sim_dir_t * sim_dir = hash_table_entry(item, sim_dir_t, item);
+	int64_t count = simulate_count_dir(sim_dir->name);
+	int64_t i = 0;
+	char name[MAX_STRING * 2];
+	int fd;
+
+	if (count < 0) {
+		ERRORPRINTF("%s: Can't populate directory: %s\n", sim_dir->name, strerror(errno));
+		return;
+	}
+
+	while (count < sim_dir->max_entries) {
+		snprintf(name, sizeof(name), "%s/ioreplay_dirent_%06"PRIi64, sim_dir->name, i++);
+		if ( (fd = open(name, O_WRONLY | O_CREAT | O_EXCL, 0644)) != -1 ) {
+			close(fd);
+			count++;
+		} else if (errno != EEXIST) {
+			ERRORPRINTF("%s: Can't populate directory: %s\n", name, strerror(errno));
+			return;
+		}
+	}
+}
+
 /** Checks for existence, size and read/write permission of all files
  * that would be accessed during replication of IO operations. Outputs error for every problematic file.
  */
@@ -488,4 +677,14 @@ void simulate_check_file(simfs_t * simfs, char * full_name) {
 void simulate_check_files() {
 	fprintf(stderr, "Create following files:\n");
 	simfs_apply_full_name(simulate_check_file);
+	fprintf(stderr, "Populate following directories:\n");
+	hash_table_apply(sim_map_dirs, simulate_check_dir);
+}
+
+/** Creates empty files in directories that have less entries than were returned by getdents
+ * calls in the original run.
+ */
+
+void simulate_prepare_dirs() {
+	hash_table_apply(sim_map_dirs, simulate_prepare_dir);
 }
@@ -39,6 +39,7 @@ typedef struct rw_op {
 	uint64_t size;
 	struct int32timeval start; ///< start of operation
 	int32_t dur; ///< duration of operation
+	int32_t pid; ///< process which did the operation
 } rw_op_t;
 
 
@@ -50,6 +51,17 @@ typedef struct sim_item_t {
 	list_t list;
 } sim_item_t;
 
+/** Average size of one linux_dirent64 record, used to estimate number of entries when strace didn't tell us. */
+#define SIM_DIRENT_SIZE 32
+
+typedef struct sim_dir {
+	item_t item;
+	char name[MAX_STRING];
+	struct int32timeval time_open; ///< time when the directory being scanned was opened
+	int64_t entries; ///< number of entries returned so far by the current scan
+	int64_t max_entries; ///< maximum number of entries returned by one scan of the directory
+} sim_dir_t;
+
 hash_table_t * simulate_get_map_read();
 hash_table_t * simulate_get_map_write();
 inline int simulate_get_open_fd();
@@ -58,16 +70,23 @@ inline void simulate_read(fd_item_t * fd_item, read_item_t * op_it);
 inline void simulate_write(fd_item_t * fd_item, write_item_t * op_it);
 inline void simulate_pread(fd_item_t * fd_item, pread_item_t * op_it);
 inline void simulate_pwrite(fd_item_t * fd_item, pwrite_item_t * op_it);
+void simulate_note_rw(fd_item_t * fd_item, op_info_t * info, int64_t offset, int64_t retval, int write);
+void simulate_getdents(fd_item_t * fd_item, getdents_item_t * op_it);
 void simulate_access(access_op_t * op_it);
 void simulate_stat(stat_op_t * op_it);
 void simulate_mkdir(mkdir_op_t * op_it);
 void simulate_rmdir(rmdir_op_t * op_it);
 void simulate_unlink(unlink_op_t * op_it);
 void simulate_creat(open_op_t * op_it);
+void simulate_rename(rename_op_t * op_it);
+void simulate_link(link_op_t * op_it);
+void simulate_symlink(link_op_t * op_it);
+void simulate_readlink(readlink_op_t * op_it);
 void simulate_init(int mode);
 void simulate_finish();
 void simulate_list_files();
 void simulate_check_files();
 void simulate_prepare_files();
+void simulate_prepare_dirs();
 
 #endif
@@ -0,0 +1,182 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <errno.h>
+
+#include "common.h"
+#include "throttle.h"
+
+token_bucket_t throttle_iops_tb; ///< global IOPS limit
+token_bucket_t throttle_bw_tb; ///< global bandwidth limit, tokens are bytes
+double throttle_pid_iops = 0; ///< IOPS limit of every process, 0 = unlimited
+hash_table_t throttle_pids;
+int throttle_on = 0;
+int64_t throttle_calls = 0; ///< number of calls that had to wait
+uint64_t throttle_waited = 0; ///< total time spent waiting, in usec
+
+static int ht_compare_throttle(key_t *key, item_t *item) {
+	throttle_pid_t * tp;
+
+	tp = hash_table_entry(item, throttle_pid_t, item);
+	return tp->pid == *key;
+}
+
+static inline void ht_remove_callback_throttle(item_t * item) {
+	throttle_pid_t * tp = hash_table_entry(item, throttle_pid_t, item);	
+	free(tp);
+	return;
+}
+
+/** hash table operations. */
+static hash_table_operations_t ht_ops_throttle = {
+	.hash = ht_hash_int,
+	.compare = ht_compare_throttle,
+	.remove_callback = ht_remove_callback_throttle
+};
+
+static uint64_t throttle_now() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void bucket_init(token_bucket_t * tb, double rate, uint64_t now) {
+	tb->rate = rate;
+	tb->tokens = rate * THROTTLE_BURST;
+	tb->last = now;
+}
+
+/** Takes @a n tokens from the bucket @a tb.
+ *
+ * @return time in usec the caller has to wait before the tokens are really available, 0 if they are available now
+ */
+
+static uint64_t bucket_take(token_bucket_t * tb, double n, uint64_t now) {
+	double max = tb->rate * THROTTLE_BURST;
+
+	if (tb->rate <= 0) {
+		return 0;
+	}
+	if (max < 1) {
+		max = 1;
+	}
+	if (now > tb->last) {
+		tb->tokens += (now - tb->last) * tb->rate / 1000000.0;
+		if (tb->tokens > max) {
+			tb->tokens = max;
+		}
+		tb->last = now;
+	}
+	tb->tokens -= n;
+	if (tb->tokens >= 0) {
+		return 0;
+	}
+	return (uint64_t) (-tb->tokens * 1000000.0 / tb->rate);
+}
+
+/** Initializes the throttling. Every limit equal to zero is disabled.
+ *
+ * @arg iops maximum number of IO calls per second of all processes together
+ * @arg pid_iops maximum number of IO calls per second of every process
+ * @arg bandwidth maximum number of bytes per second read and written by all processes together
+ * @return 0 on success, non-zero otherwise
+ */
+
+int throttle_init(double iops, double pid_iops, double bandwidth) {
+	uint64_t now = throttle_now();
+
+	if (iops < 0 || pid_iops < 0 || bandwidth < 0) {
+		ERRORPRINTF("Negative rate limit: iops %lf, per process iops %lf, bandwidth %lf\n", iops, pid_iops, bandwidth);
+		return -1;
+	}
+	bucket_init(&throttle_iops_tb, iops, now);
+	bucket_init(&throttle_bw_tb, bandwidth, now);
+	throttle_pid_iops = pid_iops;
+	hash_table_init(&throttle_pids, THROTTLE_PID_HT_SIZE, &ht_ops_throttle);
+	throttle_calls = 0;
+	throttle_waited = 0;
+	throttle_on = (iops > 0 || pid_iops > 0 || bandwidth > 0);
+	return 0;
+}
+
+int throttle_enabled() {
+	return throttle_on;
+}
+
+/** Accounts one IO call of @a size bytes made by process @a pid and waits if it would exceed 
+ * any of the limits.
+ */
+
+void throttle_io(int32_t pid, int64_t size) {
+	uint64_t now, wait, w;
+	key_t key = pid;
+	item_t * item;
+	throttle_pid_t * tp;
+	struct timespec ts;
+
+	if ( ! throttle_on) {
+		return;
+	}
+
+	now = throttle_now();
+	wait = bucket_take(&throttle_iops_tb, 1, now);
+	w = bucket_take(&throttle_bw_tb, size > 0 ? size : 0, now);
+	if (w > wait) {
+		wait = w;
+	}
+	if (throttle_pid_iops > 0) {
+		if ( (item = hash_table_find(&throttle_pids, &key)) == NULL) {
+			tp = malloc(sizeof(throttle_pid_t));
+			item_init(&tp->item);
+			tp->pid = key;
+			bucket_init(&tp->bucket, throttle_pid_iops, now);
+			hash_table_insert(&throttle_pids, &tp->pid, &tp->item);
+		} else {
+			tp = hash_table_entry(item, throttle_pid_t, item);
+		}
+		w = bucket_take(&tp->bucket, 1, now);
+		if (w > wait) {
+			wait = w;
+		}
+	}
+
+	if (wait > 0) {
+		throttle_calls++;
+		throttle_waited += wait;
+		ts.tv_sec = wait / 1000000;
+		ts.tv_nsec = (wait % 1000000) * 1000;
+		while (nanosleep(&ts, &ts) == -1 && errno == EINTR)
+			;
+	}
+}
+
+void throttle_report() {
+	printf("Throttling: %"PRIi64" calls delayed, %.3lfs spent waiting for rate limits\n", throttle_calls, throttle_waited / 1000000.0);
+}
+
+void throttle_finish() {
+	hash_table_destroy(&throttle_pids);
+	throttle_on = 0;
+}
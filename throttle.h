@@ -0,0 +1,60 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _THROTTLE_H_
+#define _THROTTLE_H_
+
+/** @file throttle.h
+ *
+ * Rate governors for replay. Token buckets limit the number of IO calls per second, globally and for 
+ * every process separately, and the number of bytes read and written per second. They work on top of 
+ * any timing mode: a call that would exceed one of the limits is delayed until enough tokens are available.
+ *
+ * A bucket holds at most THROTTLE_BURST seconds worth of tokens. A call bigger than the bucket still 
+ * passes, but leaves the bucket in debt which the following calls have to wait out.
+ *
+ * Per process buckets are kept in a hash_table, where the key is a pid and data are throttle_pid_t structs.
+ */
+
+#include <stdint.h>
+#include "adt/hash_table.h"
+#include "common.h"
+
+#define THROTTLE_BURST 0.01 ///< capacity of a bucket, in seconds of its rate
+#define THROTTLE_PID_HT_SIZE 1024
+
+typedef struct token_bucket {
+	double rate; ///< tokens per second, 0 = unlimited
+	double tokens; ///< tokens available, negative if in debt
+	uint64_t last; ///< time of the last refill in usec
+} token_bucket_t;
+
+typedef struct throttle_pid {
+	item_t item;
+	key_t pid;
+	token_bucket_t bucket;
+} throttle_pid_t;
+
+int throttle_init(double iops, double pid_iops, double bandwidth);
+int throttle_enabled();
+void throttle_io(int32_t pid, int64_t size);
+void throttle_report();
+void throttle_finish();
+
+#endif
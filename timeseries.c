@@ -0,0 +1,424 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+
+#include "rependian.h"
+#include "common.h"
+#include "in_common.h"
+#include "timeseries.h"
+
+int64_t timeseries_len = 0; ///< length of a window in usec, 0 = export not enabled
+int64_t timeseries_first = -1; ///< start of the first window in usec
+int64_t timeseries_base = 0; ///< index of the oldest window kept
+int64_t timeseries_last = -1; ///< index of the newest window used
+int64_t timeseries_late = 0; ///< calls which came after their window was written
+int64_t timeseries_rows = 0;
+timeseries_window_t * timeseries_windows = NULL;
+int64_t timeseries_nwindows = 0; ///< size of the ring of windows
+FILE * timeseries_csv = NULL;
+FILE * timeseries_bin = NULL;
+
+static int ht_compare_timeseries_pid(key_t *key, item_t *item) {
+	return hash_table_entry(item, timeseries_pid_t, item)->pid == *key;
+}
+
+static void ht_remove_callback_timeseries_pid(item_t * item) {
+	free(hash_table_entry(item, timeseries_pid_t, item));
+}
+
+static hash_table_operations_t ht_ops_timeseries_pid = {
+	.hash = ht_hash_int,
+	.compare = ht_compare_timeseries_pid,
+	.remove_callback = ht_remove_callback_timeseries_pid
+};
+
+/** Parses length of a window: number with optional unit us, ms, s (default) or min.
+ *
+ * @return length in usec, -1 on error
+ */
+
+static int64_t timeseries_parse_len(const char * str) {
+	char * end;
+	double v = strtod(str, &end);
+
+	if (end == str || v <= 0) {
+		return -1;
+	}
+	if ( ! strcmp(end, "us")) {
+		;
+	} else if ( ! strcmp(end, "ms")) {
+		v *= 1000;
+	} else if ( ! strcmp(end, "s") || ! *end) {
+		v *= 1000000;
+	} else if ( ! strcmp(end, "min")) {
+		v *= 60000000;
+	} else {
+		return -1;
+	}
+	return v >= 1 ? (int64_t) v : -1;
+}
+
+static int timeseries_bin_header() {
+	int32_t i32 = htole32(TIMESERIES_VERSION);
+	int64_t i64 = htole64(timeseries_len);
+
+	if (fwrite(TIMESERIES_MAGIC, 4, 1, timeseries_bin) != 1 || fwrite(&i32, sizeof(i32), 1, timeseries_bin) != 1
+			|| fwrite(&i64, sizeof(i64), 1, timeseries_bin) != 1) {
+		return -1;
+	}
+	return 0;
+}
+
+/** Starts the export.
+ *
+ * @arg spec <length>[:<file>], where <length> is length of a window (see timeseries_parse_len()) and windows are
+ *           written to <file>.csv and <file>.tsb ("timeseries" by default)
+ * @return 0 on success, -1 on error
+ */
+
+int timeseries_init(const char * spec) {
+	char len[MAX_STRING], name[MAX_STRING + 8];
+	const char * file = "timeseries";
+	const char * colon = strchr(spec, ':');
+	int64_t i;
+
+	strncpy(len, spec, MAX_STRING);
+	len[MAX_STRING-1] = 0;
+	if (colon) {
+		len[colon - spec] = 0;
+		file = colon + 1;
+	}
+	if ( (timeseries_len = timeseries_parse_len(len)) < 0) {
+		ERRORPRINTF("Wrong length of a window: %s\n", len);
+		timeseries_len = 0;
+		return -1;
+	}
+
+	snprintf(name, sizeof(name), "%s.csv", file);
+	if ( (timeseries_csv = fopen(name, "w")) == NULL) {
+		ERRORPRINTF("Error opening file %s: %s\n", name, strerror(errno));
+		return -1;
+	}
+	snprintf(name, sizeof(name), "%s.tsb", file);
+	if ( (timeseries_bin = fopen(name, "wb")) == NULL) {
+		ERRORPRINTF("Error opening file %s: %s\n", name, strerror(errno));
+		return -1;
+	}
+	if (timeseries_bin_header() != 0) {
+		ERRORPRINTF("Error writing file %s: %s\n", name, strerror(errno));
+		return -1;
+	}
+	fprintf(timeseries_csv, "time,pid,reads,writes,read_bytes,write_bytes,read_p50_us,read_p99_us,read_max_us,"
+			"write_p50_us,write_p99_us,write_max_us,opens,stats,metadata\n");
+
+	timeseries_nwindows = TIMESERIES_LAG / timeseries_len + 2;
+	if (timeseries_nwindows > TIMESERIES_MAX_WINDOWS) {
+		timeseries_nwindows = TIMESERIES_MAX_WINDOWS;
+	}
+	timeseries_windows = malloc(timeseries_nwindows * sizeof(timeseries_window_t));
+	for (i = 0; i < timeseries_nwindows; i++) {
+		timeseries_windows[i].index = -1;
+	}
+	timeseries_first = timeseries_last = -1;
+	timeseries_base = timeseries_late = timeseries_rows = 0;
+	return 0;
+}
+
+int timeseries_enabled() {
+	return timeseries_len > 0;
+}
+
+/** @return latency in usec below which fraction @a p of calls falls, at most the maximal one */
+
+static uint32_t timeseries_percentile(replay_stats_t * stats, double p) {
+	uint64_t lat = replay_stats_percentile(stats, p);
+
+	return (lat < stats->io_max ? lat : stats->io_max) / 1000;
+}
+
+/** Writes one row to the CSV and binary output.
+ *
+ * @arg start start of the window in usec since the first one
+ * @arg pid process, -1 for the whole trace
+ */
+
+static void timeseries_write(int64_t start, int32_t pid, timeseries_counters_t * c) {
+	uint32_t lat[6], u32[5];
+	int64_t i64[3];
+	int32_t i32;
+	int i;
+
+	lat[0] = timeseries_percentile(&c->read, 0.5);
+	lat[1] = timeseries_percentile(&c->read, 0.99);
+	lat[2] = c->read.io_max / 1000;
+	lat[3] = timeseries_percentile(&c->write, 0.5);
+	lat[4] = timeseries_percentile(&c->write, 0.99);
+	lat[5] = c->write.io_max / 1000;
+
+	fprintf(timeseries_csv, "%.6lf,", start / 1000000.0);
+	if (pid < 0) {
+		fprintf(timeseries_csv, "all,");
+	} else {
+		fprintf(timeseries_csv, "%d,", pid);
+	}
+	fprintf(timeseries_csv, "%"PRIi64",%"PRIi64",%"PRIi64",%"PRIi64",%u,%u,%u,%u,%u,%u,%"PRIi64",%"PRIi64",%"PRIi64"\n",
+			c->read.io_calls, c->write.io_calls, c->read.io_bytes, c->write.io_bytes,
+			lat[0], lat[1], lat[2], lat[3], lat[4], lat[5], c->opens, c->stats, c->meta);
+
+	i64[0] = htole64(start);
+	i32 = htole32(pid);
+	u32[0] = htole32(c->read.io_calls);
+	u32[1] = htole32(c->write.io_calls);
+	u32[2] = htole32(c->opens);
+	u32[3] = htole32(c->stats);
+	u32[4] = htole32(c->meta);
+	i64[1] = htole64(c->read.io_bytes);
+	i64[2] = htole64(c->write.io_bytes);
+	for (i = 0; i < 6; i++) {
+		lat[i] = htole32(lat[i]);
+	}
+	fwrite(&i64[0], sizeof(int64_t), 1, timeseries_bin);
+	fwrite(&i32, sizeof(int32_t), 1, timeseries_bin);
+	fwrite(u32, sizeof(uint32_t), 5, timeseries_bin);
+	fwrite(&i64[1], sizeof(int64_t), 2, timeseries_bin);
+	fwrite(lat, sizeof(uint32_t), 6, timeseries_bin);
+	timeseries_rows++;
+}
+
+static timeseries_pid_t ** timeseries_pid_list;
+static int64_t timeseries_npids;
+
+static void timeseries_collect_pid(item_t * item) {
+	timeseries_pid_list[timeseries_npids++] = hash_table_entry(item, timeseries_pid_t, item);
+}
+
+static int timeseries_compare_pid(const void * a, const void * b) {
+	key_t pa = (*(timeseries_pid_t * const *) a)->pid, pb = (*(timeseries_pid_t * const *) b)->pid;
+
+	return pa < pb ? -1 : pa > pb;
+}
+
+/** Writes the oldest window kept, its total and every process ordered by pid, and frees it. */
+
+static void timeseries_flush() {
+	timeseries_window_t * w = &timeseries_windows[timeseries_base % timeseries_nwindows];
+	int64_t start = timeseries_base * timeseries_len, i;
+
+	if (w->index < 0) { //nothing happened in the window
+		timeseries_counters_t c;
+
+		memset(&c, 0, sizeof(c));
+		timeseries_write(start, -1, &c);
+	} else {
+		timeseries_write(start, -1, &w->all);
+		timeseries_pid_list = malloc(w->npids * sizeof(timeseries_pid_t *));
+		timeseries_npids = 0;
+		hash_table_apply(&w->pids, timeseries_collect_pid);
+		qsort(timeseries_pid_list, timeseries_npids, sizeof(timeseries_pid_t *), timeseries_compare_pid);
+		for (i = 0; i < timeseries_npids; i++) {
+			timeseries_write(start, timeseries_pid_list[i]->pid, &timeseries_pid_list[i]->c);
+		}
+		free(timeseries_pid_list);
+		hash_table_destroy(&w->pids);
+		w->index = -1;
+	}
+	timeseries_base++;
+}
+
+/** @return counters of window @a index for the whole trace, the ones of @a pid are stored to @a pc */
+
+static timeseries_counters_t * timeseries_get(int64_t index, int32_t pid, timeseries_counters_t ** pc) {
+	timeseries_window_t * w = &timeseries_windows[index % timeseries_nwindows];
+	timeseries_pid_t * p;
+	item_t * item;
+	key_t key = pid;
+
+	if (w->index < 0) {
+		w->index = index;
+		w->npids = 0;
+		memset(&w->all, 0, sizeof(w->all));
+		hash_table_init(&w->pids, TIMESERIES_HT_SIZE, &ht_ops_timeseries_pid);
+	}
+	if ( (item = hash_table_find(&w->pids, &key)) == NULL) {
+		p = calloc(1, sizeof(timeseries_pid_t));
+		item_init(&p->item);
+		p->pid = pid;
+		hash_table_insert(&w->pids, &p->pid, &p->item);
+		w->npids++;
+	} else {
+		p = hash_table_entry(item, timeseries_pid_t, item);
+	}
+	*pc = &p->c;
+	return &w->all;
+}
+
+/** Accounts one call into its window.
+ *
+ * @arg type OP_* type of the call
+ * @arg info pid, start and duration of the call
+ * @arg bytes bytes read or written by reads and writes
+ */
+
+static void timeseries_add(char type, op_info_t * info, int64_t bytes) {
+	int64_t start = (int64_t) info->start.tv_sec * 1000000 + info->start.tv_usec;
+	int64_t index;
+	timeseries_counters_t * all, * pc;
+	uint64_t lat = info->dur > 0 ? (uint64_t) info->dur * 1000 : 0;
+
+	if (timeseries_first < 0) {
+		timeseries_first = start - start % timeseries_len;
+	}
+	index = (start - timeseries_first) / timeseries_len;
+	if (start < timeseries_first || index < timeseries_base) {
+		index = timeseries_base;
+		timeseries_late++;
+	}
+	while (index >= timeseries_base + timeseries_nwindows) {
+		timeseries_flush();
+	}
+	if (index > timeseries_last) {
+		timeseries_last = index;
+	}
+
+	all = timeseries_get(index, info->pid, &pc);
+	switch (type) {
+		case OP_READ:
+		case OP_PREAD:
+			replay_stats_add(&all->read, bytes, lat);
+			replay_stats_add(&pc->read, bytes, lat);
+			break;
+		case OP_WRITE:
+		case OP_PWRITE:
+			replay_stats_add(&all->write, bytes, lat);
+			replay_stats_add(&pc->write, bytes, lat);
+			break;
+		case OP_OPEN:
+			all->opens++;
+			pc->opens++;
+			break;
+		case OP_STAT:
+		case OP_ACCESS:
+			all->stats++;
+			pc->stats++;
+			break;
+		default:
+			all->meta++;
+			pc->meta++;
+			break;
+	}
+}
+
+/** Accounts all calls of @a list. Passed to the streaming loaders (see strace_stream_items()). */
+
+void timeseries_consume(list_t * list) {
+	item_t * item;
+	common_op_item_t * com_it;
+	sendfile_item_t * sendfile_it;
+
+	for (item = list->head; item; item = item->next) {
+		com_it = list_entry(item, common_op_item_t, item);
+		switch (com_it->type) {
+			case OP_READ:
+				timeseries_add(com_it->type, &((read_item_t *) com_it)->o.info, ((read_item_t *) com_it)->o.retval);
+				break;
+			case OP_PREAD:
+				timeseries_add(com_it->type, &((pread_item_t *) com_it)->o.info, ((pread_item_t *) com_it)->o.retval);
+				break;
+			case OP_WRITE:
+				timeseries_add(com_it->type, &((write_item_t *) com_it)->o.info, ((write_item_t *) com_it)->o.retval);
+				break;
+			case OP_PWRITE:
+				timeseries_add(com_it->type, &((pwrite_item_t *) com_it)->o.info, ((pwrite_item_t *) com_it)->o.retval);
+				break;
+			case OP_SENDFILE: //both read and write
+				sendfile_it = (sendfile_item_t *) com_it;
+				timeseries_add(OP_READ, &sendfile_it->o.info, sendfile_it->o.retval);
+				timeseries_add(OP_WRITE, &sendfile_it->o.info, sendfile_it->o.retval);
+				break;
+			case OP_OPEN:
+				timeseries_add(com_it->type, &((open_item_t *) com_it)->o.info, 0);
+				break;
+			case OP_STAT:
+				timeseries_add(com_it->type, &((stat_item_t *) com_it)->o.info, 0);
+				break;
+			case OP_ACCESS:
+				timeseries_add(com_it->type, &((access_item_t *) com_it)->o.info, 0);
+				break;
+			case OP_UNLINK:
+				timeseries_add(com_it->type, &((unlink_item_t *) com_it)->o.info, 0);
+				break;
+			case OP_MKDIR:
+				timeseries_add(com_it->type, &((mkdir_item_t *) com_it)->o.info, 0);
+				break;
+			case OP_RMDIR:
+				timeseries_add(com_it->type, &((rmdir_item_t *) com_it)->o.info, 0);
+				break;
+			case OP_RENAME:
+				timeseries_add(com_it->type, &((rename_item_t *) com_it)->o.info, 0);
+				break;
+			case OP_LINK:
+			case OP_SYMLINK:
+				timeseries_add(com_it->type, &((link_item_t *) com_it)->o.info, 0);
+				break;
+			case OP_READLINK:
+				timeseries_add(com_it->type, &((readlink_item_t *) com_it)->o.info, 0);
+				break;
+			case OP_GETDENTS:
+				timeseries_add(com_it->type, &((getdents_item_t *) com_it)->o.info, 0);
+				break;
+			default: //not IO nor metadata
+				break;
+		}
+	}
+}
+
+/** Writes the windows still kept and closes the output.
+ *
+ * @return 0 on success, -1 on error
+ */
+
+int timeseries_finish() {
+	int retval = 0;
+
+	if ( ! timeseries_enabled()) {
+		return 0;
+	}
+	while (timeseries_base <= timeseries_last) {
+		timeseries_flush();
+	}
+	if (timeseries_late) {
+		DEBUGPRINTF("%"PRIi64" calls started more than %d usec before the last one, counted in later windows.\n",
+				timeseries_late, TIMESERIES_LAG);
+	}
+	DEBUGPRINTF("%"PRIi64" windows of %"PRIi64" usec, %"PRIi64" rows written.\n", timeseries_base, timeseries_len,
+			timeseries_rows);
+	if (fclose(timeseries_csv) != 0 || fclose(timeseries_bin) != 0) {
+		ERRORPRINTF("Error writing time series: %s\n", strerror(errno));
+		retval = -1;
+	}
+	free(timeseries_windows);
+	timeseries_windows = NULL;
+	timeseries_len = 0;
+	return retval;
+}
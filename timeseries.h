@@ -0,0 +1,78 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _TIMESERIES_H_
+#define _TIMESERIES_H_
+
+/** @file timeseries.h
+ *
+ * Time series export. Calls of the trace are aggregated into windows of fixed length by their start: reads and
+ * writes (count, bytes, latency percentiles), opens, stats and other metadata calls, for the whole trace and for
+ * every process. Windows are written as CSV and in binary form.
+ *
+ * The trace is streamed (see strace_stream_items()), so it does not have to fit in memory. Calls may come out of
+ * order by up to TIMESERIES_LAG usec (e.g. long calls recorded as unfinished), a window is written once it is that
+ * old. Calls coming even later are counted in the oldest window still kept.
+ *
+ * Binary form: header of magic "IOTS", int32 version, int64 window length in usec, followed by records of
+ * int64 start of the window in usec since the first window, int32 pid (-1 for the whole trace), uint32 reads,
+ * writes, opens, stats and metadata calls, int64 bytes read and written and uint32 p50, p99 and maximum latency
+ * of reads and writes in usec. All little endian, 72 bytes per record.
+ */
+
+#include <stdint.h>
+#include "common.h"
+#include "replicate.h"
+#include "adt/hash_table.h"
+
+#define TIMESERIES_MAGIC "IOTS"
+#define TIMESERIES_VERSION 1
+#define TIMESERIES_LAG 10000000 ///< how long (usec) a window waits for late calls
+#define TIMESERIES_MAX_WINDOWS 65536 ///< maximum number of windows kept at once
+#define TIMESERIES_CHUNK 65536 ///< number of calls loaded at once
+#define TIMESERIES_HT_SIZE 64
+
+/** Counters of one window, for the whole trace or one process. */
+typedef struct timeseries_counters {
+	replay_stats_t read; ///< number, bytes and latencies of reads
+	replay_stats_t write;
+	int64_t opens;
+	int64_t stats; ///< stat and access
+	int64_t meta; ///< other metadata calls: unlink, mkdir, rmdir, rename, link, readlink, getdents
+} timeseries_counters_t;
+
+typedef struct timeseries_pid {
+	item_t item;
+	key_t pid;
+	timeseries_counters_t c;
+} timeseries_pid_t;
+
+typedef struct timeseries_window {
+	int64_t index; ///< number of the window since the first one, -1 if unused
+	timeseries_counters_t all;
+	hash_table_t pids;
+	int64_t npids;
+} timeseries_window_t;
+
+int timeseries_init(const char * spec);
+int timeseries_enabled();
+void timeseries_consume(list_t * list);
+int timeseries_finish();
+
+#endif
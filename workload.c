@@ -0,0 +1,1007 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+
+#include "common.h"
+#include "workload.h"
+#include "in_binary.h"
+
+char workload_model[MAX_STRING] = ""; ///< model file to extract to, empty = extraction not enabled
+hash_table_t workload_files;
+hash_table_t workload_procs;
+hash_table_t workload_dirs;
+workload_file_t ** workload_file_list = NULL; ///< files by their number
+int32_t workload_nfiles = 0;
+int32_t workload_files_size = 0;
+workload_proc_t ** workload_proc_list = NULL; ///< processes by their number
+int32_t workload_nprocs = 0;
+int32_t workload_procs_size = 0;
+int32_t workload_ndirs = 0;
+int64_t workload_first = INT64_MAX; ///< start of the first call
+int64_t workload_last = INT64_MIN; ///< end of the last call
+int64_t workload_duration = 0;
+workload_hist_t workload_durs[3]; ///< durations of reads, writes and metadata calls
+uint64_t workload_rand_state = WORKLOAD_SEED;
+
+static const char * workload_dur_names[3] = { "read", "write", "meta" };
+
+static int ht_compare_workload_file(key_t *key, item_t *item) {
+	return ! strncmp(hash_table_entry(item, workload_file_t, item)->name, (char *) key, MAX_STRING);
+}
+
+static int ht_compare_workload_dir(key_t *key, item_t *item) {
+	return ! strncmp(hash_table_entry(item, workload_dir_t, item)->name, (char *) key, MAX_STRING);
+}
+
+static int ht_compare_workload_proc(key_t *key, item_t *item) {
+	return hash_table_entry(item, workload_proc_t, item)->pid == *key;
+}
+
+static void ht_remove_callback_workload_file(item_t * item) {
+	free(hash_table_entry(item, workload_file_t, item));
+}
+
+static void ht_remove_callback_workload_dir(item_t * item) {
+	free(hash_table_entry(item, workload_dir_t, item));
+}
+
+static void ht_remove_callback_workload_proc(item_t * item) {
+	workload_proc_t * proc = hash_table_entry(item, workload_proc_t, item);
+
+	free(proc->uses);
+	free(proc);
+}
+
+static hash_table_operations_t ht_ops_workload_file = {
+	.hash = ht_hash_str,
+	.compare = ht_compare_workload_file,
+	.remove_callback = ht_remove_callback_workload_file
+};
+
+static hash_table_operations_t ht_ops_workload_dir = {
+	.hash = ht_hash_str,
+	.compare = ht_compare_workload_dir,
+	.remove_callback = ht_remove_callback_workload_dir
+};
+
+static hash_table_operations_t ht_ops_workload_proc = {
+	.hash = ht_hash_int,
+	.compare = ht_compare_workload_proc,
+	.remove_callback = ht_remove_callback_workload_proc
+};
+
+static void workload_tables_init() {
+	hash_table_init(&workload_files, WORKLOAD_HT_SIZE, &ht_ops_workload_file);
+	hash_table_init(&workload_procs, WORKLOAD_HT_SIZE, &ht_ops_workload_proc);
+	hash_table_init(&workload_dirs, WORKLOAD_HT_SIZE, &ht_ops_workload_dir);
+	memset(workload_durs, 0, sizeof(workload_durs));
+	workload_nfiles = workload_nprocs = workload_ndirs = 0;
+	workload_first = INT64_MAX;
+	workload_last = INT64_MIN;
+}
+
+/** Starts extraction of a model.
+ *
+ * @arg model file to write the model to
+ * @return 0 on success, -1 on error
+ */
+
+int workload_init(const char * model) {
+	strncpy(workload_model, model, MAX_STRING);
+	workload_model[MAX_STRING-1] = 0;
+	workload_tables_init();
+	return 0;
+}
+
+int workload_enabled() {
+	return workload_model[0] != 0;
+}
+
+static inline int workload_bucket(int64_t v) {
+	int b = 0;
+
+	for (; v > 0 && b < WORKLOAD_BUCKETS - 1; v >>= 1) {
+		b++;
+	}
+	return b;
+}
+
+static inline void workload_hist_add(workload_hist_t * h, int64_t v) {
+	int b = workload_bucket(v);
+
+	h->count[b]++;
+	h->sum[b] += v > 0 ? v : 0;
+}
+
+static workload_file_t * workload_new_file() {
+	workload_file_t * file = calloc(1, sizeof(workload_file_t));
+
+	item_init(&file->item);
+	file->id = workload_nfiles;
+	file->last_proc = -1;
+	if (workload_nfiles == workload_files_size) {
+		workload_files_size = workload_files_size ? 2 * workload_files_size : 1024;
+		workload_file_list = realloc(workload_file_list, workload_files_size * sizeof(workload_file_t *));
+	}
+	workload_file_list[workload_nfiles++] = file;
+	return file;
+}
+
+static workload_proc_t * workload_new_proc() {
+	workload_proc_t * proc = calloc(1, sizeof(workload_proc_t));
+
+	item_init(&proc->item);
+	proc->id = workload_nprocs;
+	proc->prev = -1;
+	proc->first = INT64_MAX;
+	proc->last = INT64_MIN;
+	if (workload_nprocs == workload_procs_size) {
+		workload_procs_size = workload_procs_size ? 2 * workload_procs_size : 1024;
+		workload_proc_list = realloc(workload_proc_list, workload_procs_size * sizeof(workload_proc_t *));
+	}
+	workload_proc_list[workload_nprocs++] = proc;
+	return proc;
+}
+
+/** @return number of the directory of file @a name */
+
+static int32_t workload_get_dir(const char * name) {
+	char dir[MAX_STRING];
+	char * slash;
+	workload_dir_t * d;
+	item_t * item;
+
+	strncpy(dir, name, MAX_STRING);
+	dir[MAX_STRING-1] = 0;
+	if ( (slash = strrchr(dir, '/')) != NULL) {
+		*slash = 0;
+	} else {
+		dir[0] = 0;
+	}
+	if ( (item = hash_table_find(&workload_dirs, (key_t *) dir)) != NULL) {
+		return hash_table_entry(item, workload_dir_t, item)->id;
+	}
+	d = malloc(sizeof(workload_dir_t));
+	item_init(&d->item);
+	strncpy(d->name, dir, MAX_STRING);
+	d->id = workload_ndirs++;
+	hash_table_insert(&workload_dirs, (key_t *) d->name, &d->item);
+	return d->id;
+}
+
+static workload_file_t * workload_get_file(const char * name) {
+	workload_file_t * file;
+	item_t * item;
+
+	if ( (item = hash_table_find(&workload_files, (key_t *) name)) != NULL) {
+		return hash_table_entry(item, workload_file_t, item);
+	}
+	file = workload_new_file();
+	strncpy(file->name, name, MAX_STRING);
+	file->name[MAX_STRING-1] = 0;
+	file->dir = workload_get_dir(name);
+	hash_table_insert(&workload_files, (key_t *) file->name, &file->item);
+	return file;
+}
+
+static workload_proc_t * workload_get_proc(int32_t pid) {
+	workload_proc_t * proc;
+	item_t * item;
+	key_t key = pid;
+
+	if ( (item = hash_table_find(&workload_procs, &key)) != NULL) {
+		return hash_table_entry(item, workload_proc_t, item);
+	}
+	proc = workload_new_proc();
+	proc->pid = pid;
+	hash_table_insert(&workload_procs, &proc->pid, &proc->item);
+	return proc;
+}
+
+/** Adds @a calls calls of process @a proc on file @a file. */
+
+static void workload_use(workload_proc_t * proc, workload_file_t * file, int64_t calls) {
+	int64_t u;
+
+	if (file->last_proc == proc->id) {
+		u = file->last_use;
+	} else {
+		for (u = 0; u < proc->nuses && proc->uses[u].file != file->id; u++)
+			;
+		if (u == proc->nuses) {
+			if (proc->nuses == proc->size) {
+				proc->size = proc->size ? 2 * proc->size : 16;
+				proc->uses = realloc(proc->uses, proc->size * sizeof(workload_use_t));
+			}
+			proc->uses[u].file = file->id;
+			proc->uses[u].calls = 0;
+			proc->nuses++;
+		}
+		file->last_proc = proc->id;
+		file->last_use = u;
+	}
+	proc->uses[u].calls += calls;
+	proc->total += calls;
+}
+
+/** Notes one read or write. Called by simulate_* functions, which know the file behind the descriptor.
+ *
+ * @arg pid process which did the call
+ * @arg name name of the file
+ * @arg offset offset of the call
+ * @arg size number of bytes the call transferred
+ * @arg write whether it was a write
+ * @arg dur duration of the call in usec
+ */
+
+void workload_add_rw(int32_t pid, const char * name, int64_t offset, int64_t size, int write, int32_t dur) {
+	workload_file_t * file = workload_get_file(name);
+	int64_t delta;
+
+	if (size <= 0) {
+		return;
+	}
+	if (file->reads + file->writes == 0) {
+		file->populate = ! write;
+	} else {
+		delta = offset - file->prev_offset;
+		if (offset == file->prev_end) {
+			file->seq++;
+		} else if (delta != 0 && delta == file->prev_delta) {
+			file->strided++;
+			file->stride = delta;
+		} else {
+			file->random++;
+		}
+		file->prev_delta = delta;
+	}
+	file->prev_offset = offset;
+	file->prev_end = offset + size;
+	if (file->prev_end > file->size) {
+		file->size = file->prev_end;
+	}
+	if (write) {
+		file->writes++;
+		file->write_bytes += size;
+	} else {
+		file->reads++;
+		file->read_bytes += size;
+	}
+	workload_hist_add(&file->sizes, size);
+	workload_hist_add(&workload_durs[write ? WORKLOAD_WRITE : WORKLOAD_READ], dur);
+	workload_use(workload_get_proc(pid), file, 1);
+}
+
+/** @return kind of call of type @a type (WORKLOAD_*), -1 if it is not modeled */
+
+static int workload_kind(char type) {
+	switch (type) {
+		case OP_READ:
+		case OP_PREAD:
+		case OP_SENDFILE:
+			return WORKLOAD_READ;
+		case OP_WRITE:
+		case OP_PWRITE:
+			return WORKLOAD_WRITE;
+		case OP_OPEN:
+			return WORKLOAD_OPEN;
+		case OP_STAT:
+		case OP_ACCESS:
+			return WORKLOAD_STAT;
+		case OP_UNLINK:
+		case OP_MKDIR:
+		case OP_RMDIR:
+		case OP_RENAME:
+		case OP_LINK:
+		case OP_SYMLINK:
+		case OP_READLINK:
+		case OP_GETDENTS:
+			return WORKLOAD_META;
+		default:
+			return -1;
+	}
+}
+
+/** Takes per process call counts, gaps and active time and durations of metadata calls from the trace. Has to
+ * be called after the simulation.
+ */
+
+void workload_scan(list_t * list) {
+	common_op_item_t * com_it;
+	workload_proc_t * proc;
+	op_info_t * info;
+	item_t * item;
+	int64_t start;
+	int kind;
+
+	for (item = list->head; item; item = item->next) {
+		com_it = list_entry(item, common_op_item_t, item);
+		if ( (info = get_item_info(com_it)) == NULL) {
+			continue;
+		}
+		start = (int64_t) info->start.tv_sec * 1000000 + info->start.tv_usec;
+		if (start < workload_first) {
+			workload_first = start;
+		}
+		if (start + info->dur > workload_last) {
+			workload_last = start + info->dur;
+		}
+		if ( (kind = workload_kind(com_it->type)) < 0) {
+			continue;
+		}
+		proc = workload_get_proc(info->pid);
+		proc->calls[kind]++;
+		if (proc->prev >= 0) {
+			workload_hist_add(&proc->gaps, start - proc->prev);
+		}
+		proc->prev = start;
+		if (start < proc->first) {
+			proc->first = start;
+		}
+		if (start > proc->last) {
+			proc->last = start;
+		}
+		if (kind >= WORKLOAD_OPEN) {
+			workload_hist_add(&workload_durs[2], info->dur);
+		}
+	}
+}
+
+static void workload_save_hist(FILE * f, const char * what, int64_t id, workload_hist_t * h) {
+	int b;
+
+	for (b = 0; b < WORKLOAD_BUCKETS; b++) {
+		if (h->count[b]) {
+			fprintf(f, "%s %"PRIi64" %d %"PRIi64" %"PRIi64"\n", what, id, b, h->count[b], h->sum[b]);
+		}
+	}
+}
+
+/** Writes the model extracted by workload_add_rw() and workload_scan() to the file given to workload_init().
+ *
+ * @return 0 on success, -1 on error
+ */
+
+int workload_extract() {
+	workload_file_t * file;
+	workload_proc_t * proc;
+	FILE * f;
+	int64_t i, u;
+	int b, k;
+
+	if ( (f = fopen(workload_model, "w")) == NULL) {
+		ERRORPRINTF("Error opening file %s: %s\n", workload_model, strerror(errno));
+		return -1;
+	}
+	fprintf(f, "# ioreplay workload model: %d files in %d directories, %d processes\n", workload_nfiles, workload_ndirs,
+			workload_nprocs);
+	fprintf(f, "model %d\n", WORKLOAD_VERSION);
+	fprintf(f, "duration %"PRIi64"\n", workload_last > workload_first ? workload_last - workload_first : 0);
+	for (i = 0; i < workload_nfiles; i++) {
+		file = workload_file_list[i];
+		fprintf(f, "file %d %d %"PRIi64" %"PRIi64" %"PRIi64" %"PRIi64" %"PRIi64" %"PRIi64" %"PRIi64" %"PRIi64" %"PRIi64" %d\n",
+				file->id, file->dir, file->size, file->seq, file->strided, file->random, file->stride, file->reads,
+				file->writes, file->read_bytes, file->write_bytes, file->populate);
+		workload_save_hist(f, "size", file->id, &file->sizes);
+	}
+	for (i = 0; i < workload_nprocs; i++) {
+		proc = workload_proc_list[i];
+		if (proc->first > proc->last) { //no modeled calls
+			continue;
+		}
+		fprintf(f, "process %d %"PRIi64" %"PRIi64, proc->id, proc->first - workload_first, proc->last - workload_first);
+		for (k = 0; k < WORKLOAD_KINDS; k++) {
+			fprintf(f, " %"PRIi64, proc->calls[k]);
+		}
+		fprintf(f, "\n");
+		workload_save_hist(f, "gap", proc->id, &proc->gaps);
+		for (u = 0; u < proc->nuses; u++) {
+			fprintf(f, "use %d %d %"PRIi64"\n", proc->id, proc->uses[u].file, proc->uses[u].calls);
+		}
+	}
+	for (k = 0; k < 3; k++) {
+		for (b = 0; b < WORKLOAD_BUCKETS; b++) {
+			if (workload_durs[k].count[b]) {
+				fprintf(f, "dur %s %d %"PRIi64" %"PRIi64"\n", workload_dur_names[k], b, workload_durs[k].count[b],
+						workload_durs[k].sum[b]);
+			}
+		}
+	}
+	if (fclose(f) != 0) {
+		ERRORPRINTF("Error writing file %s: %s\n", workload_model, strerror(errno));
+		return -1;
+	}
+	DEBUGPRINTF("Model of %d files and %d processes written to %s\n", workload_nfiles, workload_nprocs, workload_model);
+	return 0;
+}
+
+/** Reads model @a model written by workload_extract().
+ *
+ * @return 0 on success, -1 on error
+ */
+
+static int workload_load(const char * model) {
+	char line[MAX_LINE], what[16];
+	workload_file_t * file;
+	workload_proc_t * proc;
+	int64_t v[12];
+	int32_t id, id2;
+	int64_t linenum = 0;
+	int b, k, version = 0;
+	FILE * f;
+
+	if ( (f = fopen(model, "r")) == NULL) {
+		ERRORPRINTF("Error opening file %s: %s\n", model, strerror(errno));
+		return -1;
+	}
+	workload_tables_init();
+	while (fgets(line, MAX_LINE, f) != NULL) {
+		linenum++;
+		if (line[0] == '#' || line[0] == '\n') {
+			continue;
+		}
+		if (sscanf(line, "%15s", what) != 1) {
+			goto error;
+		}
+		if ( ! strcmp(what, "model")) {
+			if (sscanf(line, "model %d", &version) != 1 || version != WORKLOAD_VERSION) {
+				ERRORPRINTF("Unsupported model version in %s\n", model);
+				fclose(f);
+				return -1;
+			}
+		} else if ( ! strcmp(what, "duration")) {
+			if (sscanf(line, "duration %"SCNi64, &workload_duration) != 1) {
+				goto error;
+			}
+		} else if ( ! strcmp(what, "file")) {
+			if (sscanf(line, "file %d %"SCNi64" %"SCNi64" %"SCNi64" %"SCNi64" %"SCNi64" %"SCNi64" %"SCNi64" %"SCNi64" %"SCNi64" %"SCNi64" %"SCNi64,
+					&id, &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7], &v[8], &v[9], &v[10]) != 12 || id != workload_nfiles) {
+				goto error;
+			}
+			file = workload_new_file();
+			file->dir = v[0];
+			file->size = v[1];
+			file->seq = v[2];
+			file->strided = v[3];
+			file->random = v[4];
+			file->stride = v[5];
+			file->reads = v[6];
+			file->writes = v[7];
+			file->read_bytes = v[8];
+			file->write_bytes = v[9];
+			file->populate = v[10];
+			if (file->dir >= workload_ndirs) {
+				workload_ndirs = file->dir + 1;
+			}
+		} else if ( ! strcmp(what, "size") || ! strcmp(what, "gap")) {
+			if (sscanf(line, "%*s %d %d %"SCNi64" %"SCNi64, &id, &b, &v[0], &v[1]) != 4 || b < 0 || b >= WORKLOAD_BUCKETS) {
+				goto error;
+			}
+			if (what[0] == 's' && id >= 0 && id < workload_nfiles) {
+				workload_file_list[id]->sizes.count[b] = v[0];
+				workload_file_list[id]->sizes.sum[b] = v[1];
+			} else if (what[0] == 'g' && id >= 0 && id < workload_nprocs) {
+				workload_proc_list[id]->gaps.count[b] = v[0];
+				workload_proc_list[id]->gaps.sum[b] = v[1];
+			} else {
+				goto error;
+			}
+		} else if ( ! strcmp(what, "process")) {
+			if (sscanf(line, "process %d %"SCNi64" %"SCNi64" %"SCNi64" %"SCNi64" %"SCNi64" %"SCNi64" %"SCNi64,
+					&id, &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6]) != 8 || id != workload_nprocs) {
+				goto error;
+			}
+			proc = workload_new_proc();
+			proc->first = v[0];
+			proc->last = v[1];
+			for (k = 0; k < WORKLOAD_KINDS; k++) {
+				proc->calls[k] = v[2 + k];
+			}
+		} else if ( ! strcmp(what, "use")) {
+			if (sscanf(line, "use %d %d %"SCNi64, &id, &id2, &v[0]) != 3 || id < 0 || id >= workload_nprocs
+					|| id2 < 0 || id2 >= workload_nfiles) {
+				goto error;
+			}
+			workload_use(workload_proc_list[id], workload_file_list[id2], v[0]);
+		} else if ( ! strcmp(what, "dur")) {
+			if (sscanf(line, "dur %15s %d %"SCNi64" %"SCNi64, what, &b, &v[0], &v[1]) != 4 || b < 0 || b >= WORKLOAD_BUCKETS) {
+				goto error;
+			}
+			for (k = 0; k < 3 && strcmp(what, workload_dur_names[k]); k++)
+				;
+			if (k == 3) {
+				goto error;
+			}
+			workload_durs[k].count[b] = v[0];
+			workload_durs[k].sum[b] = v[1];
+		} else {
+			goto error;
+		}
+	}
+	fclose(f);
+	if (version == 0) {
+		ERRORPRINTF("%s is not a workload model\n", model);
+		return -1;
+	}
+	return 0;
+
+error:
+	ERRORPRINTF("Error parsing model %s on line %"PRIi64"\n", model, linenum);
+	fclose(f);
+	return -1;
+}
+
+/** @return random number from [0, 1) */
+
+static inline double workload_rand() {
+	workload_rand_state ^= workload_rand_state >> 12;
+	workload_rand_state ^= workload_rand_state << 25;
+	workload_rand_state ^= workload_rand_state >> 27;
+	return ((workload_rand_state * 2685821657736338717ULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/** Samples value from histogram @a h: picks a bucket by its count, then either the mean of the bucket (@a mean)
+ * or a uniform value within the bucket.
+ */
+
+static int64_t workload_sample(workload_hist_t * h, int mean) {
+	int64_t total = 0, r;
+	int b;
+
+	for (b = 0; b < WORKLOAD_BUCKETS; b++) {
+		total += h->count[b];
+	}
+	if (total == 0) {
+		return 0;
+	}
+	r = (int64_t) (workload_rand() * total);
+	for (b = 0; b < WORKLOAD_BUCKETS - 1 && r >= h->count[b]; b++) {
+		r -= h->count[b];
+	}
+	if (b == 0) {
+		return 0;
+	}
+	if (mean) {
+		return h->sum[b] / h->count[b];
+	}
+	return ((int64_t) 1 << (b - 1)) + (int64_t) (workload_rand() * ((int64_t) 1 << (b - 1)));
+}
+
+static list_t workload_out; ///< calls generated but not written yet
+static int64_t workload_out_count;
+static FILE * workload_out_file;
+static char * workload_out_name;
+
+static int workload_flush() {
+	int retval = bin_write_items(workload_out_file, workload_out_name, &workload_out);
+
+	remove_items(&workload_out);
+	list_init(&workload_out);
+	workload_out_count = 0;
+	return retval;
+}
+
+static inline void workload_info(op_info_t * info, int32_t pid, int64_t start, int64_t dur) {
+	info->pid = pid;
+	info->dur = dur;
+	info->start.tv_sec = start / 1000000;
+	info->start.tv_usec = start % 1000000;
+}
+
+static int workload_emit(common_op_item_t * com_it) {
+	list_append(&workload_out, &com_it->item);
+	if (++workload_out_count >= WORKLOAD_CHUNK) {
+		return workload_flush();
+	}
+	return 0;
+}
+
+static int workload_emit_named(char type, const char * name, int32_t pid, int64_t start, int64_t dur) {
+	mkdir_item_t * mkdir_it;
+	stat_item_t * stat_it;
+
+	if (type == OP_MKDIR) {
+		mkdir_it = new_mkdir_item();
+		mkdir_it->type = OP_MKDIR;
+		strncpy(mkdir_it->o.name, name, MAX_STRING);
+		mkdir_it->o.mode = 0755;
+		mkdir_it->o.retval = 0;
+		workload_info(&mkdir_it->o.info, pid, start, dur);
+		return workload_emit((common_op_item_t *) mkdir_it);
+	}
+	stat_it = new_stat_item();
+	stat_it->type = OP_STAT;
+	strncpy(stat_it->o.name, name, MAX_STRING);
+	stat_it->o.retval = 0;
+	workload_info(&stat_it->o.info, pid, start, dur);
+	return workload_emit((common_op_item_t *) stat_it);
+}
+
+static int workload_emit_clone(int32_t pid, int64_t start) {
+	clone_item_t * clone_it = new_clone_item();
+
+	clone_it->type = OP_CLONE;
+	clone_it->o.mode = 0; //descriptors of the init process, i.e. just the standard ones
+	clone_it->o.retval = pid;
+	workload_info(&clone_it->o.info, WORKLOAD_INIT_PID, start, 0);
+	return workload_emit((common_op_item_t *) clone_it);
+}
+
+static int workload_emit_open(const char * name, int32_t fd, int32_t pid, int64_t start, int64_t dur) {
+	open_item_t * open_it = new_open_item();
+
+	open_it->type = OP_OPEN;
+	strncpy(open_it->o.name, name, MAX_STRING);
+	open_it->o.flags = O_RDWR | O_CREAT;
+	open_it->o.mode = 0644;
+	open_it->o.retval = fd;
+	workload_info(&open_it->o.info, pid, start, dur);
+	return workload_emit((common_op_item_t *) open_it);
+}
+
+static int workload_emit_close(int32_t fd, int32_t pid, int64_t start) {
+	close_item_t * close_it = new_close_item();
+
+	close_it->type = OP_CLOSE;
+	close_it->o.fd = fd;
+	close_it->o.retval = 0;
+	workload_info(&close_it->o.info, pid, start, 0);
+	return workload_emit((common_op_item_t *) close_it);
+}
+
+static int workload_emit_rw(int write, int32_t fd, int64_t offset, int64_t size, int32_t pid, int64_t start, int64_t dur) {
+	pwrite_item_t * pwrite_it;
+	pread_item_t * pread_it;
+
+	if (write) {
+		pwrite_it = new_pwrite_item();
+		pwrite_it->type = OP_PWRITE;
+		pwrite_it->o.fd = fd;
+		pwrite_it->o.size = pwrite_it->o.retval = size;
+		pwrite_it->o.offset = offset;
+		workload_info(&pwrite_it->o.info, pid, start, dur);
+		return workload_emit((common_op_item_t *) pwrite_it);
+	}
+	pread_it = new_pread_item();
+	pread_it->type = OP_PREAD;
+	pread_it->o.fd = fd;
+	pread_it->o.size = pread_it->o.retval = size;
+	pread_it->o.offset = offset;
+	workload_info(&pread_it->o.info, pid, start, dur);
+	return workload_emit((common_op_item_t *) pread_it);
+}
+
+static char workload_root[MAX_STRING / 2]; ///< leaves room for c<copy>/d<dir>/f<file>
+
+static void workload_file_name(char * buf, int32_t copy, workload_file_t * file) {
+	snprintf(buf, MAX_STRING, "%s/c%d/d%d/f%d", workload_root, copy, file->dir, file->id);
+}
+
+/** Emits the setup process: creates directories and writes files which have to exist.
+ *
+ * @return time when the setup is done
+ */
+
+static int64_t workload_setup(int32_t scale, int64_t t) {
+	char name[MAX_STRING];
+	workload_file_t * file;
+	int32_t c, i;
+	int64_t off, size;
+
+	workload_emit_clone(WORKLOAD_PID, t++);
+	workload_emit_named(OP_MKDIR, workload_root, WORKLOAD_PID, t++, 0);
+	for (c = 0; c < scale; c++) {
+		snprintf(name, MAX_STRING, "%s/c%d", workload_root, c);
+		workload_emit_named(OP_MKDIR, name, WORKLOAD_PID, t++, 0);
+		for (i = 0; i < workload_ndirs; i++) {
+			snprintf(name, MAX_STRING, "%s/c%d/d%d", workload_root, c, i);
+			workload_emit_named(OP_MKDIR, name, WORKLOAD_PID, t++, 0);
+		}
+		for (i = 0; i < workload_nfiles; i++) {
+			file = workload_file_list[i];
+			if ( ! file->populate || file->size <= 0) {
+				continue;
+			}
+			workload_file_name(name, c, file);
+			workload_emit_open(name, 3, WORKLOAD_PID, t++, 0);
+			for (off = 0; off < file->size; off += size) {
+				size = file->size - off < WORKLOAD_POPULATE ? file->size - off : WORKLOAD_POPULATE;
+				workload_emit_rw(1, 3, off, size, WORKLOAD_PID, t++, 0);
+			}
+			workload_emit_close(3, WORKLOAD_PID, t++);
+		}
+	}
+	return t;
+}
+
+/** @return offset of the next call of @a size bytes on @a file, whose position in copy is @a pos */
+
+static int64_t workload_offset(workload_file_t * file, int64_t * pos, int64_t size) {
+	int64_t n = file->seq + file->strided + file->random;
+	int64_t span = file->size - size;
+	double r = workload_rand();
+	int64_t off;
+
+	if (n == 0 || r * n < file->seq) {
+		off = *pos;
+	} else if (r * n < file->seq + file->strided) {
+		off = *pos - size + file->stride; //pos is the end of the previous call
+	} else {
+		off = span > 0 ? (int64_t) (workload_rand() * (span / 4096 + 1)) * 4096 : 0;
+	}
+	if (off < 0 || off > span) {
+		off = span > 0 && file->stride < 0 ? span : 0;
+	}
+	*pos = off + size;
+	return off;
+}
+
+/** Picks a use of process @a proc by the number of its calls. */
+
+static int64_t workload_pick_use(workload_proc_t * proc) {
+	int64_t r = (int64_t) (workload_rand() * proc->total), u;
+
+	for (u = 0; u < proc->nuses - 1 && r >= proc->uses[u].calls; u++) {
+		r -= proc->uses[u].calls;
+	}
+	return u;
+}
+
+/** Emits the next call of copy @a gen of a process.
+ *
+ * @return 0 on success, 1 if there was nothing to call, -1 on error
+ */
+
+static int workload_step(workload_gen_t * gen, int64_t * pos) {
+	workload_proc_t * proc = gen->proc;
+	char name[MAX_STRING];
+	workload_file_t * file;
+	int64_t n = 0, r, u, size, dur, off, gap;
+	int kind;
+
+	if (proc->nuses == 0 && workload_nfiles == 0) { //no file to call on, e.g. model of a metadata only trace
+		gap = workload_sample(&proc->gaps, 0);
+		gen->next += gap > 0 ? gap : 1;
+		return 1;
+	}
+	if ( ! gen->started) {
+		if (workload_emit_clone(gen->pid, gen->next) != 0) {
+			return -1;
+		}
+		gen->started = 1;
+	}
+	for (kind = 0; kind < WORKLOAD_KINDS; kind++) {
+		n += proc->calls[kind];
+	}
+	r = (int64_t) (workload_rand() * n);
+	for (kind = 0; kind < WORKLOAD_KINDS - 1 && r >= proc->calls[kind]; kind++) {
+		r -= proc->calls[kind];
+	}
+	if (proc->nuses == 0) { //metadata only process, use any file
+		file = workload_file_list[(int32_t) (workload_rand() * workload_nfiles)];
+		u = -1;
+		if (kind < WORKLOAD_OPEN) {
+			kind = WORKLOAD_STAT;
+		}
+	} else {
+		u = workload_pick_use(proc);
+		file = workload_file_list[proc->uses[u].file];
+	}
+	workload_file_name(name, gen->copy, file);
+
+	switch (kind) {
+		case WORKLOAD_READ:
+		case WORKLOAD_WRITE:
+			if (gen->fds[u] == 0) {
+				gen->fds[u] = gen->next_fd++;
+				if (workload_emit_open(name, gen->fds[u], gen->pid, gen->next, 0) != 0) {
+					return -1;
+				}
+			}
+			if ( (size = workload_sample(&file->sizes, 1)) <= 0) {
+				size = 4096;
+			}
+			off = workload_offset(file, &pos[(int64_t) gen->copy * workload_nfiles + file->id], size);
+			dur = workload_sample(&workload_durs[kind], 0);
+			if (workload_emit_rw(kind == WORKLOAD_WRITE, gen->fds[u], off, size, gen->pid, gen->next, dur) != 0) {
+				return -1;
+			}
+			break;
+		case WORKLOAD_OPEN:
+			dur = workload_sample(&workload_durs[2], 0);
+			if (workload_emit_open(name, gen->next_fd, gen->pid, gen->next, dur) != 0
+					|| workload_emit_close(gen->next_fd, gen->pid, gen->next + dur) != 0) {
+				return -1;
+			}
+			break;
+		default: //stat and other metadata calls
+			dur = workload_sample(&workload_durs[2], 0);
+			if (workload_emit_named(OP_STAT, name, gen->pid, gen->next, dur) != 0) {
+				return -1;
+			}
+			break;
+	}
+	gap = workload_sample(&proc->gaps, 0);
+	gen->next += gap > dur ? gap : dur + 1;
+	return 0;
+}
+
+/** Closes descriptors of copy @a gen which are still open. */
+
+static int workload_close_all(workload_gen_t * gen) {
+	int64_t u;
+
+	for (u = 0; u < gen->proc->nuses; u++) {
+		if (gen->fds[u] && workload_emit_close(gen->fds[u], gen->pid, gen->end) != 0) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static void workload_heap_down(workload_gen_t ** heap, int64_t n, int64_t i) {
+	workload_gen_t * tmp;
+	int64_t c;
+
+	while ( (c = 2 * i + 1) < n) {
+		if (c + 1 < n && heap[c+1]->next < heap[c]->next) {
+			c++;
+		}
+		if (heap[i]->next <= heap[c]->next) {
+			break;
+		}
+		tmp = heap[i];
+		heap[i] = heap[c];
+		heap[c] = tmp;
+		i = c;
+	}
+}
+
+/** Generates binary trace @a output from a model.
+ *
+ * @arg spec <model>[:<seconds>[:<scale>[:<root>]]], length of the trace (the original one by default), number
+ *           of copies of every process and directory where the files are created (WORKLOAD_ROOT by default)
+ * @return 0 on success, -1 on error
+ */
+
+int workload_generate(const char * spec, char * output) {
+	char model[MAX_STRING];
+	char * part, * next;
+	double seconds = 0;
+	int32_t scale = 1, c, i;
+	int64_t duration, t0, n = 0, calls = 0;
+	int64_t * pos;
+	workload_gen_t * gens, ** heap;
+	workload_gen_t * gen;
+	int retval = 0;
+
+	strncpy(model, spec, MAX_STRING);
+	model[MAX_STRING-1] = 0;
+	strncpy(workload_root, WORKLOAD_ROOT, sizeof(workload_root));
+	if ( (part = strchr(model, ':')) != NULL) {
+		*part++ = 0;
+		if ( (next = strchr(part, ':')) != NULL) {
+			*next++ = 0;
+		}
+		seconds = atof(part);
+		if (next) {
+			part = next;
+			if ( (next = strchr(part, ':')) != NULL) {
+				*next++ = 0;
+				strncpy(workload_root, next, sizeof(workload_root));
+				workload_root[sizeof(workload_root)-1] = 0;
+			}
+			scale = atoi(part);
+		}
+	}
+	if (seconds < 0 || scale <= 0) {
+		ERRORPRINTF("Wrong length or scale of the generated trace: %s\n", spec);
+		return -1;
+	}
+	if (workload_load(model) != 0) {
+		return -1;
+	}
+	duration = seconds > 0 ? (int64_t) (seconds * 1000000) : workload_duration;
+
+	if ( (workload_out_file = fopen(output, "wb")) == NULL) {
+		ERRORPRINTF("Error opening file %s: %s\n", output, strerror(errno));
+		return -1;
+	}
+	workload_out_name = output;
+	list_init(&workload_out);
+	workload_out_count = 0;
+	t0 = workload_setup(scale, (int64_t) WORKLOAD_START * 1000000) + 1000000;
+
+	gens = calloc((int64_t) workload_nprocs * scale, sizeof(workload_gen_t));
+	heap = malloc(((int64_t) workload_nprocs * scale + 1) * sizeof(workload_gen_t *));
+	pos = calloc((int64_t) workload_nfiles * scale + 1, sizeof(int64_t));
+	for (c = 0; c < scale; c++) {
+		for (i = 0; i < workload_nprocs; i++) {
+			gen = &gens[n];
+			gen->proc = workload_proc_list[i];
+			gen->copy = c;
+			gen->pid = WORKLOAD_PID + 1 + n;
+			gen->next_fd = 3;
+			gen->fds = calloc(gen->proc->nuses + 1, sizeof(int32_t));
+			if (workload_duration > 0) { //keep phases of the original trace
+				gen->next = t0 + (int64_t) ((double) gen->proc->first / workload_duration * duration);
+				gen->end = t0 + (int64_t) ((double) gen->proc->last / workload_duration * duration);
+			} else {
+				gen->next = gen->end = t0;
+			}
+			heap[n] = gen;
+			n++;
+		}
+	}
+	for (i = n / 2; i >= 0 && n; i--) {
+		workload_heap_down(heap, n, i);
+	}
+
+	while (n > 0 && retval == 0) {
+		gen = heap[0];
+		if (gen->next > gen->end) {
+			retval = workload_close_all(gen);
+			heap[0] = heap[--n];
+		} else if ( (retval = workload_step(gen, pos)) == 0) {
+			calls++;
+		} else if (retval > 0) {
+			retval = 0;
+		}
+		workload_heap_down(heap, n, 0);
+	}
+	if (retval == 0) {
+		retval = workload_flush();
+	} else {
+		workload_flush();
+	}
+	if (fclose(workload_out_file) != 0) {
+		ERRORPRINTF("Error writing file %s: %s\n", output, strerror(errno));
+		retval = -1;
+	}
+	DEBUGPRINTF("%"PRIi64" calls of %"PRIi64" processes generated to %s\n", calls, (int64_t) workload_nprocs * scale, output);
+
+	for (i = 0; i < (int64_t) workload_nprocs * scale; i++) {
+		free(gens[i].fds);
+	}
+	free(gens);
+	free(heap);
+	free(pos);
+	workload_finish();
+	return retval;
+}
+
+void workload_finish() {
+	hash_table_destroy(&workload_files);
+	hash_table_destroy(&workload_procs);
+	hash_table_destroy(&workload_dirs);
+	free(workload_file_list);
+	free(workload_proc_list);
+	workload_file_list = NULL;
+	workload_proc_list = NULL;
+	workload_nfiles = workload_files_size = 0;
+	workload_nprocs = workload_procs_size = 0;
+	workload_ndirs = 0;
+	workload_model[0] = 0;
+}
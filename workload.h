@@ -0,0 +1,150 @@
+/* IOapps, IO profiler and IO traces replayer
+
+    Copyright (C) 2010 Jiri Horky <jiri.horky@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _WORKLOAD_H_
+#define _WORKLOAD_H_
+
+/** @file workload.h
+ *
+ * Synthetic workload model. workload_extract() distils a simulated trace into a small text model without any
+ * paths: for every file its directory number, size, fractions of sequential, strided and random calls, request
+ * sizes and read/write mix; for every process its active time, numbers of reads, writes, opens, stats and other
+ * metadata calls, distribution of gaps between them and the files it uses; and distributions of call durations.
+ *
+ * workload_generate() creates a new binary trace of any length from the model. Files get anonymized names
+ * <root>/c<copy>/d<dir>/f<file>, every process of the model is run <scale> times (copies) with its own files.
+ * The trace starts with a setup process creating the directories and writing files which were read before
+ * being written in the original trace, so it can be replayed as it is. Every process (the setup one too) is
+ * cloned from an idle init process (WORKLOAD_INIT_PID) at its first call, so it starts with just the standard
+ * descriptors and descriptors of concurrent processes do not mix during replay. Every process then issues calls with
+ * gaps sampled from its distribution, kinds of calls in the original proportion and files chosen by the number
+ * of calls it did on them. Offsets follow the pattern of the file and sizes its request size distribution.
+ * Metadata calls other than open and stat (unlink, rename, ...) are generated as stat, so the synthetic files
+ * stay in place.
+ *
+ * Model lines (all times in usec, histograms are log2 buckets with count and sum of values):
+ *   model <version>
+ *   duration <usec>
+ *   file <id> <dir> <size> <seq> <strided> <random> <stride> <reads> <writes> <read bytes> <written bytes> <populate>
+ *   size <file> <bucket> <count> <sum>
+ *   process <id> <first> <last> <reads> <writes> <opens> <stats> <meta>
+ *   gap <process> <bucket> <count> <sum>
+ *   use <process> <file> <calls>
+ *   dur <read|write|meta> <bucket> <count> <sum>
+ */
+
+#include <stdint.h>
+#include "common.h"
+#include "in_common.h"
+#include "adt/hash_table.h"
+
+#define WORKLOAD_VERSION 1
+#define WORKLOAD_BUCKETS 48
+#define WORKLOAD_HT_SIZE 1024
+#define WORKLOAD_ROOT "/tmp/ioreplay-synth"
+#define WORKLOAD_PID 1000 ///< pid of the setup process, workload processes follow
+#define WORKLOAD_INIT_PID (WORKLOAD_PID - 1) ///< idle process all other processes are cloned from
+#define WORKLOAD_START 1000000000 ///< start of the generated trace, in seconds
+#define WORKLOAD_CHUNK 65536 ///< number of calls written at once
+#define WORKLOAD_POPULATE (1 << 20) ///< size of writes of the setup process
+#define WORKLOAD_SEED 0x2545F4914F6CDD1DULL
+
+#define WORKLOAD_READ 0
+#define WORKLOAD_WRITE 1
+#define WORKLOAD_OPEN 2
+#define WORKLOAD_STAT 3
+#define WORKLOAD_META 4
+#define WORKLOAD_KINDS 5
+
+typedef struct workload_hist {
+	int64_t count[WORKLOAD_BUCKETS];
+	int64_t sum[WORKLOAD_BUCKETS];
+} workload_hist_t;
+
+typedef struct workload_file {
+	item_t item;
+	char name[MAX_STRING]; ///< original name, only while extracting
+	int32_t id;
+	int32_t dir;
+	int64_t size; ///< the highest offset reached
+	int64_t seq;
+	int64_t strided;
+	int64_t random;
+	int64_t stride; ///< the last stride seen
+	int64_t reads;
+	int64_t writes;
+	int64_t read_bytes;
+	int64_t write_bytes;
+	int populate; ///< the first call was a read, so the file has to exist
+	workload_hist_t sizes;
+	int64_t prev_offset; ///< offset of the previous call, for the classification
+	int64_t prev_end;
+	int64_t prev_delta;
+	int32_t last_proc; ///< the last process using the file and its use, to find uses quickly
+	int64_t last_use;
+} workload_file_t;
+
+typedef struct workload_dir {
+	item_t item;
+	char name[MAX_STRING];
+	int32_t id;
+} workload_dir_t;
+
+/** Number of calls a process did on one file. */
+typedef struct workload_use {
+	int32_t file;
+	int64_t calls;
+} workload_use_t;
+
+typedef struct workload_proc {
+	item_t item;
+	key_t pid;
+	int32_t id;
+	int64_t first; ///< start of the first call
+	int64_t last; ///< start of the last call
+	int64_t prev; ///< start of the previous modeled call, -1 if none
+	int64_t calls[WORKLOAD_KINDS];
+	workload_hist_t gaps;
+	workload_use_t * uses;
+	int64_t nuses;
+	int64_t size;
+	int64_t total; ///< sum of calls of all uses
+} workload_proc_t;
+
+/** One copy of a process being generated. */
+typedef struct workload_gen {
+	workload_proc_t * proc;
+	int32_t pid;
+	int32_t copy;
+	int64_t next; ///< start of the next call
+	int64_t end; ///< no calls after this time
+	int32_t * fds; ///< descriptor of every use, 0 if not open
+	int32_t next_fd;
+	int started; ///< whether the clone of the process was emitted
+} workload_gen_t;
+
+int workload_init(const char * model);
+int workload_enabled();
+void workload_add_rw(int32_t pid, const char * name, int64_t offset, int64_t size, int write, int32_t dur);
+void workload_scan(list_t * list);
+int workload_extract();
+int workload_generate(const char * spec, char * output);
+void workload_finish();
+
+#endif